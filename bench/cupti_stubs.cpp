@@ -0,0 +1,361 @@
+#include <chrono>
+#include <cstdlib>
+#include <cuda.h>
+#include <cuda_runtime_api.h>
+#include <cupti.h>
+#include <cupti_target.h>
+#include <cupti_profiler_target.h>
+#include <cupti_profiler_host.h>
+#include <cupti_range_profiler.h>
+#include "cupti_stubs.h"
+
+namespace
+{
+    CUpti_BuffersCallbackCompleteFunc bufferCompleted = nullptr;
+    size_t rangeCount = 0;
+    GmpStubCallCounts callCounts;
+
+    // Opaque handles GMP only passes back to the stubs.
+    char hostObject;
+    char rangeProfilerObject;
+    char context;
+
+    constexpr size_t IMAGE_SIZE = 64;
+}
+
+uint8_t *GmpSyntheticActivityBuffer::copy(size_t &validSize) const
+{
+    validSize = bytes.size();
+    auto *buffer = static_cast<uint8_t *>(malloc(validSize > 0 ? validSize : 1));
+    memcpy(buffer, bytes.data(), validSize);
+    return buffer;
+}
+
+void gmpStubCompleteBuffer(uint8_t *buffer, size_t validSize)
+{
+    if (bufferCompleted)
+    {
+        bufferCompleted(nullptr, 0, buffer, validSize, validSize);
+    }
+    else
+    {
+        free(buffer);
+    }
+}
+
+void gmpStubSetRangeCount(size_t count)
+{
+    rangeCount = count;
+}
+
+void gmpStubAddRanges(size_t count)
+{
+    rangeCount += count;
+}
+
+const GmpStubCallCounts &gmpStubGetCallCounts()
+{
+    return callCounts;
+}
+
+extern "C"
+{
+    // --- Driver API ---
+    CUresult CUDAAPI cuInit(unsigned int)
+    {
+        return CUDA_SUCCESS;
+    }
+
+    CUresult CUDAAPI cuDeviceGet(CUdevice *device, int ordinal)
+    {
+        *device = ordinal;
+        return CUDA_SUCCESS;
+    }
+
+    CUresult CUDAAPI cuDeviceGetAttribute(int *value, CUdevice_attribute attribute, CUdevice)
+    {
+        // Report a device new enough for the range profiler.
+        *value = attribute == CU_DEVICE_ATTRIBUTE_COMPUTE_CAPABILITY_MAJOR ? 8 : 0;
+        return CUDA_SUCCESS;
+    }
+
+    CUresult CUDAAPI cuDevicePrimaryCtxRetain(CUcontext *ctx, CUdevice)
+    {
+        *ctx = reinterpret_cast<CUcontext>(&context);
+        return CUDA_SUCCESS;
+    }
+
+    CUresult CUDAAPI cuCtxSetCurrent(CUcontext)
+    {
+        return CUDA_SUCCESS;
+    }
+
+    CUresult CUDAAPI cuGetErrorString(CUresult, const char **str)
+    {
+        *str = "stubbed driver";
+        return CUDA_SUCCESS;
+    }
+
+    // --- Runtime API ---
+    cudaError_t CUDARTAPI cudaDeviceSynchronize(void)
+    {
+        callCounts.deviceSynchronize++;
+        return cudaSuccess;
+    }
+
+    cudaError_t CUDARTAPI cudaFree(void *)
+    {
+        return cudaSuccess;
+    }
+
+    const char *CUDARTAPI cudaGetErrorString(cudaError_t)
+    {
+        return "stubbed runtime";
+    }
+
+    // --- CUPTI ---
+    CUptiResult CUPTIAPI cuptiGetTimestamp(uint64_t *timestamp)
+    {
+        *timestamp = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                               std::chrono::steady_clock::now().time_since_epoch())
+                                               .count());
+        return CUPTI_SUCCESS;
+    }
+
+    CUptiResult CUPTIAPI cuptiGetVersion(uint32_t *version)
+    {
+        *version = CUPTI_API_VERSION;
+        return CUPTI_SUCCESS;
+    }
+
+    CUptiResult CUPTIAPI cuptiGetResultString(CUptiResult, const char **str)
+    {
+        *str = "stubbed CUPTI";
+        return CUPTI_SUCCESS;
+    }
+
+    CUptiResult CUPTIAPI cuptiUnsubscribe(CUpti_SubscriberHandle)
+    {
+        return CUPTI_SUCCESS;
+    }
+
+    CUptiResult CUPTIAPI cuptiActivityEnable(CUpti_ActivityKind)
+    {
+        return CUPTI_SUCCESS;
+    }
+
+    CUptiResult CUPTIAPI cuptiActivityConfigureUnifiedMemoryCounter(CUpti_ActivityUnifiedMemoryCounterConfig *,
+                                                                     uint32_t)
+    {
+        return CUPTI_SUCCESS;
+    }
+
+    CUptiResult CUPTIAPI cuptiActivityDisable(CUpti_ActivityKind)
+    {
+        return CUPTI_SUCCESS;
+    }
+
+    CUptiResult CUPTIAPI cuptiActivityFlushAll(uint32_t)
+    {
+        // Buffers are delivered explicitly through gmpStubCompleteBuffer.
+        callCounts.activityFlushAll++;
+        return CUPTI_SUCCESS;
+    }
+
+    CUptiResult CUPTIAPI cuptiActivityRegisterCallbacks(CUpti_BuffersCallbackRequestFunc,
+                                                        CUpti_BuffersCallbackCompleteFunc funcBufferCompleted)
+    {
+        bufferCompleted = funcBufferCompleted;
+        return CUPTI_SUCCESS;
+    }
+
+    CUptiResult CUPTIAPI cuptiActivityGetNextRecord(uint8_t *buffer, size_t validBufferSizeBytes, CUpti_Activity **record)
+    {
+        // Every record is preceded by its padded size, see GmpSyntheticActivityBuffer.
+        uint8_t *next = buffer;
+        if (*record)
+        {
+            uint8_t *current = reinterpret_cast<uint8_t *>(*record);
+            uint64_t size = 0;
+            memcpy(&size, current - sizeof(uint64_t), sizeof(size));
+            next = current + size;
+        }
+        if (next >= buffer + validBufferSizeBytes)
+        {
+            return CUPTI_ERROR_MAX_LIMIT_REACHED;
+        }
+        *record = reinterpret_cast<CUpti_Activity *>(next + sizeof(uint64_t));
+        return CUPTI_SUCCESS;
+    }
+
+    CUptiResult CUPTIAPI cuptiActivityGetNumDroppedRecords(CUcontext, uint32_t, size_t *dropped)
+    {
+        *dropped = 0;
+        return CUPTI_SUCCESS;
+    }
+
+    CUptiResult CUPTIAPI cuptiSetEventCollectionMode(CUcontext, CUpti_EventCollectionMode)
+    {
+        return CUPTI_SUCCESS;
+    }
+
+    CUptiResult CUPTIAPI cuptiEventGroupEnable(CUpti_EventGroup)
+    {
+        return CUPTI_SUCCESS;
+    }
+
+    CUptiResult CUPTIAPI cuptiEventGroupDisable(CUpti_EventGroup)
+    {
+        return CUPTI_SUCCESS;
+    }
+
+    CUptiResult CUPTIAPI cuptiEventGroupGetAttribute(CUpti_EventGroup, CUpti_EventGroupAttribute, size_t *valueSize, void *value)
+    {
+        memset(value, 0, *valueSize);
+        return CUPTI_SUCCESS;
+    }
+
+    CUptiResult CUPTIAPI cuptiEventGroupReadEvent(CUpti_EventGroup, CUpti_ReadEventFlags, CUpti_EventID,
+                                                  size_t *eventValueBufferSizeBytes, uint64_t *eventValueBuffer)
+    {
+        memset(eventValueBuffer, 0, *eventValueBufferSizeBytes);
+        return CUPTI_SUCCESS;
+    }
+
+    // --- Profiler host ---
+    CUptiResult CUPTIAPI cuptiProfilerInitialize(CUpti_Profiler_Initialize_Params *)
+    {
+        return CUPTI_SUCCESS;
+    }
+
+    CUptiResult CUPTIAPI cuptiDeviceGetChipName(CUpti_Device_GetChipName_Params *pParams)
+    {
+        pParams->pChipName = "stub";
+        return CUPTI_SUCCESS;
+    }
+
+    CUptiResult CUPTIAPI cuptiProfilerGetCounterAvailability(CUpti_Profiler_GetCounterAvailability_Params *pParams)
+    {
+        if (pParams->pCounterAvailabilityImage)
+        {
+            memset(pParams->pCounterAvailabilityImage, 0, pParams->counterAvailabilityImageSize);
+        }
+        pParams->counterAvailabilityImageSize = IMAGE_SIZE;
+        return CUPTI_SUCCESS;
+    }
+
+    CUptiResult CUPTIAPI cuptiProfilerHostInitialize(CUpti_Profiler_Host_Initialize_Params *pParams)
+    {
+        pParams->pHostObject = reinterpret_cast<CUpti_Profiler_Host_Object *>(&hostObject);
+        return CUPTI_SUCCESS;
+    }
+
+    CUptiResult CUPTIAPI cuptiProfilerHostDeinitialize(CUpti_Profiler_Host_Deinitialize_Params *)
+    {
+        return CUPTI_SUCCESS;
+    }
+
+    CUptiResult CUPTIAPI cuptiProfilerHostConfigAddMetrics(CUpti_Profiler_Host_ConfigAddMetrics_Params *)
+    {
+        return CUPTI_SUCCESS;
+    }
+
+    CUptiResult CUPTIAPI cuptiProfilerHostGetConfigImageSize(CUpti_Profiler_Host_GetConfigImageSize_Params *pParams)
+    {
+        pParams->configImageSize = IMAGE_SIZE;
+        return CUPTI_SUCCESS;
+    }
+
+    CUptiResult CUPTIAPI cuptiProfilerHostGetConfigImage(CUpti_Profiler_Host_GetConfigImage_Params *pParams)
+    {
+        memset(pParams->pConfigImage, 0, pParams->configImageSize);
+        return CUPTI_SUCCESS;
+    }
+
+    CUptiResult CUPTIAPI cuptiProfilerHostGetNumOfPasses(CUpti_Profiler_Host_GetNumOfPasses_Params *pParams)
+    {
+        pParams->numOfPasses = 1;
+        return CUPTI_SUCCESS;
+    }
+
+    CUptiResult CUPTIAPI cuptiProfilerHostEvaluateToGpuValues(CUpti_Profiler_Host_EvaluateToGpuValues_Params *pParams)
+    {
+        // Deterministic values, distinct per range and metric.
+        callCounts.evaluateToGpuValues++;
+        for (size_t i = 0; i < pParams->numMetrics; ++i)
+        {
+            pParams->pMetricValues[i] = static_cast<double>(pParams->rangeIndex % 997) * 16.0 + static_cast<double>(i);
+        }
+        return CUPTI_SUCCESS;
+    }
+
+    // --- Range profiler ---
+    CUptiResult CUPTIAPI cuptiRangeProfilerEnable(CUpti_RangeProfiler_Enable_Params *pParams)
+    {
+        pParams->pRangeProfilerObject = reinterpret_cast<CUpti_RangeProfiler_Object *>(&rangeProfilerObject);
+        return CUPTI_SUCCESS;
+    }
+
+    CUptiResult CUPTIAPI cuptiRangeProfilerDisable(CUpti_RangeProfiler_Disable_Params *)
+    {
+        return CUPTI_SUCCESS;
+    }
+
+    CUptiResult CUPTIAPI cuptiRangeProfilerGetCounterDataSize(CUpti_RangeProfiler_GetCounterDataSize_Params *pParams)
+    {
+        pParams->counterDataSize = IMAGE_SIZE;
+        return CUPTI_SUCCESS;
+    }
+
+    CUptiResult CUPTIAPI cuptiRangeProfilerCounterDataImageInitialize(CUpti_RangeProfiler_CounterDataImage_Initialize_Params *)
+    {
+        callCounts.counterDataInitialize++;
+        rangeCount = 0;
+        return CUPTI_SUCCESS;
+    }
+
+    CUptiResult CUPTIAPI cuptiRangeProfilerSetConfig(CUpti_RangeProfiler_SetConfig_Params *)
+    {
+        return CUPTI_SUCCESS;
+    }
+
+    CUptiResult CUPTIAPI cuptiRangeProfilerStart(CUpti_RangeProfiler_Start_Params *)
+    {
+        return CUPTI_SUCCESS;
+    }
+
+    CUptiResult CUPTIAPI cuptiRangeProfilerStop(CUpti_RangeProfiler_Stop_Params *pParams)
+    {
+        pParams->isAllPassSubmitted = 1;
+        return CUPTI_SUCCESS;
+    }
+
+    CUptiResult CUPTIAPI cuptiRangeProfilerPushRange(CUpti_RangeProfiler_PushRange_Params *)
+    {
+        callCounts.rangeProfilerPushRange++;
+        return CUPTI_SUCCESS;
+    }
+
+    CUptiResult CUPTIAPI cuptiRangeProfilerPopRange(CUpti_RangeProfiler_PopRange_Params *)
+    {
+        callCounts.rangeProfilerPopRange++;
+        return CUPTI_SUCCESS;
+    }
+
+    CUptiResult CUPTIAPI cuptiRangeProfilerDecodeData(CUpti_RangeProfiler_DecodeData_Params *)
+    {
+        return CUPTI_SUCCESS;
+    }
+
+    CUptiResult CUPTIAPI cuptiRangeProfilerGetCounterDataInfo(CUpti_RangeProfiler_GetCounterDataInfo_Params *pParams)
+    {
+        pParams->numTotalRanges = rangeCount;
+        return CUPTI_SUCCESS;
+    }
+
+    CUptiResult CUPTIAPI cuptiRangeProfilerCounterDataGetRangeInfo(CUpti_RangeProfiler_CounterData_GetRangeInfo_Params *pParams)
+    {
+        pParams->rangeName = "stub_range";
+        return CUPTI_SUCCESS;
+    }
+}
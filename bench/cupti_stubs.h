@@ -0,0 +1,73 @@
+#ifndef GMP_BENCH_CUPTI_STUBS_H
+#define GMP_BENCH_CUPTI_STUBS_H
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include <cupti.h>
+
+// The benchmark links the GMP sources against cupti_stubs.cpp instead of
+// libcuda, libcudart and libcupti. Every driver, runtime and CUPTI entry
+// point GMP calls succeeds without touching a GPU, and activity records are
+// fed to the completion callback GMP registered from synthetic buffers.
+
+// Builds an activity buffer in the layout the stubbed
+// cuptiActivityGetNextRecord walks: every record is preceded by its size,
+// so any record type can be appended.
+class GmpSyntheticActivityBuffer
+{
+public:
+  template <typename Record>
+  void append(const Record &record)
+  {
+    uint64_t size = (sizeof(Record) + 7) & ~uint64_t(7);
+    size_t offset = bytes.size();
+    bytes.resize(offset + sizeof(uint64_t) + size, 0);
+    memcpy(bytes.data() + offset, &size, sizeof(size));
+    memcpy(bytes.data() + offset + sizeof(uint64_t), &record, sizeof(Record));
+    recordCount++;
+  }
+
+  size_t size() const { return recordCount; }
+
+  void clear()
+  {
+    bytes.clear();
+    recordCount = 0;
+  }
+
+  // A malloc'ed copy, owned by the completion callback like a CUPTI buffer.
+  uint8_t *copy(size_t &validSize) const;
+
+private:
+  std::vector<uint8_t> bytes;
+  size_t recordCount = 0;
+};
+
+// Hand a buffer from GmpSyntheticActivityBuffer::copy to the completion
+// callback registered through cuptiActivityRegisterCallbacks.
+void gmpStubCompleteBuffer(uint8_t *buffer, size_t validSize);
+
+// Number of ranges the stubbed counter data image reports, i.e. the number
+// of kernels the range profiler would have seen in auto range mode.
+void gmpStubSetRangeCount(size_t rangeCount);
+
+// Add ranges to the counter data image, e.g. the kernels of a range just
+// popped. Initializing the image empties it again.
+void gmpStubAddRanges(size_t rangeCount);
+
+// Calls of each stubbed entry point, to check the benchmark measures what it claims.
+struct GmpStubCallCounts
+{
+  size_t deviceSynchronize = 0;
+  size_t activityFlushAll = 0;
+  size_t rangeProfilerPushRange = 0;
+  size_t rangeProfilerPopRange = 0;
+  size_t evaluateToGpuValues = 0;
+  size_t counterDataInitialize = 0;
+};
+
+const GmpStubCallCounts &gmpStubGetCallCounts();
+
+#endif // GMP_BENCH_CUPTI_STUBS_H
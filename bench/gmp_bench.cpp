@@ -0,0 +1,1693 @@
+// gmp_bench: host-side microbenchmarks of GMP on synthetic CUPTI data.
+//
+// Every CUDA and CUPTI call is stubbed (see cupti_stubs.h), so the numbers
+// are the cost GMP itself adds on the host: activity record parsing, session
+// bookkeeping, push/pop and report generation. Each scenario runs in its own
+// process because GmpProfiler is a singleton.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <new>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "gmp/bottleneck.h"
+#include "gmp/nvtx_bridge.h"
+#include "gmp/profile.h"
+#include "gmp/scoped_range.h"
+#include "cupti_stubs.h"
+
+// Heap allocations of the process, to check the allocation-free paths. The
+// arena and the spill code also allocate from the CUPTI buffer thread.
+static std::atomic<size_t> allocationCount{0};
+
+static void *countedMalloc(size_t size)
+{
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (void *memory = malloc(size ? size : 1))
+    {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+// Every form allocates and frees directly, so GCC sees matching pairs.
+void *operator new(size_t size)
+{
+    return countedMalloc(size);
+}
+
+void *operator new[](size_t size)
+{
+    return countedMalloc(size);
+}
+
+void operator delete(void *memory) noexcept
+{
+    free(memory);
+}
+
+void operator delete[](void *memory) noexcept
+{
+    free(memory);
+}
+
+void operator delete(void *memory, size_t) noexcept
+{
+    free(memory);
+}
+
+void operator delete[](void *memory, size_t) noexcept
+{
+    free(memory);
+}
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    struct BenchConfig
+    {
+        size_t kernels = 100000;
+        size_t ranges = 1000;
+        size_t rangeNames = 100; // Distinct range names, the rest are repeats
+        size_t memRecords = 100000;
+        size_t recordsPerBuffer = 4096;
+        size_t iterations = 100000;
+        size_t extraMetrics = 0;
+        size_t kernelNames = 64;
+        bool keepKernelDetail = true;
+    };
+
+    double elapsedNs(Clock::time_point start)
+    {
+        return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+    }
+
+    void printHeader(const char *scenario)
+    {
+        printf("\n== %s ==\n", scenario);
+        printf("%-46s %12s %12s %14s\n", "case", "count", "total ms", "ns/op");
+    }
+
+    void printResult(const char *name, size_t count, double totalNs)
+    {
+        printf("%-46s %12zu %12.3f %14.1f\n", name, count, totalNs / 1e6, count > 0 ? totalNs / count : 0.0);
+        fflush(stdout);
+    }
+
+    // Mangled-looking names of realistic length, owned for the whole run
+    // because activity records only point at them.
+    std::vector<std::string> makeKernelNames(size_t count)
+    {
+        std::vector<std::string> names;
+        for (size_t i = 0; i < count; ++i)
+        {
+            names.push_back("_ZN7cutlass6KernelINS_4gemm6kernel13GemmUniversalILi" + std::to_string(i) +
+                            "ENS_6half_tENS_11layout_RowEEEEEvNT_6ParamsE");
+        }
+        return names;
+    }
+
+    std::string rangeName(size_t rangeIndex, const BenchConfig &config)
+    {
+        return "range_" + std::to_string(rangeIndex % config.rangeNames);
+    }
+
+    // Heap allocations made by the completion callbacks, i.e. by ingestion.
+    size_t ingestAllocations = 0;
+
+    // Deliver records in buffers of recordsPerBuffer, timing only the completion callbacks.
+    template <typename MakeRecord>
+    double deliverRecords(size_t count, const BenchConfig &config, MakeRecord &&makeRecord)
+    {
+        double totalNs = 0.0;
+        GmpSyntheticActivityBuffer synthetic;
+        for (size_t first = 0; first < count; first += config.recordsPerBuffer)
+        {
+            synthetic.clear();
+            size_t last = std::min(count, first + config.recordsPerBuffer);
+            for (size_t i = first; i < last; ++i)
+            {
+                synthetic.append(makeRecord(i));
+            }
+            size_t validSize = 0;
+            uint8_t *buffer = synthetic.copy(validSize);
+            size_t allocationsBefore = allocationCount;
+            auto start = Clock::now();
+            gmpStubCompleteBuffer(buffer, validSize);
+            totalNs += elapsedNs(start);
+            ingestAllocations += allocationCount - allocationsBefore;
+        }
+        return totalNs;
+    }
+
+    GmpProfiler *initProfiler(const BenchConfig &config)
+    {
+        GmpProfiler *profiler = GmpProfiler::getInstance();
+        profiler->setConfigCache(false);
+        profiler->setKernelDetail(config.keepKernelDetail);
+        for (size_t i = 0; i < config.extraMetrics; ++i)
+        {
+            profiler->addMetrics("bench__metric_" + std::to_string(i) + ".sum");
+        }
+        profiler->init();
+        profiler->startRangeProfiling();
+        return profiler;
+    }
+
+    struct ActivityTimes
+    {
+        double kernelNs = 0.0;
+        double memoryNs = 0.0;
+        size_t memoryRecords = 0;
+    };
+
+    // Kernel ranges, then memory ranges, with their records delivered through
+    // the completion callback. Kernel names must outlive the profiler.
+    ActivityTimes deliverActivity(GmpProfiler *profiler, const BenchConfig &config,
+                                  const std::vector<std::string> &kernelNames)
+    {
+        ActivityTimes times;
+        size_t kernelIndex = 0;
+        uint64_t timestamp = 1000000;
+        for (size_t range = 0; range < config.ranges; ++range)
+        {
+            size_t kernelsInRange = config.kernels / config.ranges + (range < config.kernels % config.ranges ? 1 : 0);
+            profiler->pushRange(rangeName(range, config), GmpProfileType::CONCURRENT_KERNEL);
+            times.kernelNs += deliverRecords(kernelsInRange, config, [&](size_t)
+            {
+                CUpti_ActivityKernel8 kernel{};
+                kernel.kind = CUPTI_ACTIVITY_KIND_CONCURRENT_KERNEL;
+                kernel.name = kernelNames[kernelIndex % kernelNames.size()].c_str();
+                kernel.gridX = static_cast<int32_t>(128 + kernelIndex % 4);
+                kernel.gridY = kernel.gridZ = 1;
+                kernel.blockX = 256;
+                kernel.blockY = kernel.blockZ = 1;
+                kernel.streamId = static_cast<uint32_t>(kernelIndex % 4);
+                kernel.correlationId = static_cast<uint32_t>(kernelIndex);
+                kernel.start = timestamp;
+                kernel.end = timestamp + 5000;
+                timestamp += 6000;
+                kernelIndex++;
+                return kernel;
+            });
+            profiler->popRange(rangeName(range, config), GmpProfileType::CONCURRENT_KERNEL);
+        }
+
+        constexpr size_t MEMORY_RANGES = 100;
+        size_t memIndex = 0;
+        for (size_t range = 0; range < MEMORY_RANGES; ++range)
+        {
+            size_t recordsInRange = config.memRecords / MEMORY_RANGES;
+            profiler->pushRange(rangeName(range, config), GmpProfileType::MEMORY);
+            times.memoryNs += deliverRecords(recordsInRange, config, [&](size_t i)
+            {
+                // Alternate allocations and releases of the same address.
+                CUpti_ActivityMemory4 memory{};
+                memory.kind = CUPTI_ACTIVITY_KIND_MEMORY2;
+                memory.memoryOperationType = i % 2 == 0 ? CUPTI_ACTIVITY_MEMORY_OPERATION_TYPE_ALLOCATION
+                                                        : CUPTI_ACTIVITY_MEMORY_OPERATION_TYPE_RELEASE;
+                memory.memoryKind = CUPTI_ACTIVITY_MEMORY_KIND_DEVICE;
+                memory.address = 0x700000000000ull + (memIndex / 2) * 4096;
+                memory.bytes = 1 << 20;
+                memory.timestamp = timestamp;
+                memory.streamId = CUPTI_INVALID_STREAM_ID;
+                memory.contextId = 1;
+                timestamp += 1000;
+                memIndex++;
+                return memory;
+            });
+            profiler->popRange(rangeName(range, config), GmpProfileType::MEMORY);
+            times.memoryRecords += recordsInRange;
+        }
+        return times;
+    }
+
+    // Activity parsing through bufferCompletedImpl, then every report built from it.
+    void runPipeline(const BenchConfig &config)
+    {
+        GmpProfiler *profiler = initProfiler(config);
+        auto kernelNames = makeKernelNames(config.kernelNames);
+
+        printHeader("activity parsing");
+        ActivityTimes times = deliverActivity(profiler, config, kernelNames);
+        printResult("kernel record (CONCURRENT_KERNEL)", config.kernels, times.kernelNs);
+        printResult("memory record (MEMORY2)", times.memoryRecords, times.memoryNs);
+        printf("  per record: %.3f allocations\n", double(ingestAllocations) / (config.kernels + times.memoryRecords));
+
+        // Every kernel is one auto range of the stubbed counter data image.
+        gmpStubSetRangeCount(config.kernels);
+        profiler->stopRangeProfiling();
+        profiler->decodeCounterData();
+
+        printHeader("report generation (ns per kernel)");
+        auto start = Clock::now();
+        auto stats = profiler->getRangeStatistics(GmpOutputKernelReduction::SUM);
+        printResult("evaluate counter data + range statistics", config.kernels, elapsedNs(start));
+
+        start = Clock::now();
+        stats = profiler->getRangeStatistics(GmpOutputKernelReduction::SUM);
+        printResult("range statistics", config.kernels, elapsedNs(start));
+
+        std::string configName = "bench";
+        const std::pair<const char *, GmpOutputKernelReduction> reductions[] = {
+            {"produceOutput SUM", GmpOutputKernelReduction::SUM},
+            {"produceOutput MAX", GmpOutputKernelReduction::MAX},
+            {"produceOutput MEAN", GmpOutputKernelReduction::MEAN},
+        };
+        for (const auto &reduction : reductions)
+        {
+            start = Clock::now();
+            profiler->produceOutput(configName, reduction.second);
+            printResult(reduction.first, config.kernels, elapsedNs(start));
+        }
+
+        start = Clock::now();
+        auto hotKernels = profiler->getHotKernelTable();
+        printResult("hot kernel table", config.kernels, elapsedNs(start));
+
+        // The stubbed chip is not in the peak table, use the A100 one.
+        profiler->setRooflinePeaks(*GmpRoofline::findPeaks("GA100"));
+        start = Clock::now();
+        auto rooflineKernels = profiler->getRooflineKernels();
+        printResult("roofline per kernel", config.kernels, elapsedNs(start));
+
+        start = Clock::now();
+        auto bottleneckKernels = profiler->getBottleneckKernels();
+        printResult("bottlenecks per kernel", config.kernels, elapsedNs(start));
+
+        start = Clock::now();
+        if (profiler->exportRooflineCsv("roofline.csv") != GmpResult::SUCCESS)
+        {
+            fprintf(stderr, "Roofline CSV export failed\n");
+            _exit(1);
+        }
+        printResult("roofline CSV export", config.kernels, elapsedNs(start));
+
+        start = Clock::now();
+        auto kernelTimeline = profiler->getKernelTimeline();
+        printResult("kernel timeline", config.kernels, elapsedNs(start));
+
+        start = Clock::now();
+        auto footprint = profiler->getMemoryFootprint();
+        printResult("memory footprint (ns per memory record)", config.memRecords, elapsedNs(start));
+
+        start = Clock::now();
+        profiler->exportTrace("trace.json");
+        printResult("Chrome trace export", config.kernels + config.memRecords, elapsedNs(start));
+
+        // Range names repeat every config.rangeNames ranges. The range check of
+        // printProfilerRanges exits the process if it miscounts their kernels,
+        // the listing itself goes to /dev/null.
+        fflush(stdout);
+        int savedStdout = dup(STDOUT_FILENO);
+        int devNull = open("/dev/null", O_WRONLY);
+        dup2(devNull, STDOUT_FILENO);
+        start = Clock::now();
+        profiler->printProfilerRanges(configName, GmpOutputKernelReduction::SUM);
+        double printNs = elapsedNs(start);
+        std::cout.flush();
+        fflush(stdout);
+        dup2(savedStdout, STDOUT_FILENO);
+        close(devNull);
+        close(savedStdout);
+        printResult("printProfilerRanges, repeated range names", config.kernels, printNs);
+    }
+
+    // SessionManager on its own, without the profiler around it.
+    void runSessions(const BenchConfig &config)
+    {
+        printHeader("session manager");
+        auto kernelNames = makeKernelNames(config.kernelNames);
+        std::vector<uint32_t> kernelNameIds;
+        for (const auto &name : kernelNames)
+        {
+            kernelNameIds.push_back(GmpStringTable::instance().intern(name));
+        }
+        SessionManager sessionManager;
+        double accumulateNs = 0.0;
+        size_t kernelIndex = 0;
+        for (size_t range = 0; range < config.ranges; ++range)
+        {
+            size_t kernelsInRange = config.kernels / config.ranges + (range < config.kernels % config.ranges ? 1 : 0);
+            sessionManager.startSession(GmpProfileType::CONCURRENT_KERNEL,
+                                        sessionManager.createSession<GmpConcurrentKernelSession>(rangeName(range, config)));
+            auto start = Clock::now();
+            for (size_t i = 0; i < kernelsInRange; ++i, ++kernelIndex)
+            {
+                uint32_t nameId = kernelNameIds[kernelIndex % kernelNameIds.size()];
+                sessionManager.accumulate<GmpConcurrentKernelSession>(
+                    GmpProfileType::CONCURRENT_KERNEL,
+                    [nameId](GmpConcurrentKernelSession *sessionPtr)
+                    {
+                        GmpKernelData data;
+                        data.nameId = nameId;
+                        data.launchIndex = static_cast<uint32_t>(sessionPtr->getKernelLaunchCount());
+                        sessionPtr->pushKernelData(data);
+                    });
+            }
+            accumulateNs += elapsedNs(start);
+            sessionManager.endSession(GmpProfileType::CONCURRENT_KERNEL);
+        }
+        printResult("SessionManager::accumulate (per record)", config.kernels, accumulateNs);
+
+        auto start = Clock::now();
+        auto allData = sessionManager.getAllKernelDataOfType(GmpProfileType::CONCURRENT_KERNEL);
+        printResult("getAllKernelDataOfType (per record)", config.kernels, elapsedNs(start));
+
+        start = Clock::now();
+        size_t visited = 0;
+        sessionManager.forEachSession(GmpProfileType::CONCURRENT_KERNEL, [&visited](const GmpProfileSession &session)
+                                      { visited += session.getKernelDataView().size(); });
+        printResult("forEachSession (per record)", visited, elapsedNs(start));
+    }
+
+    // Kernel, memory and transfer records of every range, visited through forEachSession.
+    uint64_t checksumSessions(const SessionManager &sessionManager)
+    {
+        uint64_t checksum = 0;
+        sessionManager.forEachSession(GmpProfileType::CONCURRENT_KERNEL, [&checksum](const GmpProfileSession &session)
+        {
+            checksum = checksum * 31 + session.getKernelLaunchCount();
+            for (const auto &kernel : session.getKernelDataView())
+            {
+                checksum = checksum * 31 + gmpHash64(kernel.name()) + kernel.start + kernel.grid_size[0];
+            }
+            const auto &memData = session.getMemDataView();
+            for (size_t i = 0; i < memData.size(); ++i)
+            {
+                checksum = checksum * 31 + memData.address[i] + memData.bytes[i] + memData.flags[i];
+            }
+            for (const auto &transfer : session.getTransferDataView())
+            {
+                checksum = checksum * 31 + transfer.bytes + transfer.copyKind;
+            }
+        });
+        return checksum;
+    }
+
+    // Sessions under a memory budget: completed ranges are spilled to disk
+    // and paged back when visited. The reports must match the unbounded run.
+    void runSpill(const BenchConfig &config)
+    {
+        printHeader("session spill");
+        auto kernelNames = makeKernelNames(config.kernelNames);
+        constexpr size_t BUDGET = size_t(1) << 20;
+        double endNs[2] = {};
+        uint64_t checksums[2] = {};
+        SessionManager sessionManagers[2];
+        sessionManagers[1].setMemoryBudget(BUDGET, "sessions.spill");
+        for (size_t managerIndex = 0; managerIndex < 2; ++managerIndex)
+        {
+            SessionManager &sessionManager = sessionManagers[managerIndex];
+            size_t kernelIndex = 0;
+            for (size_t range = 0; range < config.ranges; ++range)
+            {
+                size_t kernelsInRange = config.kernels / config.ranges + (range < config.kernels % config.ranges ? 1 : 0);
+                sessionManager.startSession(GmpProfileType::CONCURRENT_KERNEL,
+                                            sessionManager.createSession<GmpConcurrentKernelSession>(rangeName(range, config)));
+                sessionManager.accumulate<GmpConcurrentKernelSession>(
+                    GmpProfileType::CONCURRENT_KERNEL,
+                    [&](GmpConcurrentKernelSession *sessionPtr)
+                    {
+                        for (size_t i = 0; i < kernelsInRange; ++i, ++kernelIndex)
+                        {
+                            GmpKernelData kernel;
+                            kernel.nameId = GmpStringTable::instance().intern(kernelNames[kernelIndex % kernelNames.size()]);
+                            kernel.grid_size[0] = static_cast<int>(kernelIndex % 1024);
+                            kernel.launchIndex = static_cast<uint32_t>(i);
+                            kernel.start = kernelIndex * 1000;
+                            kernel.end = kernel.start + 500;
+                            sessionPtr->pushKernelData(kernel);
+
+                            GmpMemData mem;
+                            mem.address = 0x7f0000000000ull + kernelIndex * 4096;
+                            mem.bytes = 4096;
+                            mem.flags = static_cast<uint8_t>(kernelIndex % 3);
+                            sessionPtr->pushMemData(mem);
+
+                            GmpTransferData transfer;
+                            transfer.bytes = kernelIndex % 65536;
+                            transfer.copyKind = static_cast<uint8_t>(kernelIndex % 4);
+                            sessionPtr->pushTransferData(transfer);
+                        }
+                    });
+                auto start = Clock::now();
+                sessionManager.endSession(GmpProfileType::CONCURRENT_KERNEL);
+                endNs[managerIndex] += elapsedNs(start);
+            }
+        }
+        printResult("endSession, unbounded (per record)", config.kernels, endNs[0]);
+        printResult("endSession, 1 MiB budget (per record)", config.kernels, endNs[1]);
+
+        for (size_t managerIndex = 0; managerIndex < 2; ++managerIndex)
+        {
+            auto start = Clock::now();
+            checksums[managerIndex] = checksumSessions(sessionManagers[managerIndex]);
+            printResult(managerIndex == 0 ? "forEachSession, unbounded (per record)" : "forEachSession, paged in (per record)",
+                        config.kernels, elapsedNs(start));
+        }
+
+        auto stats = sessionManagers[1].getStorageStats();
+        if (checksums[0] != checksums[1] || stats.residentBytes > BUDGET)
+        {
+            fprintf(stderr, "Spilled sessions differ from the unbounded ones, or exceed the budget\n");
+            _exit(1);
+        }
+        printf("  %zu of %zu ranges spilled, %.1f MB in the spill file, %.1f KB resident, %zu page-ins\n",
+               stats.spilledSessions, config.ranges, stats.spilledBytes / 1e6, stats.residentBytes / 1e3, stats.pageIns);
+
+        // The last spilled session can no longer be read back. It is visited
+        // without records, keeping its kernel launches for range indexing.
+        if (stats.spilledSessions > 0 && truncate("sessions.spill", static_cast<off_t>(stats.spilledBytes) - 1) == 0)
+        {
+            size_t sessionCount = 0;
+            size_t launchCount = 0;
+            size_t emptyCount = 0;
+            sessionManagers[1].forEachSession(GmpProfileType::CONCURRENT_KERNEL, [&](const GmpProfileSession &session)
+            {
+                sessionCount++;
+                launchCount += session.getKernelLaunchCount();
+                emptyCount += session.getKernelDataView().empty() ? 1 : 0;
+            });
+            if (sessionCount != config.ranges || launchCount != config.kernels || emptyCount != 1)
+            {
+                fprintf(stderr, "Visited %zu sessions with %zu kernel launches, %zu without records, after a failed page-in\n",
+                        sessionCount, launchCount, emptyCount);
+                _exit(1);
+            }
+        }
+    }
+
+    // Sessions and records of one epoch, written through accumulate with a
+    // single capture so the std::function holds it inline.
+    struct ArenaEpoch
+    {
+        const std::vector<uint32_t> *kernelNameIds;
+        size_t kernelsInRange = 0;
+        size_t kernelIndex = 0;
+    };
+
+    template <typename MakeSession>
+    void fillEpoch(SessionManager &sessionManager, ArenaEpoch &epoch, const std::vector<uint32_t> &rangeNameIds,
+                   const BenchConfig &config, MakeSession &&makeSession)
+    {
+        epoch.kernelIndex = 0;
+        for (size_t range = 0; range < config.ranges; ++range)
+        {
+            epoch.kernelsInRange = config.kernels / config.ranges + (range < config.kernels % config.ranges ? 1 : 0);
+            sessionManager.startSession(GmpProfileType::CONCURRENT_KERNEL,
+                                        makeSession(rangeNameIds[range % rangeNameIds.size()]));
+            sessionManager.accumulate<GmpConcurrentKernelSession>(
+                GmpProfileType::CONCURRENT_KERNEL,
+                [&epoch](GmpConcurrentKernelSession *sessionPtr)
+                {
+                    for (size_t i = 0; i < epoch.kernelsInRange; ++i, ++epoch.kernelIndex)
+                    {
+                        GmpKernelData kernel;
+                        kernel.nameId = (*epoch.kernelNameIds)[epoch.kernelIndex % epoch.kernelNameIds->size()];
+                        kernel.grid_size[0] = static_cast<int>(epoch.kernelIndex % 1024);
+                        kernel.launchIndex = static_cast<uint32_t>(i);
+                        kernel.start = epoch.kernelIndex * 1000;
+                        kernel.end = kernel.start + 500;
+                        sessionPtr->pushKernelData(kernel);
+
+                        GmpMemData mem;
+                        mem.address = 0x7f0000000000ull + epoch.kernelIndex * 4096;
+                        mem.bytes = 4096;
+                        mem.flags = static_cast<uint8_t>(epoch.kernelIndex % 3);
+                        sessionPtr->pushMemData(mem);
+                    }
+                });
+            sessionManager.endSession(GmpProfileType::CONCURRENT_KERNEL);
+        }
+    }
+
+    // Sessions built in the SessionManager arena against heap ones, over
+    // several epochs. After the first, an epoch reuses the arena chunks and
+    // must not allocate at all.
+    void runArena(const BenchConfig &config)
+    {
+        printHeader("session arena (ns per record)");
+        std::vector<uint32_t> kernelNameIds;
+        for (const auto &name : makeKernelNames(config.kernelNames))
+        {
+            kernelNameIds.push_back(GmpStringTable::instance().intern(name));
+        }
+        std::vector<uint32_t> rangeNameIds;
+        for (size_t i = 0; i < config.rangeNames; ++i)
+        {
+            rangeNameIds.push_back(GmpStringTable::instance().intern(rangeName(i, config)));
+        }
+        ArenaEpoch epoch;
+        epoch.kernelNameIds = &kernelNameIds;
+
+        SessionManager heapManager;
+        auto start = Clock::now();
+        fillEpoch(heapManager, epoch, rangeNameIds, config, [](uint32_t nameId)
+                  { return std::make_unique<GmpConcurrentKernelSession>(nameId); });
+        printResult("heap sessions", config.kernels, elapsedNs(start));
+        uint64_t heapChecksum = checksumSessions(heapManager);
+
+        constexpr size_t EPOCHS = 3;
+        SessionManager arenaManager;
+        GmpArenaStats firstEpochStats;
+        size_t blocksBefore = 0;
+        for (size_t epochIndex = 0; epochIndex < EPOCHS; ++epochIndex)
+        {
+            size_t allocationsBefore = allocationCount;
+            start = Clock::now();
+            fillEpoch(arenaManager, epoch, rangeNameIds, config, [&arenaManager](uint32_t nameId)
+                      { return arenaManager.createSession<GmpConcurrentKernelSession>(nameId); });
+            double fillNs = elapsedNs(start);
+            size_t allocations = allocationCount - allocationsBefore;
+            printResult(epochIndex == 0 ? "arena sessions, first epoch" : "arena sessions, reused epoch", config.kernels,
+                        fillNs);
+
+            GmpArenaStats stats = arenaManager.getArenaStats();
+            if (epochIndex == 0)
+            {
+                firstEpochStats = stats;
+            }
+            if (checksumSessions(arenaManager) != heapChecksum ||
+                (epochIndex > 0 && (allocations != 0 || stats.chunks != firstEpochStats.chunks)))
+            {
+                fprintf(stderr, "Arena sessions differ from the heap ones, or a reused epoch allocated\n");
+                _exit(1);
+            }
+            printf("  %zu heap allocations, %zu blocks carved from %zu chunks (%.1f MB), %.1f MB in use\n", allocations,
+                   stats.allocations - blocksBefore, stats.chunks, stats.chunkBytes / 1e6, stats.bytesInUse / 1e6);
+            blocksBefore = stats.allocations;
+            arenaManager.reset();
+        }
+    }
+
+    // Streaming mode: kernel ranges are written and freed every WINDOW_RANGES.
+    // Every row must carry the metrics of its own window of the counter data,
+    // the arena must be empty after each window and never grow after the
+    // first, and a torn last line must be cut when the file is reopened.
+    void runStreaming(const BenchConfig &config)
+    {
+        constexpr size_t WINDOW_RANGES = 16;
+        const char *STREAM_FILE = "stream.csv";
+        GmpProfiler *profiler = GmpProfiler::getInstance();
+        GmpStreamingConfig streamingConfig;
+        streamingConfig.path = STREAM_FILE;
+        streamingConfig.rangeInterval = WINDOW_RANGES;
+        profiler->enableStreaming(streamingConfig);
+        initProfiler(config);
+        auto kernelNames = makeKernelNames(config.kernelNames);
+
+        printHeader("streaming");
+        // Metric 0 of every range, summed over its kernels as the stub evaluates them.
+        std::vector<double> expected;
+        size_t kernelIndex = 0;
+        size_t imageRange = 0; // Next range of the counter data image, reset with every window
+        uint64_t timestamp = 1000000;
+        size_t windows = 0;
+        size_t windowChunks = 0;
+        double rangeNs = 0.0;
+        double flushNs = 0.0;
+        for (size_t range = 0; range < config.ranges; ++range)
+        {
+            size_t kernelsInRange = config.kernels / config.ranges + (range < config.kernels % config.ranges ? 1 : 0);
+            double sum = 0.0;
+            for (size_t i = 0; i < kernelsInRange; ++i)
+            {
+                sum += static_cast<double>((imageRange + i) % 997) * 16.0;
+            }
+            expected.push_back(sum);
+            imageRange += kernelsInRange;
+
+            auto start = Clock::now();
+            profiler->pushRange(rangeName(range, config), GmpProfileType::CONCURRENT_KERNEL);
+            rangeNs += elapsedNs(start);
+            rangeNs += deliverRecords(kernelsInRange, config, [&](size_t)
+            {
+                CUpti_ActivityKernel8 kernel{};
+                kernel.kind = CUPTI_ACTIVITY_KIND_CONCURRENT_KERNEL;
+                kernel.name = kernelNames[kernelIndex % kernelNames.size()].c_str();
+                kernel.gridX = kernel.gridY = kernel.gridZ = 1;
+                kernel.blockX = kernel.blockY = kernel.blockZ = 1;
+                kernel.correlationId = static_cast<uint32_t>(kernelIndex);
+                kernel.start = timestamp;
+                kernel.end = timestamp + 5000;
+                timestamp += 6000;
+                kernelIndex++;
+                return kernel;
+            });
+            gmpStubAddRanges(kernelsInRange);
+            start = Clock::now();
+            profiler->popRange(rangeName(range, config), GmpProfileType::CONCURRENT_KERNEL);
+            double popNs = elapsedNs(start);
+
+            GmpStreamingStats stats = profiler->getStreamingStats();
+            if (stats.windows == windows)
+            {
+                rangeNs += popNs;
+                continue;
+            }
+            flushNs += popNs;
+            windows = stats.windows;
+            imageRange = 0;
+            GmpArenaStats arenaStats = profiler->getSessionArenaStats();
+            if (windows == 1)
+            {
+                windowChunks = arenaStats.chunks;
+            }
+            if (arenaStats.bytesInUse != 0 || arenaStats.chunks != windowChunks)
+            {
+                fprintf(stderr, "Window %zu left %zu bytes in the arena, or grew it to %zu chunks\n", windows,
+                        arenaStats.bytesInUse, arenaStats.chunks);
+                _exit(1);
+            }
+        }
+        // A memory range would be freed with its window, so pushing one
+        // writes the last window and stops streaming instead.
+        auto start = Clock::now();
+        profiler->pushRange("stream_memory", GmpProfileType::MEMORY);
+        flushNs += elapsedNs(start);
+        profiler->popRange("stream_memory", GmpProfileType::MEMORY);
+        GmpMemoryTimeline memoryTimeline = profiler->getMemoryFootprint();
+        const auto &footprints = memoryTimeline.getRangeFootprints();
+        if (footprints.size() != 1 || footprints[0].name != "stream_memory")
+        {
+            fprintf(stderr, "The memory range pushed while streaming was not kept for the end-of-run reports\n");
+            _exit(1);
+        }
+        profiler->closeStreaming();
+        printResult("push, records, pop (ns per kernel)", config.kernels, rangeNs);
+        printResult("window flush (ns per range)", config.ranges, flushNs);
+
+        GmpStreamingStats stats = profiler->getStreamingStats();
+        size_t expectedWindows = (config.ranges + WINDOW_RANGES - 1) / WINDOW_RANGES;
+        FILE *file = fopen(STREAM_FILE, "r");
+        if (!file || stats.windows != expectedWindows || stats.ranges != config.ranges)
+        {
+            fprintf(stderr, "Expected %zu windows of %zu ranges, got %zu windows of %zu ranges\n", expectedWindows,
+                    config.ranges, stats.windows, stats.ranges);
+            _exit(1);
+        }
+        char *line = nullptr;
+        size_t lineCapacity = 0;
+        std::vector<std::string> metricNames;
+        if (getline(&line, &lineCapacity, file) > 0)
+        {
+            std::string header(line, strcspn(line, "\n"));
+            size_t begin = 0;
+            for (size_t column = 0; begin <= header.size(); ++column)
+            {
+                size_t end = std::min(header.find(',', begin), header.size());
+                if (column >= 5)
+                {
+                    metricNames.push_back(header.substr(begin, end - begin));
+                }
+                begin = end + 1;
+            }
+        }
+        size_t rows = 0;
+        while (getline(&line, &lineCapacity, file) > 0)
+        {
+            size_t rangeIndex = 0;
+            size_t kernels = 0;
+            double metric = 0.0;
+            if (sscanf(line, "%zu,%*[^,],%*u,%*u,%zu,%lf", &rangeIndex, &kernels, &metric) != 3 || rangeIndex != rows ||
+                rows >= expected.size() || metric != expected[rows])
+            {
+                fprintf(stderr, "Stream row %zu does not match its range: %s", rows, line);
+                _exit(1);
+            }
+            rows++;
+        }
+        free(line);
+        fclose(file);
+        if (rows != config.ranges)
+        {
+            fprintf(stderr, "Stream file holds %zu rows instead of %zu\n", rows, config.ranges);
+            _exit(1);
+        }
+
+        // A process killed in the middle of an append leaves a torn last line.
+        file = fopen(STREAM_FILE, "a");
+        fputs("1000,range_torn,12", file);
+        fclose(file);
+        GmpStreamWriter writer;
+        size_t committedSize = stats.bytesWritten;
+        struct stat fileStat{};
+        if (writer.open(STREAM_FILE, metricNames) != GmpResult::SUCCESS || stat(STREAM_FILE, &fileStat) != 0 ||
+            static_cast<uint64_t>(fileStat.st_size) != writer.getSize() || writer.getSize() <= committedSize)
+        {
+            fprintf(stderr, "Reopening the stream file did not cut the torn line\n");
+            _exit(1);
+        }
+        // Rows appended by a later run continue the range index.
+        size_t reopenedIndex = writer.getNextRangeIndex();
+        writer.appendRange("range_reopened", 0, 0, 0, {});
+        writer.commit();
+        writer.close();
+        if (reopenedIndex != config.ranges || writer.open(STREAM_FILE, metricNames) != GmpResult::SUCCESS ||
+            writer.getNextRangeIndex() != config.ranges + 1)
+        {
+            fprintf(stderr, "Reopened stream file continues at range %zu instead of %zu\n", reopenedIndex, config.ranges);
+            _exit(1);
+        }
+        writer.close();
+        printf("  %zu ranges in %zu windows, %.1f KB streamed, arena held at %zu chunks (%.1f MB)\n", stats.ranges,
+               stats.windows, stats.bytesWritten / 1e3, windowChunks,
+               windowChunks * GmpArena::CHUNK_SIZE / 1e6);
+    }
+
+    // pushRange/popRange pairs with the GPU calls stubbed out.
+    struct PushPopCounts
+    {
+        GmpStubCallCounts calls;
+        size_t allocations;
+    };
+
+    PushPopCounts getPushPopCounts()
+    {
+        return {gmpStubGetCallCounts(), allocationCount};
+    }
+
+    void printPushPopCounts(const PushPopCounts &before, size_t pairs)
+    {
+        const GmpStubCallCounts &after = gmpStubGetCallCounts();
+        printf("  per pair: %.1f cudaDeviceSynchronize, %.1f cuptiActivityFlushAll, %.1f range profiler push/pop, "
+               "%.1f allocations\n",
+               double(after.deviceSynchronize - before.calls.deviceSynchronize) / pairs,
+               double(after.activityFlushAll - before.calls.activityFlushAll) / pairs,
+               double(after.rangeProfilerPushRange - before.calls.rangeProfilerPushRange +
+                      after.rangeProfilerPopRange - before.calls.rangeProfilerPopRange) / pairs,
+               double(allocationCount - before.allocations) / pairs);
+    }
+
+    template <GmpProfileType Type>
+    void scopedRange()
+    {
+        GMP_SCOPED_RANGE("bench_scoped_range", Type);
+    }
+
+    void runPushPop(const BenchConfig &config)
+    {
+        GmpProfiler *profiler = initProfiler(config);
+        printHeader("push/pop (ns per pair)");
+        const std::pair<const char *, GmpProfileType> types[] = {
+            {"kernel range push/pop", GmpProfileType::CONCURRENT_KERNEL},
+            {"memory range push/pop", GmpProfileType::MEMORY},
+        };
+        for (const auto &type : types)
+        {
+            PushPopCounts before = getPushPopCounts();
+            auto start = Clock::now();
+            for (size_t i = 0; i < config.iterations; ++i)
+            {
+                const std::string &name = rangeName(i, config);
+                profiler->pushRange(name, type.second);
+                profiler->popRange(name, type.second);
+            }
+            printResult(type.first, config.iterations, elapsedNs(start));
+            printPushPopCounts(before, config.iterations);
+        }
+
+        // GMP_SCOPED_RANGE pushes an interned name: the remaining
+        // allocations are the session of every range.
+        const std::pair<const char *, void (*)()> scopedCases[] = {
+            {"kernel GMP_SCOPED_RANGE", scopedRange<GmpProfileType::CONCURRENT_KERNEL>},
+            {"memory GMP_SCOPED_RANGE", scopedRange<GmpProfileType::MEMORY>},
+        };
+        for (const auto &scoped : scopedCases)
+        {
+            PushPopCounts before = getPushPopCounts();
+            auto start = Clock::now();
+            for (size_t i = 0; i < config.iterations; ++i)
+            {
+                scoped.second();
+            }
+            printResult(scoped.first, config.iterations, elapsedNs(start));
+            printPushPopCounts(before, config.iterations);
+        }
+
+        // Instrumentation left in place with the profiler disabled, where
+        // the name is the only cost.
+        profiler->disable();
+        PushPopCounts before = getPushPopCounts();
+        auto start = Clock::now();
+        for (size_t i = 0; i < config.iterations; ++i)
+        {
+            profiler->pushRange("bench_literal_range", GmpProfileType::CONCURRENT_KERNEL);
+            profiler->popRange("bench_literal_range", GmpProfileType::CONCURRENT_KERNEL);
+        }
+        printResult("string literal push/pop, disabled", config.iterations, elapsedNs(start));
+        printPushPopCounts(before, config.iterations);
+
+        before = getPushPopCounts();
+        start = Clock::now();
+        for (size_t i = 0; i < config.iterations; ++i)
+        {
+            scopedRange<GmpProfileType::CONCURRENT_KERNEL>();
+        }
+        printResult("GMP_SCOPED_RANGE, disabled", config.iterations, elapsedNs(start));
+        printPushPopCounts(before, config.iterations);
+        profiler->enable();
+    }
+
+    constexpr const char *SPILL_FILE = "capture.spill";
+
+    // Capture mode: the completion callback only appends the raw buffers to the spill file.
+    void runCapture(const BenchConfig &config)
+    {
+        GmpProfiler *profiler = GmpProfiler::getInstance();
+        profiler->setSpillFile(SPILL_FILE);
+        initProfiler(config);
+        auto kernelNames = makeKernelNames(config.kernelNames);
+
+        printHeader("capture to spill file");
+        ActivityTimes times = deliverActivity(profiler, config, kernelNames);
+        printResult("kernel record (CONCURRENT_KERNEL)", config.kernels, times.kernelNs);
+        printResult("memory record (MEMORY2)", times.memoryRecords, times.memoryNs);
+
+        gmpStubSetRangeCount(config.kernels);
+        profiler->stopRangeProfiling();
+        profiler->decodeCounterData();
+        auto start = Clock::now();
+        profiler->closeSpill();
+        printResult("close spill file (ns per kernel)", config.kernels, elapsedNs(start));
+    }
+
+    // Replay of the file written by the capture scenario.
+    void runReplay(const BenchConfig &config)
+    {
+        GmpProfiler *profiler = GmpProfiler::getInstance();
+        profiler->setKernelDetail(config.keepKernelDetail);
+        gmpStubSetRangeCount(config.kernels);
+
+        printHeader("replay of spill file (ns per record)");
+        auto start = Clock::now();
+        if (profiler->replaySpill(SPILL_FILE) != GmpResult::SUCCESS)
+        {
+            fprintf(stderr, "Replay needs the capture scenario to run first\n");
+            _exit(1);
+        }
+        printResult("replaySpill", config.kernels + config.memRecords, elapsedNs(start));
+
+        // The first report after the replay evaluates the counter data itself.
+        start = Clock::now();
+        auto hotKernels = profiler->getHotKernelTable();
+        printResult("evaluate counter data + hot kernel table", config.kernels, elapsedNs(start));
+        size_t measuredLaunchCount = hotKernels.getTotals().measuredLaunchCount;
+        if (config.keepKernelDetail && measuredLaunchCount != config.kernels)
+        {
+            fprintf(stderr, "Hot kernel table has metrics for %zu of %zu launches\n", measuredLaunchCount, config.kernels);
+            _exit(1);
+        }
+
+        start = Clock::now();
+        auto stats = profiler->getRangeStatistics(GmpOutputKernelReduction::SUM);
+        printResult("range statistics", config.kernels, elapsedNs(start));
+        printf("  %zu range names, %zu kernels in the hot kernel table\n", stats.getStats().size(), hotKernels.size());
+    }
+
+    // A minimal NVTX client: the callback tables NVTX hands to an injection
+    // library, called the way the NVTX headers call them.
+    struct StubNvtxClient
+    {
+        NvtxFunctionPointer core[NVTX_CBID_CORE_SIZE] = {};
+        NvtxFunctionPointer core2[NVTX_CBID_CORE2_SIZE] = {};
+        NvtxFunctionPointer *coreSlots[NVTX_CBID_CORE_SIZE] = {};
+        NvtxFunctionPointer *core2Slots[NVTX_CBID_CORE2_SIZE] = {};
+
+        StubNvtxClient()
+        {
+            for (size_t i = 1; i < NVTX_CBID_CORE_SIZE; ++i)
+            {
+                coreSlots[i] = &core[i];
+            }
+            for (size_t i = 1; i < NVTX_CBID_CORE2_SIZE; ++i)
+            {
+                core2Slots[i] = &core2[i];
+            }
+        }
+
+        template <typename Function>
+        Function slot(NvtxFunctionPointer function) const
+        {
+            return reinterpret_cast<Function>(function);
+        }
+    };
+
+    StubNvtxClient stubNvtx;
+
+    int NVTX_API stubGetModuleFunctionTable(NvtxCallbackModule module, NvtxFunctionTable *table, unsigned int *size)
+    {
+        if (module == NVTX_CB_MODULE_CORE)
+        {
+            *table = stubNvtx.coreSlots;
+            *size = NVTX_CBID_CORE_SIZE;
+            return 1;
+        }
+        if (module == NVTX_CB_MODULE_CORE2)
+        {
+            *table = stubNvtx.core2Slots;
+            *size = NVTX_CBID_CORE2_SIZE;
+            return 1;
+        }
+        return 0;
+    }
+
+    const void *NVTX_API stubGetExportTable(uint32_t exportTableId)
+    {
+        static const NvtxExportTableCallbacks callbacks = {sizeof(NvtxExportTableCallbacks), stubGetModuleFunctionTable};
+        return exportTableId == NVTX_ETID_CALLBACKS ? &callbacks : nullptr;
+    }
+
+    // NVTX ranges of an uninstrumented application mapped through GmpNvtxBridge.
+    void runNvtx(const BenchConfig &config)
+    {
+        GmpProfiler *profiler = initProfiler(config);
+        GmpNvtxBridge bridge(profiler);
+        bridge.addRangeFilter("skip", GmpFilterAction::EXCLUDE);
+        if (bridge.attach(stubGetExportTable) != GmpResult::SUCCESS)
+        {
+            _exit(1);
+        }
+        auto pushA = stubNvtx.slot<int (*)(const char *)>(stubNvtx.core[NVTX_CBID_CORE_RangePushA]);
+        auto pop = stubNvtx.slot<int (*)()>(stubNvtx.core[NVTX_CBID_CORE_RangePop]);
+        auto createDomain = stubNvtx.slot<nvtxDomainHandle_t (*)(const char *)>(stubNvtx.core2[NVTX_CBID_CORE2_DomainCreateA]);
+        auto registerString = stubNvtx.slot<nvtxStringHandle_t (*)(nvtxDomainHandle_t, const char *)>(
+            stubNvtx.core2[NVTX_CBID_CORE2_DomainRegisterStringA]);
+        auto domainPushEx = stubNvtx.slot<int (*)(nvtxDomainHandle_t, const nvtxEventAttributes_t *)>(
+            stubNvtx.core2[NVTX_CBID_CORE2_DomainRangePushEx]);
+        auto domainPop = stubNvtx.slot<int (*)(nvtxDomainHandle_t)>(stubNvtx.core2[NVTX_CBID_CORE2_DomainRangePop]);
+
+        printHeader("NVTX injection (ns per push/pop pair)");
+        std::vector<std::string> names;
+        for (size_t i = 0; i < config.rangeNames; ++i)
+        {
+            names.push_back(rangeName(i, config));
+        }
+        auto start = Clock::now();
+        for (size_t i = 0; i < config.iterations; ++i)
+        {
+            pushA(names[i % names.size()].c_str());
+            pop();
+        }
+        printResult("nvtxRangePushA/Pop, mapped", config.iterations, elapsedNs(start));
+
+        nvtxDomainHandle_t domain = createDomain("app");
+        std::vector<nvtxStringHandle_t> handles;
+        for (const auto &name : names)
+        {
+            handles.push_back(registerString(domain, name.c_str()));
+        }
+        nvtxEventAttributes_t attributes{};
+        attributes.version = NVTX_VERSION;
+        attributes.size = NVTX_EVENT_ATTRIB_STRUCT_SIZE;
+        attributes.messageType = NVTX_MESSAGE_TYPE_REGISTERED;
+        start = Clock::now();
+        for (size_t i = 0; i < config.iterations; ++i)
+        {
+            attributes.message.registered = handles[i % handles.size()];
+            domainPushEx(domain, &attributes);
+            domainPop(domain);
+        }
+        printResult("nvtxDomainRangePushEx/Pop, registered", config.iterations, elapsedNs(start));
+
+        start = Clock::now();
+        for (size_t i = 0; i < config.iterations; ++i)
+        {
+            pushA("skip_me");
+            pop();
+        }
+        printResult("nvtxRangePushA/Pop, filtered out", config.iterations, elapsedNs(start));
+
+        // An inner range is not a GMP range of its own, and the kernels after
+        // it still belong to the outer one.
+        std::string kernelName = "nvtx_kernel";
+        uint64_t timestamp = 1000000;
+        auto launchKernel = [&]()
+        {
+            deliverRecords(1, config, [&](size_t)
+            {
+                CUpti_ActivityKernel8 kernel{};
+                kernel.kind = CUPTI_ACTIVITY_KIND_CONCURRENT_KERNEL;
+                kernel.name = kernelName.c_str();
+                kernel.gridX = kernel.gridY = kernel.gridZ = 1;
+                kernel.blockX = kernel.blockY = kernel.blockZ = 1;
+                kernel.start = timestamp;
+                kernel.end = timestamp + 1000;
+                timestamp += 2000;
+                return kernel;
+            });
+            gmpStubAddRanges(1);
+        };
+        size_t ignoredBefore = bridge.getIgnoredRangeCount();
+        pushA("nvtx_step");
+        launchKernel();
+        pushA("nvtx_forward");
+        launchKernel();
+        pop();
+        launchKernel();
+        pop();
+        size_t stepKernels = 0;
+        size_t forwardRanges = 0;
+        for (const auto &timeline : profiler->getKernelTimeline())
+        {
+            stepKernels += timeline.name == "nvtx_step" ? timeline.kernelCount : 0;
+            forwardRanges += timeline.name == "nvtx_forward" ? 1 : 0;
+        }
+        if (stepKernels != 3 || forwardRanges != 0 || bridge.getIgnoredRangeCount() != ignoredBefore + 1)
+        {
+            fprintf(stderr, "Nested NVTX ranges left %zu kernels in the outer range and %zu inner ranges\n", stepKernels,
+                    forwardRanges);
+            _exit(1);
+        }
+
+        size_t sessions = 0;
+        GmpRangeStatsTable statsTable = profiler->getRangeStatistics();
+        for (const auto &stats : statsTable.getStats())
+        {
+            sessions += stats.iterationCount;
+        }
+        printf("  %zu ranges mapped, %zu ignored, %zu kernel sessions recorded\n", bridge.getMappedRangeCount(),
+               bridge.getIgnoredRangeCount(), sessions);
+    }
+
+    // Memcpy and memset records of TRANSFER ranges, with a kernel overlapping
+    // every other copy. The reported statistics are checked against the
+    // values the synthetic records were built with.
+    void runTransfers(const BenchConfig &config)
+    {
+        GmpProfiler *profiler = initProfiler(config);
+        constexpr size_t TRANSFER_RANGES = 100;
+        constexpr uint64_t PERIOD_NS = 1000;
+        constexpr uint64_t COPY_NS = 500;
+        constexpr uint64_t KERNEL_OFFSET_NS = 250;
+        const uint8_t copyKinds[] = {CUPTI_ACTIVITY_MEMCPY_KIND_HTOD, CUPTI_ACTIVITY_MEMCPY_KIND_DTOH,
+                                     CUPTI_ACTIVITY_MEMCPY_KIND_DTOD, GmpTransferData::MEMSET_KIND};
+
+        size_t transfersInRange = config.memRecords / TRANSFER_RANGES;
+        size_t kernelsInRange = (transfersInRange + 1) / 2;
+        uint64_t expectedBytes = 0;
+        size_t expectedPageable = 0;
+        size_t expectedCopies = 0;
+        for (size_t i = 0; i < transfersInRange; ++i)
+        {
+            expectedBytes += uint64_t(1) << (10 + i % 12);
+            expectedPageable += i % 8 == 0 ? 1 : 0;
+            expectedCopies += copyKinds[i % 4] != GmpTransferData::MEMSET_KIND ? 1 : 0;
+        }
+
+        printHeader("memcpy/memset activity");
+        double decodeNs = 0.0;
+        uint64_t timestamp = 1000000;
+        GmpSyntheticActivityBuffer synthetic;
+        for (size_t range = 0; range < TRANSFER_RANGES; ++range)
+        {
+            profiler->pushRange(rangeName(range, config), GmpProfileType::TRANSFER);
+            for (size_t first = 0; first < transfersInRange; first += config.recordsPerBuffer)
+            {
+                synthetic.clear();
+                size_t last = std::min(transfersInRange, first + config.recordsPerBuffer);
+                for (size_t i = first; i < last; ++i)
+                {
+                    uint64_t start = timestamp + i * PERIOD_NS;
+                    uint8_t copyKind = copyKinds[i % 4];
+                    if (copyKind == GmpTransferData::MEMSET_KIND)
+                    {
+                        CUpti_ActivityMemset4 memset{};
+                        memset.kind = CUPTI_ACTIVITY_KIND_MEMSET;
+                        memset.bytes = uint64_t(1) << (10 + i % 12);
+                        memset.start = start;
+                        memset.end = start + COPY_NS;
+                        memset.memoryKind = CUPTI_ACTIVITY_MEMORY_KIND_DEVICE;
+                        synthetic.append(memset);
+                    }
+                    else
+                    {
+                        // Every 8th copy is a host to device copy from pageable memory.
+                        CUpti_ActivityMemcpy5 memcpy{};
+                        memcpy.kind = CUPTI_ACTIVITY_KIND_MEMCPY;
+                        memcpy.copyKind = copyKind;
+                        memcpy.srcKind = i % 8 == 0 ? CUPTI_ACTIVITY_MEMORY_KIND_PAGEABLE : CUPTI_ACTIVITY_MEMORY_KIND_DEVICE;
+                        memcpy.dstKind = copyKind == CUPTI_ACTIVITY_MEMCPY_KIND_DTOH ? CUPTI_ACTIVITY_MEMORY_KIND_PINNED
+                                                                                     : CUPTI_ACTIVITY_MEMORY_KIND_DEVICE;
+                        memcpy.flags = CUPTI_ACTIVITY_FLAG_MEMCPY_ASYNC;
+                        memcpy.bytes = uint64_t(1) << (10 + i % 12);
+                        memcpy.start = start;
+                        memcpy.end = start + COPY_NS;
+                        synthetic.append(memcpy);
+                    }
+                    if (i % 2 == 0)
+                    {
+                        CUpti_ActivityKernel8 kernel{};
+                        kernel.kind = CUPTI_ACTIVITY_KIND_CONCURRENT_KERNEL;
+                        kernel.name = "overlapped_kernel";
+                        kernel.start = start + KERNEL_OFFSET_NS;
+                        kernel.end = start + KERNEL_OFFSET_NS + COPY_NS;
+                        synthetic.append(kernel);
+                    }
+                }
+                size_t validSize = 0;
+                uint8_t *buffer = synthetic.copy(validSize);
+                auto start = Clock::now();
+                gmpStubCompleteBuffer(buffer, validSize);
+                decodeNs += elapsedNs(start);
+            }
+            profiler->popRange(rangeName(range, config), GmpProfileType::TRANSFER);
+            timestamp += transfersInRange * PERIOD_NS + PERIOD_NS;
+        }
+        size_t records = TRANSFER_RANGES * (transfersInRange + kernelsInRange);
+        printResult("memcpy, memset or kernel record", records, decodeNs);
+
+        auto start = Clock::now();
+        auto allStats = profiler->getTransferStats();
+        printResult("transfer statistics (ns per transfer)", TRANSFER_RANGES * transfersInRange, elapsedNs(start));
+
+        // Copies start every PERIOD_NS, kernels cover the second half of the even ones.
+        size_t evenCopies = 0;
+        for (size_t i = 0; i < transfersInRange; i += 2)
+        {
+            evenCopies += copyKinds[i % 4] != GmpTransferData::MEMSET_KIND ? 1 : 0;
+        }
+        for (const auto &stats : allStats)
+        {
+            if (stats.transferCount != transfersInRange || stats.totalBytes != expectedBytes ||
+                stats.pageableCount != expectedPageable || stats.kernelCount != kernelsInRange ||
+                stats.copyBusyNs != expectedCopies * COPY_NS ||
+                stats.overlapNs != evenCopies * (COPY_NS - KERNEL_OFFSET_NS))
+            {
+                fprintf(stderr, "Unexpected transfer statistics for range %s\n", stats.name.c_str());
+                _exit(1);
+            }
+        }
+        if (allStats.size() != TRANSFER_RANGES)
+        {
+            fprintf(stderr, "Expected %zu transfer ranges, got %zu\n", TRANSFER_RANGES, allStats.size());
+            _exit(1);
+        }
+        if (!allStats.empty())
+        {
+            const auto &stats = allStats.front();
+            printf("  per range: %zu transfers, %.1f MB, %zu pageable, copy busy %.1f us, %.1f%% overlapped, "
+                   "HtoD %.2f GB/s\n",
+                   stats.transferCount, stats.totalBytes / 1e6, stats.pageableCount, stats.copyBusyNs / 1000.0,
+                   100.0 * stats.overlapFraction(), stats.direction(GmpTransferDirection::HOST_TO_DEVICE).bandwidth());
+        }
+    }
+
+    // Memory ranges that release the previous range's last block, allocate,
+    // release and allocate again one address, and allocate a block released
+    // by the next range; then kernel ranges of overlapping kernel pairs
+    // separated by idle gaps. The footprints and the kernel timeline are
+    // checked against the values the records were built with.
+    void runTimelines(const BenchConfig &config)
+    {
+        GmpProfiler *profiler = initProfiler(config);
+        constexpr size_t TIMELINE_RANGES = 100;
+        constexpr uint64_t REUSED_BYTES = 256;    // Allocated twice, live at the end of its range
+        constexpr uint64_t TEMPORARY_BYTES = 1024; // Released in its range
+        constexpr uint64_t CARRIED_BYTES = 512;   // Released by the next range
+        uint64_t timestamp = 1000000;
+        auto memoryRecord = [&timestamp](uint64_t address, uint64_t bytes, bool allocation)
+        {
+            CUpti_ActivityMemory4 memory{};
+            memory.kind = CUPTI_ACTIVITY_KIND_MEMORY2;
+            memory.memoryOperationType = allocation ? CUPTI_ACTIVITY_MEMORY_OPERATION_TYPE_ALLOCATION
+                                                    : CUPTI_ACTIVITY_MEMORY_OPERATION_TYPE_RELEASE;
+            memory.memoryKind = CUPTI_ACTIVITY_MEMORY_KIND_DEVICE;
+            memory.address = address;
+            memory.bytes = bytes;
+            memory.timestamp = timestamp;
+            memory.streamId = CUPTI_INVALID_STREAM_ID;
+            memory.contextId = 1;
+            timestamp += 1000;
+            return memory;
+        };
+
+        printHeader("memory and kernel timelines");
+        GmpSyntheticActivityBuffer synthetic;
+        auto deliver = [&synthetic]()
+        {
+            size_t validSize = 0;
+            uint8_t *buffer = synthetic.copy(validSize);
+            gmpStubCompleteBuffer(buffer, validSize);
+            synthetic.clear();
+        };
+        for (size_t range = 0; range < TIMELINE_RANGES; ++range)
+        {
+            uint64_t base = 0x700000000000ull + range * 0x10000;
+            profiler->pushRange(rangeName(range, config), GmpProfileType::MEMORY);
+            if (range > 0)
+            {
+                synthetic.append(memoryRecord(base - 0x10000 + 0x2000, CARRIED_BYTES, false));
+            }
+            synthetic.append(memoryRecord(base, REUSED_BYTES, true));
+            synthetic.append(memoryRecord(base, REUSED_BYTES, false));
+            synthetic.append(memoryRecord(base, REUSED_BYTES, true));
+            synthetic.append(memoryRecord(base + 0x1000, TEMPORARY_BYTES, true));
+            synthetic.append(memoryRecord(base + 0x1000, TEMPORARY_BYTES, false));
+            synthetic.append(memoryRecord(base + 0x2000, CARRIED_BYTES, true));
+            deliver();
+            profiler->popRange(rangeName(range, config), GmpProfileType::MEMORY);
+        }
+
+        // Pairs of kernels overlapping by OVERLAP_NS, one pair every PAIR_PERIOD_NS.
+        constexpr size_t PAIRS = 50;
+        constexpr uint64_t KERNEL_NS = 1000;
+        constexpr uint64_t OVERLAP_NS = 500;
+        constexpr uint64_t PAIR_PERIOD_NS = 3000;
+        for (size_t range = 0; range < TIMELINE_RANGES; ++range)
+        {
+            profiler->pushRange(rangeName(range, config), GmpProfileType::CONCURRENT_KERNEL);
+            uint64_t rangeStart = timestamp;
+            for (size_t pair = 0; pair < PAIRS; ++pair)
+            {
+                for (size_t second = 0; second < 2; ++second)
+                {
+                    CUpti_ActivityKernel8 kernel{};
+                    kernel.kind = CUPTI_ACTIVITY_KIND_CONCURRENT_KERNEL;
+                    kernel.name = "timeline_kernel";
+                    kernel.streamId = static_cast<uint32_t>(second);
+                    kernel.start = rangeStart + pair * PAIR_PERIOD_NS + second * (KERNEL_NS - OVERLAP_NS);
+                    kernel.end = kernel.start + KERNEL_NS;
+                    synthetic.append(kernel);
+                }
+            }
+            deliver();
+            profiler->popRange(rangeName(range, config), GmpProfileType::CONCURRENT_KERNEL);
+            timestamp += PAIRS * PAIR_PERIOD_NS;
+        }
+
+        auto start = Clock::now();
+        auto footprint = profiler->getMemoryFootprint();
+        printResult("memory footprint (ns per memory record)", TIMELINE_RANGES * 6, elapsedNs(start));
+        const auto &footprints = footprint.getRangeFootprints();
+        for (size_t range = 0; range < footprints.size(); ++range)
+        {
+            const auto &rangeFootprint = footprints[range];
+            uint64_t liveAtEnd = (range + 1) * REUSED_BYTES + CARRIED_BYTES;
+            uint64_t leakedBytes = 0;
+            for (const auto &allocation : rangeFootprint.leakedAllocations)
+            {
+                leakedBytes += allocation.bytes;
+            }
+            if (rangeFootprint.allocatedBytes != 2 * REUSED_BYTES + TEMPORARY_BYTES + CARRIED_BYTES ||
+                rangeFootprint.releasedBytes != REUSED_BYTES + TEMPORARY_BYTES + (range > 0 ? CARRIED_BYTES : 0) ||
+                rangeFootprint.liveBytesAtEnd != liveAtEnd ||
+                rangeFootprint.peakLiveBytes != (range + 1) * REUSED_BYTES + TEMPORARY_BYTES ||
+                rangeFootprint.highWaterMark != rangeFootprint.peakLiveBytes ||
+                rangeFootprint.leakedAllocations.size() != 2 || leakedBytes != REUSED_BYTES + CARRIED_BYTES)
+            {
+                fprintf(stderr, "Unexpected footprint for memory range %zu: %zu allocations outlive it\n", range,
+                        rangeFootprint.leakedAllocations.size());
+                _exit(1);
+            }
+        }
+        if (footprints.size() != TIMELINE_RANGES || footprint.getUnmatchedReleaseCount() != 0)
+        {
+            fprintf(stderr, "Expected %zu memory ranges without unmatched releases, got %zu\n", TIMELINE_RANGES,
+                    footprints.size());
+            _exit(1);
+        }
+
+        start = Clock::now();
+        auto kernelTimeline = profiler->getKernelTimeline();
+        printResult("kernel timeline (ns per kernel)", TIMELINE_RANGES * PAIRS * 2, elapsedNs(start));
+        uint64_t pairNs = 2 * KERNEL_NS - OVERLAP_NS;
+        for (const auto &stats : kernelTimeline)
+        {
+            if (stats.kernelCount != 2 * PAIRS || stats.spanNs != (PAIRS - 1) * PAIR_PERIOD_NS + pairNs ||
+                stats.busyNs != PAIRS * pairNs || stats.overlapNs != PAIRS * OVERLAP_NS || stats.maxConcurrency != 2 ||
+                stats.idleGapCount != PAIRS - 1 || stats.longestGaps.empty() ||
+                stats.longestGaps.front().duration() != PAIR_PERIOD_NS - pairNs)
+            {
+                fprintf(stderr, "Unexpected kernel timeline for range %s\n", stats.name.c_str());
+                _exit(1);
+            }
+        }
+        if (kernelTimeline.size() != TIMELINE_RANGES)
+        {
+            fprintf(stderr, "Expected %zu kernel ranges, got %zu\n", TIMELINE_RANGES, kernelTimeline.size());
+            _exit(1);
+        }
+        printf("  per memory range: %zu allocations outlive it, peak %.1f KB; per kernel range: %.0f%% busy, "
+               "max concurrency %u\n",
+               footprints.back().leakedAllocations.size(), footprints.back().peakLiveBytes / 1e3,
+               100.0 * kernelTimeline.back().busyFraction(), kernelTimeline.back().maxConcurrency);
+    }
+
+    // Unified memory counter records, attributed to a kernel range and the
+    // memory range nested in it. Both summaries must match the records.
+    void runUnifiedMemory(const BenchConfig &config)
+    {
+        GmpProfiler *profiler = GmpProfiler::getInstance();
+        profiler->setUnifiedMemoryCounters(true);
+        initProfiler(config);
+        constexpr size_t UM_RANGES = 100;
+        const CUpti_ActivityUnifiedMemoryCounterKind kinds[] = {
+            CUPTI_ACTIVITY_UNIFIED_MEMORY_COUNTER_KIND_BYTES_TRANSFER_HTOD,
+            CUPTI_ACTIVITY_UNIFIED_MEMORY_COUNTER_KIND_BYTES_TRANSFER_DTOH,
+            CUPTI_ACTIVITY_UNIFIED_MEMORY_COUNTER_KIND_CPU_PAGE_FAULT_COUNT,
+            CUPTI_ACTIVITY_UNIFIED_MEMORY_COUNTER_KIND_GPU_PAGE_FAULT,
+            CUPTI_ACTIVITY_UNIFIED_MEMORY_COUNTER_KIND_BYTES_TRANSFER_HTOD,
+            CUPTI_ACTIVITY_UNIFIED_MEMORY_COUNTER_KIND_GPU_PAGE_FAULT,
+            CUPTI_ACTIVITY_UNIFIED_MEMORY_COUNTER_KIND_THRASHING,
+            CUPTI_ACTIVITY_UNIFIED_MEMORY_COUNTER_KIND_BYTES_TRANSFER_DTOD,
+        };
+        constexpr size_t KIND_COUNT = sizeof(kinds) / sizeof(kinds[0]);
+        // Bytes for the migrations, fault or event counts otherwise.
+        auto valueOf = [&](size_t i)
+        {
+            switch (kinds[i % KIND_COUNT])
+            {
+            case CUPTI_ACTIVITY_UNIFIED_MEMORY_COUNTER_KIND_BYTES_TRANSFER_HTOD:
+            case CUPTI_ACTIVITY_UNIFIED_MEMORY_COUNTER_KIND_BYTES_TRANSFER_DTOH:
+            case CUPTI_ACTIVITY_UNIFIED_MEMORY_COUNTER_KIND_BYTES_TRANSFER_DTOD:
+                return uint64_t(4096) * (i % 16 + 1);
+            default:
+                return uint64_t(i % 4 + 1);
+            }
+        };
+
+        size_t recordsInRange = config.memRecords / UM_RANGES;
+        GmpUnifiedMemorySummary expected;
+        for (size_t i = 0; i < recordsInRange; ++i)
+        {
+            expected.add(kinds[i % KIND_COUNT], valueOf(i), 0, 1000);
+        }
+
+        printHeader("unified memory counters");
+        double decodeNs = 0.0;
+        uint64_t timestamp = 1000000;
+        for (size_t range = 0; range < UM_RANGES; ++range)
+        {
+            profiler->pushRange(rangeName(range, config), GmpProfileType::CONCURRENT_KERNEL);
+            profiler->pushRange(rangeName(range, config), GmpProfileType::MEMORY);
+            decodeNs += deliverRecords(recordsInRange, config, [&](size_t i)
+            {
+                CUpti_ActivityUnifiedMemoryCounter2 counter{};
+                counter.kind = CUPTI_ACTIVITY_KIND_UNIFIED_MEMORY_COUNTER;
+                counter.counterKind = kinds[i % KIND_COUNT];
+                counter.value = valueOf(i);
+                counter.start = timestamp;
+                counter.end = timestamp + 1000;
+                counter.address = 0x7f0000000000ull + i * 4096;
+                timestamp += 2000;
+                return counter;
+            });
+            profiler->popRange(rangeName(range, config), GmpProfileType::MEMORY);
+            profiler->popRange(rangeName(range, config), GmpProfileType::CONCURRENT_KERNEL);
+        }
+        printResult("unified memory counter record", UM_RANGES * recordsInRange, decodeNs);
+
+        auto ranges = profiler->getUnifiedMemorySummary();
+        if (ranges.size() != 2 * UM_RANGES)
+        {
+            fprintf(stderr, "Expected %zu ranges with a unified memory summary, got %zu\n", 2 * UM_RANGES, ranges.size());
+            _exit(1);
+        }
+        for (const auto &range : ranges)
+        {
+            const auto &summary = range.summary;
+            if (summary.bytesHtoD != expected.bytesHtoD || summary.bytesDtoH != expected.bytesDtoH ||
+                summary.bytesDtoD != expected.bytesDtoD || summary.migrationCount != expected.migrationCount ||
+                summary.migrationNs != expected.migrationNs || summary.cpuPageFaults != expected.cpuPageFaults ||
+                summary.gpuPageFaults != expected.gpuPageFaults || summary.gpuPageFaultGroups != expected.gpuPageFaultGroups ||
+                summary.thrashingEvents != expected.thrashingEvents)
+            {
+                fprintf(stderr, "Unexpected unified memory summary for range %s\n", range.name.c_str());
+                _exit(1);
+            }
+        }
+        printf("  per range: %llu migrations (%.1f MB HtoD, %.1f MB DtoH), %llu CPU and %llu GPU page faults, "
+               "%llu thrashing events\n",
+               (unsigned long long)expected.migrationCount, expected.bytesHtoD / 1e6, expected.bytesDtoH / 1e6,
+               (unsigned long long)expected.cpuPageFaults, (unsigned long long)expected.gpuPageFaults,
+               (unsigned long long)expected.thrashingEvents);
+    }
+
+    // GmpBottleneckClassifier on fixed metric vectors with known rankings,
+    // then its cost per kernel.
+    void runBottlenecks(const BenchConfig &config)
+    {
+        struct Case
+        {
+            const char *name;
+            std::unordered_map<std::string, double> metricValues;
+            std::vector<GmpBottleneckKind> expected;
+            const char *summary;
+        };
+        const Case cases[] = {
+            {"latency bound",
+             {{"smsp__cycles_active.sum", 1000}, {"smsp__inst_executed.sum", 200}, {"smsp__warps_active.sum", 8000},
+              {"smsp__warps_eligible.sum", 300}, {"smsp__warps_issue_stalled_long_scoreboard.sum", 5200},
+              {"smsp__warps_issue_stalled_mio_throttle.sum", 200}, {"smsp__warps_issue_stalled_math_pipe_throttle.sum", 100},
+              {"smsp__pipe_alu_cycles_active.sum", 100}, {"smsp__pipe_fma_cycles_active.sum", 150},
+              {"smsp__pipe_shared_cycles_active.sum", 50}},
+             {GmpBottleneckKind::ISSUE_IDLE, GmpBottleneckKind::MEMORY_LATENCY, GmpBottleneckKind::OTHER_STALL,
+              GmpBottleneckKind::FMA_PIPE_BUSY, GmpBottleneckKind::ALU_PIPE_BUSY, GmpBottleneckKind::SHARED_PIPE_BUSY},
+             "issue idle 80%, memory latency 65%, other stalls 29%"},
+            {"tensor kernel",
+             {{"smsp__cycles_active.sum", 1000}, {"smsp__inst_executed.sum", 900}, {"smsp__warps_active.sum", 4000},
+              {"smsp__warps_eligible.sum", 3000}, {"smsp__warps_issue_stalled_long_scoreboard.sum", 400},
+              {"smsp__warps_issue_stalled_mio_throttle.sum", 100}, {"smsp__warps_issue_stalled_math_pipe_throttle.sum", 1600},
+              {"smsp__pipe_alu_cycles_active.sum", 200}, {"smsp__pipe_fma_cycles_active.sum", 300},
+              {"smsp__pipe_tensor_cycles_active.sum", 200}},
+             {GmpBottleneckKind::TENSOR_PIPE_IDLE, GmpBottleneckKind::MATH_PIPE_THROTTLE, GmpBottleneckKind::FMA_PIPE_BUSY,
+              GmpBottleneckKind::OTHER_STALL, GmpBottleneckKind::ALU_PIPE_BUSY, GmpBottleneckKind::MEMORY_LATENCY,
+              GmpBottleneckKind::ISSUE_IDLE},
+             "tensor pipe idle 80%, math pipe throttle 40%, FMA pipe busy 30%"},
+            {"no metrics", {}, {}, ""},
+        };
+
+        GmpBottleneckClassifier classifier;
+        for (const auto &testCase : cases)
+        {
+            auto report = classifier.classify(testCase.name, GmpStallMetrics::fromMetrics(testCase.metricValues));
+            bool isExpected = report.ranked.size() == testCase.expected.size() && report.summary() == testCase.summary;
+            for (size_t i = 0; isExpected && i < report.ranked.size(); ++i)
+            {
+                isExpected = report.ranked[i].kind == testCase.expected[i];
+            }
+            if (!isExpected)
+            {
+                fprintf(stderr, "Unexpected bottlenecks for %s: %s\n", testCase.name, report.summary(SIZE_MAX).c_str());
+                _exit(1);
+            }
+        }
+
+        printHeader("bottleneck classification");
+        auto metrics = GmpStallMetrics::fromMetrics(cases[1].metricValues);
+        size_t rankedCount = 0;
+        auto start = Clock::now();
+        for (size_t i = 0; i < config.kernels; ++i)
+        {
+            metrics.longScoreboard = static_cast<double>(i % 4000);
+            rankedCount += classifier.classify("kernel", metrics).ranked.size();
+        }
+        printResult("classify one kernel", config.kernels, elapsedNs(start));
+        printf("  %s: %s\n  %s: %s\n", cases[0].name, cases[0].summary, cases[1].name, cases[1].summary);
+        if (rankedCount == 0)
+        {
+            _exit(1);
+        }
+    }
+
+    void printUsage(const char *program)
+    {
+        fprintf(stderr,
+                "Usage: %s [options] [pipeline] [sessions] [pushpop] [capture] [replay] [nvtx] [transfers] [unified]\n"
+                "          [bottlenecks] [timelines] [spill] [arena] [streaming]\n"
+                "\n"
+                "Runs every scenario when none is given. replay reads the file written by capture.\n"
+                "\n"
+                "Options:\n"
+                "  --kernels <n>             Kernel activity records (default 100000)\n"
+                "  --ranges <n>              Kernel ranges the records are spread over (default 1000)\n"
+                "  --range-names <n>         Distinct range names, ranges repeat them (default 100)\n"
+                "  --mem-records <n>         Memory, memcpy, memset and unified memory records (default 100000)\n"
+                "  --records-per-buffer <n>  Records per activity buffer (default 4096)\n"
+                "  --iterations <n>          Push/pop pairs (default 100000)\n"
+                "  --extra-metrics <n>       Metrics added on top of the default list (default 0)\n"
+                "  --no-kernel-detail        Reduce metrics per range while evaluating\n",
+                program);
+    }
+
+    bool parseSize(const char *text, size_t &value)
+    {
+        char *end = nullptr;
+        unsigned long long parsed = strtoull(text, &end, 10);
+        if (end == text || *end != '\0')
+        {
+            return false;
+        }
+        value = static_cast<size_t>(parsed);
+        return true;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    BenchConfig config;
+    std::vector<std::string> scenarios;
+    const std::pair<const char *, size_t *> sizeOptions[] = {
+        {"--kernels", &config.kernels},
+        {"--ranges", &config.ranges},
+        {"--range-names", &config.rangeNames},
+        {"--mem-records", &config.memRecords},
+        {"--records-per-buffer", &config.recordsPerBuffer},
+        {"--iterations", &config.iterations},
+        {"--extra-metrics", &config.extraMetrics},
+    };
+
+    for (int i = 1; i < argc; ++i)
+    {
+        bool matched = false;
+        for (const auto &option : sizeOptions)
+        {
+            if (strcmp(argv[i], option.first) == 0)
+            {
+                if (i + 1 >= argc || !parseSize(argv[i + 1], *option.second))
+                {
+                    fprintf(stderr, "%s expects a non-negative integer\n", option.first);
+                    return 2;
+                }
+                i++;
+                matched = true;
+            }
+        }
+        if (matched)
+        {
+            continue;
+        }
+        if (strcmp(argv[i], "--no-kernel-detail") == 0)
+        {
+            config.keepKernelDetail = false;
+        }
+        else if (strcmp(argv[i], "pipeline") == 0 || strcmp(argv[i], "sessions") == 0 || strcmp(argv[i], "pushpop") == 0 ||
+                 strcmp(argv[i], "capture") == 0 || strcmp(argv[i], "replay") == 0 || strcmp(argv[i], "nvtx") == 0 ||
+                 strcmp(argv[i], "transfers") == 0 || strcmp(argv[i], "unified") == 0 ||
+                 strcmp(argv[i], "bottlenecks") == 0 || strcmp(argv[i], "spill") == 0 || strcmp(argv[i], "arena") == 0 ||
+                 strcmp(argv[i], "streaming") == 0 || strcmp(argv[i], "timelines") == 0)
+        {
+            scenarios.push_back(argv[i]);
+        }
+        else
+        {
+            printUsage(argv[0]);
+            return strcmp(argv[i], "--help") == 0 ? 0 : 2;
+        }
+    }
+    if (config.ranges == 0 || config.rangeNames == 0 || config.recordsPerBuffer == 0 || config.kernelNames == 0)
+    {
+        fprintf(stderr, "--ranges, --range-names and --records-per-buffer must be positive\n");
+        return 2;
+    }
+    if (scenarios.empty())
+    {
+        scenarios = {"pipeline", "sessions", "pushpop", "capture", "replay", "nvtx", "transfers", "unified", "bottlenecks",
+                     "timelines", "spill", "arena", "streaming"};
+    }
+
+    // produceOutput and exportTrace write relative to the working directory.
+    char workDir[] = "/tmp/gmp_bench_XXXXXX";
+    if (!mkdtemp(workDir) || chdir(workDir) != 0 || mkdir("output", 0755) != 0)
+    {
+        fprintf(stderr, "Failed to create a working directory under /tmp\n");
+        return 2;
+    }
+
+    printf("kernels=%zu ranges=%zu range-names=%zu mem-records=%zu records-per-buffer=%zu iterations=%zu "
+           "extra-metrics=%zu kernel-detail=%s\n",
+           config.kernels, config.ranges, config.rangeNames, config.memRecords, config.recordsPerBuffer,
+           config.iterations, config.extraMetrics, config.keepKernelDetail ? "on" : "off");
+    fflush(stdout);
+
+    int exitCode = 0;
+    for (const auto &scenario : scenarios)
+    {
+        pid_t pid = fork();
+        if (pid == 0)
+        {
+            if (scenario == "pipeline")
+            {
+                runPipeline(config);
+            }
+            else if (scenario == "sessions")
+            {
+                runSessions(config);
+            }
+            else if (scenario == "pushpop")
+            {
+                runPushPop(config);
+            }
+            else if (scenario == "capture")
+            {
+                runCapture(config);
+            }
+            else if (scenario == "nvtx")
+            {
+                runNvtx(config);
+            }
+            else if (scenario == "transfers")
+            {
+                runTransfers(config);
+            }
+            else if (scenario == "unified")
+            {
+                runUnifiedMemory(config);
+            }
+            else if (scenario == "bottlenecks")
+            {
+                runBottlenecks(config);
+            }
+            else if (scenario == "spill")
+            {
+                runSpill(config);
+            }
+            else if (scenario == "arena")
+            {
+                runArena(config);
+            }
+            else if (scenario == "timelines")
+            {
+                runTimelines(config);
+            }
+            else if (scenario == "streaming")
+            {
+                runStreaming(config);
+            }
+            else
+            {
+                runReplay(config);
+            }
+            fflush(stdout);
+            _exit(0);
+        }
+        int status = 0;
+        if (pid < 0 || waitpid(pid, &status, 0) != pid || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+        {
+            fprintf(stderr, "Scenario %s failed\n", scenario.c_str());
+            exitCode = 1;
+        }
+    }
+
+    if (chdir("/") == 0)
+    {
+        std::error_code error;
+        std::filesystem::remove_all(workDir, error);
+    }
+    return exitCode;
+}
@@ -0,0 +1,147 @@
+#ifndef GMP_ACTIVITY_SPILL_H
+#define GMP_ACTIVITY_SPILL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "gmp/data_struct.h"
+
+// Capture mode file: raw CUPTI activity buffers and range boundaries are
+// appended as they arrive, and replayed later, possibly on another machine,
+// through the same sessions and reports as a live run.
+//
+// The file is a 64-byte header followed by 8-byte aligned entries, each a
+// GmpSpillEntryHeader and its payload. Entries are only counted once the
+// header's committed size covers them, so a run that crashes still leaves a
+// readable prefix.
+//
+// Activity records carry pointers to strings owned by CUPTI (kernel names,
+// memory symbols). They are not valid outside the process, so every distinct
+// pointer is written once as a STRING entry before the first buffer that
+// references it, and replay points the records at the saved copies.
+
+enum class GmpSpillEntryType : uint32_t
+{
+  BUFFER = 1,       // aux: stream id, payload: valid bytes of an activity buffer
+  STRING = 2,       // payload: uint64 pointer value, then the characters
+  PUSH_RANGE = 3,   // aux: GmpProfileType, payload: uint64 timestamp, then the name
+  POP_RANGE = 4,    // aux: GmpProfileType, payload: uint64 timestamp, then the name
+  COUNTER_DATA = 5, // payload: see GmpSpillCounterData
+};
+
+struct GmpSpillEntryHeader
+{
+  uint32_t type;
+  uint32_t aux;
+  uint64_t size; // Payload bytes, without the alignment padding
+};
+
+struct GmpSpillEntry
+{
+  GmpSpillEntryType type;
+  uint32_t aux;
+  const uint8_t *payload;
+  size_t size;
+};
+
+// Everything needed to evaluate the range profiler metrics offline with the
+// CUPTI profiler host, which does not need a GPU.
+struct GmpSpillCounterData
+{
+  GmpRangeMode rangeMode = GmpRangeMode::AUTO;
+  std::string chipName;
+  std::vector<std::string> metrics;
+  std::vector<uint8_t> counterAvailabilityImage;
+  std::vector<uint8_t> counterDataImage;
+};
+
+class GmpSpillWriter
+{
+public:
+  GmpSpillWriter() = default;
+  ~GmpSpillWriter();
+
+  GmpSpillWriter(const GmpSpillWriter &) = delete;
+  GmpSpillWriter &operator=(const GmpSpillWriter &) = delete;
+
+  GmpResult open(const std::string &path, uint32_t cuptiVersion);
+
+  bool isOpen() const { return mapping != nullptr; }
+
+  // Append the valid bytes of a completed activity buffer. Only the record
+  // headers are walked, to find strings that have not been written yet.
+  GmpResult appendBuffer(uint32_t streamId, uint8_t *buffer, size_t validSize);
+
+  GmpResult appendRange(GmpSpillEntryType type, GmpProfileType profileType, uint64_t timestamp,
+                        const std::string &name);
+
+  GmpResult appendCounterData(const GmpSpillCounterData &counterData);
+
+  // Truncate the file to the committed size and unmap it.
+  GmpResult close();
+
+  size_t getCommittedSize() const { return committedSize; }
+
+private:
+  // Append one entry whose payload is the concatenation of parts.
+  GmpResult appendEntry(GmpSpillEntryType type, uint32_t aux,
+                        std::initializer_list<std::pair<const void *, size_t>> parts);
+
+  GmpResult reserve(size_t bytes);
+
+  GmpResult appendString(const char *string);
+
+  std::mutex mutex;
+  int fd = -1;
+  uint8_t *mapping = nullptr;
+  size_t capacity = 0;
+  size_t committedSize = 0;
+  std::unordered_set<uint64_t> writtenStrings;
+};
+
+class GmpSpillReader
+{
+public:
+  GmpSpillReader() = default;
+  ~GmpSpillReader();
+
+  GmpSpillReader(const GmpSpillReader &) = delete;
+  GmpSpillReader &operator=(const GmpSpillReader &) = delete;
+
+  GmpResult open(const std::string &path);
+
+  uint32_t getCuptiVersion() const { return cuptiVersion; }
+
+  // Visit the committed entries in file order. Returns ERROR if an entry is
+  // malformed, after visiting the ones before it.
+  GmpResult forEachEntry(const std::function<void(const GmpSpillEntry &)> &visit) const;
+
+  static GmpResult parseString(const GmpSpillEntry &entry, uint64_t &pointer, std::string &string);
+
+  static GmpResult parseRange(const GmpSpillEntry &entry, uint64_t &timestamp, std::string &name);
+
+  static GmpResult parseCounterData(const GmpSpillEntry &entry, GmpSpillCounterData &counterData);
+
+private:
+  void unmap();
+
+  const uint8_t *mapping = nullptr;
+  size_t mappedSize = 0;
+  size_t committedSize = 0;
+  uint32_t cuptiVersion = 0;
+};
+
+// A malloc'ed copy of a BUFFER entry, owned like a CUPTI activity buffer,
+// whose string pointers are redirected to the strings read from the file.
+// Pointers without a saved string are set to an empty string.
+uint8_t *gmpSpillCopyBuffer(const GmpSpillEntry &entry, const std::unordered_map<uint64_t, std::string> &strings);
+
+#endif // GMP_ACTIVITY_SPILL_H
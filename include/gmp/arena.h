@@ -0,0 +1,376 @@
+#ifndef GMP_ARENA_H
+#define GMP_ARENA_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+struct GmpArenaStats
+{
+  size_t chunks = 0;      // Chunks obtained from malloc, kept across resets
+  size_t chunkBytes = 0;
+  size_t allocations = 0; // Blocks handed out, over every epoch
+  size_t reuses = 0;      // Of which taken from a free list
+  size_t bytesInUse = 0;  // Handed out in this epoch and not released
+  size_t resets = 0;
+};
+
+// Chunked monotonic allocator for sessions and their record blocks.
+// Blocks are carved from 64 KiB chunks by bumping an offset; sizes are
+// rounded up to a power of two, and a released block goes to the free list
+// of its size class, so records freed by a spill or a page-out are reused
+// without going back to malloc. reset() starts a new epoch: every block is
+// invalidated at once and the chunks are kept for the next one. Requests
+// larger than a chunk get a chunk of their own. Safe to use from the CUPTI
+// buffer thread.
+class GmpArena
+{
+public:
+  static constexpr size_t CHUNK_SIZE = 64 * 1024;
+  static constexpr size_t MIN_BLOCK_SIZE = 16;
+
+  GmpArena() = default;
+  ~GmpArena();
+
+  GmpArena(const GmpArena &) = delete;
+  GmpArena &operator=(const GmpArena &) = delete;
+
+  // A block of at least bytes, 16-byte aligned. nullptr if malloc fails.
+  void *allocate(size_t bytes);
+
+  // bytes must be the size the block was allocated with.
+  void release(void *block, size_t bytes);
+
+  // Invalidate every block and rewind the chunks for a new epoch.
+  void reset();
+
+  GmpArenaStats getStats() const;
+
+  // Bytes a block of the given size takes, i.e. its size class.
+  static size_t blockSize(size_t bytes);
+
+private:
+  static constexpr size_t CLASS_COUNT = 48;
+
+  struct Chunk
+  {
+    uint8_t *memory;
+    size_t size;
+  };
+
+  struct FreeBlock
+  {
+    FreeBlock *next;
+  };
+
+  static size_t sizeClass(size_t blockBytes);
+
+  // Next chunk with at least bytes free, reusing the ones of past epochs first.
+  bool advanceChunk(size_t bytes);
+
+  mutable std::mutex mutex;
+  std::vector<Chunk> chunks;
+  size_t currentChunk = 0; // Chunks before it are full for this epoch
+  size_t offset = 0;       // In chunks[currentChunk]
+  FreeBlock *freeLists[CLASS_COUNT] = {};
+  GmpArenaStats stats;
+};
+
+// Append-only list of trivially copyable records in blocks from a GmpArena,
+// or from malloc without one. Blocks are linked through a directory and
+// never move: the first holds FIRST_BLOCK records, each next one twice as
+// many up to BLOCK_RECORDS (about 4 KiB), so a short range costs a few
+// hundred bytes and a long one no reallocation or copy. Indexing maps to a
+// block and an offset in constant time.
+template <typename T>
+class GmpRecordList
+{
+  static_assert(std::is_trivially_copyable<T>::value, "GmpRecordList holds trivially copyable records");
+
+  static constexpr size_t floorPow2(size_t value)
+  {
+    size_t result = 1;
+    while (result * 2 <= value)
+    {
+      result *= 2;
+    }
+    return result;
+  }
+
+  static constexpr size_t log2(size_t value)
+  {
+    size_t result = 0;
+    while (value > 1)
+    {
+      value /= 2;
+      result++;
+    }
+    return result;
+  }
+
+public:
+  static constexpr size_t BLOCK_RECORDS = sizeof(T) * 8 <= 4096 ? floorPow2(4096 / sizeof(T)) : 8;
+  static constexpr size_t FIRST_BLOCK = BLOCK_RECORDS < 8 ? BLOCK_RECORDS : 8;
+  // Blocks before the first full-size one.
+  static constexpr size_t GROWING_BLOCKS = log2(BLOCK_RECORDS / FIRST_BLOCK);
+
+  explicit GmpRecordList(GmpArena *arena = nullptr) : arena(arena) {}
+
+  ~GmpRecordList() { clear(); }
+
+  GmpRecordList(const GmpRecordList &) = delete;
+  GmpRecordList &operator=(const GmpRecordList &) = delete;
+
+  GmpRecordList(GmpRecordList &&other) noexcept { swap(other); }
+
+  GmpRecordList &operator=(GmpRecordList &&other) noexcept
+  {
+    if (this != &other)
+    {
+      clear();
+      swap(other);
+    }
+    return *this;
+  }
+
+  // Only while empty, blocks go back to the allocator they came from.
+  void setArena(GmpArena *newArena)
+  {
+    clear();
+    arena = newArena;
+  }
+
+  void push_back(const T &value)
+  {
+    if (tail == tailEnd)
+    {
+      addBlock();
+    }
+    *tail++ = value;
+    count++;
+  }
+
+  // Append valueCount records copied from data, which needs no alignment.
+  void appendBytes(const void *data, size_t valueCount)
+  {
+    const auto *bytes = static_cast<const uint8_t *>(data);
+    while (valueCount > 0)
+    {
+      if (tail == tailEnd)
+      {
+        addBlock();
+      }
+      size_t n = std::min(valueCount, size_t(tailEnd - tail));
+      memcpy(static_cast<void *>(tail), bytes, n * sizeof(T));
+      tail += n;
+      bytes += n * sizeof(T);
+      count += n;
+      valueCount -= n;
+    }
+  }
+
+  const T &operator[](size_t index) const
+  {
+    size_t position = index + FIRST_BLOCK;
+    if (position < BLOCK_RECORDS)
+    {
+      // Position of the highest set bit, i.e. log2 of position / FIRST_BLOCK.
+      size_t block = 63 - __builtin_clzll(position) - log2(FIRST_BLOCK);
+      return blocks[block][position - (FIRST_BLOCK << block)];
+    }
+    return blocks[GROWING_BLOCKS + position / BLOCK_RECORDS - 1][position % BLOCK_RECORDS];
+  }
+
+  T &operator[](size_t index)
+  {
+    return const_cast<T &>(static_cast<const GmpRecordList &>(*this)[index]);
+  }
+
+  size_t size() const { return count; }
+
+  bool empty() const { return count == 0; }
+
+  // Bytes held by the blocks and the directory.
+  size_t getCapacityBytes() const
+  {
+    size_t bytes = directoryCapacity * sizeof(T *);
+    for (size_t block = 0; block < blockCount; ++block)
+    {
+      bytes += blockCapacity(block) * sizeof(T);
+    }
+    return bytes;
+  }
+
+  // Call func(records, count) for each block in order.
+  template <typename Func>
+  void forEachBlock(Func &&func) const
+  {
+    size_t remaining = count;
+    for (size_t block = 0; block < blockCount && remaining > 0; ++block)
+    {
+      size_t n = std::min(remaining, blockCapacity(block));
+      func(static_cast<const T *>(blocks[block]), n);
+      remaining -= n;
+    }
+  }
+
+  std::vector<T> toVector() const
+  {
+    std::vector<T> values;
+    values.reserve(count);
+    forEachBlock([&values](const T *records, size_t n)
+                 { values.insert(values.end(), records, records + n); });
+    return values;
+  }
+
+  // Free every block.
+  void clear()
+  {
+    for (size_t block = 0; block < blockCount; ++block)
+    {
+      freeBytes(blocks[block], blockCapacity(block) * sizeof(T));
+    }
+    if (blocks)
+    {
+      freeBytes(blocks, directoryCapacity * sizeof(T *));
+    }
+    blocks = nullptr;
+    blockCount = 0;
+    directoryCapacity = 0;
+    tail = tailEnd = nullptr;
+    count = 0;
+  }
+
+  class const_iterator
+  {
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const T *;
+    using reference = const T &;
+
+    const_iterator(const GmpRecordList *list, size_t index) : list(list), index(index)
+    {
+      settle();
+    }
+
+    reference operator*() const { return *current; }
+
+    pointer operator->() const { return current; }
+
+    const_iterator &operator++()
+    {
+      ++index;
+      if (++current == blockEnd)
+      {
+        block++;
+        settle();
+      }
+      return *this;
+    }
+
+    bool operator==(const const_iterator &other) const { return index == other.index; }
+
+    bool operator!=(const const_iterator &other) const { return index != other.index; }
+
+  private:
+    // Point at the start of block, only ever called on block boundaries.
+    void settle()
+    {
+      if (index < list->count && block < list->blockCount)
+      {
+        current = list->blocks[block];
+        blockEnd = current + list->blockCapacity(block);
+      }
+    }
+
+    const GmpRecordList *list;
+    size_t index;
+    size_t block = 0;
+    const T *current = nullptr;
+    const T *blockEnd = nullptr;
+  };
+
+  const_iterator begin() const { return const_iterator(this, 0); }
+
+  const_iterator end() const { return const_iterator(this, count); }
+
+private:
+  static constexpr size_t blockCapacity(size_t block)
+  {
+    return block < GROWING_BLOCKS ? FIRST_BLOCK << block : BLOCK_RECORDS;
+  }
+
+  void *allocateBytes(size_t bytes)
+  {
+    void *memory = arena ? arena->allocate(bytes) : malloc(bytes);
+    if (!memory)
+    {
+      throw std::bad_alloc();
+    }
+    return memory;
+  }
+
+  void freeBytes(void *memory, size_t bytes)
+  {
+    if (arena)
+    {
+      arena->release(memory, bytes);
+    }
+    else
+    {
+      free(memory);
+    }
+  }
+
+  void addBlock()
+  {
+    if (blockCount == directoryCapacity)
+    {
+      // Only the block pointers are copied, the records stay where they are.
+      size_t newCapacity = directoryCapacity ? directoryCapacity * 2 : 4;
+      auto **newBlocks = static_cast<T **>(allocateBytes(newCapacity * sizeof(T *)));
+      if (blocks)
+      {
+        memcpy(newBlocks, blocks, blockCount * sizeof(T *));
+        freeBytes(blocks, directoryCapacity * sizeof(T *));
+      }
+      blocks = newBlocks;
+      directoryCapacity = newCapacity;
+    }
+    size_t capacity = blockCapacity(blockCount);
+    tail = static_cast<T *>(allocateBytes(capacity * sizeof(T)));
+    tailEnd = tail + capacity;
+    blocks[blockCount++] = tail;
+  }
+
+  void swap(GmpRecordList &other) noexcept
+  {
+    std::swap(arena, other.arena);
+    std::swap(blocks, other.blocks);
+    std::swap(blockCount, other.blockCount);
+    std::swap(directoryCapacity, other.directoryCapacity);
+    std::swap(tail, other.tail);
+    std::swap(tailEnd, other.tailEnd);
+    std::swap(count, other.count);
+  }
+
+  GmpArena *arena = nullptr;
+  T **blocks = nullptr; // Directory of the blocks
+  size_t blockCount = 0;
+  size_t directoryCapacity = 0;
+  T *tail = nullptr; // Next free record of the last block
+  T *tailEnd = nullptr;
+  size_t count = 0;
+};
+
+#endif // GMP_ARENA_H
@@ -0,0 +1,99 @@
+#ifndef GMP_BOTTLENECK_H
+#define GMP_BOTTLENECK_H
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Stall and pipe counters of one kernel or range, all summed over SMSPs.
+struct GmpStallMetrics
+{
+  double cyclesActive = 0.0;     // smsp__cycles_active.sum
+  double instructions = 0.0;     // smsp__inst_executed.sum
+  double warpsActive = 0.0;      // smsp__warps_active.sum, warp-cycles
+  double warpsEligible = 0.0;    // smsp__warps_eligible.sum, warp-cycles
+  double longScoreboard = 0.0;   // smsp__warps_issue_stalled_long_scoreboard.sum
+  double mioThrottle = 0.0;      // smsp__warps_issue_stalled_mio_throttle.sum
+  double mathPipeThrottle = 0.0; // smsp__warps_issue_stalled_math_pipe_throttle.sum
+  double pipeAlu = 0.0;          // smsp__pipe_*_cycles_active.sum
+  double pipeFma = 0.0;
+  double pipeFp64 = 0.0;
+  double pipeShared = 0.0;
+  double pipeTensor = 0.0;
+  double durationNs = 0.0; // gpu__time_duration.sum, only used to rank kernels
+
+  // Missing metrics are left at 0.
+  static GmpStallMetrics fromMetrics(const std::unordered_map<std::string, double> &metricValues);
+};
+
+enum class GmpBottleneckKind
+{
+  MEMORY_LATENCY = 0, // Waiting on L1TEX: global, local, texture or surface data
+  MIO_THROTTLE,       // MIO queue full: shared memory, special math or dynamic branches
+  MATH_PIPE_THROTTLE, // Waiting for a busy math pipe
+  OTHER_STALL,        // Stalls of the reasons not collected
+  ISSUE_IDLE,         // Cycles without any instruction issued
+  ALU_PIPE_BUSY,
+  FMA_PIPE_BUSY,
+  FP64_PIPE_BUSY,
+  SHARED_PIPE_BUSY,
+  TENSOR_PIPE_IDLE,   // Only for kernels using the tensor pipe at all
+  COUNT,
+};
+
+const char *gmpBottleneckName(GmpBottleneckKind kind);
+
+struct GmpBottleneck
+{
+  GmpBottleneckKind kind;
+  double fraction; // In [0, 1]
+};
+
+struct GmpBottleneckReport
+{
+  std::string name;
+  std::string rangeName; // Enclosing range of a kernel, empty for a range
+  double durationNs = 0.0;
+  double issueRate = 0.0;        // Instructions issued per active cycle and SMSP, at most 1
+  double eligiblePerCycle = 0.0; // Eligible warps per active cycle and SMSP
+  std::vector<GmpBottleneck> ranked; // Largest fraction first
+
+  // e.g. "memory latency 52%, tensor pipe idle 80%" for the first maxCount entries.
+  std::string summary(size_t maxCount = 3) const;
+};
+
+// Turns the stall and pipe counters of the default metric list into a
+// ranked list of bottlenecks:
+//
+// 1. Stall shares, over the active warp-cycles W (smsp__warps_active.sum).
+//    Every active warp either issues or stalls in a cycle, and an issued
+//    instruction takes one warp-cycle, so with I instructions:
+//      memory latency     = long_scoreboard / W
+//      MIO throttle       = mio_throttle / W
+//      math pipe throttle = math_pipe_throttle / W
+//      other stalls       = max(0, 1 - I / W - the three above)
+// 2. Issue idle, over the active cycles C (smsp__cycles_active.sum). An
+//    SMSP issues at most one instruction a cycle, so 1 - I / C of its cycles
+//    issued nothing: latency was not hidden by the eligible warps.
+// 3. Pipe utilization over C: pipe busy = pipe_cycles_active / C for the
+//    ALU, FMA, FP64 and shared pipes. For the tensor pipe, the idle share
+//    1 - tensor_cycles_active / C is reported instead, and only when the
+//    pipe was used, since tensor throughput is what such kernels are after.
+//
+// Every fraction is clamped to [0, 1]; the ones below minFraction are
+// dropped and the rest are sorted largest first. Stall shares and pipe
+// utilizations are both fractions of the time, so they are ranked together.
+// Counters are summed over kernels before the ratios are taken, so a range
+// weighs its kernels by their warp-cycles.
+class GmpBottleneckClassifier
+{
+public:
+  explicit GmpBottleneckClassifier(double minFraction = 0.05);
+
+  GmpBottleneckReport classify(const std::string &name, const GmpStallMetrics &metrics) const;
+
+private:
+  double minFraction;
+};
+
+#endif // GMP_BOTTLENECK_H
@@ -0,0 +1,41 @@
+#ifndef GMP_CONFIG_CACHE_H
+#define GMP_CONFIG_CACHE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// On-disk cache of range profiler config images. Building a config image
+// resolves every metric on the host and takes seconds for large metric lists,
+// while the result only depends on the chip, the CUPTI version, the counter
+// availability and the metric list, which together form the cache key.
+//
+// The directory is $GMP_CACHE_DIR, else $XDG_CACHE_HOME/gmp, else
+// $HOME/.cache/gmp. Entries are written to a temporary file and renamed, so
+// concurrent workers never read a partial image.
+class GmpConfigImageCache
+{
+public:
+  // An empty directory selects the default location.
+  explicit GmpConfigImageCache(std::string directory = "");
+
+  static std::string defaultDirectory();
+
+  static std::string makeKey(const std::string &chipName, uint32_t cuptiVersion,
+                             const std::vector<uint8_t> &counterAvailabilityImage,
+                             const std::vector<std::string> &metrics);
+
+  // Returns false on a miss or a corrupted entry.
+  bool load(const std::string &key, std::vector<uint8_t> &configImage) const;
+
+  bool store(const std::string &key, const std::vector<uint8_t> &configImage) const;
+
+  const std::string &getDirectory() const { return directory; }
+
+private:
+  std::string pathOf(const std::string &key) const;
+
+  std::string directory;
+};
+
+#endif // GMP_CONFIG_CACHE_H
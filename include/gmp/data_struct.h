@@ -8,6 +8,11 @@
 #include <map>
 #include <cupti_callbacks.h>
 #include <cupti_activity.h>
+#include <string_view>
+
+#include "gmp/arena.h"
+#include "gmp/string_table.h"
+
 struct ApiRuntimeRecord
 {
   std::string functionName;
@@ -42,158 +47,357 @@ enum class GmpOutputKernelReduction
   MEAN = 2,
 };
 
+// How the range profiler collects metrics that need several passes.
+// KERNEL: CUPTI saves and restores device memory and replays each kernel.
+// USER: the application reruns the whole workload once per pass, see GmpProfiler::profile.
+enum class GmpReplayMode
+{
+  KERNEL = 0,
+  USER,
+};
+
+// How kernels map to CUPTI ranges in the counter data image.
+// AUTO: every kernel is its own range, GMP ranges are reduced from per-kernel metrics.
+// USER: a GMP kernel range is one CUPTI range aggregated by the hardware. Requires user replay.
+enum class GmpRangeMode
+{
+  AUTO = 0,
+  USER,
+};
+
 enum class GmpProfileType
 {
   CONCURRENT_KERNEL = 0,
   MEMORY,
+  TRANSFER, // Memcpy and memset activity, see GmpTransferAnalyzer
 };
 
 struct GmpKernelData
 {
-  std::string name;
+  uint32_t nameId = 0; // Kernel name in GmpStringTable
   int grid_size[3] = {};
   int block_size[3] = {};
+  // Position among all kernels launched in the range, including filtered ones.
+  uint32_t launchIndex = 0;
+  uint32_t streamId = 0;
+  uint32_t deviceId = 0;
+  uint32_t correlationId = 0;
+  uint64_t start = 0; // GPU timestamps in ns
+  uint64_t end = 0;
+
+  const std::string &name() const { return GmpStringTable::instance().get(nameId); }
+};
+
+// Compact MEMORY2 activity record (40 bytes). Only the fields GMP reports are
+// kept; the variable name and source are interned together as one symbol.
+struct GmpMemData
+{
+  static constexpr uint16_t INVALID_CONTEXT_ID = 0xFFFF;
+
+  uint64_t address = 0;       // Virtual address of the allocation
+  uint64_t bytes = 0;         // Number of bytes allocated or released
+  uint64_t timestamp = 0;     // Start timestamp of the operation, in ns
+  uint32_t correlationId = 0; // Matches the driver/runtime API record
+  uint32_t streamId = 0;      // CUPTI_INVALID_STREAM_ID if not async
+  uint32_t symbolId = 0;      // "name\0source" in GmpStringTable, 0 if both are empty
+  uint16_t contextId = 0;     // INVALID_CONTEXT_ID for a NULL context
+  uint8_t deviceId = 0;
+  uint8_t flags = 0;          // Operation type, memory kind and async bit, see setFlags()
+
+  void setFlags(CUpti_ActivityMemoryOperationType operationType, CUpti_ActivityMemoryKind kind, bool async)
+  {
+    flags = static_cast<uint8_t>((static_cast<uint32_t>(operationType) & 0x3) |
+                                 ((static_cast<uint32_t>(kind) & 0xF) << 2) |
+                                 (async ? 0x40 : 0));
+  }
+
+  void setSymbol(const char *name, const char *source)
+  {
+    if ((!name || !*name) && (!source || !*source))
+    {
+      symbolId = 0;
+      return;
+    }
+    std::string symbol = name ? name : "";
+    symbol.push_back('\0');
+    symbol += source ? source : "";
+    symbolId = GmpStringTable::instance().intern(std::string_view(symbol));
+  }
+
+  CUpti_ActivityMemoryOperationType memoryOperationType() const
+  {
+    return static_cast<CUpti_ActivityMemoryOperationType>(flags & 0x3);
+  }
+
+  CUpti_ActivityMemoryKind memoryKind() const
+  {
+    return static_cast<CUpti_ActivityMemoryKind>((flags >> 2) & 0xF);
+  }
+
+  bool isAsync() const { return flags & 0x40; }
+
+  std::string_view name() const
+  {
+    std::string_view symbol = GmpStringTable::instance().get(symbolId);
+    return symbol.substr(0, symbol.find('\0'));
+  }
+
+  std::string_view source() const
+  {
+    std::string_view symbol = GmpStringTable::instance().get(symbolId);
+    size_t separator = symbol.find('\0');
+    return separator == std::string_view::npos ? std::string_view() : symbol.substr(separator + 1);
+  }
+};
+
+static_assert(sizeof(GmpMemData) == 40, "GmpMemData is expected to stay 40 bytes");
+
+// Column-wise storage of the memory records of one session.
+class GmpMemColumns
+{
+public:
+  explicit GmpMemColumns(GmpArena *arena = nullptr)
+  {
+    setArena(arena);
+  }
+
+  // Only while empty.
+  void setArena(GmpArena *arena)
+  {
+    address.setArena(arena);
+    bytes.setArena(arena);
+    timestamp.setArena(arena);
+    correlationId.setArena(arena);
+    streamId.setArena(arena);
+    symbolId.setArena(arena);
+    contextId.setArena(arena);
+    deviceId.setArena(arena);
+    flags.setArena(arena);
+  }
+
+  void push(const GmpMemData &record)
+  {
+    address.push_back(record.address);
+    bytes.push_back(record.bytes);
+    timestamp.push_back(record.timestamp);
+    correlationId.push_back(record.correlationId);
+    streamId.push_back(record.streamId);
+    symbolId.push_back(record.symbolId);
+    contextId.push_back(record.contextId);
+    deviceId.push_back(record.deviceId);
+    flags.push_back(record.flags);
+  }
+
+  GmpMemData at(size_t index) const
+  {
+    GmpMemData record;
+    record.address = address[index];
+    record.bytes = bytes[index];
+    record.timestamp = timestamp[index];
+    record.correlationId = correlationId[index];
+    record.streamId = streamId[index];
+    record.symbolId = symbolId[index];
+    record.contextId = contextId[index];
+    record.deviceId = deviceId[index];
+    record.flags = flags[index];
+    return record;
+  }
+
+  std::vector<GmpMemData> rows() const
+  {
+    std::vector<GmpMemData> records;
+    records.reserve(size());
+    for (size_t i = 0; i < size(); ++i)
+    {
+      records.push_back(at(i));
+    }
+    return records;
+  }
+
+  size_t size() const { return address.size(); }
+
+  bool empty() const { return address.empty(); }
+
+  size_t getCapacityBytes() const
+  {
+    return address.getCapacityBytes() + bytes.getCapacityBytes() + timestamp.getCapacityBytes() +
+           correlationId.getCapacityBytes() + streamId.getCapacityBytes() + symbolId.getCapacityBytes() +
+           contextId.getCapacityBytes() + deviceId.getCapacityBytes() + flags.getCapacityBytes();
+  }
+
+  void clear()
+  {
+    address.clear();
+    bytes.clear();
+    timestamp.clear();
+    correlationId.clear();
+    streamId.clear();
+    symbolId.clear();
+    contextId.clear();
+    deviceId.clear();
+    flags.clear();
+  }
+
+  GmpRecordList<uint64_t> address;
+  GmpRecordList<uint64_t> bytes;
+  GmpRecordList<uint64_t> timestamp;
+  GmpRecordList<uint32_t> correlationId;
+  GmpRecordList<uint32_t> streamId;
+  GmpRecordList<uint32_t> symbolId;
+  GmpRecordList<uint16_t> contextId;
+  GmpRecordList<uint8_t> deviceId;
+  GmpRecordList<uint8_t> flags;
 };
 
-struct GmpMemData{
-    /**
-   * The activity record kind, must be CUPTI_ACTIVITY_KIND_MEMORY2
-   */
-  CUpti_ActivityKind kind;
-
-  /**
-   * The memory operation requested by the user, \ref CUpti_ActivityMemoryOperationType.
-   */
-  CUpti_ActivityMemoryOperationType memoryOperationType;
-
-  /**
-   * The memory kind requested by the user, \ref CUpti_ActivityMemoryKind.
-   */
-  CUpti_ActivityMemoryKind memoryKind;
-
-  /**
-   * The correlation ID of the memory operation. Each memory operation is
-   * assigned a unique correlation ID that is identical to the
-   * correlation ID in the driver and runtime API activity record that
-   * launched the memory operation.
-   */
-  uint32_t correlationId;
-
-  /**
-   * The virtual address of the allocation.
-   */
-  uint64_t address;
-
-  /**
-   * The number of bytes of memory allocated.
-   */
-  uint64_t bytes;
-
-  /**
-   * The start timestamp for the memory operation, in ns.
-   */
-  uint64_t timestamp;
-
-  /**
-   * The program counter of the memory operation.
-   */
-  uint64_t PC;
-
-  /**
-   * The ID of the process to which this record belongs to.
-   */
-  uint32_t processId;
-
-  /**
-   * The ID of the device where the memory operation is taking place.
-   */
-  uint32_t deviceId;
-
-  /**
-   * The ID of the context. If context is NULL, \p contextId is set to CUPTI_INVALID_CONTEXT_ID.
-   */
-  uint32_t contextId;
-
-  /**
-   * The ID of the stream. If memory operation is not async, \p streamId is set to CUPTI_INVALID_STREAM_ID.
-   */
-  uint32_t streamId;
-
-  /**
-   * Variable name. This name is shared across all activity
-   * records representing the same symbol, and so should not be
-   * modified.
-   */
-  const char* name;
-
-  /**
-   * \p isAsync is set if memory operation happens through async memory APIs.
-   */
-  uint32_t isAsync;
-
-#ifdef CUPTILP64
-  /**
-   * Undefined. Reserved for internal use.
-   */
-  uint32_t pad1;
-#endif
-
-  /**
-   * The memory pool configuration used for the memory operations.
-   */
-  struct PACKED_ALIGNMENT {
-    /**
-     * The type of the memory pool, \ref CUpti_ActivityMemoryPoolType
-     */
-    CUpti_ActivityMemoryPoolType memoryPoolType;
-
-#ifdef CUPTILP64
-    /**
-     * Undefined. Reserved for internal use.
-     */
-    uint32_t pad2;
-#endif
-
-    /**
-     * The base address of the memory pool.
-     */
-    uint64_t address;
-
-    /**
-     * The release threshold of the memory pool in bytes. \p releaseThreshold is
-     * valid for CUPTI_ACTIVITY_MEMORY_POOL_TYPE_LOCAL, \ref CUpti_ActivityMemoryPoolType.
-     */
-    uint64_t releaseThreshold;
-
-    /**
-     * The size of memory pool in bytes and the processId of the memory pools
-     * \p size is valid if \p memoryPoolType is
-     * CUPTI_ACTIVITY_MEMORY_POOL_TYPE_LOCAL, \ref CUpti_ActivityMemoryPoolType.
-     * \p processId is valid if \p memoryPoolType is
-     * CUPTI_ACTIVITY_MEMORY_POOL_TYPE_IMPORTED, \ref CUpti_ActivityMemoryPoolType
-     */
-    union {
-      uint64_t size;
-      uint64_t processId;
-    } pool;
-
-    /**
-     * The utilized size of the memory pool. \p utilizedSize is
-     * valid for CUPTI_ACTIVITY_MEMORY_POOL_TYPE_LOCAL, \ref CUpti_ActivityMemoryPoolType.
-     */
-    uint64_t utilizedSize;
-  } memoryPoolConfig;
-
-    /**
-     * The shared object or binary that the memory allocation request comes from.
-     */
-    const char* source;
+// Compact MEMCPY or MEMSET activity record (40 bytes).
+struct GmpTransferData
+{
+  // copyKind of a memset, outside the CUpti_ActivityMemcpyKind values.
+  static constexpr uint8_t MEMSET_KIND = 0xFF;
+
+  uint64_t bytes = 0;
+  uint64_t start = 0; // GPU timestamps in ns
+  uint64_t end = 0;
+  uint32_t correlationId = 0;
+  uint32_t streamId = 0;
+  uint8_t deviceId = 0;
+  uint8_t copyKind = 0; // CUpti_ActivityMemcpyKind, or MEMSET_KIND
+  uint8_t srcKind = 0;  // CUpti_ActivityMemoryKind, the set memory for a memset
+  uint8_t dstKind = 0;  // CUpti_ActivityMemoryKind, the set memory for a memset
+  bool isAsync = false;
+
+  bool isMemset() const { return copyKind == MEMSET_KIND; }
+};
+
+static_assert(sizeof(GmpTransferData) == 40, "GmpTransferData is expected to stay 40 bytes");
+
+// Unified memory counter activity of one range, folded as the records
+// arrive so a range costs the same whatever the number of faults.
+struct GmpUnifiedMemorySummary
+{
+  uint64_t bytesHtoD = 0; // Migrated to the device
+  uint64_t bytesDtoH = 0; // Migrated to the host
+  uint64_t bytesDtoD = 0; // Migrated between devices
+  uint64_t migrationCount = 0;
+  uint64_t migrationNs = 0; // Sum of the migration durations
+  uint64_t cpuPageFaults = 0;
+  uint64_t gpuPageFaults = 0;
+  uint64_t gpuPageFaultGroups = 0; // The GPU reports faults in groups
+  uint64_t gpuPageFaultNs = 0;     // Sum of the fault group durations
+  uint64_t thrashingEvents = 0;
+  uint64_t throttlingEvents = 0;
+  uint64_t remoteMapEvents = 0;
+
+  void add(CUpti_ActivityUnifiedMemoryCounterKind kind, uint64_t value, uint64_t start, uint64_t end)
+  {
+    uint64_t duration = end > start ? end - start : 0;
+    switch (kind)
+    {
+    case CUPTI_ACTIVITY_UNIFIED_MEMORY_COUNTER_KIND_BYTES_TRANSFER_HTOD:
+      bytesHtoD += value;
+      migrationCount++;
+      migrationNs += duration;
+      break;
+    case CUPTI_ACTIVITY_UNIFIED_MEMORY_COUNTER_KIND_BYTES_TRANSFER_DTOH:
+      bytesDtoH += value;
+      migrationCount++;
+      migrationNs += duration;
+      break;
+    case CUPTI_ACTIVITY_UNIFIED_MEMORY_COUNTER_KIND_BYTES_TRANSFER_DTOD:
+      bytesDtoD += value;
+      migrationCount++;
+      migrationNs += duration;
+      break;
+    case CUPTI_ACTIVITY_UNIFIED_MEMORY_COUNTER_KIND_CPU_PAGE_FAULT_COUNT:
+      cpuPageFaults += value;
+      break;
+    case CUPTI_ACTIVITY_UNIFIED_MEMORY_COUNTER_KIND_GPU_PAGE_FAULT:
+      gpuPageFaults += value;
+      gpuPageFaultGroups++;
+      gpuPageFaultNs += duration;
+      break;
+    case CUPTI_ACTIVITY_UNIFIED_MEMORY_COUNTER_KIND_THRASHING:
+      thrashingEvents++;
+      break;
+    case CUPTI_ACTIVITY_UNIFIED_MEMORY_COUNTER_KIND_THROTTLING:
+      throttlingEvents++;
+      break;
+    case CUPTI_ACTIVITY_UNIFIED_MEMORY_COUNTER_KIND_REMOTE_MAP:
+      remoteMapEvents++;
+      break;
+    default:
+      break;
+    }
+  }
+
+  bool empty() const
+  {
+    return migrationCount == 0 && cpuPageFaults == 0 && gpuPageFaultGroups == 0 && thrashingEvents == 0 &&
+           throttlingEvents == 0 && remoteMapEvents == 0;
+  }
+};
+
+struct GmpRangeUnifiedMemory
+{
+  std::string name;
+  GmpProfileType type;
+  GmpUnifiedMemorySummary summary;
+};
+
+struct GmpTimeInterval
+{
+  uint64_t start = 0;
+  uint64_t end = 0;
 };
 
 struct GmpRangeData
 {
   std::string name;
   std::vector<GmpKernelData> kernelDataInRange;
+  // Kernels launched in the range, i.e. range profiler ranges it consumed.
+  size_t launchedKernelCount = 0;
+};
+
+// Running reduction of the per-kernel metrics of one GMP range.
+// Values are indexed like the profiler's metric list.
+struct GmpRangeMetricAccumulator
+{
+  std::string name;
+  size_t kernelCount = 0;
+  std::vector<double> sum;
+  std::vector<double> max;
+
+  void add(const std::vector<double> &values)
+  {
+    if (kernelCount == 0)
+    {
+      sum.assign(values.size(), 0.0);
+      max = values;
+    }
+    for (size_t i = 0; i < values.size() && i < sum.size(); ++i)
+    {
+      sum[i] += values[i];
+      max[i] = values[i] > max[i] ? values[i] : max[i];
+    }
+    kernelCount++;
+  }
+
+  double reduce(size_t metricIndex, GmpOutputKernelReduction option) const
+  {
+    if (metricIndex >= sum.size())
+    {
+      return 0.0;
+    }
+    switch (option)
+    {
+    case GmpOutputKernelReduction::MAX:
+      return max[metricIndex];
+    case GmpOutputKernelReduction::MEAN:
+      return sum[metricIndex] / kernelCount;
+    default:
+      return sum[metricIndex];
+    }
+  }
 };
 
 struct GmpMemRangeData
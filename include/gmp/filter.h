@@ -0,0 +1,78 @@
+#ifndef GMP_FILTER_H
+#define GMP_FILTER_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+enum class GmpFilterAction
+{
+  INCLUDE = 0,
+  EXCLUDE,
+};
+
+enum class GmpFilterMatch
+{
+  EXACT = 0, // The whole name must equal the pattern
+  SUBSTRING, // The pattern may appear anywhere in the name
+};
+
+// Include/exclude matcher for range and kernel names.
+// Rules are compiled once into a hashed exact set plus an Aho-Corasick
+// automaton over the substring patterns, so a lookup costs one hash of the
+// name and one pass over its characters regardless of the number of rules.
+// A name passes if no exclude rule matches it and, when include rules
+// exist, at least one include rule matches it.
+class GmpNameFilter
+{
+public:
+  GmpNameFilter() = default;
+
+  void addRule(const std::string &pattern, GmpFilterAction action, GmpFilterMatch match);
+
+  // Build the lookup structures. Must be called after the last addRule.
+  void compile();
+
+  void clear();
+
+  // True when there is at least one rule, i.e. matches() may return false.
+  bool isActive() const { return active; }
+
+  bool matches(std::string_view name) const;
+
+  // Same, with hash = gmpHash64(name) already known, e.g. from compile time.
+  bool matches(std::string_view name, uint64_t hash) const;
+
+private:
+  static constexpr uint8_t INCLUDE_BIT = 1;
+  static constexpr uint8_t EXCLUDE_BIT = 2;
+  static constexpr size_t ALPHABET_SIZE = 256;
+
+  struct Rule
+  {
+    std::string pattern;
+    uint8_t bit;
+    GmpFilterMatch match;
+  };
+
+  struct ExactEntry
+  {
+    std::string name;
+    uint8_t bits;
+  };
+
+  std::vector<Rule> rules;
+  bool active = false;
+  bool hasIncludes = false;
+
+  // Exact rules keyed by the hash of the name.
+  std::unordered_map<uint64_t, std::vector<ExactEntry>> exactRules;
+
+  // Automaton as a dense transition table, one row of ALPHABET_SIZE per state.
+  std::vector<uint32_t> transitions;
+  std::vector<uint8_t> stateOutput;
+};
+
+#endif // GMP_FILTER_H
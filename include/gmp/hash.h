@@ -0,0 +1,34 @@
+#ifndef GMP_HASH_H
+#define GMP_HASH_H
+
+#include <cstdint>
+#include <cstddef>
+#include <string_view>
+
+constexpr uint64_t GMP_FNV1A_OFFSET = 14695981039346656037ull;
+constexpr uint64_t GMP_FNV1A_PRIME = 1099511628211ull;
+
+// Stable 64-bit FNV-1a hash, identical across runs, machines and compilers.
+constexpr uint64_t gmpHash64(std::string_view str, uint64_t seed = GMP_FNV1A_OFFSET)
+{
+  uint64_t hash = seed;
+  for (char c : str)
+  {
+    hash ^= static_cast<uint8_t>(c);
+    hash *= GMP_FNV1A_PRIME;
+  }
+  return hash;
+}
+
+// Mix an integer into a running hash.
+constexpr uint64_t gmpHashCombine(uint64_t hash, uint64_t value)
+{
+  for (int i = 0; i < 8; ++i)
+  {
+    hash ^= (value >> (i * 8)) & 0xff;
+    hash *= GMP_FNV1A_PRIME;
+  }
+  return hash;
+}
+
+#endif // GMP_HASH_H
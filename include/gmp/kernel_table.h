@@ -0,0 +1,79 @@
+#ifndef GMP_KERNEL_TABLE_H
+#define GMP_KERNEL_TABLE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "gmp/data_struct.h"
+
+// Totals of every launch sharing a signature, i.e. kernel name, grid and block.
+struct GmpHotKernel
+{
+  std::string name;
+  uint32_t nameId = 0; // name in GmpStringTable
+  int grid_size[3] = {};
+  int block_size[3] = {};
+  size_t launchCount = 0;
+  uint64_t totalTimeNs = 0;
+  // Metric totals, only over the launches that had metrics evaluated.
+  size_t measuredLaunchCount = 0;
+  double instructions = 0.0; // smsp__inst_executed.sum
+  double dramSectors = 0.0;  // dram__sectors_read.sum + dram__sectors_write.sum
+};
+
+enum class GmpHotKernelOrder
+{
+  TIME = 0,
+  INSTRUCTIONS,
+  DRAM_SECTORS,
+};
+
+// Group-by of kernel launches over their signature across the whole run.
+// Signatures live in an open-addressing table with linear probing over
+// their 64-bit hash, so each launch costs one hash and, in the common case,
+// one probe. Entries are stored densely in insertion order.
+class GmpHotKernelTable
+{
+public:
+  explicit GmpHotKernelTable(size_t initialCapacity = 64);
+
+  // instructions and dramSectors are ignored unless hasMetrics is set.
+  void add(const GmpKernelData &kernel, bool hasMetrics, double instructions, double dramSectors);
+
+  // The n entries with the largest value of order, largest first.
+  std::vector<GmpHotKernel> top(size_t n, GmpHotKernelOrder order) const;
+
+  size_t size() const { return entries.size(); }
+
+  const std::vector<GmpHotKernel> &getEntries() const { return entries; }
+
+  const GmpHotKernel &getTotals() const { return totals; }
+
+  void clear();
+
+  static double valueOf(const GmpHotKernel &entry, GmpHotKernelOrder order);
+
+private:
+  static constexpr uint32_t EMPTY_SLOT = UINT32_MAX;
+
+  struct Slot
+  {
+    uint64_t hash = 0;
+    uint32_t entryIndex = EMPTY_SLOT;
+  };
+
+  static uint64_t hashOf(const GmpKernelData &kernel);
+
+  static bool isSameSignature(const GmpHotKernel &entry, const GmpKernelData &kernel);
+
+  GmpHotKernel &findOrInsert(const GmpKernelData &kernel);
+
+  void grow();
+
+  std::vector<Slot> slots; // Size is a power of two
+  std::vector<GmpHotKernel> entries;
+  GmpHotKernel totals;
+};
+
+#endif // GMP_KERNEL_TABLE_H
@@ -0,0 +1,57 @@
+#ifndef GMP_KERNEL_TIMELINE_H
+#define GMP_KERNEL_TIMELINE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "gmp/data_struct.h"
+
+struct GmpIdleGap
+{
+  uint64_t start = 0;
+  uint64_t end = 0;
+
+  uint64_t duration() const { return end - start; }
+};
+
+struct GmpKernelTimelineStats
+{
+  std::string name;
+  size_t kernelCount = 0;
+  uint64_t firstStart = 0;
+  uint64_t lastEnd = 0;
+  uint64_t spanNs = 0;    // From the first kernel start to the last kernel end
+  uint64_t busyNs = 0;    // Time with at least one kernel running
+  uint64_t idleNs = 0;    // spanNs - busyNs
+  uint64_t overlapNs = 0; // Time with two or more kernels running
+  uint32_t maxConcurrency = 0;
+  // concurrencyHistogram[k] is the time in ns with exactly k kernels running.
+  std::vector<uint64_t> concurrencyHistogram;
+  size_t idleGapCount = 0;
+  std::vector<GmpIdleGap> longestGaps; // Longest first
+
+  double busyFraction() const { return spanNs ? static_cast<double>(busyNs) / spanNs : 0.0; }
+};
+
+// Sweep-line analysis of kernel start/end timestamps.
+// Kernels are visited in start order while a min-heap holds the end times of
+// the running ones, so the cost is O(n log c) for n kernels and a peak
+// concurrency of c, plus a sort when the input is not already start-ordered.
+// Under kernel replay CUPTI serializes kernels, so concurrency above 1 is
+// only observed while the range profiler is stopped or in user replay.
+class GmpKernelTimelineAnalyzer
+{
+public:
+  explicit GmpKernelTimelineAnalyzer(size_t maxReportedGaps = 5, uint64_t minGapNs = 0);
+
+  GmpKernelTimelineStats analyze(const std::string &name, const std::vector<GmpKernelData> &kernels) const;
+
+  std::vector<GmpKernelTimelineStats> analyze(const std::vector<GmpRangeData> &ranges) const;
+
+private:
+  size_t maxReportedGaps;
+  uint64_t minGapNs;
+};
+
+#endif // GMP_KERNEL_TIMELINE_H
@@ -0,0 +1,97 @@
+#ifndef GMP_MEMORY_TIMELINE_H
+#define GMP_MEMORY_TIMELINE_H
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "gmp/data_struct.h"
+
+struct GmpLiveAllocation
+{
+  uint64_t address = 0;
+  uint64_t bytes = 0;
+  uint64_t timestamp = 0;
+  size_t rangeIndex = 0;
+};
+
+struct GmpMemoryTimelinePoint
+{
+  uint64_t timestamp = 0;
+  uint64_t liveBytes = 0;
+};
+
+struct GmpRangeFootprint
+{
+  std::string name;
+  uint64_t liveBytesAtStart = 0;
+  uint64_t liveBytesAtEnd = 0;
+  uint64_t peakLiveBytes = 0;  // Highest live footprint inside the range
+  uint64_t highWaterMark = 0;  // Highest live footprint from the first range up to the end of this one
+  uint64_t allocatedBytes = 0;
+  uint64_t releasedBytes = 0;
+  // Allocations made in the range that were still live when it ended.
+  std::vector<GmpLiveAllocation> leakedAllocations;
+};
+
+// Live device memory footprint rebuilt from MEMORY2 activity records.
+// Allocations are kept in an address-keyed interval map, so each record is
+// applied in O(log n) of the number of live allocations. Host-side kinds
+// (pinned and pageable) are not part of the device footprint and are ignored.
+class GmpMemoryTimeline
+{
+public:
+  GmpMemoryTimeline() = default;
+
+  // Replay all ranges in order, sorting each range's records by timestamp.
+  void build(const std::vector<GmpMemRangeData> &ranges);
+
+  void beginRange(const std::string &name);
+
+  // Apply one record to the current range and return the live bytes after it.
+  uint64_t apply(const GmpMemData &record);
+
+  void endRange();
+
+  void clear();
+
+  // Keep the live-bytes timeline in memory (default). Disable when the
+  // caller consumes the value returned by apply() itself.
+  void setRecordTimeline(bool record) { recordTimeline = record; }
+
+  uint64_t getLiveBytes() const { return liveBytes; }
+
+  uint64_t getHighWaterMark() const { return highWaterMark; }
+
+  // Releases of addresses that were never seen allocated, e.g. allocated outside any range.
+  size_t getUnmatchedReleaseCount() const { return unmatchedReleases; }
+
+  const std::vector<GmpMemoryTimelinePoint> &getTimeline() const { return timeline; }
+
+  const std::vector<GmpRangeFootprint> &getRangeFootprints() const { return rangeFootprints; }
+
+  const std::map<uint64_t, GmpLiveAllocation> &getLiveAllocations() const { return liveAllocations; }
+
+private:
+  static bool isDeviceMemory(CUpti_ActivityMemoryKind kind);
+
+  // Find the live allocation containing the address, or end().
+  std::map<uint64_t, GmpLiveAllocation>::iterator findContaining(uint64_t address);
+
+  void allocate(const GmpMemData &record);
+
+  void release(const GmpMemData &record);
+
+  std::map<uint64_t, GmpLiveAllocation> liveAllocations;
+  std::vector<GmpMemoryTimelinePoint> timeline;
+  std::vector<GmpRangeFootprint> rangeFootprints;
+  std::vector<uint64_t> rangeAllocations; // Addresses allocated in the current range
+  uint64_t liveBytes = 0;
+  uint64_t highWaterMark = 0;
+  size_t unmatchedReleases = 0;
+  bool inRange = false;
+  bool recordTimeline = true;
+};
+
+#endif // GMP_MEMORY_TIMELINE_H
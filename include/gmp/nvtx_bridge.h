@@ -0,0 +1,112 @@
+#ifndef GMP_NVTX_BRIDGE_H
+#define GMP_NVTX_BRIDGE_H
+
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <nvtx3/nvToolsExt.h>
+// Callback table types used by injection libraries
+#include <nvtx3/nvtxDetail/nvtxTypes.h>
+
+#include "gmp/data_struct.h"
+#include "gmp/filter.h"
+
+class GmpProfiler;
+
+// Maps the NVTX push/pop ranges of an unmodified application to GMP ranges.
+// An NVTX injection library (see injection/) calls attach() with the export
+// table NVTX passes to InitializeInjectionNvtx2, which points the push, pop,
+// domain and registered string slots of every NVTX module at this bridge.
+// The entry points are public so that any caller filling an export table,
+// e.g. gmp_bench, drives the same path.
+//
+// A GMP session cannot open inside another of its type, so only the
+// outermost mapped range of a nest becomes a GMP range and the ranges inside
+// it are ignored, their kernels counting towards the outer one. Only the
+// thread that pushes the first mapped range is followed, ranges of other
+// threads are ignored. NVTX start/end ranges may overlap arbitrarily and are
+// not mapped.
+class GmpNvtxBridge
+{
+public:
+  explicit GmpNvtxBridge(GmpProfiler *profiler, GmpProfileType type = GmpProfileType::CONCURRENT_KERNEL);
+
+  ~GmpNvtxBridge();
+
+  GmpNvtxBridge(const GmpNvtxBridge &) = delete;
+  GmpNvtxBridge &operator=(const GmpNvtxBridge &) = delete;
+
+  // Domain name of the ranges pushed without a domain.
+  static constexpr const char *DEFAULT_DOMAIN = "@default";
+
+  // Only map the ranges of the added domains. Without any, every domain is
+  // mapped. Must be called before attach().
+  void addDomain(const std::string &name);
+
+  // Filter on the range message, same rules as GmpProfiler::addRangeFilter.
+  // Must be called before attach().
+  void addRangeFilter(const std::string &pattern, GmpFilterAction action,
+                      GmpFilterMatch match = GmpFilterMatch::SUBSTRING);
+
+  // Called once, right before the first mapped range is pushed, e.g. to init the profiler.
+  void setFirstRangeHook(std::function<void()> hook);
+
+  // Patch the callback tables of one NVTX client. Every client of the
+  // process calls the injection, so this may run several times.
+  GmpResult attach(NvtxGetExportTableFunc_t getExportTable);
+
+  nvtxDomainHandle_t createDomain(const char *name);
+
+  nvtxStringHandle_t registerString(nvtxDomainHandle_t domain, const char *string);
+
+  // NVTX semantics: push returns the 0-based nesting level of the new range
+  // on the calling thread, pop the level of the ended range, or -1 on error.
+  int pushRange(nvtxDomainHandle_t domain, const nvtxEventAttributes_t *attributes);
+
+  int pushRange(nvtxDomainHandle_t domain, const char *message);
+
+  int popRange(nvtxDomainHandle_t domain);
+
+  size_t getMappedRangeCount() const { return mappedRangeCount; }
+
+  // Ranges not mapped because of their domain, the filter, their thread or
+  // because they are nested inside a mapped range.
+  size_t getIgnoredRangeCount() const { return ignoredRangeCount; }
+
+private:
+  struct Domain
+  {
+    std::string name;
+    bool isMapped;
+  };
+
+  bool isMappedDomain(const std::string &name) const;
+
+  int push(nvtxDomainHandle_t domain, std::string message);
+
+  GmpProfiler *profiler;
+  GmpProfileType type;
+  std::unordered_set<std::string> domainNames;
+  GmpNameFilter rangeFilter;
+  std::function<void()> firstRangeHook;
+
+  std::mutex mutex;
+  // Handles point into these, deques keep the addresses stable.
+  std::deque<Domain> domains;
+  std::deque<std::string> registeredStrings;
+  Domain defaultDomain;
+  bool isAttached = false;
+  bool hasOwnerThread = false;
+  bool hasWarnedThread = false;
+  std::thread::id ownerThread;
+  // Read without the mutex, and ignored ranges are counted outside of it.
+  std::atomic<size_t> mappedRangeCount{0};
+  std::atomic<size_t> ignoredRangeCount{0};
+};
+
+#endif // GMP_NVTX_BRIDGE_H
@@ -4,22 +4,45 @@
 
 #ifdef ENABLE_NVTX
 #include <nvtx3/nvtx3.hpp>
-#include <stack>
+#include <array>
+#include <cstddef>
 #include <unordered_map>
 #include <string>
+#include <vector>
+#include "gmp/string_table.h"
 
 // NVTX Range Manager - independent of CUPTI
+// Ranges are pushed in a dedicated domain with registered message strings:
+// a marker costs one lookup of the cached handle plus the NVTX call, and
+// tools (including GmpNvtxBridge) can tell GMP's ranges from the application's.
 class NvtxRangeManager {
 public:
+  static constexpr const char *DOMAIN_NAME = "GMP";
+
+  // Names of deeper ranges are not kept, the ranges are still pushed.
+  static constexpr size_t MAX_TRACKED_DEPTH = 64;
+
   NvtxRangeManager() = default;
-  ~NvtxRangeManager() = default;
+  ~NvtxRangeManager();
+
+  NvtxRangeManager(const NvtxRangeManager &) = delete;
+  NvtxRangeManager &operator=(const NvtxRangeManager &) = delete;
+
+  // Push an NVTX range named name in the GMP domain
+  void startRange(const std::string& name);
 
-  // Start an NVTX range and return its ID
-  nvtxRangeId_t startRange(const std::string& name);
+  // Push an NVTX range from a handle returned by getStringHandle
+  void startRange(nvtxStringHandle_t name);
 
   // End the most recent NVTX range
   bool endRange(const std::string& expectedName = "");
 
+  // Registered string of a range name, registered on first use
+  nvtxStringHandle_t getStringHandle(const std::string& name);
+
+  // Same for an interned name, an index instead of a hash lookup
+  nvtxStringHandle_t getStringHandle(const GmpRangeName& name);
+
   // Get the number of active ranges
   size_t getActiveRangeCount() const;
 
@@ -27,9 +50,16 @@ public:
   void clearAllRanges();
 
 private:
-  std::stack<nvtxRangeId_t> activeRanges_;
-  std::unordered_map<nvtxRangeId_t, std::string> rangeNameMap_;
+  // Created on the first range, creating it can load an NVTX injection library.
+  nvtxDomainHandle_t getDomain();
+
+  nvtxDomainHandle_t domain_ = nullptr;
+  std::unordered_map<std::string, nvtxStringHandle_t> stringHandles_;
+  // By GmpStringTable id, null where not registered yet
+  std::vector<nvtxStringHandle_t> internedHandles_;
+  std::array<nvtxStringHandle_t, MAX_TRACKED_DEPTH> activeRanges_{};
+  size_t depth_ = 0;
 };
 #endif // ENABLE_NVTX
 
-#endif // GMP_NVTX_RANGE_MANAGER_H
\ No newline at end of file
+#endif // GMP_NVTX_RANGE_MANAGER_H
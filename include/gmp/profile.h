@@ -1,6 +1,8 @@
 #ifndef GMP_PROFILE_H
 #define GMP_PROFILE_H
+#include <chrono>
 #include <functional>
+#include <future>
 #include <vector>
 #include <cassert>
 #include <memory>
@@ -17,6 +19,19 @@
 #include "gmp/session.h"
 #include "gmp/session_manager.h"
 #include "gmp/nvtx_range_manager.h"
+#include "gmp/sampling.h"
+#include "gmp/filter.h"
+#include "gmp/memory_timeline.h"
+#include "gmp/kernel_timeline.h"
+#include "gmp/transfer_stats.h"
+#include "gmp/trace_writer.h"
+#include "gmp/config_cache.h"
+#include "gmp/kernel_table.h"
+#include "gmp/range_stats.h"
+#include "gmp/roofline.h"
+#include "gmp/bottleneck.h"
+#include "gmp/activity_spill.h"
+#include "gmp/stream_writer.h"
 
 #define USE_CUPTI
 #define ENABLE_NVTX
@@ -65,6 +80,14 @@ public:
 
   void init();
 
+  // Run init() on a background thread. pushRange and startRangeProfiling
+  // block only if they are reached before it completes.
+  void initAsync();
+
+  // Reuse config images across processes, see GmpConfigImageCache. Enabled by
+  // default; must be called before init().
+  GmpResult setConfigCache(bool enabled, const std::string &directory = "");
+
   static GmpProfiler *getInstance();
 
   void startRangeProfiling();
@@ -79,6 +102,12 @@ public:
   // Activity + Range Profiling API
   GmpResult popRange(const std::string &name, GmpProfileType type);
 
+  // Same for a name interned once, see GmpScopedRange: no std::string is
+  // built and the name is not hashed again.
+  GmpResult pushRange(const GmpRangeName &name, GmpProfileType type);
+
+  GmpResult popRange(const GmpRangeName &name, GmpProfileType type);
+
   // Called after end of range profiling
   void printProfilerRanges(std::string& configName, GmpOutputKernelReduction option);
 
@@ -88,6 +117,85 @@ public:
   // Get all memory activity data
   std::vector<GmpMemRangeData> getMemoryActivity();
 
+  // Print live footprint, peak and leaked allocations of every memory range
+  void printMemoryFootprint();
+
+  // Replay the memory activity into a live footprint timeline
+  GmpMemoryTimeline getMemoryFootprint();
+
+  // Print busy time, kernel concurrency and idle gaps of every kernel range
+  void printKernelTimeline(size_t maxReportedGaps = 5);
+
+  std::vector<GmpKernelTimelineStats> getKernelTimeline(size_t maxReportedGaps = 5);
+
+  // Bytes, bandwidth and sizes per direction, pageable copies and copy/compute
+  // overlap of every TRANSFER range. Overlap only sees kernels that ran
+  // concurrently, which kernel replay prevents while the range profiler runs.
+  std::vector<GmpTransferStats> getTransferStats();
+
+  void printTransferStats();
+
+  // Collect unified memory counters: migrated bytes, CPU/GPU page faults,
+  // thrashing, throttling and remote map events, summarized per range of
+  // every type. Off by default. Must be called before init().
+  GmpResult setUnifiedMemoryCounters(bool enabled);
+
+  // Ranges of every type in push order, kernel ranges first.
+  std::vector<GmpRangeUnifiedMemory> getUnifiedMemorySummary();
+
+  // Print the ranges with unified memory activity
+  void printUnifiedMemorySummary();
+
+  // Group repeated ranges by name and compute mean, stddev, min, max and
+  // coefficient of variation of every reduced metric across their iterations.
+  GmpRangeStatsTable getRangeStatistics(GmpOutputKernelReduction option = GmpOutputKernelReduction::SUM);
+
+  void printRangeStatistics(GmpOutputKernelReduction option = GmpOutputKernelReduction::SUM);
+
+  // Write one summary row per range name to result.csv instead of one row per range instance.
+  void setRangeSummary(bool summarize);
+
+  // Group all kernel launches of the run by name, grid and block. Instruction
+  // and DRAM totals need per-kernel metrics, i.e. auto range mode with kernel
+  // detail kept and the counter data evaluated.
+  GmpHotKernelTable getHotKernelTable();
+
+  std::vector<GmpHotKernel> getHotKernels(size_t topN = 10, GmpHotKernelOrder order = GmpHotKernelOrder::TIME);
+
+  // Print the top kernels by time, instructions and DRAM sectors
+  void printHotKernels(size_t topN = 10);
+
+  // Use these peaks for the roofline instead of the built-in ones of the
+  // chip found by init(), e.g. for a board with fewer SMs or other clocks.
+  void setRooflinePeaks(const GmpRooflinePeaks &peaks);
+
+  // Place every kernel range on the instruction roofline, with the metrics
+  // summed over its kernels. Empty if the chip has no known peaks.
+  std::vector<GmpRooflinePoint> getRooflineRanges();
+
+  // Same per kernel launch. Needs per-kernel metrics, like getHotKernelTable().
+  std::vector<GmpRooflinePoint> getRooflineKernels();
+
+  // Print the ranges and the kernels furthest below the roof
+  void printRoofline(size_t topN = 10);
+
+  // Write the roofline of every range, and of every kernel if includeKernels is set, to a CSV file.
+  GmpResult exportRooflineCsv(const std::string &path, bool includeKernels = true);
+
+  // Rank the stall reasons and pipe utilizations of every kernel range, see
+  // GmpBottleneckClassifier. Counters are summed over the kernels of a range.
+  std::vector<GmpBottleneckReport> getBottleneckRanges();
+
+  // Same per kernel launch. Needs per-kernel metrics, like getHotKernelTable().
+  std::vector<GmpBottleneckReport> getBottleneckKernels();
+
+  // Print the bottlenecks of every range and of the topN longest kernels
+  void printBottlenecks(size_t topN = 10);
+
+  // Write ranges, kernels and memory operations to a Chrome JSON trace that
+  // Perfetto UI and chrome://tracing can open.
+  GmpResult exportTrace(const std::string &path);
+
   bool isAllPassSubmitted();
 
   void decodeCounterData();
@@ -102,11 +210,149 @@ public:
 
   bool hasSubmittedAllPasses();
 
+  // Select the replay mode used by the range profiler. Must be called before init().
+  GmpResult setReplayMode(GmpReplayMode mode);
+
+  GmpReplayMode getReplayMode() const;
+
+  // Select the range mode. USER also switches to user replay. Must be called before init().
+  GmpResult setRangeMode(GmpRangeMode mode);
+
+  GmpRangeMode getRangeMode() const;
+
+  // Run the workload under the range profiler until every pass has been
+  // submitted, then decode and evaluate the counter data. Under user replay
+  // the workload is rerun once per pass and restore, if given, is called
+  // before every rerun to reset the state the workload mutates. Activity
+  // sessions are only recorded on the first pass. Under kernel replay the
+  // workload runs once.
+  GmpResult profile(const std::function<void()> &workload, const std::function<void()> &restore = nullptr,
+                    size_t maxPasses = 64);
+
+  // Keep the metrics of every kernel after evaluation (default). When off,
+  // auto range metrics are folded into per-range sum and max while they are
+  // evaluated, so memory grows with the number of ranges instead of kernels,
+  // and per-kernel output is not available.
+  void setKernelDetail(bool keep);
+
+  // Choose which pushRange calls are profiled. Skipped ranges, and every range
+  // nested inside them, are ignored until the matching popRange. This holds
+  // across types: memory and transfer ranges pushed inside a skipped kernel
+  // range are skipped with it.
+  void setSamplingPolicy(const GmpSamplingPolicy &policy);
+
+  const GmpRangeSampler &getSampler() const;
+
+  // Only profile ranges whose name passes the filter. Must be called before init().
+  GmpResult addRangeFilter(const std::string &pattern, GmpFilterAction action,
+                           GmpFilterMatch match = GmpFilterMatch::EXACT);
+
+  // Only record kernels whose name passes the filter. Must be called before init().
+  GmpResult addKernelFilter(const std::string &pattern, GmpFilterAction action,
+                            GmpFilterMatch match = GmpFilterMatch::SUBSTRING);
+
+  // Bound the host memory held by the records of completed ranges. Beyond
+  // budgetBytes the oldest ranges are written to spillPath (a file in the
+  // temporary directory if empty) and read back lazily by the reports, see
+  // SessionManager::setMemoryBudget. 0 keeps everything in memory (default).
+  // Must be called before the first range is popped.
+  GmpResult setMemoryBudget(size_t budgetBytes, const std::string &spillPath = "");
+
+  GmpSessionStorageStats getSessionStorageStats() const;
+
+  // Chunks and blocks of the arena the sessions and their records live in.
+  GmpArenaStats getSessionArenaStats() const;
+
+  // Capture mode: completed activity buffers and range boundaries are
+  // appended raw to a memory-mapped spill file instead of being decoded, see
+  // GmpSpillWriter. Reports are built from the file by replaySpill(), later
+  // or on another machine. Must be called before init().
+  GmpResult setSpillFile(const std::string &path);
+
+  // Flush the activity buffers, append the counter data image (call after
+  // decodeCounterData(), which profile() does) and close the spill file.
+  // The destructor closes it too.
+  GmpResult closeSpill();
+
+  // Rebuild the sessions and counter data of a spill file, instead of
+  // init(). The reports are then available as after a live run; metrics are
+  // evaluated by the CUPTI profiler host, which does not need a GPU.
+  GmpResult replaySpill(const std::string &path);
+
+  // Streaming mode for runs that never reach the end-of-run reports: once
+  // config.rangeInterval kernel ranges have been popped or
+  // config.intervalSeconds have passed, and no range is open, the window of
+  // completed kernel ranges is decoded, evaluated, reduced and appended to
+  // config.path (see GmpStreamWriter). Its sessions, evaluated ranges and
+  // counter data are then freed, so the reports only cover the current
+  // window. Pushing a memory or transfer range writes the last window and
+  // stops streaming, as windows only hold kernel rows. Needs auto range mode
+  // and kernel replay, and is disabled in capture mode and with unified
+  // memory counters. Must be called before init().
+  GmpResult enableStreaming(const GmpStreamingConfig &config);
+
+  // Close the current window now, e.g. at a checkpoint of the application.
+  GmpResult flushStreamingWindow();
+
+  // Flush the last window and close the stream file. The destructor closes it too.
+  GmpResult closeStreaming();
+
+  GmpStreamingStats getStreamingStats() const;
+
 private:
   static GmpProfiler *instance;
-  bool isInitialized = false;
+  bool isInitialized = false; // Set once init(), initAsync() or replaySpill() has been called
+  bool isReplayed = false;    // Set by replaySpill(), no CUPTI activity is enabled
+  bool isUnifiedMemoryCounterEnabled = false;
+  bool hasTransferSessions = false; // Set by the first TRANSFER range, kernels are then recorded for copy/compute overlap
   bool isEnabled = false;
 
+  GmpRangeSampler sampler;
+  GmpNameFilter rangeFilter;
+  GmpNameFilter kernelFilter;
+  size_t skippedRangeDepth = 0;
+  bool isRangeProfilingStarted = false;
+  bool isRangeProfilingSuspended = false;
+  bool isConfigCacheEnabled = true;
+  GmpRangeMode rangeMode = ENABLE_USER_RANGE ? GmpRangeMode::USER : GmpRangeMode::AUTO;
+  GmpReplayMode replayMode = ENABLE_USER_RANGE ? GmpReplayMode::USER : GmpReplayMode::KERNEL;
+  // 1-based pass of the running profile() call, 0 outside of it.
+  size_t replayPass = 0;
+  // Counter data ranges already evaluated, later evaluations start from here.
+  size_t evaluatedRangeCount = 0;
+  // First kernel session accumulateCounterData() has not finished with, and
+  // the counter data range its kernels start at.
+  size_t accumulatedSessionIndex = 0;
+  size_t accumulatedRangeOffset = 0;
+  bool keepKernelDetail = true;
+  bool isRangeSummaryEnabled = false;
+  // Set by setRooflinePeaks(), otherwise looked up from the chip name.
+  GmpRooflinePeaks rooflinePeaks;
+  // One per kernel session, filled instead of the per-kernel results when
+  // keepKernelDetail is off.
+  std::vector<GmpRangeMetricAccumulator> rangeAccumulators;
+  std::string configCacheDirectory;
+  std::future<void> initFuture;
+  std::string spillPath;
+  // Set in capture mode, between init() and closeSpill().
+  std::unique_ptr<GmpSpillWriter> spillWriter;
+  GmpStreamingConfig streamingConfig;
+  // Set in streaming mode, between init() and closeStreaming().
+  std::unique_ptr<GmpStreamWriter> streamWriter;
+  GmpStreamingStats streamingStats;
+  size_t windowRangeCount = 0; // Kernel ranges popped in the current window
+  std::chrono::steady_clock::time_point windowStart;
+
+  // Whether popRange should close the streaming window.
+  bool isStreamingWindowDue() const;
+
+  void initCupti();
+
+  void waitForInit();
+
+  // Configure and enable the unified memory counter activity, warns if unsupported.
+  void enableUnifiedMemoryCounters();
+
 #ifdef ENABLE_NVTX
   NvtxRangeManager nvtxManager_;
 #endif
@@ -150,6 +396,40 @@ private:
   CuptiProfilerHostPtr cuptiProfilerHost = nullptr;
   SessionManager sessionManager;
   std::vector<uint8_t> counterDataImage;
+  // Kept to set up the profiler host lazily when the config image came from the cache.
+  std::string chipName;
+  std::vector<uint8_t> counterAvailabilityImage;
+
+  GmpResult ensureProfilerHost();
+
+  using KernelMetricsVisitor = std::function<void(const GmpProfileSession &, const GmpKernelData &,
+                                                  const std::unordered_map<std::string, double> &)>;
+
+  // Pass every recorded kernel with its evaluated metrics to visit, in launch
+  // order. Only auto range mode with kernel detail has per-kernel metrics.
+  void forEachKernelMetrics(const KernelMetricsVisitor &visit);
+
+  // The roofline of the profiled chip, nullptr with a warning if its peaks are unknown.
+  std::unique_ptr<GmpRoofline> makeRoofline();
+
+  using RangeMetricsVisitor = std::function<void(const GmpProfileSession &, const std::unordered_map<std::string, double> &)>;
+
+  // Reduce the metrics of every kernel range, in push order, and pass them to visit.
+  void reduceRangeMetrics(GmpOutputKernelReduction option, const RangeMetricsVisitor &visit);
+
+  // Evaluate the counter data ranges that have not been evaluated yet.
+  GmpResult evaluateCounterData();
+
+  // Fold the auto ranges [begin, end) into rangeAccumulators.
+  void accumulateCounterData(size_t begin, size_t end);
+
+  // Print the reduced metrics of every range from rangeAccumulators.
+  void printRangeAccumulators(GmpOutputKernelReduction option);
+
+  // User range mode: index of the evaluated CUPTI range of every kernel session, given their names.
+  GmpResult getUserRangeIndices(const std::vector<std::string> &rangeNames, std::vector<size_t> &indices);
+
+  std::vector<std::string> getKernelRangeNames() const;
 
 #endif
 
@@ -163,11 +443,29 @@ private:
   void bufferCompletedImpl(CUcontext ctx, uint32_t streamId,
                            uint8_t *buffer, size_t size, size_t validSize);
 
+  // Add the kernel and memory records of an activity buffer to the open sessions.
+  void decodeActivityBuffer(uint8_t *buffer, size_t validSize);
+
+  // interned is null for names pushed as std::string.
+  GmpResult pushRangeImpl(const std::string &name, const GmpRangeName *interned, GmpProfileType type);
+
+  // Start the session of a pushed range, or only record the boundary in capture mode.
+  GmpResult openSession(GmpProfileType type, const std::string &name, uint64_t timestamp,
+                        const GmpRangeName *interned = nullptr);
+
+  GmpResult closeSession(GmpProfileType type, const std::string &name, uint64_t timestamp);
+
   // Check if the number of kernels recorded by activity API matches that by range profiler
   GmpResult checkActivityAndRangeResultMatch();
   
   GmpResult pushRangeProfilerRange(const char *rangeName);
 
   GmpResult popRangeProfilerRange();
+
+  // Enter a range rejected by the sampler.
+  GmpResult skipRange();
+
+  // Restart the range profiler if it was stopped for skipped ranges.
+  void resumeRangeProfiling();
 };
 #endif // GMP_PROFILE_H
\ No newline at end of file
@@ -48,6 +48,8 @@ public:
     void SetUp(std::string chipName, std::vector<uint8_t> &counterAvailibilityImage);
     void TearDown();
 
+    bool IsSetUp() const { return m_pHostObject != nullptr; }
+
     CUptiResult CreateConfigImage(
         std::vector<const char *> metricsList,
         std::vector<uint8_t> &configImage);
@@ -57,6 +59,13 @@ public:
         std::vector<const char *> metricsList,
         std::vector<uint8_t> &counterDataImage);
 
+    // Evaluate one range into metricValues, ordered like metricsList, without storing it.
+    CUptiResult EvaluateRange(
+        size_t rangeIndex,
+        const std::vector<const char *> &metricsList,
+        const std::vector<uint8_t> &counterDataImage,
+        std::vector<double> &metricValues);
+
     CUptiResult GetNumOfRanges(
         std::vector<uint8_t> &counterDataImage,
         size_t &numOfRanges);
@@ -65,19 +74,20 @@ public:
 
     void PrintProfilerRangesWithNames(const std::vector<GmpRangeData> &rangeDataVec)
     {
-        size_t currProfilerKernelCounter = 0;
-        for (int usrRangeIndex = 0; usrRangeIndex < rangeDataVec.size() && currProfilerKernelCounter < m_profilerRanges.size(); ++usrRangeIndex)
+        size_t rangeOffset = 0;
+        for (int usrRangeIndex = 0; usrRangeIndex < rangeDataVec.size() && rangeOffset < m_profilerRanges.size(); ++usrRangeIndex)
         {
             auto &rangeData = rangeDataVec[usrRangeIndex];
             std::cout << "Range Name: " << rangeData.name << "\n";
             std::cout << "======================================================================================\n";
             for (auto &kernelData : rangeData.kernelDataInRange)
             {
+                size_t currProfilerKernelCounter = rangeOffset + kernelData.launchIndex;
                 if (currProfilerKernelCounter >= m_profilerRanges.size())
                 {
                     break;
                 }
-                std::cout << "Kernel: " << kernelData.name << "<<<{" << kernelData.grid_size[0] << ", " << kernelData.grid_size[1] << ", " << kernelData.grid_size[2] << "}, {"
+                std::cout << "Kernel: " << kernelData.name() << "<<<{" << kernelData.grid_size[0] << ", " << kernelData.grid_size[1] << ", " << kernelData.grid_size[2] << "}, {"
                           << kernelData.block_size[0] << ", " << kernelData.block_size[1] << ", " << kernelData.block_size[2] << "} >>>" << "\n";
                 const auto &profilerRange = m_profilerRanges[currProfilerKernelCounter];
                 std::cout << "-----------------------------------------------------------------------------------\n";
@@ -88,12 +98,40 @@ public:
                     std::cout << std::setw(30) << std::right << metric.second << "\n";
                 }
                 std::cout << "-----------------------------------------------------------------------------------\n";
+            }
+            rangeOffset += rangeData.launchedKernelCount;
+        }
+    }
 
-                currProfilerKernelCounter++;
+    // User range mode, rangeIndices[i] is the profiler range of rangeDataVec[i].
+    void PrintUserRanges(const std::vector<GmpRangeData> &rangeDataVec, const std::vector<size_t> &rangeIndices)
+    {
+        for (size_t usrRangeIndex = 0; usrRangeIndex < rangeDataVec.size() && usrRangeIndex < rangeIndices.size(); ++usrRangeIndex)
+        {
+            const auto &rangeData = rangeDataVec[usrRangeIndex];
+            std::cout << "Range Name: " << rangeData.name << " (" << rangeData.launchedKernelCount << " kernels)\n";
+            std::cout << "-----------------------------------------------------------------------------------\n";
+            for (const auto &metric : m_profilerRanges[rangeIndices[usrRangeIndex]].metricValues)
+            {
+                std::cout << std::fixed << std::setprecision(3);
+                std::cout << std::setw(50) << std::left << metric.first;
+                std::cout << std::setw(30) << std::right << metric.second << "\n";
             }
+            std::cout << "-----------------------------------------------------------------------------------\n\n";
         }
     }
 
+    const std::vector<ProfilerRange> &getProfilerRanges() const
+    {
+        return m_profilerRanges;
+    }
+
+    // Drop the evaluated ranges, e.g. once their counter data image has been reset.
+    void ClearProfilerRanges()
+    {
+        m_profilerRanges.clear();
+    }
+
     std::unordered_map<std::string, double> getRangeMetrics(size_t startIndex, size_t size, std::function<std::unordered_map<std::string, double>(const std::vector<ProfilerRange> &, size_t, size_t)> transformFunc)
     {
         assert(startIndex < m_profilerRanges.size() && (startIndex + size) <= m_profilerRanges.size());
@@ -105,6 +143,23 @@ public:
         return transformFunc(m_profilerRanges, startIndex, size);
     }
 
+    // Same as above for a non-contiguous set of ranges, e.g. when filtered kernels are skipped.
+    std::unordered_map<std::string, double> getRangeMetrics(const std::vector<size_t> &indices, std::function<std::unordered_map<std::string, double>(const std::vector<ProfilerRange> &, size_t, size_t)> transformFunc)
+    {
+        std::vector<ProfilerRange> selectedRanges;
+        selectedRanges.reserve(indices.size());
+        for (size_t index : indices)
+        {
+            assert(index < m_profilerRanges.size());
+            selectedRanges.push_back(m_profilerRanges[index]);
+        }
+        if (selectedRanges.size() == 1)
+        {
+            return selectedRanges[0].metricValues;
+        }
+        return transformFunc(selectedRanges, 0, selectedRanges.size());
+    }
+
 private:
     CUptiResult Initialize(std::vector<uint8_t> &counterAvailibilityImage);
     CUptiResult Deinitialize();
@@ -140,17 +195,25 @@ public:
     CUptiResult DecodeCounterData();
     CUptiResult CreateCounterDataImage(std::vector<const char *> &metrics, std::vector<uint8_t> &counterDataImage);
 
+    // Empty a decoded counter data image and set the config of the last
+    // SetConfig again, so profiling continues into it from range 0.
+    CUptiResult ResetCounterData(std::vector<uint8_t> &counterDataImage);
+
     bool IsAllPassSubmitted() const { return bIsAllPassSubmitted; }
     static CUptiResult GetChipName(size_t deviceIndex, std::string &chipName);
     static CUptiResult GetCounterAvailabilityImage(CUcontext ctx, std::vector<uint8_t> &counterAvailabilityImage);
 
 private:
+    CUptiResult ApplyConfig(std::vector<uint8_t> &counterDataImage);
+
     CUcontext m_context = nullptr;
     size_t isProfilingActive = 0;
     bool bIsAllPassSubmitted = false;
 
     std::vector<const char *> metricNames = {};
     std::vector<uint8_t> configImage = {};
+    CUpti_ProfilerRange mRange = CUPTI_AutoRange;
+    CUpti_ProfilerReplayMode mReplayMode = CUPTI_KernelReplay;
     RangeProfilerConfig mConfig = {};
     CUpti_RangeProfiler_Object *rangeProfilerObject = nullptr;
     bool bIsCuptiInitialized = false;
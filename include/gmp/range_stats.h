@@ -0,0 +1,63 @@
+#ifndef GMP_RANGE_STATS_H
+#define GMP_RANGE_STATS_H
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Streaming mean and variance (Welford), numerically stable over long runs.
+struct GmpWelford
+{
+  size_t count = 0;
+  double mean = 0.0;
+  double m2 = 0.0; // Sum of squared deviations from the mean
+  double min = 0.0;
+  double max = 0.0;
+
+  void add(double value);
+
+  // Sample variance, 0 with fewer than two values.
+  double variance() const { return count > 1 ? m2 / (count - 1) : 0.0; }
+
+  double stddev() const;
+
+  // Coefficient of variation, stddev / |mean|. 0 when the mean is 0.
+  double cv() const;
+};
+
+// Statistics of every instance of a range name, e.g. one per training step.
+struct GmpRangeStats
+{
+  std::string name;
+  size_t iterationCount = 0;
+  GmpWelford durationNs;           // Push to pop, from the session timestamps
+  std::vector<GmpWelford> metrics; // Indexed like the metric list
+};
+
+// Groups repeated ranges by name in first-seen order, keeping O(1) state per
+// range name and metric regardless of the number of iterations.
+class GmpRangeStatsTable
+{
+public:
+  explicit GmpRangeStatsTable(std::vector<std::string> metricNames);
+
+  // Add one instance of a range and return its iteration index, counted from 0.
+  // durationNs of 0 means unknown.
+  size_t add(const std::string &name, const std::unordered_map<std::string, double> &metricValues,
+             uint64_t durationNs);
+
+  const std::vector<GmpRangeStats> &getStats() const { return stats; }
+
+  const std::vector<std::string> &getMetricNames() const { return metricNames; }
+
+  // nullptr if the range name was never added.
+  const GmpRangeStats *find(const std::string &name) const;
+
+private:
+  std::vector<std::string> metricNames;
+  std::vector<GmpRangeStats> stats;
+  std::unordered_map<std::string, size_t> indexByName;
+};
+
+#endif // GMP_RANGE_STATS_H
@@ -0,0 +1,120 @@
+#ifndef GMP_RESULT_DIFF_H
+#define GMP_RESULT_DIFF_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "gmp/data_struct.h"
+
+// One metric value of one range instance in a result.csv.
+struct GmpResultRow
+{
+  uint64_t key = 0;        // gmpHash64 of config name, range name and metric
+  uint32_t occurrence = 0; // Instance of the same key within the file, in file order
+  uint32_t line = 0;
+  std::string_view config;
+  std::string_view range;
+  std::string_view metric;
+  double value = 0.0;
+  double stddev = 0.0;     // Summary rows only, see GmpProfiler::setRangeSummary
+  uint32_t iterations = 0; // Summary rows only
+};
+
+// A parsed result.csv. Both the per-range rows (range,metric,value) and the
+// summary rows (range,metric,mean,stddev,min,max,cv,iterations) are accepted,
+// each section starting with a "Config Name,<name>" line. Rows point into the
+// file buffer held by the set and are sorted by (key, occurrence).
+class GmpResultSet
+{
+public:
+  GmpResultSet() = default;
+
+  // A copy would point its rows into the buffer of the original.
+  GmpResultSet(const GmpResultSet &) = delete;
+  GmpResultSet &operator=(const GmpResultSet &) = delete;
+  GmpResultSet(GmpResultSet &&) = default;
+  GmpResultSet &operator=(GmpResultSet &&) = default;
+
+  GmpResult load(const std::string &path);
+
+  GmpResult parse(std::string_view text);
+
+  const std::vector<GmpResultRow> &getRows() const { return rows; }
+
+  size_t getMalformedLineCount() const { return malformedLineCount; }
+
+private:
+  GmpResult parseBuffer();
+
+  // NUL-terminated. A vector keeps the row views valid when the set is moved.
+  std::vector<char> buffer;
+  std::vector<GmpResultRow> rows;
+  size_t malformedLineCount = 0;
+};
+
+enum class GmpBudgetDirection
+{
+  BOTH = 0,
+  INCREASE,
+  DECREASE,
+};
+
+// Largest relative change of a metric that still passes the gate.
+struct GmpDiffBudget
+{
+  std::string metric; // "*" applies to every metric without a budget of its own
+  double maxRelative = 0.0;
+  GmpBudgetDirection direction = GmpBudgetDirection::BOTH;
+};
+
+struct GmpDiffOptions
+{
+  // A change is noise if any of these hold. sigma only applies when both
+  // sides carry a stddev, i.e. summary rows. Budgets apply to every change,
+  // noise included.
+  double absNoise = 0.0;
+  double relNoise = 0.01;
+  double sigma = 3.0;
+  std::vector<GmpDiffBudget> budgets;
+  bool failOnMissing = false;
+};
+
+enum class GmpDiffStatus
+{
+  UNCHANGED = 0,
+  NOISE,
+  CHANGED,
+  OVER_BUDGET,
+  ONLY_BASE,
+  ONLY_NEW,
+};
+
+struct GmpDiffEntry
+{
+  const GmpResultRow *base = nullptr;
+  const GmpResultRow *current = nullptr;
+  double absDelta = 0.0;
+  double relDelta = 0.0; // Infinite when the base value is 0
+  GmpDiffStatus status = GmpDiffStatus::UNCHANGED;
+};
+
+struct GmpDiffReport
+{
+  std::vector<GmpDiffEntry> entries; // In key order
+  size_t statusCounts[6] = {};
+
+  size_t count(GmpDiffStatus status) const { return statusCounts[static_cast<int>(status)]; }
+};
+
+// Join two result sets on (config, range, metric, occurrence) with a single
+// merge over their sorted keys and classify every pair.
+GmpDiffReport gmpDiffResults(const GmpResultSet &base, const GmpResultSet &current, const GmpDiffOptions &options);
+
+// True if the report should fail a regression gate.
+bool gmpDiffFailed(const GmpDiffReport &report, const GmpDiffOptions &options);
+
+const char *gmpDiffStatusName(GmpDiffStatus status);
+
+#endif // GMP_RESULT_DIFF_H
@@ -0,0 +1,83 @@
+#ifndef GMP_ROOFLINE_H
+#define GMP_ROOFLINE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Peak throughput of one chip, at its boost clock.
+struct GmpRooflinePeaks
+{
+  std::string chipName;
+  uint32_t smCount = 0;
+  double clockGhz = 0.0;      // SM boost clock
+  double dramBandwidth = 0.0; // GB/s, i.e. bytes per ns
+
+  // Every SM has 4 SMSPs issuing at most one warp instruction per cycle,
+  // in G warp instructions per second.
+  double instructionRate() const { return 4.0 * smCount * clockGhz; }
+
+  bool isValid() const { return smCount > 0 && clockGhz > 0.0 && dramBandwidth > 0.0; }
+};
+
+enum class GmpRooflineBound
+{
+  UNKNOWN = 0, // No instructions or duration measured
+  MEMORY,
+  COMPUTE,
+};
+
+const char *gmpRooflineBoundName(GmpRooflineBound bound);
+
+// One kernel or range placed on the instruction roofline.
+struct GmpRooflinePoint
+{
+  std::string name;
+  std::string rangeName; // Enclosing range of a kernel, empty for a range
+  double instructions = 0.0; // smsp__inst_executed.sum, warp instructions
+  double dramBytes = 0.0;    // dram__sectors_read.sum + dram__sectors_write.sum, 32 bytes each
+  double durationNs = 0.0;   // gpu__time_duration.sum
+  double intensity = 0.0;    // Warp instructions per DRAM byte, infinite without DRAM traffic
+  double instructionRate = 0.0; // Achieved G warp instructions per second
+  double bandwidth = 0.0;       // Achieved DRAM GB/s
+  double roofRate = 0.0;        // Attainable instruction rate at this intensity
+  double roofFraction = 0.0;    // instructionRate / roofRate
+  GmpRooflineBound bound = GmpRooflineBound::UNKNOWN;
+
+  // How far below the roof the point is, 0 on the roof and 1 at the origin.
+  double distanceToRoof() const { return bound == GmpRooflineBound::UNKNOWN ? 0.0 : 1.0 - roofFraction; }
+};
+
+// Instruction roofline built from the default metric list: the attainable
+// rate at an intensity is min(peak instruction rate, intensity * peak DRAM
+// bandwidth). Points left of the ridge intensity, where both limits meet,
+// are memory-bound, the others compute-bound. Only the DRAM roof is modeled,
+// the cache hierarchy is not.
+class GmpRoofline
+{
+public:
+  static constexpr double DRAM_SECTOR_BYTES = 32.0;
+
+  explicit GmpRoofline(GmpRooflinePeaks peaks);
+
+  // Built-in peaks of a chip, as reported by CUPTI (e.g. "GA100"), matched
+  // case-insensitively. nullptr if the chip is not in the table.
+  static const GmpRooflinePeaks *findPeaks(const std::string &chipName);
+
+  static const std::vector<GmpRooflinePeaks> &getPeakTable();
+
+  const GmpRooflinePeaks &getPeaks() const { return peaks; }
+
+  // Warp instructions per byte where the memory roof meets the compute roof.
+  double ridgeIntensity() const { return peaks.instructionRate() / peaks.dramBandwidth; }
+
+  GmpRooflinePoint classify(const std::string &name, double instructions, double dramSectors, double durationNs) const;
+
+  // Write the points as CSV, one row per point after a header row.
+  static bool writeCsv(const std::string &path, const std::vector<GmpRooflinePoint> &points);
+
+private:
+  GmpRooflinePeaks peaks;
+};
+
+#endif // GMP_ROOFLINE_H
@@ -0,0 +1,84 @@
+#ifndef GMP_SAMPLING_H
+#define GMP_SAMPLING_H
+
+#include <chrono>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <unordered_map>
+
+enum class GmpSamplingMode
+{
+  ALL = 0,         // Profile every range once warm-up is over
+  EVERY_KTH,       // Profile every Kth occurrence of each range name
+  RANDOM_FRACTION, // Profile a fixed random fraction of the ranges
+  ADAPTIVE,        // Profile while the measured overhead stays under a budget
+};
+
+struct GmpSamplingPolicy
+{
+  GmpSamplingMode mode = GmpSamplingMode::ALL;
+
+  // Number of occurrences of each range name that are skipped as warm-up.
+  uint64_t warmupIterations = 0;
+
+  // EVERY_KTH: profile occurrence warmupIterations + n * period of a name.
+  uint64_t period = 1;
+
+  // RANDOM_FRACTION: probability in [0, 1] that a range is profiled.
+  double fraction = 1.0;
+  uint64_t seed = 0;
+
+  // ADAPTIVE: maximum share of wall time spent in profiled push/pop, in percent.
+  double overheadBudgetPct = 5.0;
+};
+
+// Decides per pushRange whether the range is profiled or skipped.
+class GmpRangeSampler
+{
+public:
+  using clock_t = std::chrono::steady_clock;
+
+  GmpRangeSampler() = default;
+
+  void setPolicy(const GmpSamplingPolicy &policy);
+
+  const GmpSamplingPolicy &getPolicy() const;
+
+  // False for the default policy, in which case shouldProfile() is never needed.
+  bool isActive() const { return active; }
+
+  bool isAdaptive() const { return policy.mode == GmpSamplingMode::ADAPTIVE; }
+
+  bool shouldProfile(const std::string &name);
+
+  // Same with nameHash = gmpHash64(name) already known, e.g. from GmpRangeName.
+  bool shouldProfile(uint64_t nameHash);
+
+  // Report the time spent inside a profiled push or pop (ADAPTIVE mode).
+  void recordOverhead(clock_t::duration elapsed);
+
+  uint64_t getProfiledCount() const { return profiledCount; }
+
+  uint64_t getSkippedCount() const { return skippedCount; }
+
+  void reset();
+
+private:
+  bool decide(uint64_t occurrence);
+
+  GmpSamplingPolicy policy;
+  bool active = false;
+  // Only warm-up and EVERY_KTH count occurrences, the other policies skip the lookup.
+  bool countsOccurrences = false;
+  std::unordered_map<uint64_t, uint64_t> occurrences; // By name hash
+  std::mt19937_64 rng;
+  std::uniform_real_distribution<double> uniform{0.0, 1.0};
+  clock_t::time_point firstDecision;
+  bool hasFirstDecision = false;
+  clock_t::duration overhead = clock_t::duration::zero();
+  uint64_t profiledCount = 0;
+  uint64_t skippedCount = 0;
+};
+
+#endif // GMP_SAMPLING_H
@@ -0,0 +1,51 @@
+#ifndef GMP_SCOPED_RANGE_H
+#define GMP_SCOPED_RANGE_H
+
+#include <string_view>
+
+#include "gmp/hash.h"
+#include "gmp/profile.h"
+#include "gmp/string_table.h"
+
+// Pushes a range for the lifetime of the object. Name is a type with a
+// constexpr static value() returning the range name:
+//
+//   struct Forward { static constexpr std::string_view value() { return "forward"; } };
+//   GmpScopedRange<Forward> range;
+//
+// or, for a string literal, GMP_SCOPED_RANGE("forward", GmpProfileType::CONCURRENT_KERNEL).
+// The name is hashed at compile time and interned once per Name in static
+// storage; every push and pop then reuses the interned handle, so the scope
+// builds no std::string and the object is empty.
+template <typename Name, GmpProfileType Type = GmpProfileType::CONCURRENT_KERNEL>
+class GmpScopedRange
+{
+public:
+  GmpScopedRange() { GmpProfiler::getInstance()->pushRange(rangeName(), Type); }
+
+  ~GmpScopedRange() { GmpProfiler::getInstance()->popRange(rangeName(), Type); }
+
+  GmpScopedRange(const GmpScopedRange &) = delete;
+  GmpScopedRange &operator=(const GmpScopedRange &) = delete;
+
+  static const GmpRangeName &rangeName()
+  {
+    static constexpr uint64_t hash = gmpHash64(Name::value());
+    static const GmpRangeName name = GmpStringTable::instance().internRangeName(Name::value(), hash);
+    return name;
+  }
+};
+
+#define GMP_SCOPED_RANGE_CONCAT_IMPL(a, b) a##b
+#define GMP_SCOPED_RANGE_CONCAT(a, b) GMP_SCOPED_RANGE_CONCAT_IMPL(a, b)
+
+// Profile the rest of the enclosing scope as a range named by a string literal.
+#define GMP_SCOPED_RANGE(name, type)                                              \
+  struct GMP_SCOPED_RANGE_CONCAT(GmpScopedRangeName_, __LINE__)                   \
+  {                                                                               \
+    static constexpr std::string_view value() { return name; }                    \
+  };                                                                              \
+  GmpScopedRange<GMP_SCOPED_RANGE_CONCAT(GmpScopedRangeName_, __LINE__), (type)> \
+      GMP_SCOPED_RANGE_CONCAT(gmpScopedRange_, __LINE__)
+
+#endif // GMP_SCOPED_RANGE_H
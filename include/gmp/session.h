@@ -4,9 +4,12 @@
 #include <vector>
 #include <string>
 #include <chrono>
+#include <memory>
 #include <cupti.h>
 
+#include "gmp/arena.h"
 #include "gmp/data_struct.h"
+#include "gmp/string_table.h"
 
 // Abstract Node
 class GmpProfileSession
@@ -15,12 +18,18 @@ class GmpProfileSession
 
 public:
   GmpProfileSession(const std::string &session_name)
-      : sessionName(session_name) {}
+      : sessionNameId(GmpStringTable::instance().intern(session_name)) {}
+  // Name already interned in GmpStringTable, e.g. a GmpRangeName id
+  explicit GmpProfileSession(uint32_t sessionNameId)
+      : sessionNameId(sessionNameId) {}
   virtual ~GmpProfileSession() = default;
   virtual void report() const = 0;
   bool isActive() const;
   void deactivate();
-  std::string getSessionName();
+  const std::string &getSessionName() const;
+
+  // Carve the record blocks from arena. Only before the first record.
+  void setArena(GmpArena *arena);
 
   void setRuntimeData(const ApiRuntimeRecord &data);
 
@@ -34,32 +43,102 @@ public:
 
   void pushKernelData(const GmpKernelData &data);
 
+  // Count a kernel dropped by the kernel filter without storing it.
+  void pushFilteredKernel();
+
+  size_t getKernelLaunchCount() const;
+
   void pushMemData(const GmpMemData &data);
 
   std::vector<GmpKernelData> getKernelData() const;
 
   std::vector<GmpMemData> getMemData() const;
 
+  void pushTransferData(const GmpTransferData &data);
+
+  // Kernel execution recorded alongside the transfers, for copy/compute overlap.
+  void pushComputeInterval(const GmpTimeInterval &interval);
+
+  void addUnifiedMemoryCounter(CUpti_ActivityUnifiedMemoryCounterKind kind, uint64_t value, uint64_t start, uint64_t end);
+
+  const GmpUnifiedMemorySummary &getUnifiedMemorySummary() const;
+
+  // Access the records without copying them
+  const GmpRecordList<GmpKernelData> &getKernelDataView() const;
+
+  const GmpMemColumns &getMemDataView() const;
+
+  const GmpRecordList<GmpTransferData> &getTransferDataView() const;
+
+  const GmpRecordList<GmpTimeInterval> &getComputeIntervalView() const;
+
+  // CUPTI timestamps of push and pop, in ns. 0 if unknown.
+  void setStartTimestamp(uint64_t timestamp);
+
+  void setEndTimestamp(uint64_t timestamp);
+
+  uint64_t getStartTimestamp() const;
+
+  uint64_t getEndTimestamp() const;
+
+  // Bytes held by the records, what releasing them would free.
+  size_t getRecordBytes() const;
+
+  // Append the kernel, memory, transfer and compute interval records to out
+  // in a compact binary form, for the session spill file.
+  void serializeRecords(std::vector<uint8_t> &out) const;
+
+  // Replace the records with the ones serialized in data.
+  bool deserializeRecords(const uint8_t *data, size_t size);
+
+  // Free the records. The name, timestamps, counts and summaries stay.
+  void releaseRecords();
+
 protected:
-  std::string sessionName;      // Name of the profiling session
+  uint32_t sessionNameId;       // Name of the profiling session in GmpStringTable
   ApiRuntimeRecord runtimeData; // Data structure to hold timing information
 #ifdef USE_CUPTI
   CUpti_SubscriberHandle runtimeSubscriber;
   CUcontext context = 0;
 #endif
-  std::vector<GmpKernelData> kernelData; // Names of kernels launched in this session
-  std::vector<GmpMemData> memData;       // Memory operations in this session
+  GmpRecordList<GmpKernelData> kernelData; // Kernels launched in this session
+  GmpMemColumns memData;                   // Memory operations in this session
+  GmpRecordList<GmpTransferData> transferData;     // Memcpy and memset operations in this session
+  GmpRecordList<GmpTimeInterval> computeIntervals; // Kernels run while a transfer session is active
+  GmpUnifiedMemorySummary unifiedMemory;        // Page faults and migrations in this session
+  size_t kernelLaunchCount = 0;          // Stored and filtered kernels, kept when the records are released
+  uint64_t startTimestamp = 0;
+  uint64_t endTimestamp = 0;
   bool is_active = true;
 };
 
+// Deletes a session built by SessionManager::createSession in its arena,
+// or a heap one, e.g. from std::make_unique, when arena is null.
+struct GmpSessionDeleter
+{
+  GmpArena *arena = nullptr;
+  size_t size = 0; // sizeof the concrete session
+
+  GmpSessionDeleter() = default;
+  GmpSessionDeleter(GmpArena *arena, size_t size) : arena(arena), size(size) {}
+  template <typename Session>
+  GmpSessionDeleter(const std::default_delete<Session> &) {}
+
+  void operator()(GmpProfileSession *session) const;
+};
+
+using GmpSessionPtr = std::unique_ptr<GmpProfileSession, GmpSessionDeleter>;
+
 // Concrete Node
 class GmpConcurrentKernelSession : public GmpProfileSession
 {
 public:
   GmpConcurrentKernelSession(const std::string &sessionName);
 
+  explicit GmpConcurrentKernelSession(uint32_t sessionNameId);
+
   void report() const override;
-  unsigned long long num_calls;
+  unsigned long long num_calls = 0;
 
 private:
 };
@@ -69,10 +148,22 @@ class GmpMemSession : public GmpProfileSession
 public:
   GmpMemSession(const std::string &sessionName);
 
+  explicit GmpMemSession(uint32_t sessionNameId);
+
   void report() const override;
-  unsigned long long num_calls;
+  unsigned long long num_calls = 0;
 
 private:
 };
 
+class GmpTransferSession : public GmpProfileSession
+{
+public:
+  GmpTransferSession(const std::string &sessionName);
+
+  explicit GmpTransferSession(uint32_t sessionNameId);
+
+  void report() const override;
+};
+
 #endif // GMP_SESSION_H
\ No newline at end of file
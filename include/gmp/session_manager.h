@@ -1,19 +1,57 @@
 #ifndef GMP_SESSION_MANAGER_H
 #define GMP_SESSION_MANAGER_H
 
+#include <deque>
 #include <map>
 #include <memory>
+#include <unordered_map>
 #include <vector>
 #include <functional>
 
+#include "gmp/arena.h"
 #include "gmp/session.h"
+#include "gmp/session_spill.h"
 #include "gmp/data_struct.h"
 
+struct GmpSessionStorageStats
+{
+  size_t memoryBudget = 0;    // 0 when unlimited
+  size_t residentBytes = 0;   // Records of the completed sessions held in memory
+  size_t spilledSessions = 0; // Sessions whose records live in the spill file
+  uint64_t spilledBytes = 0;  // Size of the spill file
+  size_t pageIns = 0;         // Spilled sessions read back for a report
+};
+
 class SessionManager
 {
 public:
   SessionManager() = default;
 
+  // Keep the records of completed sessions under budget bytes. Beyond it,
+  // the oldest completed sessions are written to the spill file at path and
+  // their records freed; reports read them back one session at a time, so
+  // memory stays bounded by the budget plus the active sessions and the
+  // largest single session. 0 disables the budget. Must be set before the
+  // first session ends.
+  GmpResult setMemoryBudget(size_t bytes, const std::string &spillPath);
+
+  GmpSessionStorageStats getStorageStats() const;
+
+  // Build a session in the arena of this manager; its records are carved
+  // from the arena too, so opening a range and adding records to it make no
+  // heap allocation once the arena has grown to the working set.
+  template <typename Session, typename... Args>
+  GmpSessionPtr createSession(Args &&...args);
+
+  // Drop every session and rewind the arena for a new epoch. Refused while
+  // a session is active.
+  GmpResult reset();
+
+  // True while a session of any type has been started and not ended.
+  bool hasActiveSession() const;
+
+  GmpArenaStats getArenaStats() const;
+
   std::string getSessionName(GmpProfileType type);
 
   template <typename DerivedSession>
@@ -25,19 +63,64 @@ public:
 
   GmpResult reportAllSessions();
 
-  GmpResult startSession(GmpProfileType type, std::unique_ptr<GmpProfileSession> sessionPtr);
+  // sessionPtr comes from createSession, or from std::make_unique.
+  GmpResult startSession(GmpProfileType type, GmpSessionPtr sessionPtr);
 
-  GmpResult endSession(GmpProfileType type);
+  GmpResult endSession(GmpProfileType type, uint64_t endTimestamp = 0);
+
+  // Visit the sessions of a type in push order without copying their records.
+  // Spilled sessions are paged in for the call and released after it. One
+  // that cannot be read back is visited without records.
+  template <typename Func>
+  void forEachSession(GmpProfileType type, Func &&func) const;
+
+  // Same from the firstSession-th session of the type on, until func returns
+  // false, so an incremental pass neither walks nor pages in the sessions
+  // before and after the ones it needs.
+  template <typename Func>
+  void forEachSessionFrom(GmpProfileType type, size_t firstSession, Func &&func) const;
 
   std::vector<GmpRangeData> getAllKernelDataOfType(GmpProfileType type);
 
   std::vector<GmpMemRangeData> getAllMemDataOfType(GmpProfileType type);
 
 private:
-  std::map<GmpProfileType, std::vector<std::unique_ptr<GmpProfileSession>>> ActivityMap;
+  // Spill the oldest completed sessions until the resident records fit the budget.
+  void enforceMemoryBudget();
+
+  // Read the records of a spilled session back, false on error.
+  bool pageIn(GmpProfileSession &session) const;
+
+  void pageOut(GmpProfileSession &session) const;
+
+  // Declared before the sessions, which release their blocks to it.
+  GmpArena arena;
+  std::map<GmpProfileType, std::vector<GmpSessionPtr>> ActivityMap;
+
+  size_t memoryBudget = 0;
+  size_t residentBytes = 0;
+  // Completed sessions with resident records, oldest first, with their size when they ended.
+  std::deque<std::pair<GmpProfileSession *, size_t>> residentSessions;
+  std::unordered_map<const GmpProfileSession *, GmpSessionSpillSlot> spillSlots;
+  GmpSessionSpillFile spillFile;
+  mutable std::vector<uint8_t> pageBuffer; // Reused by every spill and page-in
+  mutable size_t pageInCount = 0;
 };
 
 // Template function implementations
+template <typename Session, typename... Args>
+GmpSessionPtr SessionManager::createSession(Args &&...args)
+{
+    void *memory = arena.allocate(sizeof(Session));
+    if (!memory)
+    {
+        throw std::bad_alloc();
+    }
+    Session *session = new (memory) Session(std::forward<Args>(args)...);
+    session->setArena(&arena);
+    return GmpSessionPtr(session, GmpSessionDeleter(&arena, sizeof(Session)));
+}
+
 template <typename DerivedSession>
 GmpResult SessionManager::accumulate(GmpProfileType type, AccumulateFunc<DerivedSession> callback)
 {
@@ -60,4 +143,45 @@ GmpResult SessionManager::accumulate(GmpProfileType type, AccumulateFunc<Derived
     return GmpResult::SUCCESS;
 }
 
+template <typename Func>
+void SessionManager::forEachSession(GmpProfileType type, Func &&func) const
+{
+    forEachSessionFrom(type, 0, [&func](const GmpProfileSession &session)
+                       {
+                           func(session);
+                           return true;
+                       });
+}
+
+template <typename Func>
+void SessionManager::forEachSessionFrom(GmpProfileType type, size_t firstSession, Func &&func) const
+{
+    auto it = ActivityMap.find(type);
+    if (it == ActivityMap.end())
+    {
+        return;
+    }
+    const auto &sessions = it->second;
+    for (size_t sessionIndex = firstSession; sessionIndex < sessions.size(); ++sessionIndex)
+    {
+        GmpProfileSession &session = *sessions[sessionIndex];
+        bool isPaged = !spillSlots.empty();
+        // A session that cannot be read back is still visited, without its
+        // records, so callers indexing ranges by session stay aligned.
+        if (isPaged)
+        {
+            pageIn(session);
+        }
+        bool keepGoing = func(static_cast<const GmpProfileSession &>(session));
+        if (isPaged)
+        {
+            pageOut(session);
+        }
+        if (!keepGoing)
+        {
+            return;
+        }
+    }
+}
+
 #endif // GMP_SESSION_MANAGER_H
\ No newline at end of file
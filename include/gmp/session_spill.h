@@ -0,0 +1,52 @@
+#ifndef GMP_SESSION_SPILL_H
+#define GMP_SESSION_SPILL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "gmp/data_struct.h"
+
+// Location of one spilled session in a GmpSessionSpillFile.
+struct GmpSessionSpillSlot
+{
+  uint64_t offset = 0;
+  uint64_t size = 0;
+};
+
+// Scratch file the records of completed sessions are written to once the
+// memory budget of the SessionManager is exceeded. Slots are appended and
+// never rewritten: a session paged back in is only released again, so each
+// session is written once. The file is removed when closed.
+class GmpSessionSpillFile
+{
+public:
+  GmpSessionSpillFile() = default;
+  ~GmpSessionSpillFile();
+
+  GmpSessionSpillFile(const GmpSessionSpillFile &) = delete;
+  GmpSessionSpillFile &operator=(const GmpSessionSpillFile &) = delete;
+
+  GmpResult open(const std::string &path);
+
+  bool isOpen() const { return fd >= 0; }
+
+  GmpResult append(const std::vector<uint8_t> &payload, GmpSessionSpillSlot &slot);
+
+  // Read a slot into out, which is resized to the slot size.
+  GmpResult read(const GmpSessionSpillSlot &slot, std::vector<uint8_t> &out) const;
+
+  void close();
+
+  uint64_t getSize() const { return size; }
+
+  const std::string &getPath() const { return path; }
+
+private:
+  int fd = -1;
+  uint64_t size = 0;
+  std::string path;
+};
+
+#endif // GMP_SESSION_SPILL_H
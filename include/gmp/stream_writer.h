@@ -0,0 +1,93 @@
+#ifndef GMP_STREAM_WRITER_H
+#define GMP_STREAM_WRITER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <sys/types.h>
+#include <unordered_map>
+#include <vector>
+
+#include "gmp/data_struct.h"
+
+// Streaming mode of GmpProfiler, see GmpProfiler::enableStreaming.
+struct GmpStreamingConfig
+{
+  std::string path;            // CSV file the windows are appended to
+  size_t rangeInterval = 0;    // Close a window every this many kernel ranges, 0 to not count ranges
+  double intervalSeconds = 0;  // Close a window after this many seconds, 0 to not time windows
+  GmpOutputKernelReduction reduction = GmpOutputKernelReduction::SUM;
+};
+
+struct GmpStreamingStats
+{
+  size_t windows = 0;       // Windows written and freed
+  size_t ranges = 0;        // Kernel ranges written
+  uint64_t bytesWritten = 0; // By this process, without the header
+};
+
+// Append-only CSV of the reduced metrics of completed kernel ranges, one row
+// per range:
+//
+//   range_index,range,start_ns,end_ns,kernels,<metric>,...
+//
+// Rows are buffered until commit(), which appends the whole window with one
+// write and syncs it, so a killed process leaves every committed window in
+// the file and at most a torn last line. open() cuts such a line off before
+// appending, refuses a file whose header lists other metrics, and continues
+// the range_index of its last row.
+class GmpStreamWriter
+{
+public:
+  GmpStreamWriter() = default;
+  ~GmpStreamWriter();
+
+  GmpStreamWriter(const GmpStreamWriter &) = delete;
+  GmpStreamWriter &operator=(const GmpStreamWriter &) = delete;
+
+  GmpResult open(const std::string &path, const std::vector<std::string> &metricNames);
+
+  bool isOpen() const { return fd >= 0; }
+
+  // Buffer one row, numbered after the rows before it. Metrics missing from
+  // metricValues, e.g. of a range without kernels, are left empty.
+  void appendRange(const std::string &name, uint64_t startNs, uint64_t endNs, size_t kernelCount,
+                   const std::unordered_map<std::string, double> &metricValues);
+
+  // Append and sync the buffered rows. On failure the file is cut back to
+  // the last committed window and the rows are dropped.
+  GmpResult commit();
+
+  void close();
+
+  // Bytes of the file, header included.
+  uint64_t getSize() const { return size; }
+
+  const std::string &getPath() const { return path; }
+
+  // range_index of the next committed row.
+  size_t getNextRangeIndex() const { return nextRangeIndex; }
+
+private:
+  // Cut the file after its last complete line, false on error.
+  bool truncateTornLine();
+
+  // Offset after the last newline before end, 0 if there is none. False on error.
+  bool findLineStart(off_t end, off_t &lineStart);
+
+  // Set nextRangeIndex from the last row after the header, false if it has none.
+  bool readNextRangeIndex(size_t headerSize);
+
+  // Write all of data at the end of the file, false on error.
+  bool writeAll(const std::string &data);
+
+  int fd = -1;
+  uint64_t size = 0;
+  std::string path;
+  std::vector<std::string> metrics;
+  std::string pending; // Rows of the window not committed yet
+  size_t pendingRangeCount = 0;
+  size_t nextRangeIndex = 0;
+};
+
+#endif // GMP_STREAM_WRITER_H
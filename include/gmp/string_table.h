@@ -0,0 +1,49 @@
+#ifndef GMP_STRING_TABLE_H
+#define GMP_STRING_TABLE_H
+
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+// A range name interned once, e.g. by GmpScopedRange, so that pushing it
+// builds no std::string. name stays valid for the lifetime of the process.
+struct GmpRangeName
+{
+  const std::string *name;
+  uint32_t id;   // In GmpStringTable
+  uint64_t hash; // gmpHash64 of the name
+};
+
+// Process-wide string interner. CUPTI only guarantees its name pointers for
+// the lifetime of the activity buffer, so records keep a 32-bit id instead.
+// Id 0 is always the empty string. Safe to use from the CUPTI buffer thread.
+class GmpStringTable
+{
+public:
+  static GmpStringTable &instance();
+
+  uint32_t intern(std::string_view str);
+
+  // nullptr is interned as the empty string.
+  uint32_t intern(const char *str);
+
+  // hash must be gmpHash64(str), usually computed at compile time.
+  GmpRangeName internRangeName(std::string_view str, uint64_t hash);
+
+  // The returned reference stays valid for the lifetime of the process.
+  const std::string &get(uint32_t id) const;
+
+  size_t size() const;
+
+private:
+  GmpStringTable();
+
+  mutable std::mutex mutex;
+  std::deque<std::string> strings;
+  std::unordered_map<std::string_view, uint32_t> ids;
+};
+
+#endif // GMP_STRING_TABLE_H
@@ -0,0 +1,72 @@
+#ifndef GMP_TRACE_WRITER_H
+#define GMP_TRACE_WRITER_H
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <string_view>
+
+// Streaming writer for the Chrome JSON trace format, which Perfetto UI and
+// chrome://tracing both load. Events are serialized into a fixed-size buffer
+// that is flushed to disk when full, so memory use does not depend on the
+// number of events. Timestamps are given in ns and written in us.
+//
+// Usage: beginComplete/beginInstant, any number of addArg, then endEvent.
+class GmpTraceWriter
+{
+public:
+  explicit GmpTraceWriter(size_t flushThreshold = 1 << 20);
+
+  ~GmpTraceWriter();
+
+  GmpTraceWriter(const GmpTraceWriter &) = delete;
+  GmpTraceWriter &operator=(const GmpTraceWriter &) = delete;
+
+  bool open(const std::string &path);
+
+  // Write the trailer and close the file. Called by the destructor if needed.
+  bool close();
+
+  bool isOpen() const { return file != nullptr; }
+
+  size_t getEventCount() const { return eventCount; }
+
+  void processName(uint32_t pid, std::string_view name);
+
+  void threadName(uint32_t pid, uint32_t tid, std::string_view name);
+
+  // Duration event ("X").
+  void beginComplete(std::string_view name, std::string_view category, uint32_t pid, uint32_t tid,
+                     uint64_t startNs, uint64_t durationNs);
+
+  // Instant event ("i") scoped to its thread.
+  void beginInstant(std::string_view name, std::string_view category, uint32_t pid, uint32_t tid,
+                    uint64_t timestampNs);
+
+  void addArg(std::string_view key, std::string_view value);
+  void addArg(std::string_view key, uint64_t value);
+  void addArg(std::string_view key, double value);
+
+  void endEvent();
+
+  // Counter event ("C"), one series per call.
+  void counter(std::string_view name, uint32_t pid, uint64_t timestampNs, std::string_view series, double value);
+
+private:
+  void beginEvent(std::string_view name, std::string_view category, char phase, uint32_t pid, uint32_t tid,
+                  uint64_t timestampNs);
+  void metadata(std::string_view type, uint32_t pid, uint32_t tid, std::string_view name);
+  void appendString(std::string_view str);
+  void appendTimestamp(uint64_t ns);
+  void beginArg(std::string_view key);
+  void flushIfNeeded();
+  void flush();
+
+  FILE *file = nullptr;
+  std::string buffer;
+  size_t flushThreshold;
+  size_t eventCount = 0;
+  bool hasArgs = false;
+};
+
+#endif // GMP_TRACE_WRITER_H
@@ -0,0 +1,85 @@
+#ifndef GMP_TRANSFER_STATS_H
+#define GMP_TRANSFER_STATS_H
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "gmp/data_struct.h"
+
+enum class GmpTransferDirection
+{
+  HOST_TO_DEVICE = 0, // Including host to array
+  DEVICE_TO_HOST,     // Including array to host
+  DEVICE_TO_DEVICE,   // Including copies from, to and between arrays
+  HOST_TO_HOST,
+  PEER_TO_PEER,
+  MEMSET,
+  UNKNOWN,
+  COUNT,
+};
+
+const char *gmpTransferDirectionName(GmpTransferDirection direction);
+
+GmpTransferDirection gmpTransferDirectionOf(const GmpTransferData &transfer);
+
+struct GmpTransferDirectionStats
+{
+  size_t count = 0;
+  uint64_t bytes = 0;
+  uint64_t durationNs = 0; // Sum of the transfer durations
+
+  // Achieved bandwidth while transferring, in GB/s (bytes per ns).
+  double bandwidth() const { return durationNs ? static_cast<double>(bytes) / durationNs : 0.0; }
+};
+
+struct GmpTransferStats
+{
+  // Transfer size buckets, each 16 times the previous one:
+  // < 4 KiB, < 64 KiB, < 1 MiB, < 16 MiB, < 256 MiB, >= 256 MiB.
+  static constexpr size_t SIZE_BUCKET_COUNT = 6;
+
+  static size_t sizeBucket(uint64_t bytes);
+
+  static const char *sizeBucketName(size_t bucket);
+
+  std::string name;
+  size_t transferCount = 0;
+  uint64_t totalBytes = 0;
+  std::array<GmpTransferDirectionStats, static_cast<size_t>(GmpTransferDirection::COUNT)> directions;
+  std::array<size_t, SIZE_BUCKET_COUNT> sizeHistogram = {};
+  // Copies from or to pageable host memory. The driver stages them through a
+  // pinned buffer, so they are slower and synchronous with the host even
+  // when issued with cudaMemcpyAsync.
+  size_t pageableCount = 0;
+  uint64_t pageableBytes = 0;
+  size_t kernelCount = 0; // Kernels run in the range, for the overlap
+  uint64_t copyBusyNs = 0; // Time with at least one memcpy running
+  uint64_t overlapNs = 0;  // Part of copyBusyNs with a kernel running as well
+
+  const GmpTransferDirectionStats &direction(GmpTransferDirection direction) const
+  {
+    return directions[static_cast<size_t>(direction)];
+  }
+
+  double overlapFraction() const { return copyBusyNs ? static_cast<double>(overlapNs) / copyBusyNs : 0.0; }
+};
+
+// Per-range summary of MEMCPY and MEMSET activity records.
+// Copy/compute overlap intersects the union of the memcpy intervals with the
+// union of the kernel intervals, after sorting both, so it costs
+// O((m + k) log(m + k)) for m copies and k kernels. Memsets run on the copy
+// engines too but are not copies, they only count towards bytes and sizes.
+class GmpTransferAnalyzer
+{
+public:
+  GmpTransferStats analyze(const std::string &name, const GmpRecordList<GmpTransferData> &transfers,
+                           const GmpRecordList<GmpTimeInterval> &computeIntervals) const;
+
+private:
+  // Sort and merge overlapping intervals in place.
+  static void mergeIntervals(std::vector<GmpTimeInterval> &intervals);
+};
+
+#endif // GMP_TRANSFER_STATS_H
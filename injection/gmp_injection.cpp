@@ -0,0 +1,211 @@
+// libgmp_injection.so: profile unmodified applications through their NVTX ranges.
+//
+//   NVTX_INJECTION64_PATH=/path/to/libgmp_injection.so ./app
+//
+// NVTX loads the library on the first NVTX call of the application and calls
+// InitializeInjectionNvtx2, which attaches a GmpNvtxBridge. The profiler is
+// initialized right before the first mapped range, and the report is written
+// when the application exits. Configuration comes from the environment:
+//
+//   GMP_NVTX_DOMAINS   Comma-separated domains to map, @default for ranges
+//                      pushed without a domain (default: every domain)
+//   GMP_NVTX_INCLUDE   Comma-separated substrings, only matching ranges are mapped
+//   GMP_NVTX_EXCLUDE   Comma-separated substrings, matching ranges are not mapped
+//   GMP_NVTX_TYPE      kernel (default), memory or transfer
+//   GMP_CONFIG_NAME    Config name of the result.csv rows (default nvtx)
+//   GMP_REDUCTION      sum (default), max or mean
+//   GMP_TRACE          Also write a Chrome trace to this path
+//   GMP_SPILL          Capture to this spill file instead of reporting, see gmp_replay
+//   GMP_UNIFIED_MEMORY 1 to also report unified memory migrations and page faults
+//   GMP_MEMORY_BUDGET  MiB of completed range records kept in memory, the
+//                      older ones are spilled to a temporary file (default: no limit)
+//   GMP_STREAM         Append the metrics of completed kernel ranges to this CSV
+//                      during the run and free them, instead of reporting at exit
+//   GMP_STREAM_RANGES  Ranges per streamed window (default 100)
+//   GMP_STREAM_SECONDS Also close a window after this many seconds (default: not timed)
+
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <sys/stat.h>
+#include "gmp/nvtx_bridge.h"
+#include "gmp/profile.h"
+
+namespace
+{
+    struct InjectionConfig
+    {
+        GmpProfileType type = GmpProfileType::CONCURRENT_KERNEL;
+        std::string configName = "nvtx";
+        GmpOutputKernelReduction reduction = GmpOutputKernelReduction::SUM;
+        std::string tracePath;
+        std::string spillPath;
+        bool unifiedMemory = false;
+        size_t memoryBudgetMb = 0;
+        GmpStreamingConfig streaming;
+    };
+
+    InjectionConfig config;
+    GmpNvtxBridge *bridge = nullptr;
+
+    std::string getEnvironment(const char *name)
+    {
+        const char *value = getenv(name);
+        return value ? value : "";
+    }
+
+    std::vector<std::string> splitList(const std::string &list)
+    {
+        std::vector<std::string> items;
+        size_t begin = 0;
+        while (begin <= list.size())
+        {
+            size_t end = list.find(',', begin);
+            if (end == std::string::npos)
+            {
+                end = list.size();
+            }
+            if (end > begin)
+            {
+                items.push_back(list.substr(begin, end - begin));
+            }
+            begin = end + 1;
+        }
+        return items;
+    }
+
+    void report()
+    {
+        GmpProfiler *profiler = GmpProfiler::getInstance();
+        if (config.type == GmpProfileType::CONCURRENT_KERNEL)
+        {
+            profiler->stopRangeProfiling();
+            if (!config.streaming.path.empty() && config.spillPath.empty())
+            {
+                // Only the last window is left, the stream holds the rest.
+                profiler->closeStreaming();
+                GmpStreamingStats stats = profiler->getStreamingStats();
+                GMP_LOG_INFO("Streamed " + std::to_string(stats.ranges) + " ranges in " + std::to_string(stats.windows) +
+                             " windows to " + config.streaming.path + ".");
+                return;
+            }
+            profiler->decodeCounterData();
+        }
+        if (!config.spillPath.empty())
+        {
+            profiler->closeSpill();
+            return;
+        }
+        if (config.type == GmpProfileType::CONCURRENT_KERNEL)
+        {
+            mkdir("output", 0755);
+            profiler->printProfilerRanges(config.configName, config.reduction);
+        }
+        else if (config.type == GmpProfileType::TRANSFER)
+        {
+            profiler->printTransferStats();
+        }
+        else
+        {
+            profiler->printMemoryActivity();
+        }
+        if (config.unifiedMemory)
+        {
+            profiler->printUnifiedMemorySummary();
+        }
+        if (!config.tracePath.empty())
+        {
+            profiler->exportTrace(config.tracePath);
+        }
+        GMP_LOG_INFO("Mapped " + std::to_string(bridge->getMappedRangeCount()) + " NVTX ranges, ignored " +
+                     std::to_string(bridge->getIgnoredRangeCount()) + ".");
+    }
+
+    // Runs right before the first mapped range, i.e. after the application
+    // started using CUDA, so report() is registered after the CUDA runtime's
+    // own exit handlers and runs before them.
+    void startProfiler()
+    {
+        GmpProfiler *profiler = GmpProfiler::getInstance();
+        if (!config.spillPath.empty())
+        {
+            profiler->setSpillFile(config.spillPath);
+        }
+        profiler->setUnifiedMemoryCounters(config.unifiedMemory);
+        if (config.memoryBudgetMb > 0)
+        {
+            profiler->setMemoryBudget(config.memoryBudgetMb << 20);
+        }
+        if (!config.streaming.path.empty())
+        {
+            profiler->enableStreaming(config.streaming);
+        }
+        profiler->init();
+        if (config.type == GmpProfileType::CONCURRENT_KERNEL)
+        {
+            profiler->startRangeProfiling();
+        }
+        atexit(report);
+    }
+
+    GmpNvtxBridge *createBridge()
+    {
+        std::string type = getEnvironment("GMP_NVTX_TYPE");
+        config.type = type == "memory"     ? GmpProfileType::MEMORY
+                      : type == "transfer" ? GmpProfileType::TRANSFER
+                                           : GmpProfileType::CONCURRENT_KERNEL;
+        if (!type.empty() && type != "memory" && type != "transfer" && type != "kernel")
+        {
+            GMP_LOG_WARNING("GMP_NVTX_TYPE must be kernel, memory or transfer, using kernel.");
+        }
+        std::string reduction = getEnvironment("GMP_REDUCTION");
+        config.reduction = reduction == "max"    ? GmpOutputKernelReduction::MAX
+                           : reduction == "mean" ? GmpOutputKernelReduction::MEAN
+                                                 : GmpOutputKernelReduction::SUM;
+        if (std::string configName = getEnvironment("GMP_CONFIG_NAME"); !configName.empty())
+        {
+            config.configName = configName;
+        }
+        config.tracePath = getEnvironment("GMP_TRACE");
+        config.spillPath = getEnvironment("GMP_SPILL");
+        config.unifiedMemory = getEnvironment("GMP_UNIFIED_MEMORY") == "1";
+        config.memoryBudgetMb = strtoull(getEnvironment("GMP_MEMORY_BUDGET").c_str(), nullptr, 10);
+        config.streaming.path = getEnvironment("GMP_STREAM");
+        if (!config.streaming.path.empty() && config.type != GmpProfileType::CONCURRENT_KERNEL)
+        {
+            GMP_LOG_WARNING("GMP_STREAM only streams kernel ranges, ignored.");
+            config.streaming.path.clear();
+        }
+        std::string streamRanges = getEnvironment("GMP_STREAM_RANGES");
+        config.streaming.rangeInterval = streamRanges.empty() ? 100 : strtoull(streamRanges.c_str(), nullptr, 10);
+        config.streaming.intervalSeconds = strtod(getEnvironment("GMP_STREAM_SECONDS").c_str(), nullptr);
+        config.streaming.reduction = config.reduction;
+
+        auto *created = new GmpNvtxBridge(GmpProfiler::getInstance(), config.type);
+        for (const auto &domain : splitList(getEnvironment("GMP_NVTX_DOMAINS")))
+        {
+            created->addDomain(domain);
+        }
+        for (const auto &pattern : splitList(getEnvironment("GMP_NVTX_INCLUDE")))
+        {
+            created->addRangeFilter(pattern, GmpFilterAction::INCLUDE);
+        }
+        for (const auto &pattern : splitList(getEnvironment("GMP_NVTX_EXCLUDE")))
+        {
+            created->addRangeFilter(pattern, GmpFilterAction::EXCLUDE);
+        }
+        created->setFirstRangeHook(startProfiler);
+        return created;
+    }
+}
+
+// Called by every NVTX client of the process (the application and each
+// library with its own copy of the NVTX headers) that loads this library.
+extern "C" __attribute__((visibility("default"))) int InitializeInjectionNvtx2(NvtxGetExportTableFunc_t getExportTable)
+{
+    // Never deleted, NVTX may call into it until the process exits.
+    static GmpNvtxBridge *instance = createBridge();
+    bridge = instance;
+    return bridge->attach(getExportTable) == GmpResult::SUCCESS ? 1 : 0;
+}
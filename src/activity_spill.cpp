@@ -0,0 +1,452 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cupti.h>
+#include "gmp/activity_spill.h"
+#include "gmp/log.h"
+
+namespace
+{
+constexpr char SPILL_MAGIC[8] = {'G', 'M', 'P', 'S', 'P', 'I', 'L', 'L'};
+constexpr uint32_t SPILL_VERSION = 1;
+constexpr size_t INITIAL_CAPACITY = size_t(64) << 20;
+constexpr size_t GROWTH_GRANULARITY = size_t(1) << 20;
+
+struct SpillFileHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t cuptiVersion;
+    uint64_t committedSize; // Header included
+    uint32_t pointerSize;
+    uint32_t reserved0;
+    uint64_t reserved[4];
+};
+static_assert(sizeof(SpillFileHeader) == 64, "spill file header must stay 64 bytes");
+
+size_t alignUp(size_t size)
+{
+    return (size + 7) & ~size_t(7);
+}
+
+// Call visit on every CUPTI-owned string pointer of the records GMP decodes.
+template <typename Visit>
+void forEachStringField(uint8_t *buffer, size_t validSize, Visit visit)
+{
+    CUpti_Activity *record = nullptr;
+    while (cuptiActivityGetNextRecord(buffer, validSize, &record) == CUPTI_SUCCESS)
+    {
+        if (record->kind == CUPTI_ACTIVITY_KIND_CONCURRENT_KERNEL)
+        {
+            visit(((CUpti_ActivityKernel8 *)record)->name);
+        }
+        else if (record->kind == CUPTI_ACTIVITY_KIND_MEMORY2)
+        {
+            auto *memRecord = (CUpti_ActivityMemory4 *)record;
+            visit(memRecord->name);
+            visit(memRecord->source);
+        }
+    }
+}
+
+// Length-prefixed fields of a COUNTER_DATA payload.
+void putBytes(std::vector<uint8_t> &out, const void *data, size_t size)
+{
+    uint64_t length = size;
+    const auto *lengthBytes = reinterpret_cast<const uint8_t *>(&length);
+    out.insert(out.end(), lengthBytes, lengthBytes + sizeof(length));
+    const auto *bytes = reinterpret_cast<const uint8_t *>(data);
+    out.insert(out.end(), bytes, bytes + size);
+}
+
+bool getBytes(const uint8_t *&cursor, const uint8_t *end, const uint8_t *&data, size_t &size)
+{
+    uint64_t length = 0;
+    if (size_t(end - cursor) < sizeof(length))
+    {
+        return false;
+    }
+    memcpy(&length, cursor, sizeof(length));
+    cursor += sizeof(length);
+    if (size_t(end - cursor) < length)
+    {
+        return false;
+    }
+    data = cursor;
+    size = length;
+    cursor += length;
+    return true;
+}
+} // namespace
+
+GmpSpillWriter::~GmpSpillWriter()
+{
+    close();
+}
+
+GmpResult GmpSpillWriter::open(const std::string &path, uint32_t cuptiVersion)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (fd >= 0)
+    {
+        GMP_LOG_ERROR("Spill file is already open.");
+        return GmpResult::ERROR;
+    }
+    fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+    {
+        GMP_LOG_ERROR("Failed to open spill file " + path + ": " + strerror(errno));
+        return GmpResult::ERROR;
+    }
+    committedSize = sizeof(SpillFileHeader);
+    if (reserve(INITIAL_CAPACITY - committedSize) != GmpResult::SUCCESS)
+    {
+        ::close(fd);
+        fd = -1;
+        return GmpResult::ERROR;
+    }
+
+    SpillFileHeader header{};
+    memcpy(header.magic, SPILL_MAGIC, sizeof(header.magic));
+    header.version = SPILL_VERSION;
+    header.cuptiVersion = cuptiVersion;
+    header.committedSize = committedSize;
+    header.pointerSize = sizeof(void *);
+    memcpy(mapping, &header, sizeof(header));
+    writtenStrings.clear();
+    return GmpResult::SUCCESS;
+}
+
+GmpResult GmpSpillWriter::reserve(size_t bytes)
+{
+    if (committedSize + bytes <= capacity)
+    {
+        return GmpResult::SUCCESS;
+    }
+    // The mapping is file backed, so growing it never copies the data written so far.
+    size_t newCapacity = std::max(capacity * 2, committedSize + bytes);
+    newCapacity = (newCapacity + GROWTH_GRANULARITY - 1) / GROWTH_GRANULARITY * GROWTH_GRANULARITY;
+    if (mapping)
+    {
+        munmap(mapping, capacity);
+        mapping = nullptr;
+    }
+    if (ftruncate(fd, newCapacity) != 0)
+    {
+        GMP_LOG_ERROR(std::string("Failed to grow spill file: ") + strerror(errno));
+        return GmpResult::ERROR;
+    }
+    void *address = mmap(nullptr, newCapacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (address == MAP_FAILED)
+    {
+        GMP_LOG_ERROR(std::string("Failed to map spill file: ") + strerror(errno));
+        return GmpResult::ERROR;
+    }
+    mapping = static_cast<uint8_t *>(address);
+    capacity = newCapacity;
+    return GmpResult::SUCCESS;
+}
+
+GmpResult GmpSpillWriter::appendEntry(GmpSpillEntryType type, uint32_t aux,
+                                      std::initializer_list<std::pair<const void *, size_t>> parts)
+{
+    if (!mapping)
+    {
+        return GmpResult::ERROR;
+    }
+    GmpSpillEntryHeader entryHeader{static_cast<uint32_t>(type), aux, 0};
+    for (const auto &part : parts)
+    {
+        entryHeader.size += part.second;
+    }
+    size_t entrySize = sizeof(entryHeader) + alignUp(entryHeader.size);
+    if (reserve(entrySize) != GmpResult::SUCCESS)
+    {
+        return GmpResult::ERROR;
+    }
+
+    uint8_t *cursor = mapping + committedSize;
+    memcpy(cursor, &entryHeader, sizeof(entryHeader));
+    cursor += sizeof(entryHeader);
+    for (const auto &part : parts)
+    {
+        memcpy(cursor, part.first, part.second);
+        cursor += part.second;
+    }
+    // The mapping grows in zeroed pages, so the padding is already zero.
+    committedSize += entrySize;
+    reinterpret_cast<SpillFileHeader *>(mapping)->committedSize = committedSize;
+    return GmpResult::SUCCESS;
+}
+
+GmpResult GmpSpillWriter::appendString(const char *string)
+{
+    uint64_t pointer = reinterpret_cast<uintptr_t>(string);
+    if (!string || !writtenStrings.insert(pointer).second)
+    {
+        return GmpResult::SUCCESS;
+    }
+    return appendEntry(GmpSpillEntryType::STRING, 0, {{&pointer, sizeof(pointer)}, {string, strlen(string)}});
+}
+
+GmpResult GmpSpillWriter::appendBuffer(uint32_t streamId, uint8_t *buffer, size_t validSize)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    GmpResult result = GmpResult::SUCCESS;
+    forEachStringField(buffer, validSize, [&](const char *string)
+    {
+        if (appendString(string) != GmpResult::SUCCESS)
+        {
+            result = GmpResult::ERROR;
+        }
+    });
+    if (appendEntry(GmpSpillEntryType::BUFFER, streamId, {{buffer, validSize}}) != GmpResult::SUCCESS)
+    {
+        result = GmpResult::ERROR;
+    }
+    return result;
+}
+
+GmpResult GmpSpillWriter::appendRange(GmpSpillEntryType type, GmpProfileType profileType, uint64_t timestamp,
+                                      const std::string &name)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return appendEntry(type, static_cast<uint32_t>(profileType),
+                       {{&timestamp, sizeof(timestamp)}, {name.data(), name.size()}});
+}
+
+GmpResult GmpSpillWriter::appendCounterData(const GmpSpillCounterData &counterData)
+{
+    std::vector<uint8_t> payload;
+    uint32_t rangeMode = static_cast<uint32_t>(counterData.rangeMode);
+    putBytes(payload, &rangeMode, sizeof(rangeMode));
+    putBytes(payload, counterData.chipName.data(), counterData.chipName.size());
+    uint64_t metricCount = counterData.metrics.size();
+    putBytes(payload, &metricCount, sizeof(metricCount));
+    for (const auto &metric : counterData.metrics)
+    {
+        putBytes(payload, metric.data(), metric.size());
+    }
+    putBytes(payload, counterData.counterAvailabilityImage.data(), counterData.counterAvailabilityImage.size());
+    putBytes(payload, counterData.counterDataImage.data(), counterData.counterDataImage.size());
+
+    std::lock_guard<std::mutex> lock(mutex);
+    return appendEntry(GmpSpillEntryType::COUNTER_DATA, 0, {{payload.data(), payload.size()}});
+}
+
+GmpResult GmpSpillWriter::close()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (fd < 0)
+    {
+        return GmpResult::SUCCESS;
+    }
+    GmpResult result = GmpResult::SUCCESS;
+    if (mapping)
+    {
+        munmap(mapping, capacity);
+        mapping = nullptr;
+    }
+    if (ftruncate(fd, committedSize) != 0)
+    {
+        GMP_LOG_ERROR(std::string("Failed to truncate spill file: ") + strerror(errno));
+        result = GmpResult::ERROR;
+    }
+    ::close(fd);
+    fd = -1;
+    capacity = 0;
+    return result;
+}
+
+GmpSpillReader::~GmpSpillReader()
+{
+    unmap();
+}
+
+void GmpSpillReader::unmap()
+{
+    if (mapping)
+    {
+        munmap(const_cast<uint8_t *>(mapping), mappedSize);
+        mapping = nullptr;
+    }
+    mappedSize = 0;
+    committedSize = 0;
+}
+
+GmpResult GmpSpillReader::open(const std::string &path)
+{
+    unmap();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        GMP_LOG_ERROR("Failed to open spill file " + path + ": " + strerror(errno));
+        return GmpResult::ERROR;
+    }
+    struct stat status;
+    if (fstat(fd, &status) != 0 || size_t(status.st_size) < sizeof(SpillFileHeader))
+    {
+        GMP_LOG_ERROR("Spill file " + path + " is too short.");
+        ::close(fd);
+        return GmpResult::ERROR;
+    }
+    void *address = mmap(nullptr, status.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (address == MAP_FAILED)
+    {
+        GMP_LOG_ERROR("Failed to map spill file " + path + ": " + strerror(errno));
+        return GmpResult::ERROR;
+    }
+    mapping = static_cast<const uint8_t *>(address);
+    mappedSize = status.st_size;
+
+    SpillFileHeader header;
+    memcpy(&header, mapping, sizeof(header));
+    if (memcmp(header.magic, SPILL_MAGIC, sizeof(header.magic)) != 0 || header.version != SPILL_VERSION)
+    {
+        GMP_LOG_ERROR("File " + path + " is not a GMP spill file of version " + std::to_string(SPILL_VERSION) + ".");
+        unmap();
+        return GmpResult::ERROR;
+    }
+    if (header.pointerSize != sizeof(void *))
+    {
+        GMP_LOG_ERROR("Spill file " + path + " was recorded with " + std::to_string(header.pointerSize) +
+                      "-byte pointers.");
+        unmap();
+        return GmpResult::ERROR;
+    }
+    if (header.committedSize > mappedSize)
+    {
+        GMP_LOG_WARNING("Spill file " + path + " is truncated, replaying the complete entries only.");
+    }
+    committedSize = std::min<size_t>(header.committedSize, mappedSize);
+    cuptiVersion = header.cuptiVersion;
+    return GmpResult::SUCCESS;
+}
+
+GmpResult GmpSpillReader::forEachEntry(const std::function<void(const GmpSpillEntry &)> &visit) const
+{
+    size_t offset = sizeof(SpillFileHeader);
+    while (offset < committedSize)
+    {
+        GmpSpillEntryHeader entryHeader;
+        if (committedSize - offset < sizeof(entryHeader))
+        {
+            GMP_LOG_ERROR("Spill file ends inside an entry header at offset " + std::to_string(offset) + ".");
+            return GmpResult::ERROR;
+        }
+        memcpy(&entryHeader, mapping + offset, sizeof(entryHeader));
+        offset += sizeof(entryHeader);
+        if (committedSize - offset < entryHeader.size)
+        {
+            GMP_LOG_ERROR("Spill file ends inside an entry at offset " + std::to_string(offset) + ".");
+            return GmpResult::ERROR;
+        }
+        visit({static_cast<GmpSpillEntryType>(entryHeader.type), entryHeader.aux, mapping + offset,
+               static_cast<size_t>(entryHeader.size)});
+        offset += alignUp(entryHeader.size);
+    }
+    return GmpResult::SUCCESS;
+}
+
+GmpResult GmpSpillReader::parseString(const GmpSpillEntry &entry, uint64_t &pointer, std::string &string)
+{
+    if (entry.type != GmpSpillEntryType::STRING || entry.size < sizeof(pointer))
+    {
+        return GmpResult::ERROR;
+    }
+    memcpy(&pointer, entry.payload, sizeof(pointer));
+    string.assign(reinterpret_cast<const char *>(entry.payload) + sizeof(pointer), entry.size - sizeof(pointer));
+    return GmpResult::SUCCESS;
+}
+
+GmpResult GmpSpillReader::parseRange(const GmpSpillEntry &entry, uint64_t &timestamp, std::string &name)
+{
+    if ((entry.type != GmpSpillEntryType::PUSH_RANGE && entry.type != GmpSpillEntryType::POP_RANGE) ||
+        entry.size < sizeof(timestamp))
+    {
+        return GmpResult::ERROR;
+    }
+    memcpy(&timestamp, entry.payload, sizeof(timestamp));
+    name.assign(reinterpret_cast<const char *>(entry.payload) + sizeof(timestamp), entry.size - sizeof(timestamp));
+    return GmpResult::SUCCESS;
+}
+
+GmpResult GmpSpillReader::parseCounterData(const GmpSpillEntry &entry, GmpSpillCounterData &counterData)
+{
+    if (entry.type != GmpSpillEntryType::COUNTER_DATA)
+    {
+        return GmpResult::ERROR;
+    }
+    const uint8_t *cursor = entry.payload;
+    const uint8_t *end = entry.payload + entry.size;
+    const uint8_t *data = nullptr;
+    size_t size = 0;
+
+    uint32_t rangeMode = 0;
+    if (!getBytes(cursor, end, data, size) || size != sizeof(rangeMode))
+    {
+        return GmpResult::ERROR;
+    }
+    memcpy(&rangeMode, data, size);
+    counterData.rangeMode = static_cast<GmpRangeMode>(rangeMode);
+
+    if (!getBytes(cursor, end, data, size))
+    {
+        return GmpResult::ERROR;
+    }
+    counterData.chipName.assign(reinterpret_cast<const char *>(data), size);
+
+    uint64_t metricCount = 0;
+    if (!getBytes(cursor, end, data, size) || size != sizeof(metricCount))
+    {
+        return GmpResult::ERROR;
+    }
+    memcpy(&metricCount, data, size);
+    counterData.metrics.clear();
+    for (uint64_t metricIndex = 0; metricIndex < metricCount; ++metricIndex)
+    {
+        if (!getBytes(cursor, end, data, size))
+        {
+            return GmpResult::ERROR;
+        }
+        counterData.metrics.emplace_back(reinterpret_cast<const char *>(data), size);
+    }
+
+    if (!getBytes(cursor, end, data, size))
+    {
+        return GmpResult::ERROR;
+    }
+    counterData.counterAvailabilityImage.assign(data, data + size);
+    if (!getBytes(cursor, end, data, size))
+    {
+        return GmpResult::ERROR;
+    }
+    counterData.counterDataImage.assign(data, data + size);
+    return GmpResult::SUCCESS;
+}
+
+uint8_t *gmpSpillCopyBuffer(const GmpSpillEntry &entry, const std::unordered_map<uint64_t, std::string> &strings)
+{
+    // CUPTI expects 8-byte aligned buffers.
+    auto *buffer = static_cast<uint8_t *>(malloc(alignUp(std::max<size_t>(entry.size, 1))));
+    if (!buffer)
+    {
+        return nullptr;
+    }
+    memcpy(buffer, entry.payload, entry.size);
+    forEachStringField(buffer, entry.size, [&strings](const char *&string)
+    {
+        if (string)
+        {
+            auto it = strings.find(reinterpret_cast<uintptr_t>(string));
+            string = it == strings.end() ? "" : it->second.c_str();
+        }
+    });
+    return buffer;
+}
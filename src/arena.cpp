@@ -0,0 +1,121 @@
+#include <cstdlib>
+#include "gmp/arena.h"
+
+GmpArena::~GmpArena()
+{
+    for (const auto &chunk : chunks)
+    {
+        free(chunk.memory);
+    }
+}
+
+size_t GmpArena::blockSize(size_t bytes)
+{
+    size_t size = MIN_BLOCK_SIZE;
+    while (size < bytes)
+    {
+        size *= 2;
+    }
+    return size;
+}
+
+size_t GmpArena::sizeClass(size_t blockBytes)
+{
+    size_t sizeClass = 0;
+    for (size_t size = MIN_BLOCK_SIZE; size < blockBytes; size *= 2)
+    {
+        sizeClass++;
+    }
+    return sizeClass;
+}
+
+bool GmpArena::advanceChunk(size_t bytes)
+{
+    for (size_t next = chunks.empty() ? 0 : currentChunk + 1; next < chunks.size(); ++next)
+    {
+        if (chunks[next].size >= bytes)
+        {
+            // A chunk of a past epoch too small for this block is skipped, not
+            // lost: reset() rewinds to the first chunk.
+            currentChunk = next;
+            offset = 0;
+            return true;
+        }
+    }
+    size_t size = bytes > CHUNK_SIZE ? bytes : CHUNK_SIZE;
+    auto *memory = static_cast<uint8_t *>(malloc(size));
+    if (!memory)
+    {
+        return false;
+    }
+    chunks.push_back({memory, size});
+    currentChunk = chunks.size() - 1;
+    offset = 0;
+    stats.chunks++;
+    stats.chunkBytes += size;
+    return true;
+}
+
+void *GmpArena::allocate(size_t bytes)
+{
+    size_t size = blockSize(bytes);
+    size_t index = sizeClass(size);
+    std::lock_guard<std::mutex> lock(mutex);
+    void *block = nullptr;
+    if (index < CLASS_COUNT && freeLists[index])
+    {
+        FreeBlock *freeBlock = freeLists[index];
+        freeLists[index] = freeBlock->next;
+        block = freeBlock;
+        stats.reuses++;
+    }
+    else
+    {
+        if ((chunks.empty() || offset + size > chunks[currentChunk].size) && !advanceChunk(size))
+        {
+            return nullptr;
+        }
+        block = chunks[currentChunk].memory + offset;
+        offset += size;
+    }
+    stats.allocations++;
+    stats.bytesInUse += size;
+    return block;
+}
+
+void GmpArena::release(void *block, size_t bytes)
+{
+    if (!block)
+    {
+        return;
+    }
+    size_t size = blockSize(bytes);
+    size_t index = sizeClass(size);
+    std::lock_guard<std::mutex> lock(mutex);
+    stats.bytesInUse -= size;
+    if (index < CLASS_COUNT)
+    {
+        auto *freeBlock = static_cast<FreeBlock *>(block);
+        freeBlock->next = freeLists[index];
+        freeLists[index] = freeBlock;
+    }
+}
+
+void GmpArena::reset()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto &freeList : freeLists)
+    {
+        freeList = nullptr;
+    }
+    currentChunk = 0;
+    offset = 0;
+    stats.bytesInUse = 0;
+    stats.resets++;
+}
+
+GmpArenaStats GmpArena::getStats() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return stats;
+}
@@ -0,0 +1,136 @@
+#include <algorithm>
+#include <cstdio>
+#include "gmp/bottleneck.h"
+
+namespace
+{
+double clampFraction(double value)
+{
+    return std::min(1.0, std::max(0.0, value));
+}
+} // namespace
+
+GmpStallMetrics GmpStallMetrics::fromMetrics(const std::unordered_map<std::string, double> &metricValues)
+{
+    auto metricOf = [&metricValues](const char *metric)
+    {
+        auto it = metricValues.find(metric);
+        return it != metricValues.end() ? it->second : 0.0;
+    };
+    GmpStallMetrics metrics;
+    metrics.cyclesActive = metricOf("smsp__cycles_active.sum");
+    metrics.instructions = metricOf("smsp__inst_executed.sum");
+    metrics.warpsActive = metricOf("smsp__warps_active.sum");
+    metrics.warpsEligible = metricOf("smsp__warps_eligible.sum");
+    metrics.longScoreboard = metricOf("smsp__warps_issue_stalled_long_scoreboard.sum");
+    metrics.mioThrottle = metricOf("smsp__warps_issue_stalled_mio_throttle.sum");
+    metrics.mathPipeThrottle = metricOf("smsp__warps_issue_stalled_math_pipe_throttle.sum");
+    metrics.pipeAlu = metricOf("smsp__pipe_alu_cycles_active.sum");
+    metrics.pipeFma = metricOf("smsp__pipe_fma_cycles_active.sum");
+    metrics.pipeFp64 = metricOf("smsp__pipe_fp64_cycles_active.sum");
+    metrics.pipeShared = metricOf("smsp__pipe_shared_cycles_active.sum");
+    metrics.pipeTensor = metricOf("smsp__pipe_tensor_cycles_active.sum");
+    metrics.durationNs = metricOf("gpu__time_duration.sum");
+    return metrics;
+}
+
+const char *gmpBottleneckName(GmpBottleneckKind kind)
+{
+    switch (kind)
+    {
+    case GmpBottleneckKind::MEMORY_LATENCY:
+        return "memory latency";
+    case GmpBottleneckKind::MIO_THROTTLE:
+        return "MIO throttle";
+    case GmpBottleneckKind::MATH_PIPE_THROTTLE:
+        return "math pipe throttle";
+    case GmpBottleneckKind::OTHER_STALL:
+        return "other stalls";
+    case GmpBottleneckKind::ISSUE_IDLE:
+        return "issue idle";
+    case GmpBottleneckKind::ALU_PIPE_BUSY:
+        return "ALU pipe busy";
+    case GmpBottleneckKind::FMA_PIPE_BUSY:
+        return "FMA pipe busy";
+    case GmpBottleneckKind::FP64_PIPE_BUSY:
+        return "FP64 pipe busy";
+    case GmpBottleneckKind::SHARED_PIPE_BUSY:
+        return "shared pipe busy";
+    case GmpBottleneckKind::TENSOR_PIPE_IDLE:
+        return "tensor pipe idle";
+    default:
+        return "unknown";
+    }
+}
+
+std::string GmpBottleneckReport::summary(size_t maxCount) const
+{
+    std::string text;
+    for (size_t i = 0; i < ranked.size() && i < maxCount; ++i)
+    {
+        char percent[16];
+        snprintf(percent, sizeof(percent), " %.0f%%", 100.0 * ranked[i].fraction);
+        if (!text.empty())
+        {
+            text += ", ";
+        }
+        text += gmpBottleneckName(ranked[i].kind);
+        text += percent;
+    }
+    return text;
+}
+
+GmpBottleneckClassifier::GmpBottleneckClassifier(double minFraction)
+    : minFraction(minFraction) {}
+
+GmpBottleneckReport GmpBottleneckClassifier::classify(const std::string &name, const GmpStallMetrics &metrics) const
+{
+    GmpBottleneckReport report;
+    report.name = name;
+    report.durationNs = metrics.durationNs;
+    if (metrics.warpsActive <= 0.0 || metrics.cyclesActive <= 0.0)
+    {
+        return report;
+    }
+    report.issueRate = metrics.instructions / metrics.cyclesActive;
+    report.eligiblePerCycle = metrics.warpsEligible / metrics.cyclesActive;
+
+    double fractions[static_cast<size_t>(GmpBottleneckKind::COUNT)] = {};
+    auto set = [&fractions](GmpBottleneckKind kind, double value)
+    {
+        fractions[static_cast<size_t>(kind)] = clampFraction(value);
+    };
+
+    // Stall shares of the active warp-cycles.
+    double issued = metrics.instructions / metrics.warpsActive;
+    double memoryLatency = metrics.longScoreboard / metrics.warpsActive;
+    double mioThrottle = metrics.mioThrottle / metrics.warpsActive;
+    double mathPipeThrottle = metrics.mathPipeThrottle / metrics.warpsActive;
+    set(GmpBottleneckKind::MEMORY_LATENCY, memoryLatency);
+    set(GmpBottleneckKind::MIO_THROTTLE, mioThrottle);
+    set(GmpBottleneckKind::MATH_PIPE_THROTTLE, mathPipeThrottle);
+    set(GmpBottleneckKind::OTHER_STALL, 1.0 - issued - memoryLatency - mioThrottle - mathPipeThrottle);
+
+    // Issue slots and pipes over the active cycles.
+    set(GmpBottleneckKind::ISSUE_IDLE, 1.0 - report.issueRate);
+    set(GmpBottleneckKind::ALU_PIPE_BUSY, metrics.pipeAlu / metrics.cyclesActive);
+    set(GmpBottleneckKind::FMA_PIPE_BUSY, metrics.pipeFma / metrics.cyclesActive);
+    set(GmpBottleneckKind::FP64_PIPE_BUSY, metrics.pipeFp64 / metrics.cyclesActive);
+    set(GmpBottleneckKind::SHARED_PIPE_BUSY, metrics.pipeShared / metrics.cyclesActive);
+    if (metrics.pipeTensor > 0.0)
+    {
+        set(GmpBottleneckKind::TENSOR_PIPE_IDLE, 1.0 - metrics.pipeTensor / metrics.cyclesActive);
+    }
+
+    for (size_t kind = 0; kind < static_cast<size_t>(GmpBottleneckKind::COUNT); ++kind)
+    {
+        if (fractions[kind] >= minFraction && fractions[kind] > 0.0)
+        {
+            report.ranked.push_back({static_cast<GmpBottleneckKind>(kind), fractions[kind]});
+        }
+    }
+    // Stable, so ties keep the order of the enum.
+    std::stable_sort(report.ranked.begin(), report.ranked.end(), [](const GmpBottleneck &a, const GmpBottleneck &b)
+                     { return a.fraction > b.fraction; });
+    return report;
+}
@@ -0,0 +1,160 @@
+#include <cerrno>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string_view>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "gmp/config_cache.h"
+#include "gmp/hash.h"
+#include "gmp/log.h"
+
+namespace
+{
+constexpr char CACHE_MAGIC[8] = {'G', 'M', 'P', 'C', 'F', 'G', '0', '1'};
+
+struct CacheEntryHeader
+{
+    char magic[8];
+    uint64_t size;
+    uint64_t checksum;
+};
+
+uint64_t checksumOf(const std::vector<uint8_t> &data)
+{
+    return gmpHash64(std::string_view(reinterpret_cast<const char *>(data.data()), data.size()));
+}
+
+// mkdir -p
+bool createDirectories(const std::string &path)
+{
+    for (size_t pos = 1; pos <= path.size(); ++pos)
+    {
+        if (pos != path.size() && path[pos] != '/')
+        {
+            continue;
+        }
+        std::string prefix = path.substr(0, pos);
+        if (mkdir(prefix.c_str(), 0755) != 0 && errno != EEXIST)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+} // namespace
+
+GmpConfigImageCache::GmpConfigImageCache(std::string directory)
+    : directory(directory.empty() ? defaultDirectory() : std::move(directory)) {}
+
+std::string GmpConfigImageCache::defaultDirectory()
+{
+    if (const char *dir = getenv("GMP_CACHE_DIR"); dir && *dir)
+    {
+        return dir;
+    }
+    if (const char *dir = getenv("XDG_CACHE_HOME"); dir && *dir)
+    {
+        return std::string(dir) + "/gmp";
+    }
+    if (const char *dir = getenv("HOME"); dir && *dir)
+    {
+        return std::string(dir) + "/.cache/gmp";
+    }
+    return "/tmp/gmp-cache";
+}
+
+std::string GmpConfigImageCache::makeKey(const std::string &chipName, uint32_t cuptiVersion,
+                                         const std::vector<uint8_t> &counterAvailabilityImage,
+                                         const std::vector<std::string> &metrics)
+{
+    uint64_t hash = checksumOf(counterAvailabilityImage);
+    for (const auto &metric : metrics)
+    {
+        // Hash the length too so that {"ab", "c"} and {"a", "bc"} differ.
+        hash = gmpHashCombine(gmpHash64(metric, hash), metric.size());
+    }
+
+    std::string key;
+    for (char c : chipName)
+    {
+        bool isSafe = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+        key.push_back(isSafe ? c : '_');
+    }
+    char suffix[64];
+    snprintf(suffix, sizeof(suffix), "-cupti%u-%016" PRIx64, cuptiVersion, hash);
+    return key + suffix;
+}
+
+std::string GmpConfigImageCache::pathOf(const std::string &key) const
+{
+    return directory + "/" + key + ".config";
+}
+
+bool GmpConfigImageCache::load(const std::string &key, std::vector<uint8_t> &configImage) const
+{
+    std::string path = pathOf(key);
+    FILE *file = fopen(path.c_str(), "rb");
+    if (!file)
+    {
+        return false;
+    }
+
+    CacheEntryHeader header;
+    struct stat fileStat;
+    bool ok = fread(&header, sizeof(header), 1, file) == 1 &&
+              memcmp(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) == 0;
+    // The size of a corrupted or truncated entry must not drive the allocation.
+    ok = ok && fstat(fileno(file), &fileStat) == 0 &&
+         header.size == static_cast<uint64_t>(fileStat.st_size) - sizeof(header);
+    if (ok)
+    {
+        configImage.resize(header.size);
+        ok = fread(configImage.data(), 1, configImage.size(), file) == configImage.size() &&
+             checksumOf(configImage) == header.checksum;
+    }
+    fclose(file);
+
+    if (!ok)
+    {
+        GMP_LOG_WARNING("Ignoring corrupted config image cache entry: " + path);
+        configImage.clear();
+    }
+    return ok;
+}
+
+bool GmpConfigImageCache::store(const std::string &key, const std::vector<uint8_t> &configImage) const
+{
+    if (!createDirectories(directory))
+    {
+        GMP_LOG_WARNING("Cannot create config image cache directory: " + directory);
+        return false;
+    }
+
+    std::string path = pathOf(key);
+    std::string tmpPath = path + ".tmp." + std::to_string(getpid());
+    FILE *file = fopen(tmpPath.c_str(), "wb");
+    if (!file)
+    {
+        GMP_LOG_WARNING("Cannot write config image cache entry: " + tmpPath);
+        return false;
+    }
+
+    CacheEntryHeader header;
+    memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    header.size = configImage.size();
+    header.checksum = checksumOf(configImage);
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+              fwrite(configImage.data(), 1, configImage.size(), file) == configImage.size();
+    ok &= fclose(file) == 0;
+
+    // rename() is atomic, readers see either the old entry or the complete new one.
+    if (!ok || rename(tmpPath.c_str(), path.c_str()) != 0)
+    {
+        GMP_LOG_WARNING("Cannot write config image cache entry: " + path);
+        unlink(tmpPath.c_str());
+        return false;
+    }
+    return true;
+}
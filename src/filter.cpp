@@ -0,0 +1,163 @@
+#include <queue>
+#include "gmp/filter.h"
+#include "gmp/hash.h"
+#include "gmp/log.h"
+
+void GmpNameFilter::addRule(const std::string &pattern, GmpFilterAction action, GmpFilterMatch match)
+{
+    if (pattern.empty())
+    {
+        GMP_LOG_WARNING("Ignoring empty filter pattern.");
+        return;
+    }
+    uint8_t bit = action == GmpFilterAction::INCLUDE ? INCLUDE_BIT : EXCLUDE_BIT;
+    rules.push_back({pattern, bit, match});
+}
+
+void GmpNameFilter::clear()
+{
+    rules.clear();
+    compile();
+}
+
+void GmpNameFilter::compile()
+{
+    exactRules.clear();
+    transitions.clear();
+    stateOutput.clear();
+    hasIncludes = false;
+    active = !rules.empty();
+
+    // State 0 is the root of the trie.
+    transitions.assign(ALPHABET_SIZE, 0);
+    stateOutput.assign(1, 0);
+    bool hasSubstringRules = false;
+
+    for (const auto &rule : rules)
+    {
+        hasIncludes |= rule.bit == INCLUDE_BIT;
+        if (rule.match == GmpFilterMatch::EXACT)
+        {
+            auto &bucket = exactRules[gmpHash64(rule.pattern)];
+            bool merged = false;
+            for (auto &entry : bucket)
+            {
+                if (entry.name == rule.pattern)
+                {
+                    entry.bits |= rule.bit;
+                    merged = true;
+                }
+            }
+            if (!merged)
+            {
+                bucket.push_back({rule.pattern, rule.bit});
+            }
+            continue;
+        }
+
+        hasSubstringRules = true;
+        uint32_t state = 0;
+        for (unsigned char c : rule.pattern)
+        {
+            uint32_t next = transitions[state * ALPHABET_SIZE + c];
+            if (next == 0)
+            {
+                next = static_cast<uint32_t>(stateOutput.size());
+                stateOutput.push_back(0);
+                transitions.resize(transitions.size() + ALPHABET_SIZE, 0);
+                transitions[state * ALPHABET_SIZE + c] = next;
+            }
+            state = next;
+        }
+        stateOutput[state] |= rule.bit;
+    }
+
+    if (!hasSubstringRules)
+    {
+        transitions.clear();
+        stateOutput.clear();
+        return;
+    }
+
+    // Breadth-first construction of the failure links, folding them into the
+    // transition table so that matching never has to follow a failure chain.
+    std::vector<uint32_t> failure(stateOutput.size(), 0);
+    std::queue<uint32_t> pending;
+    for (size_t c = 0; c < ALPHABET_SIZE; ++c)
+    {
+        uint32_t child = transitions[c];
+        if (child != 0)
+        {
+            pending.push(child);
+        }
+    }
+    while (!pending.empty())
+    {
+        uint32_t state = pending.front();
+        pending.pop();
+        stateOutput[state] |= stateOutput[failure[state]];
+        for (size_t c = 0; c < ALPHABET_SIZE; ++c)
+        {
+            uint32_t &child = transitions[state * ALPHABET_SIZE + c];
+            uint32_t fallback = transitions[failure[state] * ALPHABET_SIZE + c];
+            if (child != 0)
+            {
+                failure[child] = fallback;
+                pending.push(child);
+            }
+            else
+            {
+                child = fallback;
+            }
+        }
+    }
+}
+
+bool GmpNameFilter::matches(std::string_view name) const
+{
+    return matches(name, active && !exactRules.empty() ? gmpHash64(name) : 0);
+}
+
+bool GmpNameFilter::matches(std::string_view name, uint64_t hash) const
+{
+    if (!active)
+    {
+        return true;
+    }
+
+    uint8_t bits = 0;
+    if (!exactRules.empty())
+    {
+        auto it = exactRules.find(hash);
+        if (it != exactRules.end())
+        {
+            for (const auto &entry : it->second)
+            {
+                if (entry.name == name)
+                {
+                    bits |= entry.bits;
+                }
+            }
+        }
+    }
+
+    if (!transitions.empty() && !(bits & EXCLUDE_BIT))
+    {
+        uint32_t state = 0;
+        for (unsigned char c : name)
+        {
+            state = transitions[state * ALPHABET_SIZE + c];
+            bits |= stateOutput[state];
+            if (bits & EXCLUDE_BIT)
+            {
+                break;
+            }
+        }
+    }
+
+    if (bits & EXCLUDE_BIT)
+    {
+        return false;
+    }
+    return !hasIncludes || (bits & INCLUDE_BIT);
+}
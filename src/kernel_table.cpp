@@ -0,0 +1,143 @@
+#include <algorithm>
+#include <cstring>
+#include "gmp/kernel_table.h"
+#include "gmp/hash.h"
+
+GmpHotKernelTable::GmpHotKernelTable(size_t initialCapacity)
+{
+    size_t capacity = 16;
+    while (capacity < initialCapacity)
+    {
+        capacity *= 2;
+    }
+    slots.resize(capacity);
+}
+
+uint64_t GmpHotKernelTable::hashOf(const GmpKernelData &kernel)
+{
+    // Names are interned, so equal names have equal ids.
+    uint64_t hash = gmpHashCombine(GMP_FNV1A_OFFSET, kernel.nameId);
+    for (int i = 0; i < 3; ++i)
+    {
+        hash = gmpHashCombine(hash, static_cast<uint32_t>(kernel.grid_size[i]));
+        hash = gmpHashCombine(hash, static_cast<uint32_t>(kernel.block_size[i]));
+    }
+    return hash;
+}
+
+bool GmpHotKernelTable::isSameSignature(const GmpHotKernel &entry, const GmpKernelData &kernel)
+{
+    return memcmp(entry.grid_size, kernel.grid_size, sizeof(entry.grid_size)) == 0 &&
+           memcmp(entry.block_size, kernel.block_size, sizeof(entry.block_size)) == 0 &&
+           entry.nameId == kernel.nameId;
+}
+
+void GmpHotKernelTable::grow()
+{
+    std::vector<Slot> oldSlots(slots.size() * 2);
+    oldSlots.swap(slots);
+    size_t mask = slots.size() - 1;
+    for (const auto &slot : oldSlots)
+    {
+        if (slot.entryIndex == EMPTY_SLOT)
+        {
+            continue;
+        }
+        size_t position = slot.hash & mask;
+        while (slots[position].entryIndex != EMPTY_SLOT)
+        {
+            position = (position + 1) & mask;
+        }
+        slots[position] = slot;
+    }
+}
+
+GmpHotKernel &GmpHotKernelTable::findOrInsert(const GmpKernelData &kernel)
+{
+    uint64_t hash = hashOf(kernel);
+    size_t mask = slots.size() - 1;
+    size_t position = hash & mask;
+    while (slots[position].entryIndex != EMPTY_SLOT)
+    {
+        const Slot &slot = slots[position];
+        if (slot.hash == hash && isSameSignature(entries[slot.entryIndex], kernel))
+        {
+            return entries[slot.entryIndex];
+        }
+        position = (position + 1) & mask;
+    }
+
+    slots[position] = {hash, static_cast<uint32_t>(entries.size())};
+    entries.emplace_back();
+    GmpHotKernel &entry = entries.back();
+    entry.name = kernel.name();
+    entry.nameId = kernel.nameId;
+    memcpy(entry.grid_size, kernel.grid_size, sizeof(entry.grid_size));
+    memcpy(entry.block_size, kernel.block_size, sizeof(entry.block_size));
+
+    // Keep the load factor under 0.7 so probe sequences stay short.
+    if (entries.size() * 10 > slots.size() * 7)
+    {
+        grow();
+    }
+    return entries.back();
+}
+
+void GmpHotKernelTable::add(const GmpKernelData &kernel, bool hasMetrics, double instructions, double dramSectors)
+{
+    GmpHotKernel &entry = findOrInsert(kernel);
+    uint64_t durationNs = kernel.end > kernel.start ? kernel.end - kernel.start : 0;
+    for (GmpHotKernel *target : {&entry, &totals})
+    {
+        target->launchCount++;
+        target->totalTimeNs += durationNs;
+        if (hasMetrics)
+        {
+            target->measuredLaunchCount++;
+            target->instructions += instructions;
+            target->dramSectors += dramSectors;
+        }
+    }
+}
+
+double GmpHotKernelTable::valueOf(const GmpHotKernel &entry, GmpHotKernelOrder order)
+{
+    switch (order)
+    {
+    case GmpHotKernelOrder::INSTRUCTIONS:
+        return entry.instructions;
+    case GmpHotKernelOrder::DRAM_SECTORS:
+        return entry.dramSectors;
+    default:
+        return static_cast<double>(entry.totalTimeNs);
+    }
+}
+
+std::vector<GmpHotKernel> GmpHotKernelTable::top(size_t n, GmpHotKernelOrder order) const
+{
+    std::vector<const GmpHotKernel *> ranked;
+    ranked.reserve(entries.size());
+    for (const auto &entry : entries)
+    {
+        ranked.push_back(&entry);
+    }
+    n = std::min(n, ranked.size());
+    std::partial_sort(ranked.begin(), ranked.begin() + n, ranked.end(),
+                      [order](const GmpHotKernel *a, const GmpHotKernel *b)
+                      { return valueOf(*a, order) > valueOf(*b, order); });
+
+    std::vector<GmpHotKernel> result;
+    result.reserve(n);
+    for (size_t i = 0; i < n; ++i)
+    {
+        result.push_back(*ranked[i]);
+    }
+    return result;
+}
+
+void GmpHotKernelTable::clear()
+{
+    std::fill(slots.begin(), slots.end(), Slot());
+    entries.clear();
+    totals = GmpHotKernel();
+}
@@ -0,0 +1,122 @@
+#include <algorithm>
+#include <functional>
+#include <queue>
+#include <utility>
+#include "gmp/kernel_timeline.h"
+
+GmpKernelTimelineAnalyzer::GmpKernelTimelineAnalyzer(size_t maxReportedGaps, uint64_t minGapNs)
+    : maxReportedGaps(maxReportedGaps), minGapNs(minGapNs) {}
+
+GmpKernelTimelineStats GmpKernelTimelineAnalyzer::analyze(const std::string &name, const std::vector<GmpKernelData> &kernels) const
+{
+    GmpKernelTimelineStats stats;
+    stats.name = name;
+
+    std::vector<std::pair<uint64_t, uint64_t>> intervals;
+    intervals.reserve(kernels.size());
+    bool isSorted = true;
+    for (const auto &kernel : kernels)
+    {
+        if (kernel.end <= kernel.start)
+        {
+            continue;
+        }
+        if (!intervals.empty() && kernel.start < intervals.back().first)
+        {
+            isSorted = false;
+        }
+        intervals.emplace_back(kernel.start, kernel.end);
+    }
+    stats.kernelCount = intervals.size();
+    if (intervals.empty())
+    {
+        return stats;
+    }
+    if (!isSorted)
+    {
+        std::sort(intervals.begin(), intervals.end());
+    }
+
+    // Running kernels by end time, earliest first.
+    std::priority_queue<uint64_t, std::vector<uint64_t>, std::greater<uint64_t>> runningEnds;
+    // Longest gaps seen so far, shortest on top so it can be evicted.
+    auto longerGap = [](const GmpIdleGap &a, const GmpIdleGap &b)
+    { return a.duration() > b.duration(); };
+    std::priority_queue<GmpIdleGap, std::vector<GmpIdleGap>, decltype(longerGap)> longestGaps(longerGap);
+
+    uint64_t cursor = intervals.front().first;
+    stats.firstStart = cursor;
+    stats.concurrencyHistogram.assign(2, 0);
+
+    auto advanceTo = [&](uint64_t time)
+    {
+        size_t concurrency = runningEnds.size();
+        if (concurrency >= stats.concurrencyHistogram.size())
+        {
+            stats.concurrencyHistogram.resize(concurrency + 1, 0);
+        }
+        stats.concurrencyHistogram[concurrency] += time - cursor;
+        cursor = time;
+    };
+
+    for (const auto &interval : intervals)
+    {
+        while (!runningEnds.empty() && runningEnds.top() <= interval.first)
+        {
+            advanceTo(runningEnds.top());
+            runningEnds.pop();
+        }
+        if (runningEnds.empty() && interval.first > cursor)
+        {
+            GmpIdleGap gap{cursor, interval.first};
+            if (gap.duration() >= minGapNs)
+            {
+                stats.idleGapCount++;
+                if (maxReportedGaps > 0)
+                {
+                    longestGaps.push(gap);
+                    if (longestGaps.size() > maxReportedGaps)
+                    {
+                        longestGaps.pop();
+                    }
+                }
+            }
+        }
+        advanceTo(interval.first);
+        runningEnds.push(interval.second);
+        stats.maxConcurrency = std::max<uint32_t>(stats.maxConcurrency, static_cast<uint32_t>(runningEnds.size()));
+    }
+    while (!runningEnds.empty())
+    {
+        advanceTo(runningEnds.top());
+        runningEnds.pop();
+    }
+
+    stats.lastEnd = cursor;
+    stats.spanNs = stats.lastEnd - stats.firstStart;
+    stats.idleNs = stats.concurrencyHistogram[0];
+    stats.busyNs = stats.spanNs - stats.idleNs;
+    for (size_t concurrency = 2; concurrency < stats.concurrencyHistogram.size(); ++concurrency)
+    {
+        stats.overlapNs += stats.concurrencyHistogram[concurrency];
+    }
+
+    while (!longestGaps.empty())
+    {
+        stats.longestGaps.push_back(longestGaps.top());
+        longestGaps.pop();
+    }
+    std::reverse(stats.longestGaps.begin(), stats.longestGaps.end());
+    return stats;
+}
+
+std::vector<GmpKernelTimelineStats> GmpKernelTimelineAnalyzer::analyze(const std::vector<GmpRangeData> &ranges) const
+{
+    std::vector<GmpKernelTimelineStats> allStats;
+    allStats.reserve(ranges.size());
+    for (const auto &range : ranges)
+    {
+        allStats.push_back(analyze(range.name, range.kernelDataInRange));
+    }
+    return allStats;
+}
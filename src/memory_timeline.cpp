@@ -0,0 +1,178 @@
+#include <algorithm>
+#include "gmp/memory_timeline.h"
+#include "gmp/log.h"
+
+void GmpMemoryTimeline::build(const std::vector<GmpMemRangeData> &ranges)
+{
+    clear();
+    std::vector<const GmpMemData *> ordered;
+    for (const auto &range : ranges)
+    {
+        ordered.clear();
+        for (const auto &record : range.memDataInRange)
+        {
+            ordered.push_back(&record);
+        }
+        // Records are flushed per buffer, so restore the issue order first.
+        std::stable_sort(ordered.begin(), ordered.end(), [](const GmpMemData *a, const GmpMemData *b)
+                         { return a->timestamp < b->timestamp; });
+
+        beginRange(range.name);
+        for (const auto *record : ordered)
+        {
+            apply(*record);
+        }
+        endRange();
+    }
+}
+
+void GmpMemoryTimeline::clear()
+{
+    liveAllocations.clear();
+    timeline.clear();
+    rangeFootprints.clear();
+    rangeAllocations.clear();
+    liveBytes = 0;
+    highWaterMark = 0;
+    unmatchedReleases = 0;
+    inRange = false;
+}
+
+void GmpMemoryTimeline::beginRange(const std::string &name)
+{
+    if (inRange)
+    {
+        endRange();
+    }
+    GmpRangeFootprint footprint;
+    footprint.name = name;
+    footprint.liveBytesAtStart = liveBytes;
+    footprint.peakLiveBytes = liveBytes;
+    rangeFootprints.push_back(std::move(footprint));
+    rangeAllocations.clear();
+    inRange = true;
+}
+
+void GmpMemoryTimeline::endRange()
+{
+    if (!inRange)
+    {
+        return;
+    }
+    auto &footprint = rangeFootprints.back();
+    size_t rangeIndex = rangeFootprints.size() - 1;
+    footprint.liveBytesAtEnd = liveBytes;
+    footprint.highWaterMark = highWaterMark;
+    // rangeAllocations holds an address once per allocation in the range, so one
+    // allocated, released and allocated again would be listed twice. Keep it once.
+    std::sort(rangeAllocations.begin(), rangeAllocations.end());
+    rangeAllocations.erase(std::unique(rangeAllocations.begin(), rangeAllocations.end()), rangeAllocations.end());
+    for (uint64_t address : rangeAllocations)
+    {
+        auto it = liveAllocations.find(address);
+        if (it != liveAllocations.end() && it->second.rangeIndex == rangeIndex)
+        {
+            footprint.leakedAllocations.push_back(it->second);
+        }
+    }
+    rangeAllocations.clear();
+    inRange = false;
+}
+
+bool GmpMemoryTimeline::isDeviceMemory(CUpti_ActivityMemoryKind kind)
+{
+    return kind != CUPTI_ACTIVITY_MEMORY_KIND_PINNED && kind != CUPTI_ACTIVITY_MEMORY_KIND_PAGEABLE;
+}
+
+std::map<uint64_t, GmpLiveAllocation>::iterator GmpMemoryTimeline::findContaining(uint64_t address)
+{
+    auto it = liveAllocations.upper_bound(address);
+    if (it == liveAllocations.begin())
+    {
+        return liveAllocations.end();
+    }
+    --it;
+    if (address < it->second.address + it->second.bytes || it->second.address == address)
+    {
+        return it;
+    }
+    return liveAllocations.end();
+}
+
+uint64_t GmpMemoryTimeline::apply(const GmpMemData &record)
+{
+    if (!isDeviceMemory(record.memoryKind()))
+    {
+        return liveBytes;
+    }
+    if (!inRange)
+    {
+        beginRange("");
+    }
+
+    switch (record.memoryOperationType())
+    {
+    case CUPTI_ACTIVITY_MEMORY_OPERATION_TYPE_ALLOCATION:
+        allocate(record);
+        break;
+    case CUPTI_ACTIVITY_MEMORY_OPERATION_TYPE_RELEASE:
+        release(record);
+        break;
+    default:
+        return liveBytes;
+    }
+
+    auto &footprint = rangeFootprints.back();
+    footprint.peakLiveBytes = std::max(footprint.peakLiveBytes, liveBytes);
+    highWaterMark = std::max(highWaterMark, liveBytes);
+    if (recordTimeline)
+    {
+        timeline.push_back({record.timestamp, liveBytes});
+    }
+    return liveBytes;
+}
+
+void GmpMemoryTimeline::allocate(const GmpMemData &record)
+{
+    // An overlapping live allocation means its release was never observed,
+    // e.g. because it happened outside of any range. Treat it as released.
+    auto it = findContaining(record.address);
+    if (it == liveAllocations.end())
+    {
+        it = liveAllocations.lower_bound(record.address);
+    }
+    while (it != liveAllocations.end() && it->second.address < record.address + std::max<uint64_t>(record.bytes, 1))
+    {
+        liveBytes -= it->second.bytes;
+        it = liveAllocations.erase(it);
+    }
+
+    GmpLiveAllocation allocation;
+    allocation.address = record.address;
+    allocation.bytes = record.bytes;
+    allocation.timestamp = record.timestamp;
+    allocation.rangeIndex = rangeFootprints.size() - 1;
+    liveAllocations.emplace(record.address, allocation);
+    rangeAllocations.push_back(record.address);
+
+    liveBytes += record.bytes;
+    rangeFootprints.back().allocatedBytes += record.bytes;
+}
+
+void GmpMemoryTimeline::release(const GmpMemData &record)
+{
+    auto it = liveAllocations.find(record.address);
+    if (it == liveAllocations.end())
+    {
+        it = findContaining(record.address);
+    }
+    if (it == liveAllocations.end())
+    {
+        unmatchedReleases++;
+        GMP_LOG_DEBUG("Release of untracked address " + std::to_string(record.address));
+        return;
+    }
+    liveBytes -= it->second.bytes;
+    rangeFootprints.back().releasedBytes += it->second.bytes;
+    liveAllocations.erase(it);
+}
@@ -0,0 +1,306 @@
+#include <unordered_map>
+#include <vector>
+#include "gmp/nvtx_bridge.h"
+#include "gmp/profile.h"
+
+namespace
+{
+// NVTX callbacks carry no user data, so the trampolines reach the bridge through this.
+GmpNvtxBridge *attachedBridge = nullptr;
+
+struct ThreadRange
+{
+    bool isMapped;
+    std::string name;
+};
+
+// NVTX ranges nest per thread and domain, null is the default domain.
+thread_local std::unordered_map<const void *, std::vector<ThreadRange>> threadRanges;
+
+// Set while a range is forwarded to the profiler, whose own NVTX markers must not be mapped again.
+thread_local bool isForwarding = false;
+
+// Mapped ranges open on this thread, over all domains. A GMP session cannot
+// hold another of its type, so only the outermost one is forwarded.
+thread_local size_t mappedDepth = 0;
+
+std::string narrow(const wchar_t *text)
+{
+    std::string result;
+    for (; text && *text; ++text)
+    {
+        result.push_back(*text < 0x80 ? static_cast<char>(*text) : '?');
+    }
+    return result;
+}
+
+int NVTX_API corePushA(const char *message)
+{
+    return attachedBridge ? attachedBridge->pushRange(nullptr, message) : 0;
+}
+
+int NVTX_API corePushW(const wchar_t *message)
+{
+    return attachedBridge ? attachedBridge->pushRange(nullptr, narrow(message).c_str()) : 0;
+}
+
+int NVTX_API corePushEx(const nvtxEventAttributes_t *attributes)
+{
+    return attachedBridge ? attachedBridge->pushRange(nullptr, attributes) : 0;
+}
+
+int NVTX_API corePop()
+{
+    return attachedBridge ? attachedBridge->popRange(nullptr) : 0;
+}
+
+int NVTX_API domainPushEx(nvtxDomainHandle_t domain, const nvtxEventAttributes_t *attributes)
+{
+    return attachedBridge ? attachedBridge->pushRange(domain, attributes) : 0;
+}
+
+int NVTX_API domainPop(nvtxDomainHandle_t domain)
+{
+    return attachedBridge ? attachedBridge->popRange(domain) : 0;
+}
+
+nvtxDomainHandle_t NVTX_API domainCreateA(const char *name)
+{
+    return attachedBridge ? attachedBridge->createDomain(name) : nullptr;
+}
+
+nvtxDomainHandle_t NVTX_API domainCreateW(const wchar_t *name)
+{
+    return attachedBridge ? attachedBridge->createDomain(narrow(name).c_str()) : nullptr;
+}
+
+void NVTX_API domainDestroy(nvtxDomainHandle_t)
+{
+    // Ranges of the domain may still be popped, keep its state.
+}
+
+nvtxStringHandle_t NVTX_API domainRegisterStringA(nvtxDomainHandle_t domain, const char *string)
+{
+    return attachedBridge ? attachedBridge->registerString(domain, string) : nullptr;
+}
+
+nvtxStringHandle_t NVTX_API domainRegisterStringW(nvtxDomainHandle_t domain, const wchar_t *string)
+{
+    return attachedBridge ? attachedBridge->registerString(domain, narrow(string).c_str()) : nullptr;
+}
+
+template <typename Function>
+void patchSlot(NvtxFunctionTable table, unsigned int size, unsigned int id, Function function)
+{
+    if (id < size && table[id])
+    {
+        *table[id] = reinterpret_cast<NvtxFunctionPointer>(function);
+    }
+}
+} // namespace
+
+GmpNvtxBridge::GmpNvtxBridge(GmpProfiler *profiler, GmpProfileType type)
+    : profiler(profiler), type(type), defaultDomain{DEFAULT_DOMAIN, true} {}
+
+GmpNvtxBridge::~GmpNvtxBridge()
+{
+    // The patched slots stay in place and become no-ops.
+    if (attachedBridge == this)
+    {
+        attachedBridge = nullptr;
+    }
+}
+
+void GmpNvtxBridge::addDomain(const std::string &name)
+{
+    domainNames.insert(name);
+}
+
+void GmpNvtxBridge::addRangeFilter(const std::string &pattern, GmpFilterAction action, GmpFilterMatch match)
+{
+    rangeFilter.addRule(pattern, action, match);
+}
+
+void GmpNvtxBridge::setFirstRangeHook(std::function<void()> hook)
+{
+    firstRangeHook = std::move(hook);
+}
+
+bool GmpNvtxBridge::isMappedDomain(const std::string &name) const
+{
+    return domainNames.empty() || domainNames.count(name) > 0;
+}
+
+GmpResult GmpNvtxBridge::attach(NvtxGetExportTableFunc_t getExportTable)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!getExportTable)
+    {
+        return GmpResult::ERROR;
+    }
+    auto *callbacks = static_cast<const NvtxExportTableCallbacks *>(getExportTable(NVTX_ETID_CALLBACKS));
+    if (!callbacks || callbacks->struct_size < sizeof(NvtxExportTableCallbacks) || !callbacks->GetModuleFunctionTable)
+    {
+        GMP_LOG_ERROR("NVTX export table has no callback interface.");
+        return GmpResult::ERROR;
+    }
+    if (!isAttached)
+    {
+        rangeFilter.compile();
+        defaultDomain.isMapped = isMappedDomain(DEFAULT_DOMAIN);
+        isAttached = true;
+    }
+    if (attachedBridge && attachedBridge != this)
+    {
+        GMP_LOG_WARNING("Another NVTX bridge was attached, its callbacks now reach this one.");
+    }
+    attachedBridge = this;
+
+    NvtxFunctionTable table = nullptr;
+    unsigned int size = 0;
+    if (callbacks->GetModuleFunctionTable(NVTX_CB_MODULE_CORE, &table, &size) && table)
+    {
+        patchSlot(table, size, NVTX_CBID_CORE_RangePushA, corePushA);
+        patchSlot(table, size, NVTX_CBID_CORE_RangePushW, corePushW);
+        patchSlot(table, size, NVTX_CBID_CORE_RangePushEx, corePushEx);
+        patchSlot(table, size, NVTX_CBID_CORE_RangePop, corePop);
+    }
+    table = nullptr;
+    size = 0;
+    if (callbacks->GetModuleFunctionTable(NVTX_CB_MODULE_CORE2, &table, &size) && table)
+    {
+        patchSlot(table, size, NVTX_CBID_CORE2_DomainRangePushEx, domainPushEx);
+        patchSlot(table, size, NVTX_CBID_CORE2_DomainRangePop, domainPop);
+        patchSlot(table, size, NVTX_CBID_CORE2_DomainCreateA, domainCreateA);
+        patchSlot(table, size, NVTX_CBID_CORE2_DomainCreateW, domainCreateW);
+        patchSlot(table, size, NVTX_CBID_CORE2_DomainDestroy, domainDestroy);
+        patchSlot(table, size, NVTX_CBID_CORE2_DomainRegisterStringA, domainRegisterStringA);
+        patchSlot(table, size, NVTX_CBID_CORE2_DomainRegisterStringW, domainRegisterStringW);
+    }
+    else
+    {
+        GMP_LOG_WARNING("NVTX client has no domain callbacks, only ranges without a domain are mapped.");
+    }
+    return GmpResult::SUCCESS;
+}
+
+nvtxDomainHandle_t GmpNvtxBridge::createDomain(const char *name)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    std::string domainName = name ? name : "";
+    // GMP's own range markers are never mapped back into GMP ranges.
+    bool isMapped = domainName != NvtxRangeManager::DOMAIN_NAME && isMappedDomain(domainName);
+    domains.push_back({domainName, isMapped});
+    return reinterpret_cast<nvtxDomainHandle_t>(&domains.back());
+}
+
+nvtxStringHandle_t GmpNvtxBridge::registerString(nvtxDomainHandle_t, const char *string)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    registeredStrings.emplace_back(string ? string : "");
+    return reinterpret_cast<nvtxStringHandle_t>(&registeredStrings.back());
+}
+
+int GmpNvtxBridge::pushRange(nvtxDomainHandle_t domain, const nvtxEventAttributes_t *attributes)
+{
+    std::string message;
+    if (attributes)
+    {
+        switch (attributes->messageType)
+        {
+        case NVTX_MESSAGE_TYPE_ASCII:
+            message = attributes->message.ascii ? attributes->message.ascii : "";
+            break;
+        case NVTX_MESSAGE_TYPE_UNICODE:
+            message = narrow(attributes->message.unicode);
+            break;
+        case NVTX_MESSAGE_TYPE_REGISTERED:
+            if (attributes->message.registered)
+            {
+                message = *reinterpret_cast<const std::string *>(attributes->message.registered);
+            }
+            break;
+        default:
+            break;
+        }
+    }
+    return push(domain, std::move(message));
+}
+
+int GmpNvtxBridge::pushRange(nvtxDomainHandle_t domain, const char *message)
+{
+    return push(domain, message ? message : "");
+}
+
+int GmpNvtxBridge::push(nvtxDomainHandle_t domain, std::string message)
+{
+    if (isForwarding)
+    {
+        return 0;
+    }
+    const Domain &state = domain ? *reinterpret_cast<const Domain *>(domain) : defaultDomain;
+    bool isMapped = state.isMapped && mappedDepth == 0 && (!rangeFilter.isActive() || rangeFilter.matches(message));
+    if (isMapped)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!hasOwnerThread)
+        {
+            hasOwnerThread = true;
+            ownerThread = std::this_thread::get_id();
+            if (firstRangeHook)
+            {
+                isForwarding = true;
+                firstRangeHook();
+                isForwarding = false;
+            }
+        }
+        else if (ownerThread != std::this_thread::get_id())
+        {
+            if (!hasWarnedThread)
+            {
+                GMP_LOG_WARNING("NVTX ranges of threads other than the first profiled one are ignored.");
+                hasWarnedThread = true;
+            }
+            isMapped = false;
+        }
+        if (isMapped)
+        {
+            mappedRangeCount++;
+            mappedDepth++;
+            isForwarding = true;
+            profiler->pushRange(message, type);
+            isForwarding = false;
+        }
+    }
+    if (!isMapped)
+    {
+        ignoredRangeCount++;
+    }
+    auto &ranges = threadRanges[domain];
+    ranges.push_back({isMapped, std::move(message)});
+    return static_cast<int>(ranges.size()) - 1;
+}
+
+int GmpNvtxBridge::popRange(nvtxDomainHandle_t domain)
+{
+    if (isForwarding)
+    {
+        return 0;
+    }
+    auto &ranges = threadRanges[domain];
+    if (ranges.empty())
+    {
+        return -1;
+    }
+    ThreadRange range = std::move(ranges.back());
+    ranges.pop_back();
+    if (range.isMapped)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        mappedDepth--;
+        isForwarding = true;
+        profiler->popRange(range.name, type);
+        isForwarding = false;
+    }
+    return static_cast<int>(ranges.size());
+}
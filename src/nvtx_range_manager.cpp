@@ -1,43 +1,83 @@
 #include "gmp/nvtx_range_manager.h"
+#include "gmp/log.h"
 
 #ifdef ENABLE_NVTX
 // NvtxRangeManager method implementations
-nvtxRangeId_t NvtxRangeManager::startRange(const std::string& name) {
-    nvtxRangeId_t rangeId = nvtxRangeStartA(name.c_str());
-    activeRanges_.push(rangeId);
-    rangeNameMap_[rangeId] = name;
-    return rangeId;
+NvtxRangeManager::~NvtxRangeManager() {
+    if (domain_) {
+        nvtxDomainDestroy(domain_);
+    }
+}
+
+nvtxDomainHandle_t NvtxRangeManager::getDomain() {
+    if (!domain_) {
+        domain_ = nvtxDomainCreateA(DOMAIN_NAME);
+    }
+    return domain_;
+}
+
+nvtxStringHandle_t NvtxRangeManager::getStringHandle(const std::string& name) {
+    auto it = stringHandles_.find(name);
+    if (it != stringHandles_.end()) {
+        return it->second;
+    }
+    nvtxStringHandle_t handle = nvtxDomainRegisterStringA(getDomain(), name.c_str());
+    stringHandles_.emplace(name, handle);
+    return handle;
+}
+
+nvtxStringHandle_t NvtxRangeManager::getStringHandle(const GmpRangeName& name) {
+    if (name.id >= internedHandles_.size()) {
+        internedHandles_.resize(name.id + 1, nullptr);
+    }
+    nvtxStringHandle_t &handle = internedHandles_[name.id];
+    if (!handle) {
+        handle = getStringHandle(*name.name);
+    }
+    return handle;
+}
+
+void NvtxRangeManager::startRange(const std::string& name) {
+    startRange(getStringHandle(name));
+}
+
+void NvtxRangeManager::startRange(nvtxStringHandle_t name) {
+    nvtxEventAttributes_t attributes = {};
+    attributes.version = NVTX_VERSION;
+    attributes.size = NVTX_EVENT_ATTRIB_STRUCT_SIZE;
+    attributes.messageType = NVTX_MESSAGE_TYPE_REGISTERED;
+    attributes.message.registered = name;
+    nvtxDomainRangePushEx(getDomain(), &attributes);
+    if (depth_ < MAX_TRACKED_DEPTH) {
+        activeRanges_[depth_] = name;
+    }
+    depth_++;
 }
 
 bool NvtxRangeManager::endRange(const std::string& expectedName) {
-    if (activeRanges_.empty()) {
+    if (depth_ == 0) {
         return false;
     }
-    
-    nvtxRangeId_t rangeId = activeRanges_.top();
-    activeRanges_.pop();
-    
-    // Optional: verify the name matches what we expect
-    if (!expectedName.empty() && rangeNameMap_[rangeId] != expectedName) {
-        // Log warning but still end the range
-        // Note: In a production system, you might want to handle this differently
-    }
-    
-    nvtxRangeEnd(rangeId);
-    rangeNameMap_.erase(rangeId);
+    depth_--;
+    // Only checked with debug logging, it costs a lookup.
+    if (GMP_LOG_LEVEL >= 4 && !expectedName.empty() && depth_ < MAX_TRACKED_DEPTH) {
+        auto it = stringHandles_.find(expectedName);
+        if (it == stringHandles_.end() || it->second != activeRanges_[depth_]) {
+            GMP_LOG_DEBUG("NVTX range " + expectedName + " ended out of order.");
+        }
+    }
+    nvtxDomainRangePop(domain_);
     return true;
 }
 
 size_t NvtxRangeManager::getActiveRangeCount() const {
-    return activeRanges_.size();
+    return depth_;
 }
 
 void NvtxRangeManager::clearAllRanges() {
-    while (!activeRanges_.empty()) {
-        nvtxRangeId_t rangeId = activeRanges_.top();
-        activeRanges_.pop();
-        nvtxRangeEnd(rangeId);
-        rangeNameMap_.erase(rangeId);
+    while (depth_ > 0) {
+        depth_--;
+        nvtxDomainRangePop(domain_);
     }
 }
-#endif // ENABLE_NVTX
\ No newline at end of file
+#endif // ENABLE_NVTX
@@ -1,4 +1,7 @@
+#include <algorithm>
+#include <filesystem>
 #include <set>
+#include <unistd.h>
 #include "gmp/profile.h"
 #ifdef ENABLE_NVTX
 #include <nvtx3/nvtx3.hpp>
@@ -30,17 +33,67 @@ GmpProfiler *GmpProfiler::getInstance()
 void GmpProfiler::startRangeProfiling()
 {
 #ifdef USE_CUPTI
+    waitForInit();
     CUPTI_API_CALL(rangeProfilerTargetPtr->StartRangeProfiler());
+    isRangeProfilingStarted = true;
+    isRangeProfilingSuspended = false;
 #endif
 }
 
 void GmpProfiler::stopRangeProfiling()
 {
 #ifdef USE_CUPTI
-    CUPTI_API_CALL(rangeProfilerTargetPtr->StopRangeProfiler());
+    waitForInit();
+    // A suspended range profiler has already been stopped by skipRange.
+    if (!isRangeProfilingSuspended)
+    {
+        CUPTI_API_CALL(rangeProfilerTargetPtr->StopRangeProfiler());
+    }
+    isRangeProfilingStarted = false;
+    isRangeProfilingSuspended = false;
+#endif
+}
+
+void GmpProfiler::resumeRangeProfiling()
+{
+#ifdef USE_CUPTI
+    CUPTI_API_CALL(rangeProfilerTargetPtr->StartRangeProfiler());
+    isRangeProfilingSuspended = false;
 #endif
 }
 
+void GmpProfiler::setSamplingPolicy(const GmpSamplingPolicy &policy)
+{
+    sampler.setPolicy(policy);
+}
+
+const GmpRangeSampler &GmpProfiler::getSampler() const
+{
+    return sampler;
+}
+
+GmpResult GmpProfiler::addRangeFilter(const std::string &pattern, GmpFilterAction action, GmpFilterMatch match)
+{
+    if (isInitialized)
+    {
+        GMP_LOG_WARNING("Range filter '" + pattern + "' ignored, filters must be added before init().");
+        return GmpResult::WARNING;
+    }
+    rangeFilter.addRule(pattern, action, match);
+    return GmpResult::SUCCESS;
+}
+
+GmpResult GmpProfiler::addKernelFilter(const std::string &pattern, GmpFilterAction action, GmpFilterMatch match)
+{
+    if (isInitialized)
+    {
+        GMP_LOG_WARNING("Kernel filter '" + pattern + "' ignored, filters must be added before init().");
+        return GmpResult::WARNING;
+    }
+    kernelFilter.addRule(pattern, action, match);
+    return GmpResult::SUCCESS;
+}
+
 void GmpProfiler::decodeCounterData()
 {
 #ifdef USE_CUPTI
@@ -97,20 +150,60 @@ GmpProfiler::~GmpProfiler()
     }
 #endif
 #ifdef USE_CUPTI
-    CUPTI_CALL(cuptiActivityFlushAll(1));
-    CUPTI_CALL(cuptiActivityDisable(CUPTI_ACTIVITY_KIND_CONCURRENT_KERNEL));
+    waitForInit();
+    if (!isReplayed)
+    {
+        closeSpill();
+        closeStreaming();
+        CUPTI_CALL(cuptiActivityFlushAll(1));
+        CUPTI_CALL(cuptiActivityDisable(CUPTI_ACTIVITY_KIND_CONCURRENT_KERNEL));
+    }
 
-    cuptiProfilerHost->TearDown();
+    if (cuptiProfilerHost && cuptiProfilerHost->IsSetUp())
+    {
+        cuptiProfilerHost->TearDown();
+    }
 #endif
 }
 
 GmpResult GmpProfiler::pushRange(const std::string &name, GmpProfileType type)
 {
+    return pushRangeImpl(name, nullptr, type);
+}
+
+GmpResult GmpProfiler::pushRange(const GmpRangeName &name, GmpProfileType type)
+{
+    return pushRangeImpl(*name.name, &name, type);
+}
+
+GmpResult GmpProfiler::popRange(const GmpRangeName &name, GmpProfileType type)
+{
+    return popRange(*name.name, type);
+}
+
+GmpResult GmpProfiler::pushRangeImpl(const std::string &name, const GmpRangeName *interned, GmpProfileType type)
+{
+    // Under user replay stopping the range profiler ends the pass, so ranges cannot be skipped.
+    if (isEnabled && replayMode != GmpReplayMode::USER &&
+        (skippedRangeDepth > 0 ||
+         (rangeFilter.isActive() && !(interned ? rangeFilter.matches(name, interned->hash) : rangeFilter.matches(name))) ||
+         (sampler.isActive() && !(interned ? sampler.shouldProfile(interned->hash) : sampler.shouldProfile(name)))))
+    {
+        return skipRange();
+    }
+    auto overheadStart = sampler.isAdaptive() ? GmpRangeSampler::clock_t::now() : GmpRangeSampler::clock_t::time_point();
 #ifdef ENABLE_NVTX
     if (isEnabled)
     {
-        std::cout << "Pushing NVTX range: " << name << std::endl;
-        nvtxManager_.startRange(name);
+        GMP_LOG_DEBUG("Pushing NVTX range: " + name);
+        if (interned)
+        {
+            nvtxManager_.startRange(nvtxManager_.getStringHandle(*interned));
+        }
+        else
+        {
+            nvtxManager_.startRange(name);
+        }
     }
 #endif
 #ifdef USE_CUPTI
@@ -118,31 +211,125 @@ GmpResult GmpProfiler::pushRange(const std::string &name, GmpProfileType type)
     {
         return GmpResult::SUCCESS;
     }
+    waitForInit();
+    if (replayPass > 1)
+    {
+        // Sessions were recorded on the first pass, later passes only feed the range profiler.
+        if (type == GmpProfileType::CONCURRENT_KERNEL)
+        {
+            cudaDeviceSynchronize();
+            pushRangeProfilerRange(name.c_str());
+        }
+        return GmpResult::SUCCESS;
+    }
+    if (isRangeProfilingSuspended)
+    {
+        resumeRangeProfiling();
+    }
+    if (streamWriter && type != GmpProfileType::CONCURRENT_KERNEL)
+    {
+        // Windows only hold kernel rows, freeing one would drop this range.
+        GMP_LOG_WARNING("Streaming stopped at range " + name +
+                        ", memory and transfer ranges are reported at the end of the run.");
+        closeStreaming();
+    }
     // Remove all the activity records that is before the range.
     cudaDeviceSynchronize();
     cuptiActivityFlushAll(1);
     GMP_LOG_DEBUG("Pushed range for type: " + std::to_string(static_cast<int>(type)) + " with session name: " + name);
+    uint64_t startTimestamp = 0;
+    CUPTI_CALL(cuptiGetTimestamp(&startTimestamp));
 
     switch (type)
     {
     case GmpProfileType::CONCURRENT_KERNEL:
-        GMP_API_CALL(getInstance()->sessionManager.startSession(type, std::make_unique<GmpConcurrentKernelSession>(name)));
+        GMP_API_CALL(openSession(type, name, startTimestamp, interned));
         pushRangeProfilerRange(name.c_str());
         break;
     case GmpProfileType::MEMORY:
-        GMP_API_CALL(getInstance()->sessionManager.startSession(type, std::make_unique<GmpMemSession>(name)));
+    case GmpProfileType::TRANSFER:
+        GMP_API_CALL(openSession(type, name, startTimestamp, interned));
         break;
     default:
         GMP_LOG_ERROR("Unsupported profile type: " + std::to_string(static_cast<int>(type)));
         return GmpResult::ERROR;
     }
 
+    if (sampler.isAdaptive())
+    {
+        sampler.recordOverhead(GmpRangeSampler::clock_t::now() - overheadStart);
+    }
+    return GmpResult::SUCCESS;
+#else
+    return GmpResult::SUCCESS;
+#endif
+}
+
+GmpResult GmpProfiler::openSession(GmpProfileType type, const std::string &name, uint64_t timestamp,
+                                   const GmpRangeName *interned)
+{
+#ifdef USE_CUPTI
+    if (spillWriter)
+    {
+        return spillWriter->appendRange(GmpSpillEntryType::PUSH_RANGE, type, timestamp, name);
+    }
+    GmpSessionPtr session;
+    switch (type)
+    {
+    case GmpProfileType::CONCURRENT_KERNEL:
+        session = interned ? sessionManager.createSession<GmpConcurrentKernelSession>(interned->id)
+                           : sessionManager.createSession<GmpConcurrentKernelSession>(name);
+        break;
+    case GmpProfileType::MEMORY:
+        session = interned ? sessionManager.createSession<GmpMemSession>(interned->id)
+                           : sessionManager.createSession<GmpMemSession>(name);
+        break;
+    case GmpProfileType::TRANSFER:
+        session = interned ? sessionManager.createSession<GmpTransferSession>(interned->id)
+                           : sessionManager.createSession<GmpTransferSession>(name);
+        hasTransferSessions = true;
+        break;
+    default:
+        GMP_LOG_ERROR("Unsupported profile type: " + std::to_string(static_cast<int>(type)));
+        return GmpResult::ERROR;
+    }
+    session->setStartTimestamp(timestamp);
+    return sessionManager.startSession(type, std::move(session));
+#else
     return GmpResult::SUCCESS;
+#endif
+}
+
+GmpResult GmpProfiler::closeSession(GmpProfileType type, const std::string &name, uint64_t timestamp)
+{
+#ifdef USE_CUPTI
+    if (spillWriter)
+    {
+        return spillWriter->appendRange(GmpSpillEntryType::POP_RANGE, type, timestamp, name);
+    }
+    return sessionManager.endSession(type, timestamp);
 #else
     return GmpResult::SUCCESS;
 #endif
 }
 
+GmpResult GmpProfiler::skipRange()
+{
+#ifdef USE_CUPTI
+    if (skippedRangeDepth++ == 0 && isRangeProfilingStarted && !isRangeProfilingSuspended)
+    {
+        // With auto range every kernel launched while the range profiler is
+        // running gets replayed, so keep it stopped until the next profiled range.
+        cudaDeviceSynchronize();
+        CUPTI_API_CALL(rangeProfilerTargetPtr->StopRangeProfiler());
+        isRangeProfilingSuspended = true;
+    }
+#else
+    skippedRangeDepth++;
+#endif
+    return GmpResult::SUCCESS;
+}
+
 GmpResult GmpProfiler::pushRangeProfilerRange(const char *rangeName)
 {
 #ifdef USE_CUPTI
@@ -190,6 +377,12 @@ GmpResult GmpProfiler::popRangeProfilerRange()
 
 GmpResult GmpProfiler::popRange(const std::string &name, GmpProfileType type)
 {
+    if (skippedRangeDepth > 0)
+    {
+        skippedRangeDepth--;
+        return GmpResult::SUCCESS;
+    }
+    auto overheadStart = sampler.isAdaptive() ? GmpRangeSampler::clock_t::now() : GmpRangeSampler::clock_t::time_point();
 #ifdef ENABLE_NVTX
     if (isEnabled)
     {
@@ -201,6 +394,15 @@ GmpResult GmpProfiler::popRange(const std::string &name, GmpProfileType type)
     {
         return GmpResult::SUCCESS;
     }
+    if (replayPass > 1)
+    {
+        if (type == GmpProfileType::CONCURRENT_KERNEL)
+        {
+            cudaDeviceSynchronize();
+            popRangeProfilerRange();
+        }
+        return GmpResult::SUCCESS;
+    }
     switch (type)
     {
     case GmpProfileType::CONCURRENT_KERNEL:
@@ -211,11 +413,23 @@ GmpResult GmpProfiler::popRange(const std::string &name, GmpProfileType type)
         // within the range are collected to the correct session.
         CUPTI_CALL(cuptiActivityFlushAll(1));
         GMP_LOG_DEBUG("Popped range for type: " + std::to_string(static_cast<int>(type)) + " with session name: " + name);
-        GMP_API_CALL(sessionManager.endSession(type));
+        uint64_t endTimestamp = 0;
+        CUPTI_CALL(cuptiGetTimestamp(&endTimestamp));
+        GMP_API_CALL(closeSession(type, name, endTimestamp));
         popRangeProfilerRange();
+        if (sampler.isAdaptive())
+        {
+            sampler.recordOverhead(GmpRangeSampler::clock_t::now() - overheadStart);
+        }
+        windowRangeCount++;
+        if (isStreamingWindowDue())
+        {
+            return flushStreamingWindow();
+        }
         return GmpResult::SUCCESS;
     }
     case GmpProfileType::MEMORY:
+    case GmpProfileType::TRANSFER:
     {
         cudaDeviceSynchronize();
 
@@ -223,7 +437,13 @@ GmpResult GmpProfiler::popRange(const std::string &name, GmpProfileType type)
         // within the range are collected to the correct session.
         CUPTI_CALL(cuptiActivityFlushAll(1));
         GMP_LOG_DEBUG("Popped memory range for type: " + std::to_string(static_cast<int>(type)) + " with session name: " + name);
-        GMP_API_CALL(sessionManager.endSession(type));
+        uint64_t endTimestamp = 0;
+        CUPTI_CALL(cuptiGetTimestamp(&endTimestamp));
+        GMP_API_CALL(closeSession(type, name, endTimestamp));
+        if (sampler.isAdaptive())
+        {
+            sampler.recordOverhead(GmpRangeSampler::clock_t::now() - overheadStart);
+        }
         return GmpResult::SUCCESS;
     }
     default:
@@ -239,23 +459,29 @@ GmpResult GmpProfiler::popRange(const std::string &name, GmpProfileType type)
 
 void GmpProfiler::printProfilerRanges(std::string &configName, GmpOutputKernelReduction option)
 {
-    std::vector<const char *> c_metrics = createCStyleStringArray(metrics);
 #ifdef USE_CUPTI
-    if (cuptiProfilerHost)
+    waitForInit();
+    if (evaluateCounterData() == GmpResult::SUCCESS)
     {
-        // Evaluate the results
-        size_t numRanges = 0;
-        CUPTI_API_CALL(cuptiProfilerHost->GetNumOfRanges(counterDataImage, numRanges));
-        printf("Number of ranges: %zu\n", numRanges);
-        for (size_t rangeIndex = 0; rangeIndex < numRanges; ++rangeIndex)
-        {
-            CUPTI_API_CALL(cuptiProfilerHost->EvaluateCounterData(rangeIndex, c_metrics, counterDataImage));
-        }
-
         // cuptiProfilerHost->PrintProfilerRanges();
         GMP_API_CALL(checkActivityAndRangeResultMatch());
         auto activityAllRangeData = sessionManager.getAllKernelDataOfType(GmpProfileType::CONCURRENT_KERNEL);
-        cuptiProfilerHost->PrintProfilerRangesWithNames(activityAllRangeData);
+        if (rangeMode == GmpRangeMode::USER)
+        {
+            std::vector<size_t> rangeIndices;
+            if (getUserRangeIndices(getKernelRangeNames(), rangeIndices) == GmpResult::SUCCESS)
+            {
+                cuptiProfilerHost->PrintUserRanges(activityAllRangeData, rangeIndices);
+            }
+        }
+        else if (!keepKernelDetail)
+        {
+            printRangeAccumulators(option);
+        }
+        else
+        {
+            cuptiProfilerHost->PrintProfilerRangesWithNames(activityAllRangeData);
+        }
         produceOutput(configName, option);
     }
     else
@@ -309,7 +535,7 @@ void GmpProfiler::printMemoryActivity()
 
         for (const auto &memData : memRange.memDataInRange)
         {
-            switch (memData.memoryOperationType)
+            switch (memData.memoryOperationType())
             {
             case CUPTI_ACTIVITY_MEMORY_OPERATION_TYPE_ALLOCATION:
                 totalBytesAllocated += memData.bytes;
@@ -338,7 +564,7 @@ void GmpProfiler::printMemoryActivity()
             const auto &memData = memRange.memDataInRange[i];
 
             const char *opType = "";
-            switch (memData.memoryOperationType)
+            switch (memData.memoryOperationType())
             {
             case CUPTI_ACTIVITY_MEMORY_OPERATION_TYPE_ALLOCATION:
                 opType = "ALLOC";
@@ -352,7 +578,7 @@ void GmpProfiler::printMemoryActivity()
             }
 
             const char *memKind = "";
-            switch (memData.memoryKind)
+            switch (memData.memoryKind())
             {
             case CUPTI_ACTIVITY_MEMORY_KIND_DEVICE:
                 memKind = "DEVICE";
@@ -369,14 +595,15 @@ void GmpProfiler::printMemoryActivity()
             }
 
             printf("    [%zu] %s %s: %llu bytes at 0x%016llx",
-                   i + 1, opType, memKind, memData.bytes, memData.address);
+                   i + 1, opType, memKind, (unsigned long long)memData.bytes, (unsigned long long)memData.address);
 
-            if (memData.name && strlen(memData.name) > 0)
+            auto name = memData.name();
+            if (!name.empty())
             {
-                printf(" (%s)", memData.name);
+                printf(" (%.*s)", static_cast<int>(name.size()), name.data());
             }
 
-            if (memData.isAsync)
+            if (memData.isAsync())
             {
                 printf(" [ASYNC, Stream %u]", memData.streamId);
             }
@@ -407,146 +634,1012 @@ std::vector<GmpMemRangeData> GmpProfiler::getMemoryActivity()
 #endif
 }
 
-void GmpProfiler::produceOutput(std::string &name, GmpOutputKernelReduction option)
+GmpMemoryTimeline GmpProfiler::getMemoryFootprint()
 {
+    GmpMemoryTimeline memoryTimeline;
 #ifdef USE_CUPTI
-    std::string path = "./output/result.csv";
+    if (isEnabled)
+    {
+        memoryTimeline.build(sessionManager.getAllMemDataOfType(GmpProfileType::MEMORY));
+    }
+#endif
+    return memoryTimeline;
+}
 
-    auto sumFunc = [](const std::vector<ProfilerRange> &ranges, size_t startIndex, size_t size)
+void GmpProfiler::printMemoryFootprint()
+{
+#ifdef USE_CUPTI
+    if (!isEnabled)
     {
-        std::unordered_map<std::string, double> combinedMetrics;
-        for (size_t i = startIndex; i < startIndex + size && i < ranges.size(); ++i)
-        {
-            for (const auto &metric : ranges[i].metricValues)
-            {
-                combinedMetrics[metric.first] += metric.second;
-            }
-        }
-        return combinedMetrics;
-    };
+        printf("GMP Profiler is disabled.\n");
+        return;
+    }
 
-    auto maxFunc = [](const std::vector<ProfilerRange> &ranges, size_t startIndex, size_t size)
+    auto memoryTimeline = getMemoryFootprint();
+    const auto &footprints = memoryTimeline.getRangeFootprints();
+
+    printf("\n=== Memory Footprint Report ===\n");
+    if (footprints.empty())
     {
-        std::unordered_map<std::string, double> maxMetrics;
-        for (size_t i = startIndex; i < startIndex + size && i < ranges.size(); ++i)
-        {
-            for (const auto &metric : ranges[i].metricValues)
-            {
-                if (maxMetrics.find(metric.first) == maxMetrics.end() || metric.second > maxMetrics[metric.first])
-                {
-                    maxMetrics[metric.first] = metric.second;
-                }
-            }
-        }
-        return maxMetrics;
-    };
+        printf("No memory activity ranges found.\n");
+        return;
+    }
 
-    auto meanFunc = [](const std::vector<ProfilerRange> &ranges, size_t startIndex, size_t size)
+    for (size_t rangeIdx = 0; rangeIdx < footprints.size(); rangeIdx++)
     {
-        std::unordered_map<std::string, double> meanMetrics;
-        for (size_t i = startIndex; i < startIndex + size && i < ranges.size(); ++i)
+        const auto &footprint = footprints[rangeIdx];
+        printf("Range %zu: %s\n", rangeIdx + 1, footprint.name.c_str());
+        printf("  Live at start: %.2f MB, at end: %.2f MB\n",
+               footprint.liveBytesAtStart / 1024.0 / 1024.0, footprint.liveBytesAtEnd / 1024.0 / 1024.0);
+        printf("  Peak in range: %.2f MB, high-water mark: %.2f MB\n",
+               footprint.peakLiveBytes / 1024.0 / 1024.0, footprint.highWaterMark / 1024.0 / 1024.0);
+        printf("  Allocated: %llu bytes, released: %llu bytes\n",
+               (unsigned long long)footprint.allocatedBytes, (unsigned long long)footprint.releasedBytes);
+        if (!footprint.leakedAllocations.empty())
         {
-            for (const auto &metric : ranges[i].metricValues)
+            uint64_t leakedBytes = 0;
+            for (const auto &allocation : footprint.leakedAllocations)
             {
-                meanMetrics[metric.first] += metric.second;
+                leakedBytes += allocation.bytes;
+            }
+            printf("  Outliving the range: %zu allocations, %llu bytes\n",
+                   footprint.leakedAllocations.size(), (unsigned long long)leakedBytes);
+            for (const auto &allocation : footprint.leakedAllocations)
+            {
+                printf("    %llu bytes at 0x%016llx\n",
+                       (unsigned long long)allocation.bytes, (unsigned long long)allocation.address);
             }
         }
-        for (auto &metric : meanMetrics)
-        {
-            metric.second /= size;
-        }
-        return meanMetrics;
-    };
+        printf("\n");
+    }
 
-    std::ofstream outputFile(path, std::ios::app);
-    if (!outputFile.is_open())
+    printf("Overall high-water mark: %.2f MB, still live: %.2f MB\n",
+           memoryTimeline.getHighWaterMark() / 1024.0 / 1024.0, memoryTimeline.getLiveBytes() / 1024.0 / 1024.0);
+    if (memoryTimeline.getUnmatchedReleaseCount() > 0)
     {
-        GMP_LOG_ERROR("Failed to open output file: " + path);
-        return;
+        printf("Releases of allocations made outside any range: %zu\n", memoryTimeline.getUnmatchedReleaseCount());
     }
+    printf("=== End Memory Footprint Report ===\n\n");
+#else
+    printf("CUPTI support is not enabled. Memory activity profiling is not available.\n");
+#endif
+}
 
-    outputFile << "Config Name," << name << "\n";
+std::vector<GmpKernelTimelineStats> GmpProfiler::getKernelTimeline(size_t maxReportedGaps)
+{
+#ifdef USE_CUPTI
+    if (isEnabled)
+    {
+        GmpKernelTimelineAnalyzer analyzer(maxReportedGaps);
+        return analyzer.analyze(sessionManager.getAllKernelDataOfType(GmpProfileType::CONCURRENT_KERNEL));
+    }
+#endif
+    return std::vector<GmpKernelTimelineStats>();
+}
 
-    auto activityAllRangeData = sessionManager.getAllKernelDataOfType(GmpProfileType::CONCURRENT_KERNEL);
-    size_t rangeProfileOffset = 0;
-    for (int activityRangeIdx = 0; activityRangeIdx < activityAllRangeData.size(); activityRangeIdx++)
+void GmpProfiler::printKernelTimeline(size_t maxReportedGaps)
+{
+#ifdef USE_CUPTI
+    if (!isEnabled)
+    {
+        printf("GMP Profiler is disabled.\n");
+        return;
+    }
+
+    auto allStats = getKernelTimeline(maxReportedGaps);
+    printf("\n=== Kernel Timeline Report ===\n");
+    for (size_t rangeIdx = 0; rangeIdx < allStats.size(); rangeIdx++)
     {
-        const auto &activityRange = activityAllRangeData[activityRangeIdx];
-        auto kernelNum = activityRange.kernelDataInRange.size();
-        if (kernelNum == 0)
+        const auto &stats = allStats[rangeIdx];
+        printf("Range %zu: %s\n", rangeIdx + 1, stats.name.c_str());
+        if (stats.kernelCount == 0)
         {
-            GMP_LOG_DEBUG("Skipping kernel reduction for range '" + activityRange.name + "' because it contains no kernel records.");
+            printf("  No kernels with timestamps recorded.\n\n");
             continue;
         }
-        outputFile.precision(2);
-
-        std::unordered_map<std::string, double> reducedMetrics;
-        switch (option)
+        printf("  Kernels: %zu, span: %.3f us, busy: %.3f us (%.1f%%), idle: %.3f us\n",
+               stats.kernelCount, stats.spanNs / 1000.0, stats.busyNs / 1000.0,
+               100.0 * stats.busyFraction(), stats.idleNs / 1000.0);
+        printf("  Max concurrency: %u, overlapped: %.3f us\n", stats.maxConcurrency, stats.overlapNs / 1000.0);
+        for (size_t concurrency = 1; concurrency < stats.concurrencyHistogram.size(); ++concurrency)
         {
-        case GmpOutputKernelReduction::SUM:
-            reducedMetrics = cuptiProfilerHost->getRangeMetrics(rangeProfileOffset, kernelNum, sumFunc);
-            break;
-        case GmpOutputKernelReduction::MAX:
-            reducedMetrics = cuptiProfilerHost->getRangeMetrics(rangeProfileOffset, kernelNum, maxFunc);
-            break;
-        case GmpOutputKernelReduction::MEAN:
-            reducedMetrics = cuptiProfilerHost->getRangeMetrics(rangeProfileOffset, kernelNum, meanFunc);
-            break;
-        default:
-            break;
+            printf("    %zu kernel(s) running: %.3f us\n", concurrency, stats.concurrencyHistogram[concurrency] / 1000.0);
         }
-
-        for (auto metricsPair : reducedMetrics)
+        printf("  Idle gaps: %zu\n", stats.idleGapCount);
+        for (const auto &gap : stats.longestGaps)
         {
-            outputFile << std::fixed << activityRange.name << "," << metricsPair.first << "," << metricsPair.second << "\n";
+            printf("    %.3f us at +%.3f us\n", gap.duration() / 1000.0, (gap.start - stats.firstStart) / 1000.0);
         }
-        rangeProfileOffset += kernelNum;
+        printf("\n");
     }
-    outputFile.close();
+    printf("=== End Kernel Timeline Report ===\n\n");
 #endif
 }
 
-void GmpProfiler::bufferRequestedImpl(uint8_t **buffer, size_t *size, size_t *maxNumRecords)
+std::vector<GmpTransferStats> GmpProfiler::getTransferStats()
 {
+    std::vector<GmpTransferStats> allStats;
 #ifdef USE_CUPTI
-    *size = 16 * 1024;
-    *buffer = (uint8_t *)malloc(*size);
-    *maxNumRecords = 0;
+    if (!isEnabled)
+    {
+        return allStats;
+    }
+    GmpTransferAnalyzer analyzer;
+    sessionManager.forEachSession(GmpProfileType::TRANSFER, [&](const GmpProfileSession &session)
+    {
+        allStats.push_back(analyzer.analyze(session.getSessionName(), session.getTransferDataView(),
+                                            session.getComputeIntervalView()));
+    });
 #endif
+    return allStats;
 }
 
-void GmpProfiler::bufferCompletedImpl(CUcontext ctx, uint32_t streamId,
-                                      uint8_t *buffer, size_t size, size_t validSize)
+void GmpProfiler::printTransferStats()
 {
 #ifdef USE_CUPTI
-    CUptiResult status;
-    CUpti_Activity *record = nullptr;
-    GMP_LOG_DEBUG("Buffer completion callback called");
-    for (;;)
+    if (!isEnabled)
     {
-        status = cuptiActivityGetNextRecord(buffer, validSize, &record);
-        if (status == CUPTI_SUCCESS)
+        printf("GMP Profiler is disabled.\n");
+        return;
+    }
+
+    auto allStats = getTransferStats();
+    printf("\n=== Memcpy/Memset Report ===\n");
+    for (size_t rangeIdx = 0; rangeIdx < allStats.size(); rangeIdx++)
+    {
+        const auto &stats = allStats[rangeIdx];
+        printf("Range %zu: %s\n", rangeIdx + 1, stats.name.c_str());
+        if (stats.transferCount == 0)
         {
-            if (record->kind == CUPTI_ACTIVITY_KIND_CONCURRENT_KERNEL)
+            printf("  No memcpy or memset recorded.\n\n");
+            continue;
+        }
+        printf("  Transfers: %zu, total: %.3f MB\n", stats.transferCount, stats.totalBytes / 1e6);
+        for (size_t direction = 0; direction < stats.directions.size(); ++direction)
+        {
+            const auto &directionStats = stats.directions[direction];
+            if (directionStats.count == 0)
             {
-                auto *kernel = (CUpti_ActivityKernel8 *)record;
-                auto result = sessionManager.accumulate<GmpConcurrentKernelSession>(
-                    GmpProfileType::CONCURRENT_KERNEL,
-                    [&kernel](GmpConcurrentKernelSession *sessionPtr)
-                    {
-                        // printf("CUPTI: Kernel \"%s\" launched on stream %u, grid (%u,%u,%u), block (%u,%u,%u)\n",
-                        //         kernel->name, kernel->streamId,
-                        //         kernel->gridX, kernel->gridY, kernel->gridZ,
-                        //         kernel->blockX, kernel->blockY, kernel->blockZ);
-                        sessionPtr->num_calls++;
-                        GmpKernelData data;
-                        data.name = kernel->name;
-                        data.grid_size[0] = kernel->gridX;
-                        data.grid_size[1] = kernel->gridY;
+                continue;
+            }
+            printf("    %-7s %8zu transfers, %12.3f MB, %10.3f us, %8.2f GB/s\n",
+                   gmpTransferDirectionName(static_cast<GmpTransferDirection>(direction)), directionStats.count,
+                   directionStats.bytes / 1e6, directionStats.durationNs / 1000.0, directionStats.bandwidth());
+        }
+        printf("  Sizes:");
+        for (size_t bucket = 0; bucket < GmpTransferStats::SIZE_BUCKET_COUNT; ++bucket)
+        {
+            printf(" %s: %zu%s", GmpTransferStats::sizeBucketName(bucket), stats.sizeHistogram[bucket],
+                   bucket + 1 < GmpTransferStats::SIZE_BUCKET_COUNT ? "," : "\n");
+        }
+        printf("  Copy busy: %.3f us, overlapped with %zu kernel(s): %.3f us (%.1f%%)\n", stats.copyBusyNs / 1000.0,
+               stats.kernelCount, stats.overlapNs / 1000.0, 100.0 * stats.overlapFraction());
+        if (stats.pageableCount > 0)
+        {
+            printf("  WARNING: %zu copies (%.3f MB) use pageable host memory. They are staged through a pinned\n"
+                   "           buffer and block the host; use cudaMallocHost or cudaHostRegister.\n",
+                   stats.pageableCount, stats.pageableBytes / 1e6);
+        }
+        printf("\n");
+    }
+    printf("=== End Memcpy/Memset Report ===\n\n");
+#endif
+}
+
+GmpHotKernelTable GmpProfiler::getHotKernelTable()
+{
+    GmpHotKernelTable table;
+#ifdef USE_CUPTI
+    if (!isEnabled)
+    {
+        return table;
+    }
+    waitForInit();
+    evaluateCounterData();
+    const std::vector<ProfilerRange> emptyRanges;
+    const auto &profilerRanges = (cuptiProfilerHost && rangeMode == GmpRangeMode::AUTO)
+                                     ? cuptiProfilerHost->getProfilerRanges()
+                                     : emptyRanges;
+    auto metricOf = [](const ProfilerRange &profilerRange, const char *metric)
+    {
+        auto it = profilerRange.metricValues.find(metric);
+        return it != profilerRange.metricValues.end() ? it->second : 0.0;
+    };
+
+    // Single pass over the sessions, kernels are joined with their metrics by launch order.
+    size_t rangeOffset = 0;
+    sessionManager.forEachSession(GmpProfileType::CONCURRENT_KERNEL, [&](const GmpProfileSession &session)
+    {
+        for (const auto &kernel : session.getKernelDataView())
+        {
+            size_t metricIndex = rangeOffset + kernel.launchIndex;
+            if (metricIndex < profilerRanges.size())
+            {
+                const auto &profilerRange = profilerRanges[metricIndex];
+                table.add(kernel, true, metricOf(profilerRange, "smsp__inst_executed.sum"),
+                          metricOf(profilerRange, "dram__sectors_read.sum") + metricOf(profilerRange, "dram__sectors_write.sum"));
+            }
+            else
+            {
+                table.add(kernel, false, 0.0, 0.0);
+            }
+        }
+        rangeOffset += session.getKernelLaunchCount();
+    });
+#endif
+    return table;
+}
+
+std::vector<GmpHotKernel> GmpProfiler::getHotKernels(size_t topN, GmpHotKernelOrder order)
+{
+    return getHotKernelTable().top(topN, order);
+}
+
+void GmpProfiler::printHotKernels(size_t topN)
+{
+#ifdef USE_CUPTI
+    if (!isEnabled)
+    {
+        printf("GMP Profiler is disabled.\n");
+        return;
+    }
+
+    auto table = getHotKernelTable();
+    const auto &totals = table.getTotals();
+    printf("\n=== Hot Kernel Report ===\n");
+    printf("%zu launches of %zu distinct kernel signatures\n", totals.launchCount, table.size());
+
+    struct Column
+    {
+        GmpHotKernelOrder order;
+        const char *title;
+    };
+    const Column columns[] = {{GmpHotKernelOrder::TIME, "GPU time (ns)"},
+                              {GmpHotKernelOrder::INSTRUCTIONS, "instructions executed"},
+                              {GmpHotKernelOrder::DRAM_SECTORS, "DRAM sectors"}};
+    for (const auto &column : columns)
+    {
+        double total = GmpHotKernelTable::valueOf(totals, column.order);
+        if (column.order != GmpHotKernelOrder::TIME && totals.measuredLaunchCount == 0)
+        {
+            printf("\nTop kernels by %s: no per-kernel metrics evaluated.\n", column.title);
+            continue;
+        }
+        printf("\nTop kernels by %s:\n", column.title);
+        for (const auto &entry : table.top(topN, column.order))
+        {
+            double value = GmpHotKernelTable::valueOf(entry, column.order);
+            printf("  %6.2f%%  %14.0f  %6zu launches  %s<<<{%d, %d, %d}, {%d, %d, %d}>>>\n",
+                   total > 0 ? 100.0 * value / total : 0.0, value, entry.launchCount, entry.name.c_str(),
+                   entry.grid_size[0], entry.grid_size[1], entry.grid_size[2],
+                   entry.block_size[0], entry.block_size[1], entry.block_size[2]);
+        }
+    }
+    printf("=== End Hot Kernel Report ===\n\n");
+#else
+    printf("CUPTI support is not enabled. Kernel profiling is not available.\n");
+#endif
+}
+
+void GmpProfiler::setRooflinePeaks(const GmpRooflinePeaks &peaks)
+{
+    rooflinePeaks = peaks;
+}
+
+std::vector<GmpRooflinePoint> GmpProfiler::getRooflineRanges()
+{
+    std::vector<GmpRooflinePoint> points;
+#ifdef USE_CUPTI
+    if (!isEnabled)
+    {
+        return points;
+    }
+    waitForInit();
+    auto roofline = makeRoofline();
+    if (!roofline)
+    {
+        return points;
+    }
+    evaluateCounterData();
+    reduceRangeMetrics(GmpOutputKernelReduction::SUM, [&](const GmpProfileSession &session, const std::unordered_map<std::string, double> &reducedMetrics)
+    {
+        auto metricOf = [&reducedMetrics](const char *metric)
+        {
+            auto it = reducedMetrics.find(metric);
+            return it != reducedMetrics.end() ? it->second : 0.0;
+        };
+        points.push_back(roofline->classify(session.getSessionName(), metricOf("smsp__inst_executed.sum"),
+                                            metricOf("dram__sectors_read.sum") + metricOf("dram__sectors_write.sum"),
+                                            metricOf("gpu__time_duration.sum")));
+    });
+#endif
+    return points;
+}
+
+std::vector<GmpRooflinePoint> GmpProfiler::getRooflineKernels()
+{
+    std::vector<GmpRooflinePoint> points;
+#ifdef USE_CUPTI
+    if (!isEnabled)
+    {
+        return points;
+    }
+    waitForInit();
+    auto roofline = makeRoofline();
+    if (!roofline)
+    {
+        return points;
+    }
+    forEachKernelMetrics([&](const GmpProfileSession &session, const GmpKernelData &kernel, const std::unordered_map<std::string, double> &metricValues)
+    {
+        auto metricOf = [&metricValues](const char *metric)
+        {
+            auto it = metricValues.find(metric);
+            return it != metricValues.end() ? it->second : 0.0;
+        };
+        points.push_back(roofline->classify(kernel.name(), metricOf("smsp__inst_executed.sum"),
+                                            metricOf("dram__sectors_read.sum") + metricOf("dram__sectors_write.sum"),
+                                            metricOf("gpu__time_duration.sum")));
+        points.back().rangeName = session.getSessionName();
+    });
+#endif
+    return points;
+}
+
+void GmpProfiler::printRoofline(size_t topN)
+{
+#ifdef USE_CUPTI
+    if (!isEnabled)
+    {
+        printf("GMP Profiler is disabled.\n");
+        return;
+    }
+
+    auto ranges = getRooflineRanges();
+    if (ranges.empty())
+    {
+        printf("No roofline available.\n");
+        return;
+    }
+    auto roofline = makeRoofline();
+    const auto &peaks = roofline->getPeaks();
+    printf("\n=== Roofline Report ===\n");
+    printf("Chip %s: %.1f G warp inst/s, %.1f GB/s DRAM, ridge at %.3f inst/byte\n", peaks.chipName.c_str(),
+           peaks.instructionRate(), peaks.dramBandwidth, roofline->ridgeIntensity());
+
+    auto printPoint = [](const GmpRooflinePoint &point)
+    {
+        if (point.bound == GmpRooflineBound::UNKNOWN)
+        {
+            printf("  %-8s %s\n", gmpRooflineBoundName(point.bound), point.name.c_str());
+            return;
+        }
+        printf("  %-8s %10.3f %12.2f %12.2f %7.1f%%  %s\n", gmpRooflineBoundName(point.bound), point.intensity,
+               point.instructionRate, point.bandwidth, 100.0 * point.roofFraction, point.name.c_str());
+    };
+    const char *columns = "  %-8s %10s %12s %12s %8s  %s\n";
+    printf("\nRanges:\n");
+    printf(columns, "bound", "inst/byte", "Ginst/s", "GB/s", "of roof", "name");
+    for (const auto &point : ranges)
+    {
+        printPoint(point);
+    }
+
+    auto kernels = getRooflineKernels();
+    size_t memoryBound = 0;
+    size_t computeBound = 0;
+    for (const auto &point : kernels)
+    {
+        memoryBound += point.bound == GmpRooflineBound::MEMORY;
+        computeBound += point.bound == GmpRooflineBound::COMPUTE;
+    }
+    if (!kernels.empty())
+    {
+        // Furthest below the roof first, weighted by time: the kernels worth optimizing.
+        auto potential = [](const GmpRooflinePoint &point) { return point.distanceToRoof() * point.durationNs; };
+        size_t count = std::min(topN, kernels.size());
+        std::partial_sort(kernels.begin(), kernels.begin() + count, kernels.end(),
+                          [&](const GmpRooflinePoint &a, const GmpRooflinePoint &b) { return potential(a) > potential(b); });
+        printf("\n%zu kernels: %zu memory-bound, %zu compute-bound. Top %zu by time below the roof:\n",
+               kernels.size(), memoryBound, computeBound, count);
+        printf(columns, "bound", "inst/byte", "Ginst/s", "GB/s", "of roof", "name");
+        for (size_t i = 0; i < count; ++i)
+        {
+            printPoint(kernels[i]);
+        }
+    }
+    printf("=== End Roofline Report ===\n\n");
+#else
+    printf("CUPTI support is not enabled. Roofline is not available.\n");
+#endif
+}
+
+GmpResult GmpProfiler::exportRooflineCsv(const std::string &path, bool includeKernels)
+{
+    auto points = getRooflineRanges();
+    if (points.empty())
+    {
+        GMP_LOG_WARNING("No roofline to export.");
+        return GmpResult::WARNING;
+    }
+    if (includeKernels)
+    {
+        auto kernels = getRooflineKernels();
+        points.insert(points.end(), std::make_move_iterator(kernels.begin()), std::make_move_iterator(kernels.end()));
+    }
+    return GmpRoofline::writeCsv(path, points) ? GmpResult::SUCCESS : GmpResult::ERROR;
+}
+
+std::vector<GmpBottleneckReport> GmpProfiler::getBottleneckRanges()
+{
+    std::vector<GmpBottleneckReport> reports;
+#ifdef USE_CUPTI
+    if (!isEnabled)
+    {
+        return reports;
+    }
+    waitForInit();
+    evaluateCounterData();
+    GmpBottleneckClassifier classifier;
+    reduceRangeMetrics(GmpOutputKernelReduction::SUM, [&](const GmpProfileSession &session, const std::unordered_map<std::string, double> &reducedMetrics)
+    {
+        reports.push_back(classifier.classify(session.getSessionName(), GmpStallMetrics::fromMetrics(reducedMetrics)));
+    });
+#endif
+    return reports;
+}
+
+std::vector<GmpBottleneckReport> GmpProfiler::getBottleneckKernels()
+{
+    std::vector<GmpBottleneckReport> reports;
+#ifdef USE_CUPTI
+    if (!isEnabled)
+    {
+        return reports;
+    }
+    waitForInit();
+    GmpBottleneckClassifier classifier;
+    forEachKernelMetrics([&](const GmpProfileSession &session, const GmpKernelData &kernel, const std::unordered_map<std::string, double> &metricValues)
+    {
+        reports.push_back(classifier.classify(kernel.name(), GmpStallMetrics::fromMetrics(metricValues)));
+        reports.back().rangeName = session.getSessionName();
+    });
+#endif
+    return reports;
+}
+
+void GmpProfiler::printBottlenecks(size_t topN)
+{
+#ifdef USE_CUPTI
+    if (!isEnabled)
+    {
+        printf("GMP Profiler is disabled.\n");
+        return;
+    }
+
+    printf("\n=== Bottleneck Report ===\n");
+    printf("Ranges:\n");
+    printf("  %8s %8s  %-40s %s\n", "IPC", "eligible", "name", "bottlenecks");
+    for (const auto &report : getBottleneckRanges())
+    {
+        printf("  %8.3f %8.2f  %-40s %s\n", report.issueRate, report.eligiblePerCycle, report.name.c_str(),
+               report.summary().c_str());
+    }
+
+    auto kernels = getBottleneckKernels();
+    if (!kernels.empty())
+    {
+        size_t count = std::min(topN, kernels.size());
+        std::partial_sort(kernels.begin(), kernels.begin() + count, kernels.end(),
+                          [](const GmpBottleneckReport &a, const GmpBottleneckReport &b) { return a.durationNs > b.durationNs; });
+        printf("\nTop %zu of %zu kernels by time:\n", count, kernels.size());
+        printf("  %8s %8s  %-40s %s\n", "IPC", "eligible", "name", "bottlenecks");
+        for (size_t i = 0; i < count; ++i)
+        {
+            printf("  %8.3f %8.2f  %-40s %s\n", kernels[i].issueRate, kernels[i].eligiblePerCycle,
+                   kernels[i].name.c_str(), kernels[i].summary().c_str());
+        }
+    }
+    printf("=== End Bottleneck Report ===\n\n");
+#else
+    printf("CUPTI support is not enabled. Bottleneck classification is not available.\n");
+#endif
+}
+
+GmpResult GmpProfiler::exportTrace(const std::string &path)
+{
+#ifdef USE_CUPTI
+    if (!isEnabled)
+    {
+        GMP_LOG_WARNING("GMP Profiler is disabled, no trace exported.");
+        return GmpResult::WARNING;
+    }
+    waitForInit();
+    evaluateCounterData();
+
+    // pid 0 holds the GMP ranges, every device gets its own process.
+    constexpr uint32_t rangePid = 0;
+    constexpr uint32_t kernelRangeTid = 0;
+    constexpr uint32_t memRangeTid = 1;
+    constexpr uint32_t devicePidBase = 1;
+
+    GmpTraceWriter writer;
+    if (!writer.open(path))
+    {
+        return GmpResult::ERROR;
+    }
+    writer.processName(rangePid, "GMP ranges");
+    writer.threadName(rangePid, kernelRangeTid, "Kernel ranges");
+    writer.threadName(rangePid, memRangeTid, "Memory ranges");
+
+    auto writeMetrics = [&writer, this](const ProfilerRange &profilerRange)
+    {
+        for (const auto &metric : metrics)
+        {
+            auto it = profilerRange.metricValues.find(metric);
+            if (it != profilerRange.metricValues.end())
+            {
+                writer.addArg(metric, it->second);
+            }
+        }
+    };
+
+    auto writeRange = [&writer, &writeMetrics](const GmpProfileSession &session, uint32_t tid, const ProfilerRange *profilerRange)
+    {
+        uint64_t start = session.getStartTimestamp();
+        uint64_t end = session.getEndTimestamp();
+        if (start == 0 || end < start)
+        {
+            return;
+        }
+        writer.beginComplete(session.getSessionName(), "range", rangePid, tid, start, end - start);
+        if (profilerRange)
+        {
+            writeMetrics(*profilerRange);
+        }
+        writer.endEvent();
+    };
+
+    // In user range mode the metrics belong to the range, otherwise to the
+    // individual kernels.
+    const std::vector<ProfilerRange> *profilerRanges =
+        cuptiProfilerHost ? &cuptiProfilerHost->getProfilerRanges() : nullptr;
+    std::vector<size_t> userRangeIndices;
+    if (rangeMode == GmpRangeMode::USER && profilerRanges && !profilerRanges->empty())
+    {
+        getUserRangeIndices(getKernelRangeNames(), userRangeIndices);
+    }
+    std::set<uint32_t> namedDevices;
+    size_t rangeOffset = 0;
+    size_t sessionIndex = 0;
+    sessionManager.forEachSession(GmpProfileType::CONCURRENT_KERNEL, [&](const GmpProfileSession &session)
+    {
+        const ProfilerRange *rangeMetrics = sessionIndex < userRangeIndices.size()
+                                                ? &(*profilerRanges)[userRangeIndices[sessionIndex]]
+                                                : nullptr;
+        sessionIndex++;
+        writeRange(session, kernelRangeTid, rangeMetrics);
+        for (const auto &kernel : session.getKernelDataView())
+        {
+            if (kernel.end <= kernel.start)
+            {
+                continue;
+            }
+            uint32_t pid = devicePidBase + kernel.deviceId;
+            if (namedDevices.insert(kernel.deviceId).second)
+            {
+                writer.processName(pid, "GPU " + std::to_string(kernel.deviceId));
+            }
+            writer.beginComplete(kernel.name(), "kernel", pid, kernel.streamId, kernel.start, kernel.end - kernel.start);
+            writer.addArg("grid", std::to_string(kernel.grid_size[0]) + "x" + std::to_string(kernel.grid_size[1]) +
+                                      "x" + std::to_string(kernel.grid_size[2]));
+            writer.addArg("block", std::to_string(kernel.block_size[0]) + "x" + std::to_string(kernel.block_size[1]) +
+                                       "x" + std::to_string(kernel.block_size[2]));
+            writer.addArg("correlationId", static_cast<uint64_t>(kernel.correlationId));
+            size_t metricIndex = rangeOffset + kernel.launchIndex;
+            if (rangeMode == GmpRangeMode::AUTO && profilerRanges && metricIndex < profilerRanges->size())
+            {
+                writeMetrics((*profilerRanges)[metricIndex]);
+            }
+            writer.endEvent();
+        }
+        rangeOffset += session.getKernelLaunchCount();
+    });
+
+    // Memory operations are replayed in time order to drive the live footprint
+    // counter of each device.
+    std::map<uint32_t, GmpMemoryTimeline> memoryTimelines;
+    std::vector<size_t> order;
+    sessionManager.forEachSession(GmpProfileType::MEMORY, [&](const GmpProfileSession &session)
+    {
+        writeRange(session, memRangeTid, nullptr);
+        const auto &memData = session.getMemDataView();
+        order.resize(memData.size());
+        for (size_t i = 0; i < order.size(); ++i)
+        {
+            order[i] = i;
+        }
+        const auto &timestamps = memData.timestamp;
+        std::stable_sort(order.begin(), order.end(), [&timestamps](size_t a, size_t b)
+                         { return timestamps[a] < timestamps[b]; });
+
+        for (size_t index : order)
+        {
+            GmpMemData record = memData.at(index);
+            uint32_t pid = devicePidBase + record.deviceId;
+            if (namedDevices.insert(record.deviceId).second)
+            {
+                writer.processName(pid, "GPU " + std::to_string(record.deviceId));
+            }
+            bool isAllocation = record.memoryOperationType() == CUPTI_ACTIVITY_MEMORY_OPERATION_TYPE_ALLOCATION;
+            writer.beginInstant(isAllocation ? "alloc" : "free", "memory", pid, record.streamId, record.timestamp);
+            writer.addArg("bytes", record.bytes);
+            char address[32];
+            snprintf(address, sizeof(address), "0x%016llx", (unsigned long long)record.address);
+            writer.addArg("address", std::string_view(address));
+            writer.endEvent();
+
+            auto inserted = memoryTimelines.try_emplace(record.deviceId);
+            GmpMemoryTimeline &memoryTimeline = inserted.first->second;
+            if (inserted.second)
+            {
+                memoryTimeline.setRecordTimeline(false);
+            }
+            uint64_t liveBytes = memoryTimeline.apply(record);
+            writer.counter("live device memory", pid, record.timestamp, "bytes", static_cast<double>(liveBytes));
+        }
+        for (auto &deviceTimeline : memoryTimelines)
+        {
+            deviceTimeline.second.endRange();
+        }
+    });
+
+    size_t eventCount = writer.getEventCount();
+    if (!writer.close())
+    {
+        GMP_LOG_ERROR("Failed to write trace file: " + path);
+        return GmpResult::ERROR;
+    }
+    GMP_LOG_INFO("Exported " + std::to_string(eventCount) + " trace events to " + path);
+    return GmpResult::SUCCESS;
+#else
+    GMP_LOG_WARNING("CUPTI support is not enabled. Trace export is not available.");
+    return GmpResult::WARNING;
+#endif
+}
+
+void GmpProfiler::reduceRangeMetrics(GmpOutputKernelReduction option, const RangeMetricsVisitor &visit)
+{
+#ifdef USE_CUPTI
+    auto sumFunc = [](const std::vector<ProfilerRange> &ranges, size_t startIndex, size_t size)
+    {
+        std::unordered_map<std::string, double> combinedMetrics;
+        for (size_t i = startIndex; i < startIndex + size && i < ranges.size(); ++i)
+        {
+            for (const auto &metric : ranges[i].metricValues)
+            {
+                combinedMetrics[metric.first] += metric.second;
+            }
+        }
+        return combinedMetrics;
+    };
+
+    auto maxFunc = [](const std::vector<ProfilerRange> &ranges, size_t startIndex, size_t size)
+    {
+        std::unordered_map<std::string, double> maxMetrics;
+        for (size_t i = startIndex; i < startIndex + size && i < ranges.size(); ++i)
+        {
+            for (const auto &metric : ranges[i].metricValues)
+            {
+                if (maxMetrics.find(metric.first) == maxMetrics.end() || metric.second > maxMetrics[metric.first])
+                {
+                    maxMetrics[metric.first] = metric.second;
+                }
+            }
+        }
+        return maxMetrics;
+    };
+
+    auto meanFunc = [](const std::vector<ProfilerRange> &ranges, size_t startIndex, size_t size)
+    {
+        std::unordered_map<std::string, double> meanMetrics;
+        for (size_t i = startIndex; i < startIndex + size && i < ranges.size(); ++i)
+        {
+            for (const auto &metric : ranges[i].metricValues)
+            {
+                meanMetrics[metric.first] += metric.second;
+            }
+        }
+        for (auto &metric : meanMetrics)
+        {
+            metric.second /= size;
+        }
+        return meanMetrics;
+    };
+
+    std::function<std::unordered_map<std::string, double>(const std::vector<ProfilerRange> &, size_t, size_t)> reduceFunc;
+    switch (option)
+    {
+    case GmpOutputKernelReduction::SUM:
+        reduceFunc = sumFunc;
+        break;
+    case GmpOutputKernelReduction::MAX:
+        reduceFunc = maxFunc;
+        break;
+    case GmpOutputKernelReduction::MEAN:
+        reduceFunc = meanFunc;
+        break;
+    default:
+        break;
+    }
+
+    std::vector<size_t> userRangeIndices;
+    if (rangeMode == GmpRangeMode::USER && getUserRangeIndices(getKernelRangeNames(), userRangeIndices) != GmpResult::SUCCESS)
+    {
+        return;
+    }
+    size_t rangeProfileOffset = 0;
+    size_t activityRangeIdx = 0;
+    sessionManager.forEachSession(GmpProfileType::CONCURRENT_KERNEL, [&](const GmpProfileSession &session)
+    {
+        const auto &kernelDataInRange = session.getKernelDataView();
+        auto kernelNum = kernelDataInRange.size();
+        auto launchedKernelNum = session.getKernelLaunchCount();
+        std::unordered_map<std::string, double> reducedMetrics;
+        if (rangeMode == GmpRangeMode::USER)
+        {
+            // The hardware aggregated the whole range into one CUPTI range, nothing to reduce.
+            reducedMetrics = cuptiProfilerHost->getProfilerRanges()[userRangeIndices[activityRangeIdx]].metricValues;
+        }
+        else if (!keepKernelDetail)
+        {
+            // Already reduced while the counter data was evaluated.
+            if (activityRangeIdx < rangeAccumulators.size() && rangeAccumulators[activityRangeIdx].kernelCount > 0)
+            {
+                const auto &accumulator = rangeAccumulators[activityRangeIdx];
+                for (size_t metricIndex = 0; metricIndex < metrics.size(); ++metricIndex)
+                {
+                    reducedMetrics[metrics[metricIndex]] = accumulator.reduce(metricIndex, option);
+                }
+            }
+        }
+        else if (kernelNum == 0)
+        {
+            GMP_LOG_DEBUG("Skipping kernel reduction for range '" + session.getSessionName() + "' because it contains no kernel records.");
+        }
+        else if (reduceFunc && kernelNum == launchedKernelNum)
+        {
+            reducedMetrics = cuptiProfilerHost->getRangeMetrics(rangeProfileOffset, kernelNum, reduceFunc);
+        }
+        else if (reduceFunc)
+        {
+            // Some kernels of this range were filtered out, reduce only the recorded ones.
+            std::vector<size_t> kernelIndices;
+            kernelIndices.reserve(kernelNum);
+            for (const auto &kernelData : kernelDataInRange)
+            {
+                kernelIndices.push_back(rangeProfileOffset + kernelData.launchIndex);
+            }
+            reducedMetrics = cuptiProfilerHost->getRangeMetrics(kernelIndices, reduceFunc);
+        }
+
+        visit(session, reducedMetrics);
+        rangeProfileOffset += launchedKernelNum;
+        activityRangeIdx++;
+    });
+#endif
+}
+
+GmpRangeStatsTable GmpProfiler::getRangeStatistics(GmpOutputKernelReduction option)
+{
+    GmpRangeStatsTable statsTable(metrics);
+#ifdef USE_CUPTI
+    if (!isEnabled)
+    {
+        return statsTable;
+    }
+    waitForInit();
+    evaluateCounterData();
+    reduceRangeMetrics(option, [&statsTable](const GmpProfileSession &session, const std::unordered_map<std::string, double> &reducedMetrics)
+    {
+        uint64_t start = session.getStartTimestamp();
+        uint64_t end = session.getEndTimestamp();
+        statsTable.add(session.getSessionName(), reducedMetrics, start > 0 && end > start ? end - start : 0);
+    });
+#endif
+    return statsTable;
+}
+
+void GmpProfiler::printRangeStatistics(GmpOutputKernelReduction option)
+{
+#ifdef USE_CUPTI
+    if (!isEnabled)
+    {
+        printf("GMP Profiler is disabled.\n");
+        return;
+    }
+
+    auto statsTable = getRangeStatistics(option);
+    const auto &metricNames = statsTable.getMetricNames();
+    printf("\n=== Range Statistics Report ===\n");
+    for (const auto &rangeStats : statsTable.getStats())
+    {
+        printf("Range: %s, iterations: %zu\n", rangeStats.name.c_str(), rangeStats.iterationCount);
+        printf("  %-50s %14s %14s %14s %14s %8s\n", "metric", "mean", "stddev", "min", "max", "cv");
+        if (rangeStats.durationNs.count > 0)
+        {
+            const auto &duration = rangeStats.durationNs;
+            printf("  %-50s %14.3f %14.3f %14.3f %14.3f %7.2f%%\n", "range duration (us)", duration.mean / 1000.0,
+                   duration.stddev() / 1000.0, duration.min / 1000.0, duration.max / 1000.0, 100.0 * duration.cv());
+        }
+        for (size_t metricIndex = 0; metricIndex < metricNames.size(); ++metricIndex)
+        {
+            const auto &metric = rangeStats.metrics[metricIndex];
+            if (metric.count == 0)
+            {
+                continue;
+            }
+            printf("  %-50s %14.3f %14.3f %14.3f %14.3f %7.2f%%\n", metricNames[metricIndex].c_str(), metric.mean,
+                   metric.stddev(), metric.min, metric.max, 100.0 * metric.cv());
+        }
+        printf("\n");
+    }
+    printf("=== End Range Statistics Report ===\n\n");
+#else
+    printf("CUPTI support is not enabled. Range statistics are not available.\n");
+#endif
+}
+
+void GmpProfiler::setRangeSummary(bool summarize)
+{
+    isRangeSummaryEnabled = summarize;
+}
+
+void GmpProfiler::produceOutput(std::string &name, GmpOutputKernelReduction option)
+{
+#ifdef USE_CUPTI
+    std::string path = "./output/result.csv";
+
+    std::ofstream outputFile(path, std::ios::app);
+    if (!outputFile.is_open())
+    {
+        GMP_LOG_ERROR("Failed to open output file: " + path);
+        return;
+    }
+
+    outputFile << "Config Name," << name << "\n";
+    outputFile.precision(2);
+
+    if (isRangeSummaryEnabled)
+    {
+        // One row per range name and metric: name,metric,mean,stddev,min,max,cv,iterations
+        auto statsTable = getRangeStatistics(option);
+        const auto &metricNames = statsTable.getMetricNames();
+        for (const auto &rangeStats : statsTable.getStats())
+        {
+            for (size_t metricIndex = 0; metricIndex < metricNames.size(); ++metricIndex)
+            {
+                const auto &metric = rangeStats.metrics[metricIndex];
+                if (metric.count == 0)
+                {
+                    continue;
+                }
+                outputFile << std::fixed << rangeStats.name << "," << metricNames[metricIndex] << ","
+                           << metric.mean << "," << metric.stddev() << "," << metric.min << "," << metric.max << ","
+                           << metric.cv() << "," << rangeStats.iterationCount << "\n";
+            }
+        }
+    }
+    else
+    {
+        reduceRangeMetrics(option, [&outputFile](const GmpProfileSession &session, const std::unordered_map<std::string, double> &reducedMetrics)
+        {
+            for (const auto &metricsPair : reducedMetrics)
+            {
+                outputFile << std::fixed << session.getSessionName() << "," << metricsPair.first << "," << metricsPair.second << "\n";
+            }
+        });
+    }
+    outputFile.close();
+#endif
+}
+
+void GmpProfiler::bufferRequestedImpl(uint8_t **buffer, size_t *size, size_t *maxNumRecords)
+{
+#ifdef USE_CUPTI
+    *size = 16 * 1024;
+    *buffer = (uint8_t *)malloc(*size);
+    *maxNumRecords = 0;
+#endif
+}
+
+void GmpProfiler::bufferCompletedImpl(CUcontext ctx, uint32_t streamId,
+                                      uint8_t *buffer, size_t size, size_t validSize)
+{
+#ifdef USE_CUPTI
+    GMP_LOG_DEBUG("Buffer completion callback called");
+    if (spillWriter)
+    {
+        // Capture mode, the records are decoded by replaySpill().
+        if (spillWriter->appendBuffer(streamId, buffer, validSize) != GmpResult::SUCCESS)
+        {
+            GMP_LOG_ERROR("Failed to append activity buffer to the spill file.");
+        }
+    }
+    else
+    {
+        decodeActivityBuffer(buffer, validSize);
+    }
+    size_t dropped = 0;
+    cuptiActivityGetNumDroppedRecords(ctx, streamId, &dropped);
+    if (dropped != 0)
+    {
+        printf("CUPTI: Dropped %zu activity records\n", dropped);
+    }
+    free(buffer);
+    GMP_LOG_DEBUG("Buffer completion callback ended");
+#endif
+}
+
+void GmpProfiler::decodeActivityBuffer(uint8_t *buffer, size_t validSize)
+{
+#ifdef USE_CUPTI
+    CUptiResult status;
+    CUpti_Activity *record = nullptr;
+    for (;;)
+    {
+        status = cuptiActivityGetNextRecord(buffer, validSize, &record);
+        if (status == CUPTI_SUCCESS)
+        {
+            if (record->kind == CUPTI_ACTIVITY_KIND_CONCURRENT_KERNEL && hasTransferSessions)
+            {
+                // Every kernel counts for copy/compute overlap, filtered or not.
+                auto *kernel = (CUpti_ActivityKernel8 *)record;
+                sessionManager.accumulate<GmpTransferSession>(
+                    GmpProfileType::TRANSFER,
+                    [&kernel](GmpTransferSession *sessionPtr)
+                    {
+                        sessionPtr->pushComputeInterval({kernel->start, kernel->end});
+                    });
+            }
+            if (record->kind == CUPTI_ACTIVITY_KIND_CONCURRENT_KERNEL &&
+                kernelFilter.isActive() && !kernelFilter.matches(((CUpti_ActivityKernel8 *)record)->name))
+            {
+                // Only count the launch so that the per-kernel metrics stay aligned.
+                sessionManager.accumulate<GmpConcurrentKernelSession>(
+                    GmpProfileType::CONCURRENT_KERNEL,
+                    [](GmpConcurrentKernelSession *sessionPtr)
+                    {
+                        sessionPtr->pushFilteredKernel();
+                    });
+            }
+            else if (record->kind == CUPTI_ACTIVITY_KIND_CONCURRENT_KERNEL)
+            {
+                auto *kernel = (CUpti_ActivityKernel8 *)record;
+                auto result = sessionManager.accumulate<GmpConcurrentKernelSession>(
+                    GmpProfileType::CONCURRENT_KERNEL,
+                    [&kernel](GmpConcurrentKernelSession *sessionPtr)
+                    {
+                        // printf("CUPTI: Kernel \"%s\" launched on stream %u, grid (%u,%u,%u), block (%u,%u,%u)\n",
+                        //         kernel->name, kernel->streamId,
+                        //         kernel->gridX, kernel->gridY, kernel->gridZ,
+                        //         kernel->blockX, kernel->blockY, kernel->blockZ);
+                        sessionPtr->num_calls++;
+                        GmpKernelData data;
+                        // The name is only valid while the buffer is, so intern it.
+                        data.nameId = GmpStringTable::instance().intern(kernel->name);
+                        data.grid_size[0] = kernel->gridX;
+                        data.grid_size[1] = kernel->gridY;
                         data.grid_size[2] = kernel->gridZ;
                         data.block_size[0] = kernel->blockX;
                         data.block_size[1] = kernel->blockY;
                         data.block_size[2] = kernel->blockZ;
+                        data.launchIndex = sessionPtr->getKernelLaunchCount();
+                        data.streamId = kernel->streamId;
+                        data.deviceId = kernel->deviceId;
+                        data.correlationId = kernel->correlationId;
+                        data.start = kernel->start;
+                        data.end = kernel->end;
                         sessionPtr->pushKernelData(data);
                     });
                 if (result != GmpResult::SUCCESS)
@@ -554,95 +1647,818 @@ void GmpProfiler::bufferCompletedImpl(CUcontext ctx, uint32_t streamId,
                     GMP_LOG_ERROR("Failed to accumulate concurrent kernel session.");
                 }
             }
-            else if (record->kind == CUPTI_ACTIVITY_KIND_MEMORY2)
+            else if (record->kind == CUPTI_ACTIVITY_KIND_MEMORY2)
+            {
+                auto *memRecord = (CUpti_ActivityMemory4 *)record;
+
+                auto result = sessionManager.accumulate<GmpMemSession>(
+                    GmpProfileType::MEMORY,
+                    [&memRecord](GmpMemSession *sessionPtr)
+                    {
+                        // printf("CUPTI: Kernel \"%s\" launched on stream %u, grid (%u,%u,%u), block (%u,%u,%u)\n",
+                        //         kernel->name, kernel->streamId,
+                        //         kernel->gridX, kernel->gridY, kernel->gridZ,
+                        //         kernel->blockX, kernel->blockY, kernel->blockZ);
+                        sessionPtr->num_calls++;
+                        GmpMemData data;
+                        // Name and source are only valid while the buffer is, so intern them.
+                        data.setSymbol(memRecord->name, memRecord->source);
+                        data.setFlags(memRecord->memoryOperationType, memRecord->memoryKind, memRecord->isAsync);
+                        data.correlationId = memRecord->correlationId;
+                        data.address = memRecord->address;
+                        data.bytes = memRecord->bytes;
+                        data.timestamp = memRecord->timestamp;
+                        data.deviceId = static_cast<uint8_t>(memRecord->deviceId);
+                        data.contextId = memRecord->contextId == CUPTI_INVALID_CONTEXT_ID
+                                             ? GmpMemData::INVALID_CONTEXT_ID
+                                             : static_cast<uint16_t>(memRecord->contextId);
+                        data.streamId = memRecord->streamId;
+
+                        sessionPtr->pushMemData(data);
+                    });
+            }
+            else if (record->kind == CUPTI_ACTIVITY_KIND_UNIFIED_MEMORY_COUNTER)
+            {
+                // Faults and migrations count towards every open range, whatever its type.
+                auto *counter = (CUpti_ActivityUnifiedMemoryCounter2 *)record;
+                for (GmpProfileType type : {GmpProfileType::CONCURRENT_KERNEL, GmpProfileType::MEMORY, GmpProfileType::TRANSFER})
+                {
+                    sessionManager.accumulate<GmpProfileSession>(
+                        type,
+                        [&counter](GmpProfileSession *sessionPtr)
+                        {
+                            sessionPtr->addUnifiedMemoryCounter(counter->counterKind, counter->value, counter->start,
+                                                                counter->end);
+                        });
+                }
+            }
+            else if (record->kind == CUPTI_ACTIVITY_KIND_MEMCPY)
+            {
+                auto *memcpyRecord = (CUpti_ActivityMemcpy5 *)record;
+                sessionManager.accumulate<GmpTransferSession>(
+                    GmpProfileType::TRANSFER,
+                    [&memcpyRecord](GmpTransferSession *sessionPtr)
+                    {
+                        GmpTransferData data;
+                        data.bytes = memcpyRecord->bytes;
+                        data.start = memcpyRecord->start;
+                        data.end = memcpyRecord->end;
+                        data.correlationId = memcpyRecord->correlationId;
+                        data.streamId = memcpyRecord->streamId;
+                        data.deviceId = static_cast<uint8_t>(memcpyRecord->deviceId);
+                        data.copyKind = memcpyRecord->copyKind;
+                        data.srcKind = memcpyRecord->srcKind;
+                        data.dstKind = memcpyRecord->dstKind;
+                        data.isAsync = memcpyRecord->flags & CUPTI_ACTIVITY_FLAG_MEMCPY_ASYNC;
+                        sessionPtr->pushTransferData(data);
+                    });
+            }
+            else if (record->kind == CUPTI_ACTIVITY_KIND_MEMSET)
+            {
+                auto *memsetRecord = (CUpti_ActivityMemset4 *)record;
+                sessionManager.accumulate<GmpTransferSession>(
+                    GmpProfileType::TRANSFER,
+                    [&memsetRecord](GmpTransferSession *sessionPtr)
+                    {
+                        GmpTransferData data;
+                        data.bytes = memsetRecord->bytes;
+                        data.start = memsetRecord->start;
+                        data.end = memsetRecord->end;
+                        data.correlationId = memsetRecord->correlationId;
+                        data.streamId = memsetRecord->streamId;
+                        data.deviceId = static_cast<uint8_t>(memsetRecord->deviceId);
+                        data.copyKind = GmpTransferData::MEMSET_KIND;
+                        data.srcKind = static_cast<uint8_t>(memsetRecord->memoryKind);
+                        data.dstKind = data.srcKind;
+                        data.isAsync = memsetRecord->flags & CUPTI_ACTIVITY_FLAG_MEMSET_ASYNC;
+                        sessionPtr->pushTransferData(data);
+                    });
+            }
+        }
+        else if (status == CUPTI_ERROR_MAX_LIMIT_REACHED)
+        {
+            break;
+        }
+        else
+        {
+            CUPTI_CALL(status);
+        }
+    }
+#endif
+}
+
+void GmpProfiler::init()
+{
+    if (isInitialized)
+    {
+        GMP_LOG_WARNING("GMP Profiler is already initialized.");
+        return;
+    }
+    // Filters are fixed from here on, build their matchers once.
+    rangeFilter.compile();
+    kernelFilter.compile();
+    isInitialized = true;
+
+    initCupti();
+}
+
+void GmpProfiler::initAsync()
+{
+    if (isInitialized)
+    {
+        GMP_LOG_WARNING("GMP Profiler is already initialized.");
+        return;
+    }
+    rangeFilter.compile();
+    kernelFilter.compile();
+    isInitialized = true;
+
+    // Nothing else touches the profiler state until waitForInit() returns.
+    initFuture = std::async(std::launch::async, [this]()
+                            { initCupti(); });
+}
+
+void GmpProfiler::waitForInit()
+{
+    if (initFuture.valid())
+    {
+        initFuture.get();
+    }
+}
+
+GmpResult GmpProfiler::setConfigCache(bool enabled, const std::string &directory)
+{
+    if (isInitialized)
+    {
+        GMP_LOG_WARNING("Config cache settings ignored, they must be set before init().");
+        return GmpResult::WARNING;
+    }
+    isConfigCacheEnabled = enabled;
+    configCacheDirectory = directory;
+    return GmpResult::SUCCESS;
+}
+
+GmpResult GmpProfiler::setUnifiedMemoryCounters(bool enabled)
+{
+    if (isInitialized)
+    {
+        GMP_LOG_WARNING("Unified memory counters ignored, they must be set before init().");
+        return GmpResult::WARNING;
+    }
+    isUnifiedMemoryCounterEnabled = enabled;
+    return GmpResult::SUCCESS;
+}
+
+void GmpProfiler::enableUnifiedMemoryCounters()
+{
+#ifdef USE_CUPTI
+    const CUpti_ActivityUnifiedMemoryCounterKind kinds[] = {
+        CUPTI_ACTIVITY_UNIFIED_MEMORY_COUNTER_KIND_BYTES_TRANSFER_HTOD,
+        CUPTI_ACTIVITY_UNIFIED_MEMORY_COUNTER_KIND_BYTES_TRANSFER_DTOH,
+        CUPTI_ACTIVITY_UNIFIED_MEMORY_COUNTER_KIND_BYTES_TRANSFER_DTOD,
+        CUPTI_ACTIVITY_UNIFIED_MEMORY_COUNTER_KIND_CPU_PAGE_FAULT_COUNT,
+        CUPTI_ACTIVITY_UNIFIED_MEMORY_COUNTER_KIND_GPU_PAGE_FAULT,
+        CUPTI_ACTIVITY_UNIFIED_MEMORY_COUNTER_KIND_THRASHING,
+        CUPTI_ACTIVITY_UNIFIED_MEMORY_COUNTER_KIND_THROTTLING,
+        CUPTI_ACTIVITY_UNIFIED_MEMORY_COUNTER_KIND_REMOTE_MAP,
+    };
+    std::vector<CUpti_ActivityUnifiedMemoryCounterConfig> configs;
+    for (auto kind : kinds)
+    {
+        CUpti_ActivityUnifiedMemoryCounterConfig config{};
+        config.scope = CUPTI_ACTIVITY_UNIFIED_MEMORY_COUNTER_SCOPE_PROCESS_SINGLE_DEVICE;
+        config.kind = kind;
+        config.deviceId = 0;
+        config.enable = 1;
+        configs.push_back(config);
+    }
+    // Not supported on every platform (e.g. under WSL or with some multi-GPU
+    // setups), which must not stop the rest of the profiling.
+    CUptiResult status = cuptiActivityConfigureUnifiedMemoryCounter(configs.data(), static_cast<uint32_t>(configs.size()));
+    if (status == CUPTI_SUCCESS)
+    {
+        status = cuptiActivityEnable(CUPTI_ACTIVITY_KIND_UNIFIED_MEMORY_COUNTER);
+    }
+    if (status != CUPTI_SUCCESS)
+    {
+        const char *errstr = nullptr;
+        cuptiGetResultString(status, &errstr);
+        GMP_LOG_WARNING(std::string("Unified memory counters are not available: ") + (errstr ? errstr : "unknown error"));
+    }
+#endif
+}
+
+std::vector<GmpRangeUnifiedMemory> GmpProfiler::getUnifiedMemorySummary()
+{
+    std::vector<GmpRangeUnifiedMemory> ranges;
+#ifdef USE_CUPTI
+    if (!isEnabled)
+    {
+        return ranges;
+    }
+    for (GmpProfileType type : {GmpProfileType::CONCURRENT_KERNEL, GmpProfileType::MEMORY, GmpProfileType::TRANSFER})
+    {
+        sessionManager.forEachSession(type, [&](const GmpProfileSession &session)
+        {
+            ranges.push_back({session.getSessionName(), type, session.getUnifiedMemorySummary()});
+        });
+    }
+#endif
+    return ranges;
+}
+
+void GmpProfiler::printUnifiedMemorySummary()
+{
+#ifdef USE_CUPTI
+    if (!isEnabled)
+    {
+        printf("GMP Profiler is disabled.\n");
+        return;
+    }
+
+    printf("\n=== Unified Memory Report ===\n");
+    size_t printed = 0;
+    for (const auto &range : getUnifiedMemorySummary())
+    {
+        const auto &summary = range.summary;
+        if (summary.empty())
+        {
+            continue;
+        }
+        const char *typeName = range.type == GmpProfileType::CONCURRENT_KERNEL ? "kernel"
+                               : range.type == GmpProfileType::MEMORY          ? "memory"
+                                                                               : "transfer";
+        printf("Range %s (%s)\n", range.name.c_str(), typeName);
+        printf("  Migrations: %llu, HtoD: %.3f MB, DtoH: %.3f MB, DtoD: %.3f MB, %.3f us\n",
+               (unsigned long long)summary.migrationCount, summary.bytesHtoD / 1e6, summary.bytesDtoH / 1e6,
+               summary.bytesDtoD / 1e6, summary.migrationNs / 1000.0);
+        printf("  Page faults: CPU %llu, GPU %llu in %llu groups (%.3f us)\n",
+               (unsigned long long)summary.cpuPageFaults, (unsigned long long)summary.gpuPageFaults,
+               (unsigned long long)summary.gpuPageFaultGroups, summary.gpuPageFaultNs / 1000.0);
+        if (summary.thrashingEvents > 0 || summary.throttlingEvents > 0 || summary.remoteMapEvents > 0)
+        {
+            printf("  WARNING: thrashing %llu, throttling %llu, remote map %llu events. Pages bounce between\n"
+                   "           processors; prefetch, set preferred locations or reduce oversubscription.\n",
+                   (unsigned long long)summary.thrashingEvents, (unsigned long long)summary.throttlingEvents,
+                   (unsigned long long)summary.remoteMapEvents);
+        }
+        printed++;
+    }
+    if (printed == 0)
+    {
+        printf("No unified memory activity recorded.\n");
+    }
+    printf("=== End Unified Memory Report ===\n\n");
+#endif
+}
+
+GmpResult GmpProfiler::setMemoryBudget(size_t budgetBytes, const std::string &spillPath)
+{
+#ifdef USE_CUPTI
+    std::string path = spillPath;
+    if (path.empty())
+    {
+        std::error_code error;
+        auto directory = std::filesystem::temp_directory_path(error);
+        path = (error ? std::filesystem::path("/tmp") : directory) / ("gmp_sessions_" + std::to_string(getpid()) + ".spill");
+    }
+    return sessionManager.setMemoryBudget(budgetBytes, path);
+#else
+    return GmpResult::SUCCESS;
+#endif
+}
+
+GmpSessionStorageStats GmpProfiler::getSessionStorageStats() const
+{
+#ifdef USE_CUPTI
+    return sessionManager.getStorageStats();
+#else
+    return GmpSessionStorageStats();
+#endif
+}
+
+GmpArenaStats GmpProfiler::getSessionArenaStats() const
+{
+#ifdef USE_CUPTI
+    return sessionManager.getArenaStats();
+#else
+    return GmpArenaStats();
+#endif
+}
+
+GmpResult GmpProfiler::enableStreaming(const GmpStreamingConfig &config)
+{
+    if (isInitialized)
+    {
+        GMP_LOG_WARNING("Streaming ignored, it must be enabled before init().");
+        return GmpResult::WARNING;
+    }
+    if (config.path.empty())
+    {
+        GMP_LOG_ERROR("Streaming needs an output path.");
+        return GmpResult::ERROR;
+    }
+    if (config.rangeInterval == 0 && config.intervalSeconds <= 0.0)
+    {
+        GMP_LOG_INFO("No streaming interval set, windows are only closed by flushStreamingWindow().");
+    }
+    streamingConfig = config;
+    return GmpResult::SUCCESS;
+}
+
+bool GmpProfiler::isStreamingWindowDue() const
+{
+#ifdef USE_CUPTI
+    if (!streamWriter || sessionManager.hasActiveSession())
+    {
+        // Sessions are only freed between top-level ranges.
+        return false;
+    }
+    if (streamingConfig.rangeInterval > 0 && windowRangeCount >= streamingConfig.rangeInterval)
+    {
+        return true;
+    }
+    return streamingConfig.intervalSeconds > 0.0 &&
+           std::chrono::duration<double>(std::chrono::steady_clock::now() - windowStart).count() >=
+               streamingConfig.intervalSeconds;
+#else
+    return false;
+#endif
+}
+
+GmpResult GmpProfiler::flushStreamingWindow()
+{
+#ifdef USE_CUPTI
+    waitForInit();
+    if (!streamWriter)
+    {
+        GMP_LOG_WARNING("Streaming is not enabled.");
+        return GmpResult::WARNING;
+    }
+    if (sessionManager.hasActiveSession())
+    {
+        GMP_LOG_WARNING("Cannot close the streaming window while a range is open.");
+        return GmpResult::WARNING;
+    }
+    cudaDeviceSynchronize();
+    CUPTI_CALL(cuptiActivityFlushAll(1));
+    // A suspended range profiler has already been stopped by skipRange.
+    bool isRunning = isRangeProfilingStarted && !isRangeProfilingSuspended;
+    if (isRunning)
+    {
+        CUPTI_API_CALL(rangeProfilerTargetPtr->StopRangeProfiler());
+    }
+    decodeCounterData();
+
+    GmpResult result = evaluateCounterData();
+    size_t rangeCount = 0;
+    if (result == GmpResult::SUCCESS)
+    {
+        reduceRangeMetrics(streamingConfig.reduction, [&](const GmpProfileSession &session, const std::unordered_map<std::string, double> &reducedMetrics)
+        {
+            streamWriter->appendRange(session.getSessionName(), session.getStartTimestamp(), session.getEndTimestamp(),
+                                      session.getKernelLaunchCount(), reducedMetrics);
+            rangeCount++;
+        });
+        uint64_t sizeBefore = streamWriter->getSize();
+        result = streamWriter->commit();
+        if (result == GmpResult::SUCCESS)
+        {
+            streamingStats.ranges += rangeCount;
+            streamingStats.bytesWritten += streamWriter->getSize() - sizeBefore;
+        }
+    }
+    GMP_LOG_DEBUG("Streamed " + std::to_string(rangeCount) + " ranges to " + streamingConfig.path);
+
+    // Free the window even if it could not be written, memory has to stay bounded.
+    sessionManager.reset();
+    cuptiProfilerHost->ClearProfilerRanges();
+    rangeAccumulators.clear();
+    evaluatedRangeCount = 0;
+    accumulatedSessionIndex = 0;
+    accumulatedRangeOffset = 0;
+    CUPTI_API_CALL(rangeProfilerTargetPtr->ResetCounterData(counterDataImage));
+    if (isRunning)
+    {
+        CUPTI_API_CALL(rangeProfilerTargetPtr->StartRangeProfiler());
+    }
+    streamingStats.windows++;
+    windowRangeCount = 0;
+    windowStart = std::chrono::steady_clock::now();
+    return result;
+#else
+    return GmpResult::SUCCESS;
+#endif
+}
+
+GmpResult GmpProfiler::closeStreaming()
+{
+    if (!streamWriter)
+    {
+        return GmpResult::SUCCESS;
+    }
+    GmpResult result = flushStreamingWindow();
+    streamWriter->close();
+    streamWriter.reset();
+    GMP_LOG_INFO("Closed stream file " + streamingConfig.path + " after " + std::to_string(streamingStats.windows) +
+                 " windows.");
+    return result;
+}
+
+GmpStreamingStats GmpProfiler::getStreamingStats() const
+{
+    return streamingStats;
+}
+
+GmpResult GmpProfiler::setSpillFile(const std::string &path)
+{
+    if (isInitialized)
+    {
+        GMP_LOG_WARNING("Spill file ignored, it must be set before init().");
+        return GmpResult::WARNING;
+    }
+    spillPath = path;
+    return GmpResult::SUCCESS;
+}
+
+GmpResult GmpProfiler::closeSpill()
+{
+#ifdef USE_CUPTI
+    waitForInit();
+    if (!spillWriter)
+    {
+        return GmpResult::SUCCESS;
+    }
+    // Buffers still held by CUPTI must reach the file before it is closed.
+    CUPTI_CALL(cuptiActivityFlushAll(1));
+    GmpResult result = GmpResult::SUCCESS;
+    if (rangeProfilerTargetPtr && !counterDataImage.empty())
+    {
+        GmpSpillCounterData counterData;
+        counterData.rangeMode = rangeMode;
+        counterData.chipName = chipName;
+        counterData.metrics = metrics;
+        counterData.counterAvailabilityImage = counterAvailabilityImage;
+        counterData.counterDataImage = counterDataImage;
+        result = spillWriter->appendCounterData(counterData);
+    }
+    if (spillWriter->close() != GmpResult::SUCCESS)
+    {
+        result = GmpResult::ERROR;
+    }
+    spillWriter.reset();
+    GMP_LOG_INFO("Closed spill file " + spillPath);
+    return result;
+#else
+    return GmpResult::SUCCESS;
+#endif
+}
+
+GmpResult GmpProfiler::replaySpill(const std::string &path)
+{
+#ifdef USE_CUPTI
+    if (isInitialized)
+    {
+        GMP_LOG_ERROR("replaySpill() needs a profiler that has not been initialized.");
+        return GmpResult::ERROR;
+    }
+    GmpSpillReader reader;
+    if (reader.open(path) != GmpResult::SUCCESS)
+    {
+        return GmpResult::ERROR;
+    }
+    uint32_t cuptiVersion = 0;
+    if (cuptiGetVersion(&cuptiVersion) == CUPTI_SUCCESS && cuptiVersion != reader.getCuptiVersion())
+    {
+        GMP_LOG_WARNING("Spill file was recorded with CUPTI API version " + std::to_string(reader.getCuptiVersion()) +
+                        " and is replayed with " + std::to_string(cuptiVersion) + ", activity record layouts may differ.");
+    }
+    // Kernel filters apply to the replayed records as they would have during the run.
+    rangeFilter.compile();
+    kernelFilter.compile();
+    isInitialized = true;
+    isReplayed = true;
+
+    std::unordered_map<uint64_t, std::string> strings;
+    size_t bufferCount = 0;
+    size_t rangeCount = 0;
+    GmpResult result = GmpResult::SUCCESS;
+    GmpResult status = reader.forEachEntry([&](const GmpSpillEntry &entry)
+    {
+        if (result != GmpResult::SUCCESS)
+        {
+            return;
+        }
+        switch (entry.type)
+        {
+        case GmpSpillEntryType::STRING:
+        {
+            uint64_t pointer = 0;
+            std::string string;
+            result = GmpSpillReader::parseString(entry, pointer, string);
+            strings[pointer] = std::move(string);
+            break;
+        }
+        case GmpSpillEntryType::BUFFER:
+        {
+            uint8_t *buffer = gmpSpillCopyBuffer(entry, strings);
+            if (!buffer)
+            {
+                result = GmpResult::ERROR;
+                break;
+            }
+            decodeActivityBuffer(buffer, entry.size);
+            free(buffer);
+            bufferCount++;
+            break;
+        }
+        case GmpSpillEntryType::PUSH_RANGE:
+        case GmpSpillEntryType::POP_RANGE:
+        {
+            uint64_t timestamp = 0;
+            std::string name;
+            auto type = static_cast<GmpProfileType>(entry.aux);
+            result = GmpSpillReader::parseRange(entry, timestamp, name);
+            if (result == GmpResult::SUCCESS && entry.type == GmpSpillEntryType::PUSH_RANGE)
             {
-                auto *memRecord = (CUpti_ActivityMemory4 *)record;
-
-                auto result = sessionManager.accumulate<GmpMemSession>(
-                    GmpProfileType::MEMORY,
-                    [&memRecord](GmpMemSession *sessionPtr)
-                    {
-                        // printf("CUPTI: Kernel \"%s\" launched on stream %u, grid (%u,%u,%u), block (%u,%u,%u)\n",
-                        //         kernel->name, kernel->streamId,
-                        //         kernel->gridX, kernel->gridY, kernel->gridZ,
-                        //         kernel->blockX, kernel->blockY, kernel->blockZ);
-                        sessionPtr->num_calls++;
-                        GmpMemData data;
-                        data.name = memRecord->name;
-                        data.source = memRecord->source;
-                        data.memoryOperationType = memRecord->memoryOperationType;
-                        data.memoryKind = memRecord->memoryKind;
-                        data.correlationId = memRecord->correlationId;
-                        data.address = memRecord->address;
-                        data.bytes = memRecord->bytes;
-                        data.timestamp = memRecord->timestamp;
-                        data.PC = memRecord->PC;
-                        data.processId = memRecord->processId;
-                        data.deviceId = memRecord->deviceId;
-                        data.contextId = memRecord->contextId;
-                        data.streamId = memRecord->streamId;
-                        data.isAsync = memRecord->isAsync;
-
-                        sessionPtr->pushMemData(data);
-                    });
+                result = openSession(type, name, timestamp);
+                rangeCount++;
             }
+            else if (result == GmpResult::SUCCESS)
+            {
+                result = closeSession(type, name, timestamp);
+            }
+            break;
         }
-        else if (status == CUPTI_ERROR_MAX_LIMIT_REACHED)
+        case GmpSpillEntryType::COUNTER_DATA:
         {
+            GmpSpillCounterData counterData;
+            result = GmpSpillReader::parseCounterData(entry, counterData);
+            if (result == GmpResult::SUCCESS)
+            {
+                rangeMode = counterData.rangeMode;
+                chipName = std::move(counterData.chipName);
+                metrics = std::move(counterData.metrics);
+                counterAvailabilityImage = std::move(counterData.counterAvailabilityImage);
+                counterDataImage = std::move(counterData.counterDataImage);
+                cuptiProfilerHost = std::make_shared<CuptiProfilerHost>();
+            }
             break;
         }
-        else
+        default:
+            GMP_LOG_WARNING("Skipping spill entry of unknown type " + std::to_string(static_cast<uint32_t>(entry.type)));
+            break;
+        }
+    });
+    if (status != GmpResult::SUCCESS || result != GmpResult::SUCCESS)
+    {
+        GMP_LOG_ERROR("Spill file " + path + " is malformed, reports only cover the entries before the error.");
+        return GmpResult::ERROR;
+    }
+    GMP_LOG_INFO("Replayed " + std::to_string(rangeCount) + " ranges and " + std::to_string(bufferCount) +
+                 " activity buffers from " + path);
+    if (!cuptiProfilerHost)
+    {
+        GMP_LOG_INFO("Spill file has no counter data, only activity reports are available.");
+    }
+    return GmpResult::SUCCESS;
+#else
+    return GmpResult::SUCCESS;
+#endif
+}
+
+GmpResult GmpProfiler::setReplayMode(GmpReplayMode mode)
+{
+    if (isInitialized)
+    {
+        GMP_LOG_WARNING("Replay mode ignored, it must be set before init().");
+        return GmpResult::WARNING;
+    }
+    if (rangeMode == GmpRangeMode::USER && mode != GmpReplayMode::USER)
+    {
+        GMP_LOG_WARNING("Kernel replay is not available in user range mode.");
+        return GmpResult::WARNING;
+    }
+    replayMode = mode;
+    return GmpResult::SUCCESS;
+}
+
+void GmpProfiler::setKernelDetail(bool keep)
+{
+    if (evaluatedRangeCount > 0 && keep != keepKernelDetail)
+    {
+        GMP_LOG_WARNING("Kernel detail changed after evaluation, earlier ranges keep the previous setting.");
+    }
+    keepKernelDetail = keep;
+}
+
+GmpReplayMode GmpProfiler::getReplayMode() const
+{
+    return replayMode;
+}
+
+GmpResult GmpProfiler::setRangeMode(GmpRangeMode mode)
+{
+    if (isInitialized)
+    {
+        GMP_LOG_WARNING("Range mode ignored, it must be set before init().");
+        return GmpResult::WARNING;
+    }
+    rangeMode = mode;
+    if (mode == GmpRangeMode::USER && replayMode != GmpReplayMode::USER)
+    {
+        GMP_LOG_INFO("User range mode requires user replay, switching replay mode.");
+        replayMode = GmpReplayMode::USER;
+    }
+    return GmpResult::SUCCESS;
+}
+
+GmpRangeMode GmpProfiler::getRangeMode() const
+{
+    return rangeMode;
+}
+
+std::vector<std::string> GmpProfiler::getKernelRangeNames() const
+{
+    std::vector<std::string> rangeNames;
+#ifdef USE_CUPTI
+    sessionManager.forEachSession(GmpProfileType::CONCURRENT_KERNEL, [&rangeNames](const GmpProfileSession &session)
+                                  { rangeNames.push_back(session.getSessionName()); });
+#endif
+    return rangeNames;
+}
+
+GmpResult GmpProfiler::getUserRangeIndices(const std::vector<std::string> &rangeNames, std::vector<size_t> &indices)
+{
+    indices.clear();
+#ifdef USE_CUPTI
+    const auto &profilerRanges = cuptiProfilerHost->getProfilerRanges();
+    if (profilerRanges.size() == rangeNames.size())
+    {
+        for (size_t i = 0; i < rangeNames.size(); ++i)
         {
-            CUPTI_CALL(status);
+            indices.push_back(i);
         }
+        return GmpResult::SUCCESS;
     }
-    size_t dropped = 0;
-    cuptiActivityGetNumDroppedRecords(ctx, streamId, &dropped);
-    if (dropped != 0)
+
+    // The counter data image merges ranges pushed under the same name.
+    std::unordered_map<std::string, size_t> indexByName;
+    for (size_t i = 0; i < profilerRanges.size(); ++i)
     {
-        printf("CUPTI: Dropped %zu activity records\n", dropped);
+        indexByName.emplace(profilerRanges[i].rangeName, i);
+    }
+    for (const auto &rangeName : rangeNames)
+    {
+        auto it = indexByName.find(rangeName);
+        if (it == indexByName.end())
+        {
+            GMP_LOG_ERROR("No range profiler range found for range '" + rangeName + "'.");
+            indices.clear();
+            return GmpResult::ERROR;
+        }
+        indices.push_back(it->second);
     }
-    free(buffer);
-    GMP_LOG_DEBUG("Buffer completion callback ended");
 #endif
+    return GmpResult::SUCCESS;
 }
 
-void GmpProfiler::init()
+GmpResult GmpProfiler::profile(const std::function<void()> &workload, const std::function<void()> &restore,
+                               size_t maxPasses)
 {
-    // create a copy of metrics as c strings
-    std::vector<const char *> c_metrics = createCStyleStringArray(metrics);
+#ifdef USE_CUPTI
+    if (!isEnabled)
+    {
+        workload();
+        return GmpResult::SUCCESS;
+    }
+    if (!isInitialized)
+    {
+        GMP_LOG_ERROR("init() must be called before profile().");
+        return GmpResult::ERROR;
+    }
+    if (replayPass > 0)
+    {
+        GMP_LOG_ERROR("profile() cannot be nested.");
+        return GmpResult::ERROR;
+    }
+    waitForInit();
+    if (replayMode == GmpReplayMode::USER && (sampler.isActive() || rangeFilter.isActive()))
+    {
+        GMP_LOG_WARNING("Range sampling and range filters are ignored under user replay, every range is profiled.");
+    }
+
+    // Leave replay even if the workload throws, e.g. a Python exception.
+    struct ReplayPassReset
+    {
+        size_t &pass;
+        ~ReplayPassReset() { pass = 0; }
+    } replayPassReset{replayPass};
+
+    size_t passLimit = replayMode == GmpReplayMode::USER ? maxPasses : 1;
+    bool isAllPassSubmitted = false;
+    for (replayPass = 1; replayPass <= passLimit && !isAllPassSubmitted; ++replayPass)
+    {
+        if (replayPass > 1 && restore)
+        {
+            restore();
+        }
+        startRangeProfiling();
+        workload();
+        cudaDeviceSynchronize();
+        stopRangeProfiling();
+        isAllPassSubmitted = replayMode == GmpReplayMode::KERNEL || rangeProfilerTargetPtr->IsAllPassSubmitted();
+    }
+    size_t passCount = replayPass - 1;
+
+    if (!isAllPassSubmitted)
+    {
+        GMP_LOG_ERROR("Not all passes were submitted after " + std::to_string(passCount) +
+                      " runs of the workload, raise maxPasses or reduce the metric list.");
+        return GmpResult::ERROR;
+    }
+    GMP_LOG_INFO("Collected " + std::to_string(metrics.size()) + " metrics in " + std::to_string(passCount) + " pass(es).");
+
+    decodeCounterData();
+    return evaluateCounterData();
+#else
+    workload();
+    return GmpResult::SUCCESS;
+#endif
+}
 
+void GmpProfiler::initCupti()
+{
 #ifdef USE_CUPTI
+    if (!spillPath.empty())
+    {
+        uint32_t cuptiVersion = 0;
+        CUPTI_CALL(cuptiGetVersion(&cuptiVersion));
+        auto writer = std::make_unique<GmpSpillWriter>();
+        if (writer->open(spillPath, cuptiVersion) == GmpResult::SUCCESS)
+        {
+            spillWriter = std::move(writer);
+            GMP_LOG_INFO("Capturing activity buffers to " + spillPath);
+        }
+        else
+        {
+            GMP_LOG_WARNING("Capture mode disabled, activity records are decoded during the run.");
+        }
+    }
+    if (!streamingConfig.path.empty())
+    {
+        auto writer = std::make_unique<GmpStreamWriter>();
+        if (rangeMode == GmpRangeMode::USER || replayMode == GmpReplayMode::USER)
+        {
+            GMP_LOG_WARNING("Streaming needs auto range mode and kernel replay, ranges are reported at the end of the run.");
+        }
+        else if (spillWriter)
+        {
+            GMP_LOG_WARNING("Streaming is not available in capture mode.");
+        }
+        else if (isUnifiedMemoryCounterEnabled)
+        {
+            GMP_LOG_WARNING("Streaming does not keep unified memory summaries, ranges are reported at the end of the run.");
+        }
+        else if (writer->open(streamingConfig.path, metrics) == GmpResult::SUCCESS)
+        {
+            streamWriter = std::move(writer);
+            windowStart = std::chrono::steady_clock::now();
+            GMP_LOG_INFO("Streaming completed ranges to " + streamingConfig.path);
+        }
+        else
+        {
+            GMP_LOG_WARNING("Streaming disabled, ranges are reported at the end of the run.");
+        }
+    }
 
     // Initialize CUPTI Activity API
     CUPTI_CALL(cuptiActivityEnable(CUPTI_ACTIVITY_KIND_CONCURRENT_KERNEL));
     CUPTI_CALL(cuptiActivityEnable(CUPTI_ACTIVITY_KIND_MEMORY2));
+    CUPTI_CALL(cuptiActivityEnable(CUPTI_ACTIVITY_KIND_MEMCPY));
+    CUPTI_CALL(cuptiActivityEnable(CUPTI_ACTIVITY_KIND_MEMSET));
+    if (isUnifiedMemoryCounterEnabled)
+    {
+        enableUnifiedMemoryCounters();
+    }
     CUPTI_CALL(cuptiActivityRegisterCallbacks(&GmpProfiler::bufferRequestedThunk,
                                               &GmpProfiler::bufferCompletedThunk));
-    instance->cuptiProfilerHost = std::make_shared<CuptiProfilerHost>();
-    cuInit(0);
+    cuptiProfilerHost = std::make_shared<CuptiProfilerHost>();
 
-    CUresult init_result = cuDriverGetVersion(nullptr);
-    if (init_result != CUDA_SUCCESS)
-    {
-        printf("Initializing CUDA driver...\n");
-        cuInit(0);
-    }
-    else
-    {
-        printf("CUDA driver already initialized\n");
-    }
+    // cuInit is a no-op if the driver has already been initialized.
+    DRIVER_API_CALL(cuInit(0));
 
     CUdevice cuDevice;
     DRIVER_API_CALL(cuDeviceGet(&cuDevice, 0));
     int computeCapabilityMajor = 0, computeCapabilityMinor = 0;
     DRIVER_API_CALL(cuDeviceGetAttribute(&computeCapabilityMajor, CU_DEVICE_ATTRIBUTE_COMPUTE_CAPABILITY_MAJOR, cuDevice));
     DRIVER_API_CALL(cuDeviceGetAttribute(&computeCapabilityMinor, CU_DEVICE_ATTRIBUTE_COMPUTE_CAPABILITY_MINOR, cuDevice));
-    printf("Compute Capability of Device: %d.%d\n", computeCapabilityMajor, computeCapabilityMinor);
+    GMP_LOG_INFO("Compute Capability of Device: " + std::to_string(computeCapabilityMajor) + "." +
+                 std::to_string(computeCapabilityMinor));
 
     if (computeCapabilityMajor < 7 || (computeCapabilityMajor == 7 && computeCapabilityMinor < 5))
     {
-        std::cerr << "Range Profiling is supported only on devices with compute capability 7.5 and above" << std::endl;
+        GMP_LOG_ERROR("Range Profiling is supported only on devices with compute capability 7.5 and above");
         exit(EXIT_FAILURE);
     }
 
@@ -653,40 +2469,208 @@ void GmpProfiler::init()
     config.numOfNestingLevel = MAX_NUM_NESTING_LEVEL;
 
     cudaFree(0);
-    // Retain current context
+    // Retain current context. The context is current per thread, so this
+    // also makes it current on the initAsync() thread.
     CUcontext cuContext;
     DRIVER_API_CALL(cuDevicePrimaryCtxRetain(&cuContext, cuDevice));
     DRIVER_API_CALL(cuCtxSetCurrent(cuContext)); // matches what Eigen/Runtime use
-    instance->rangeProfilerTargetPtr = std::make_shared<RangeProfilerTarget>(cuContext, config);
+    rangeProfilerTargetPtr = std::make_shared<RangeProfilerTarget>(cuContext, config);
 
     // Get chip name
-    std::string chipName;
     CUPTI_CALL(RangeProfilerTarget::GetChipName(cuDevice, chipName));
 
     // Get Counter availability image
-    std::vector<uint8_t> counterAvailabilityImage;
     CUPTI_CALL(RangeProfilerTarget::GetCounterAvailabilityImage(cuContext, counterAvailabilityImage));
 
-    // Create config image
+    // Create config image, or reuse the one a previous process built.
     std::vector<uint8_t> configImage;
-    instance->cuptiProfilerHost->SetUp(chipName, counterAvailabilityImage);
-    CUPTI_CALL(instance->cuptiProfilerHost->CreateConfigImage(c_metrics, configImage));
+    GmpConfigImageCache configCache(configCacheDirectory);
+    std::string cacheKey;
+    if (isConfigCacheEnabled)
+    {
+        uint32_t cuptiVersion = 0;
+        CUPTI_CALL(cuptiGetVersion(&cuptiVersion));
+        cacheKey = GmpConfigImageCache::makeKey(chipName, cuptiVersion, counterAvailabilityImage, metrics);
+    }
+    if (isConfigCacheEnabled && configCache.load(cacheKey, configImage))
+    {
+        // The host is only needed to evaluate counter data, set it up then.
+        GMP_LOG_INFO("Loaded config image from cache: " + cacheKey);
+    }
+    else
+    {
+        GMP_API_CALL(ensureProfilerHost());
+        std::vector<const char *> c_metrics = createCStyleStringArray(metrics);
+        CUPTI_CALL(cuptiProfilerHost->CreateConfigImage(c_metrics, configImage));
+        if (isConfigCacheEnabled && configCache.store(cacheKey, configImage))
+        {
+            GMP_LOG_INFO("Stored config image in cache: " + configCache.getDirectory() + "/" + cacheKey);
+        }
+    }
 
     // Enable Range profiler
-    CUPTI_CALL(instance->rangeProfilerTargetPtr->EnableRangeProfiler());
+    CUPTI_CALL(rangeProfilerTargetPtr->EnableRangeProfiler());
 
     // Create CounterData Image
-    CUPTI_CALL(instance->rangeProfilerTargetPtr->CreateCounterDataImage(c_metrics, instance->counterDataImage));
+    std::vector<const char *> c_metrics = createCStyleStringArray(metrics);
+    CUPTI_CALL(rangeProfilerTargetPtr->CreateCounterDataImage(c_metrics, counterDataImage));
 
-    CUPTI_CALL(instance->rangeProfilerTargetPtr->SetConfig(
-        ENABLE_USER_RANGE ? CUPTI_UserRange : CUPTI_AutoRange,
-        ENABLE_USER_RANGE ? CUPTI_UserReplay : CUPTI_KernelReplay,
+    CUPTI_CALL(rangeProfilerTargetPtr->SetConfig(
+        rangeMode == GmpRangeMode::USER ? CUPTI_UserRange : CUPTI_AutoRange,
+        replayMode == GmpReplayMode::USER ? CUPTI_UserReplay : CUPTI_KernelReplay,
         configImage,
-        instance->counterDataImage));
+        counterDataImage));
 #endif
-    isInitialized = true;
 }
 
+#ifdef USE_CUPTI
+GmpResult GmpProfiler::evaluateCounterData()
+{
+    if (ensureProfilerHost() != GmpResult::SUCCESS)
+    {
+        return GmpResult::ERROR;
+    }
+
+    size_t numRanges = 0;
+    CUPTI_API_CALL(cuptiProfilerHost->GetNumOfRanges(counterDataImage, numRanges));
+    if (numRanges <= evaluatedRangeCount)
+    {
+        return GmpResult::SUCCESS;
+    }
+    GMP_LOG_INFO("Evaluating ranges " + std::to_string(evaluatedRangeCount) + " to " + std::to_string(numRanges) + ".");
+
+    if (!keepKernelDetail && rangeMode == GmpRangeMode::AUTO)
+    {
+        accumulateCounterData(evaluatedRangeCount, numRanges);
+    }
+    else
+    {
+        std::vector<const char *> c_metrics = createCStyleStringArray(metrics);
+        for (size_t rangeIndex = evaluatedRangeCount; rangeIndex < numRanges; ++rangeIndex)
+        {
+            CUPTI_API_CALL(cuptiProfilerHost->EvaluateCounterData(rangeIndex, c_metrics, counterDataImage));
+        }
+    }
+    evaluatedRangeCount = numRanges;
+    return GmpResult::SUCCESS;
+}
+
+void GmpProfiler::accumulateCounterData(size_t begin, size_t end)
+{
+    std::vector<const char *> c_metrics = createCStyleStringArray(metrics);
+    std::vector<double> metricValues;
+    // Resume after the sessions earlier calls are done with, they are not
+    // walked or paged in again.
+    size_t rangeOffset = accumulatedRangeOffset;
+    size_t sessionIndex = accumulatedSessionIndex;
+    sessionManager.forEachSessionFrom(GmpProfileType::CONCURRENT_KERNEL, sessionIndex,
+                                      [&](const GmpProfileSession &session)
+    {
+        size_t launchedKernelCount = session.getKernelLaunchCount();
+        bool isNewSession = sessionIndex >= rangeAccumulators.size();
+        if (isNewSession)
+        {
+            rangeAccumulators.emplace_back();
+            rangeAccumulators.back().name = session.getSessionName();
+        }
+        else if (rangeOffset >= end)
+        {
+            return false;
+        }
+        if (rangeOffset + launchedKernelCount > begin && rangeOffset < end)
+        {
+            auto &accumulator = rangeAccumulators[sessionIndex];
+            // Filtered kernels are skipped, so they are never evaluated at all.
+            for (const auto &kernel : session.getKernelDataView())
+            {
+                size_t rangeIndex = rangeOffset + kernel.launchIndex;
+                if (rangeIndex >= begin && rangeIndex < end)
+                {
+                    CUPTI_API_CALL(cuptiProfilerHost->EvaluateRange(rangeIndex, c_metrics, counterDataImage, metricValues));
+                    accumulator.add(metricValues);
+                }
+            }
+        }
+        // A closed session whose ranges are all evaluated gets no more kernels.
+        if (sessionIndex == accumulatedSessionIndex && !session.isActive() && rangeOffset + launchedKernelCount <= end)
+        {
+            accumulatedSessionIndex++;
+            accumulatedRangeOffset += launchedKernelCount;
+        }
+        rangeOffset += launchedKernelCount;
+        sessionIndex++;
+        return true;
+    });
+}
+
+void GmpProfiler::printRangeAccumulators(GmpOutputKernelReduction option)
+{
+    for (const auto &accumulator : rangeAccumulators)
+    {
+        std::cout << "Range Name: " << accumulator.name << " (" << accumulator.kernelCount << " kernels)\n";
+        std::cout << "-----------------------------------------------------------------------------------\n";
+        for (size_t metricIndex = 0; metricIndex < metrics.size() && accumulator.kernelCount > 0; ++metricIndex)
+        {
+            std::cout << std::fixed << std::setprecision(3);
+            std::cout << std::setw(50) << std::left << metrics[metricIndex];
+            std::cout << std::setw(30) << std::right << accumulator.reduce(metricIndex, option) << "\n";
+        }
+        std::cout << "-----------------------------------------------------------------------------------\n\n";
+    }
+}
+
+void GmpProfiler::forEachKernelMetrics(const KernelMetricsVisitor &visit)
+{
+    if (rangeMode != GmpRangeMode::AUTO || !keepKernelDetail || evaluateCounterData() != GmpResult::SUCCESS)
+    {
+        return;
+    }
+    const auto &profilerRanges = cuptiProfilerHost->getProfilerRanges();
+    size_t rangeOffset = 0;
+    sessionManager.forEachSession(GmpProfileType::CONCURRENT_KERNEL, [&](const GmpProfileSession &session)
+    {
+        for (const auto &kernel : session.getKernelDataView())
+        {
+            size_t metricIndex = rangeOffset + kernel.launchIndex;
+            if (metricIndex < profilerRanges.size())
+            {
+                visit(session, kernel, profilerRanges[metricIndex].metricValues);
+            }
+        }
+        rangeOffset += session.getKernelLaunchCount();
+    });
+}
+
+std::unique_ptr<GmpRoofline> GmpProfiler::makeRoofline()
+{
+    if (rooflinePeaks.isValid())
+    {
+        return std::make_unique<GmpRoofline>(rooflinePeaks);
+    }
+    const GmpRooflinePeaks *peaks = GmpRoofline::findPeaks(chipName);
+    if (!peaks)
+    {
+        GMP_LOG_WARNING("No roofline peaks known for chip '" + chipName + "', set them with setRooflinePeaks().");
+        return nullptr;
+    }
+    return std::make_unique<GmpRoofline>(*peaks);
+}
+
+GmpResult GmpProfiler::ensureProfilerHost()
+{
+    if (!cuptiProfilerHost)
+    {
+        GMP_LOG_ERROR("Range profiler host is not initialized.");
+        return GmpResult::ERROR;
+    }
+    if (!cuptiProfilerHost->IsSetUp())
+    {
+        cuptiProfilerHost->SetUp(chipName, counterAvailabilityImage);
+    }
+    return GmpResult::SUCCESS;
+}
+#endif
+
 GmpResult GmpProfiler::checkActivityAndRangeResultMatch()
 {
 #ifdef USE_CUPTI
@@ -695,19 +2679,20 @@ GmpResult GmpProfiler::checkActivityAndRangeResultMatch()
         return GmpResult::SUCCESS;
     }
 
-    auto allRangeActivityData = sessionManager.getAllKernelDataOfType(GmpProfileType::CONCURRENT_KERNEL);
-    size_t activityRecordKernelCount = 0;
-    // Note that there might be entries with same range name because of replaying, but in the counter buffer, metrics have been aggregated.
-    std::set<std::string> uniqueRangeNames;
-    for (const auto &rangeData : allRangeActivityData)
+    if (rangeMode == GmpRangeMode::USER)
     {
-        if (uniqueRangeNames.find(rangeData.name) == uniqueRangeNames.end())
-        {
-            uniqueRangeNames.insert(rangeData.name);
-            std::cout << "Range Name: " << rangeData.name << ", Kernel Count: " << rangeData.kernelDataInRange.size() << std::endl;
-            activityRecordKernelCount+= rangeData.kernelDataInRange.size();
-        }
+        std::vector<size_t> rangeIndices;
+        return getUserRangeIndices(getKernelRangeNames(), rangeIndices);
     }
+    // Every auto range is one kernel launch, and a range name pushed again,
+    // e.g. once per iteration, gets ranges of its own.
+    size_t activityRecordKernelCount = 0;
+    sessionManager.forEachSession(GmpProfileType::CONCURRENT_KERNEL, [&](const GmpProfileSession &session)
+    {
+        GMP_LOG_DEBUG("Range Name: " + session.getSessionName() + ", Kernel Count: " +
+                      std::to_string(session.getKernelLaunchCount()));
+        activityRecordKernelCount += session.getKernelLaunchCount();
+    });
 
     size_t kernelCountInRangeProfilerRange = 0;
     cuptiProfilerHost->GetNumOfRanges(counterDataImage, kernelCountInRangeProfilerRange);
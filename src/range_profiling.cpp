@@ -1,4 +1,5 @@
 #include "gmp/range_profiling.h"
+#include "gmp/log.h"
 
 void CuptiProfilerHost::SetUp(std::string chipName, std::vector<uint8_t> &counterAvailibilityImage)
 {
@@ -44,7 +45,7 @@ CUptiResult CuptiProfilerHost::CreateConfigImage(
         getNumOfPassesParam.pConfigImage = configImage.data();
         getNumOfPassesParam.configImageSize = configImage.size();
         CUPTI_API_CALL(cuptiProfilerHostGetNumOfPasses(&getNumOfPassesParam));
-        std::cout << "Num of Passes: " << getNumOfPassesParam.numOfPasses << "\n";
+        GMP_LOG_INFO("Num of Passes: " + std::to_string(getNumOfPassesParam.numOfPasses));
         // assert(getNumOfPassesParam.numOfPasses == 1); // Range profiler should always be 1 pass
     }
 
@@ -69,22 +70,33 @@ CUptiResult CuptiProfilerHost::EvaluateCounterData(
     profilerRange.rangeIndex = rangeIndex;
     profilerRange.rangeName = getRangeInfoParams.rangeName;
 
-    std::vector<double> metricValues(metricsList.size());
+    std::vector<double> metricValues;
+    CUPTI_API_CALL(EvaluateRange(rangeIndex, metricsList, counterDataImage, metricValues));
+
+    for (size_t i = 0; i < metricsList.size(); ++i)
+    {
+        profilerRange.metricValues[metricsList[i]] = metricValues[i];
+    }
+
+    return CUPTI_SUCCESS;
+}
+
+CUptiResult CuptiProfilerHost::EvaluateRange(
+    size_t rangeIndex,
+    const std::vector<const char *> &metricsList,
+    const std::vector<uint8_t> &counterDataImage,
+    std::vector<double> &metricValues)
+{
+    metricValues.resize(metricsList.size());
     CUpti_Profiler_Host_EvaluateToGpuValues_Params evalauateToGpuValuesParams{CUpti_Profiler_Host_EvaluateToGpuValues_Params_STRUCT_SIZE};
     evalauateToGpuValuesParams.pHostObject = m_pHostObject;
     evalauateToGpuValuesParams.pCounterDataImage = counterDataImage.data();
     evalauateToGpuValuesParams.counterDataImageSize = counterDataImage.size();
-    evalauateToGpuValuesParams.ppMetricNames = metricsList.data();
+    evalauateToGpuValuesParams.ppMetricNames = const_cast<const char **>(metricsList.data());
     evalauateToGpuValuesParams.numMetrics = metricsList.size();
     evalauateToGpuValuesParams.rangeIndex = rangeIndex;
     evalauateToGpuValuesParams.pMetricValues = metricValues.data();
     CUPTI_API_CALL(cuptiProfilerHostEvaluateToGpuValues(&evalauateToGpuValuesParams));
-
-    for (size_t i = 0; i < metricsList.size(); ++i)
-    {
-        profilerRange.metricValues[metricsList[i]] = metricValues[i];
-    }
-
     return CUPTI_SUCCESS;
 }
 
@@ -248,7 +260,13 @@ CUptiResult RangeProfilerTarget::SetConfig(
 {
     configImage.resize(configImageBlob.size());
     std::copy(configImageBlob.begin(), configImageBlob.end(), configImage.begin());
+    mRange = range;
+    mReplayMode = replayMode;
+    return ApplyConfig(counterDataImage);
+}
 
+CUptiResult RangeProfilerTarget::ApplyConfig(std::vector<uint8_t> &counterDataImage)
+{
     CUpti_RangeProfiler_SetConfig_Params setConfigParams{CUpti_RangeProfiler_SetConfig_Params_STRUCT_SIZE};
     setConfigParams.pRangeProfilerObject = rangeProfilerObject;
     setConfigParams.pConfig = configImage.data();
@@ -260,12 +278,23 @@ CUptiResult RangeProfilerTarget::SetConfig(
     setConfigParams.minNestingLevel = mConfig.minNestingLevel;
     setConfigParams.passIndex = 0;
     setConfigParams.targetNestingLevel = 1;
-    setConfigParams.range = range;
-    setConfigParams.replayMode = replayMode;
+    setConfigParams.range = mRange;
+    setConfigParams.replayMode = mReplayMode;
     CUPTI_API_CALL(cuptiRangeProfilerSetConfig(&setConfigParams));
     return CUPTI_SUCCESS;
 }
 
+CUptiResult RangeProfilerTarget::ResetCounterData(std::vector<uint8_t> &counterDataImage)
+{
+    // The image keeps its size, initializing it again drops the decoded ranges.
+    CUpti_RangeProfiler_CounterDataImage_Initialize_Params initializeCounterDataImageParams{CUpti_RangeProfiler_CounterDataImage_Initialize_Params_STRUCT_SIZE};
+    initializeCounterDataImageParams.pRangeProfilerObject = rangeProfilerObject;
+    initializeCounterDataImageParams.pCounterData = counterDataImage.data();
+    initializeCounterDataImageParams.counterDataSize = counterDataImage.size();
+    CUPTI_API_CALL(cuptiRangeProfilerCounterDataImageInitialize(&initializeCounterDataImageParams));
+    return ApplyConfig(counterDataImage);
+}
+
 CUptiResult RangeProfilerTarget::DecodeCounterData()
 {
     CUpti_RangeProfiler_DecodeData_Params decodeDataParams{CUpti_RangeProfiler_DecodeData_Params_STRUCT_SIZE};
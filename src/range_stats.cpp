@@ -0,0 +1,65 @@
+#include <cmath>
+#include "gmp/range_stats.h"
+
+void GmpWelford::add(double value)
+{
+    count++;
+    if (count == 1)
+    {
+        min = max = value;
+    }
+    else
+    {
+        min = value < min ? value : min;
+        max = value > max ? value : max;
+    }
+    double delta = value - mean;
+    mean += delta / count;
+    m2 += delta * (value - mean);
+}
+
+double GmpWelford::stddev() const
+{
+    return std::sqrt(variance());
+}
+
+double GmpWelford::cv() const
+{
+    return mean != 0.0 ? stddev() / std::fabs(mean) : 0.0;
+}
+
+GmpRangeStatsTable::GmpRangeStatsTable(std::vector<std::string> metricNames)
+    : metricNames(std::move(metricNames)) {}
+
+size_t GmpRangeStatsTable::add(const std::string &name, const std::unordered_map<std::string, double> &metricValues,
+                               uint64_t durationNs)
+{
+    auto inserted = indexByName.emplace(name, stats.size());
+    if (inserted.second)
+    {
+        stats.emplace_back();
+        stats.back().name = name;
+        stats.back().metrics.resize(metricNames.size());
+    }
+    GmpRangeStats &rangeStats = stats[inserted.first->second];
+
+    if (durationNs > 0)
+    {
+        rangeStats.durationNs.add(static_cast<double>(durationNs));
+    }
+    for (size_t metricIndex = 0; metricIndex < metricNames.size() && !metricValues.empty(); ++metricIndex)
+    {
+        auto it = metricValues.find(metricNames[metricIndex]);
+        if (it != metricValues.end())
+        {
+            rangeStats.metrics[metricIndex].add(it->second);
+        }
+    }
+    return rangeStats.iterationCount++;
+}
+
+const GmpRangeStats *GmpRangeStatsTable::find(const std::string &name) const
+{
+    auto it = indexByName.find(name);
+    return it != indexByName.end() ? &stats[it->second] : nullptr;
+}
@@ -0,0 +1,353 @@
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include "gmp/result_diff.h"
+#include "gmp/hash.h"
+#include "gmp/log.h"
+
+namespace
+{
+    constexpr std::string_view CONFIG_PREFIX = "Config Name,";
+    constexpr size_t SUMMARY_NUMERIC_FIELDS = 6;
+
+    bool parseDouble(const char *begin, const char *end, double &value)
+    {
+        if (begin == end)
+        {
+            return false;
+        }
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+        // Locale-independent and several times faster than strtod.
+        auto result = std::from_chars(begin, end, value);
+        if (result.ec == std::errc() && result.ptr == end)
+        {
+            return true;
+        }
+        // from_chars rejects "+1" and "inf"/"nan" spelled by printf on some platforms.
+#endif
+        // The buffer is NUL-terminated and fields end at ',', '\r' or '\n',
+        // all of which stop strtod.
+        char *parsedEnd = nullptr;
+        value = strtod(begin, &parsedEnd);
+        return parsedEnd == end;
+    }
+
+    uint64_t hashKey(uint64_t configHash, std::string_view range, std::string_view metric)
+    {
+        uint64_t hash = gmpHashCombine(gmpHash64(range, configHash), range.size());
+        return gmpHashCombine(gmpHash64(metric, hash), metric.size());
+    }
+
+    const GmpDiffBudget *findBudget(const std::vector<GmpDiffBudget> &budgets, std::string_view metric)
+    {
+        const GmpDiffBudget *fallback = nullptr;
+        for (const auto &budget : budgets)
+        {
+            if (budget.metric == metric)
+            {
+                return &budget;
+            }
+            if (budget.metric == "*" && !fallback)
+            {
+                fallback = &budget;
+            }
+        }
+        return fallback;
+    }
+
+    bool isSameKey(const GmpResultRow &a, const GmpResultRow &b)
+    {
+        return a.metric == b.metric && a.range == b.range && a.config == b.config;
+    }
+}
+
+GmpResult GmpResultSet::load(const std::string &path)
+{
+    FILE *file = fopen(path.c_str(), "rb");
+    if (!file)
+    {
+        GMP_LOG_ERROR("Failed to open result file: " + path);
+        return GmpResult::ERROR;
+    }
+
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    buffer.assign(size > 0 ? static_cast<size_t>(size) + 1 : 1, '\0');
+    if (size > 0 && fread(buffer.data(), 1, static_cast<size_t>(size), file) != static_cast<size_t>(size))
+    {
+        fclose(file);
+        buffer.clear();
+        rows.clear();
+        GMP_LOG_ERROR("Failed to read result file: " + path);
+        return GmpResult::ERROR;
+    }
+    fclose(file);
+    return parseBuffer();
+}
+
+GmpResult GmpResultSet::parse(std::string_view text)
+{
+    buffer.assign(text.begin(), text.end());
+    buffer.push_back('\0');
+    return parseBuffer();
+}
+
+GmpResult GmpResultSet::parseBuffer()
+{
+    rows.clear();
+    malformedLineCount = 0;
+    // One row per line at most, counting them is far cheaper than regrowing.
+    size_t lineCount = 1;
+    for (const char *c = buffer.data(); (c = static_cast<const char *>(memchr(c, '\n', buffer.data() + buffer.size() - c))); ++c)
+    {
+        lineCount++;
+    }
+    rows.reserve(lineCount);
+
+    std::string_view config;
+    uint64_t configHash = gmpHashCombine(gmpHash64(config), 0);
+    // The last commas of a line, rightmost first. Range names may themselves
+    // contain commas, so lines are split from the right.
+    const char *commas[SUMMARY_NUMERIC_FIELDS + 1];
+    const char *cursor = buffer.data();
+    const char *bufferEnd = buffer.data() + buffer.size() - 1;
+    uint32_t lineNumber = 0;
+
+    while (cursor < bufferEnd)
+    {
+        lineNumber++;
+        const char *lineEnd = static_cast<const char *>(memchr(cursor, '\n', bufferEnd - cursor));
+        if (!lineEnd)
+        {
+            lineEnd = bufferEnd;
+        }
+        const char *next = lineEnd < bufferEnd ? lineEnd + 1 : bufferEnd;
+        if (lineEnd > cursor && lineEnd[-1] == '\r')
+        {
+            lineEnd--;
+        }
+        std::string_view line(cursor, lineEnd - cursor);
+        cursor = next;
+
+        if (line.empty())
+        {
+            continue;
+        }
+        if (line.compare(0, CONFIG_PREFIX.size(), CONFIG_PREFIX) == 0)
+        {
+            config = line.substr(CONFIG_PREFIX.size());
+            configHash = gmpHashCombine(gmpHash64(config), config.size());
+            continue;
+        }
+
+        size_t commaCount = 0;
+        for (const char *c = lineEnd - 1; c >= line.data() && commaCount <= SUMMARY_NUMERIC_FIELDS; --c)
+        {
+            if (*c == ',')
+            {
+                commas[commaCount++] = c;
+            }
+        }
+        if (commaCount < 2)
+        {
+            malformedLineCount++;
+            continue;
+        }
+
+        GmpResultRow row;
+        row.line = lineNumber;
+        row.config = config;
+        bool isSummary = false;
+        if (commaCount == SUMMARY_NUMERIC_FIELDS + 1)
+        {
+            // range,metric,mean,stddev,min,max,cv,iterations
+            double numeric[SUMMARY_NUMERIC_FIELDS];
+            isSummary = true;
+            for (size_t i = 0; i < SUMMARY_NUMERIC_FIELDS && isSummary; ++i)
+            {
+                const char *fieldEnd = i == 0 ? lineEnd : commas[i - 1];
+                isSummary = parseDouble(commas[i] + 1, fieldEnd, numeric[SUMMARY_NUMERIC_FIELDS - 1 - i]);
+            }
+            if (isSummary)
+            {
+                const char *metricComma = commas[SUMMARY_NUMERIC_FIELDS];
+                const char *valueComma = commas[SUMMARY_NUMERIC_FIELDS - 1];
+                row.range = std::string_view(line.data(), metricComma - line.data());
+                row.metric = std::string_view(metricComma + 1, valueComma - metricComma - 1);
+                row.value = numeric[0];
+                row.stddev = numeric[1];
+                row.iterations = static_cast<uint32_t>(numeric[5]);
+            }
+        }
+        if (!isSummary)
+        {
+            // range,metric,value
+            const char *valueComma = commas[0];
+            const char *metricComma = commas[1];
+            if (!parseDouble(valueComma + 1, lineEnd, row.value))
+            {
+                malformedLineCount++;
+                continue;
+            }
+            row.range = std::string_view(line.data(), metricComma - line.data());
+            row.metric = std::string_view(metricComma + 1, valueComma - metricComma - 1);
+        }
+        row.key = hashKey(configHash, row.range, row.metric);
+        rows.push_back(row);
+    }
+
+    // Rows of a key keep their file order, which numbers repeated ranges and
+    // result files that were appended to more than once.
+    // Sort 16-byte (key, position) pairs rather than the rows themselves, the
+    // position breaks ties so the unstable sort keeps file order.
+    std::vector<std::pair<uint64_t, uint32_t>> order(rows.size());
+    for (size_t i = 0; i < rows.size(); ++i)
+    {
+        order[i] = {rows[i].key, static_cast<uint32_t>(i)};
+    }
+    std::sort(order.begin(), order.end());
+    std::vector<GmpResultRow> sortedRows;
+    sortedRows.reserve(rows.size());
+    for (const auto &entry : order)
+    {
+        sortedRows.push_back(rows[entry.second]);
+    }
+    rows.swap(sortedRows);
+    size_t collisions = 0;
+    for (size_t i = 1; i < rows.size(); ++i)
+    {
+        if (rows[i].key == rows[i - 1].key)
+        {
+            rows[i].occurrence = rows[i - 1].occurrence + 1;
+            collisions += !isSameKey(rows[i], rows[i - 1]);
+        }
+    }
+    if (collisions > 0)
+    {
+        GMP_LOG_WARNING("Result keys collided for " << collisions << " rows, their pairing may be wrong.");
+    }
+    if (malformedLineCount > 0)
+    {
+        GMP_LOG_WARNING("Skipped " << malformedLineCount << " malformed result lines.");
+    }
+    return GmpResult::SUCCESS;
+}
+
+GmpDiffReport gmpDiffResults(const GmpResultSet &base, const GmpResultSet &current, const GmpDiffOptions &options)
+{
+    GmpDiffReport report;
+    const auto &baseRows = base.getRows();
+    const auto &currentRows = current.getRows();
+    report.entries.reserve(std::max(baseRows.size(), currentRows.size()));
+
+    auto addEntry = [&report](GmpDiffEntry entry)
+    {
+        report.statusCounts[static_cast<int>(entry.status)]++;
+        report.entries.push_back(entry);
+    };
+
+    size_t b = 0;
+    size_t c = 0;
+    while (b < baseRows.size() || c < currentRows.size())
+    {
+        GmpDiffEntry entry;
+        if (c == currentRows.size() ||
+            (b < baseRows.size() && (baseRows[b].key < currentRows[c].key ||
+                                     (baseRows[b].key == currentRows[c].key && baseRows[b].occurrence < currentRows[c].occurrence))))
+        {
+            entry.base = &baseRows[b++];
+            entry.status = GmpDiffStatus::ONLY_BASE;
+            addEntry(entry);
+            continue;
+        }
+        if (b == baseRows.size() || baseRows[b].key != currentRows[c].key ||
+            baseRows[b].occurrence != currentRows[c].occurrence)
+        {
+            entry.current = &currentRows[c++];
+            entry.status = GmpDiffStatus::ONLY_NEW;
+            addEntry(entry);
+            continue;
+        }
+
+        entry.base = &baseRows[b++];
+        entry.current = &currentRows[c++];
+        double baseValue = entry.base->value;
+        entry.absDelta = entry.current->value - baseValue;
+        if (baseValue != 0.0)
+        {
+            entry.relDelta = entry.absDelta / std::fabs(baseValue);
+        }
+        else if (entry.absDelta != 0.0)
+        {
+            entry.relDelta = std::copysign(std::numeric_limits<double>::infinity(), entry.absDelta);
+        }
+
+        double absDelta = std::fabs(entry.absDelta);
+        double combinedStddev = std::sqrt(entry.base->stddev * entry.base->stddev +
+                                          entry.current->stddev * entry.current->stddev);
+        if (absDelta == 0.0)
+        {
+            entry.status = GmpDiffStatus::UNCHANGED;
+        }
+        else if (absDelta <= options.absNoise || std::fabs(entry.relDelta) <= options.relNoise ||
+                 (entry.base->stddev > 0.0 && entry.current->stddev > 0.0 && absDelta <= options.sigma * combinedStddev))
+        {
+            entry.status = GmpDiffStatus::NOISE;
+        }
+        else
+        {
+            entry.status = GmpDiffStatus::CHANGED;
+        }
+        // A budget tighter than the noise thresholds still applies to the noise.
+        const GmpDiffBudget *budget =
+            entry.status != GmpDiffStatus::UNCHANGED ? findBudget(options.budgets, entry.base->metric) : nullptr;
+        if (budget)
+        {
+            bool inDirection = budget->direction == GmpBudgetDirection::BOTH ||
+                               (budget->direction == GmpBudgetDirection::INCREASE && entry.absDelta > 0.0) ||
+                               (budget->direction == GmpBudgetDirection::DECREASE && entry.absDelta < 0.0);
+            if (inDirection && std::fabs(entry.relDelta) > budget->maxRelative)
+            {
+                entry.status = GmpDiffStatus::OVER_BUDGET;
+            }
+        }
+        addEntry(entry);
+    }
+    return report;
+}
+
+bool gmpDiffFailed(const GmpDiffReport &report, const GmpDiffOptions &options)
+{
+    if (report.count(GmpDiffStatus::OVER_BUDGET) > 0)
+    {
+        return true;
+    }
+    return options.failOnMissing &&
+           (report.count(GmpDiffStatus::ONLY_BASE) > 0 || report.count(GmpDiffStatus::ONLY_NEW) > 0);
+}
+
+const char *gmpDiffStatusName(GmpDiffStatus status)
+{
+    switch (status)
+    {
+    case GmpDiffStatus::UNCHANGED:
+        return "unchanged";
+    case GmpDiffStatus::NOISE:
+        return "noise";
+    case GmpDiffStatus::CHANGED:
+        return "changed";
+    case GmpDiffStatus::OVER_BUDGET:
+        return "over_budget";
+    case GmpDiffStatus::ONLY_BASE:
+        return "only_base";
+    case GmpDiffStatus::ONLY_NEW:
+        return "only_new";
+    default:
+        return "unknown";
+    }
+}
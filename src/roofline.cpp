@@ -0,0 +1,147 @@
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <limits>
+#include <utility>
+#include "gmp/roofline.h"
+#include "gmp/log.h"
+
+namespace
+{
+bool isSameChip(const std::string &a, const std::string &b)
+{
+    return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [](char x, char y)
+                                               { return std::tolower(static_cast<unsigned char>(x)) ==
+                                                        std::tolower(static_cast<unsigned char>(y)); });
+}
+
+// Kernel names carry commas in their template arguments, quote them.
+void writeCsvField(FILE *file, const std::string &field)
+{
+    if (field.find_first_of(",\"\n") == std::string::npos)
+    {
+        fputs(field.c_str(), file);
+        return;
+    }
+    fputc('"', file);
+    for (char c : field)
+    {
+        if (c == '"')
+        {
+            fputc('"', file);
+        }
+        fputc(c, file);
+    }
+    fputc('"', file);
+}
+} // namespace
+
+const char *gmpRooflineBoundName(GmpRooflineBound bound)
+{
+    switch (bound)
+    {
+    case GmpRooflineBound::MEMORY:
+        return "memory";
+    case GmpRooflineBound::COMPUTE:
+        return "compute";
+    default:
+        return "unknown";
+    }
+}
+
+GmpRoofline::GmpRoofline(GmpRooflinePeaks peaks)
+    : peaks(std::move(peaks)) {}
+
+const std::vector<GmpRooflinePeaks> &GmpRoofline::getPeakTable()
+{
+    // Full chip of the most common board: SMs, boost clock and DRAM bandwidth.
+    // Boards with fewer SMs or other clocks should set their own peaks.
+    static const std::vector<GmpRooflinePeaks> table = {
+        {"GV100", 80, 1.530, 900.0},  // V100 SXM2
+        {"TU102", 72, 1.770, 672.0},  // Titan RTX
+        {"TU104", 40, 1.590, 320.0},  // T4
+        {"GA100", 108, 1.410, 1555.0}, // A100 SXM4 40 GB
+        {"GA102", 82, 1.695, 936.0},  // RTX 3090
+        {"GA104", 46, 1.725, 448.0},  // RTX 3070
+        {"GA10B", 16, 1.300, 204.8},  // Jetson AGX Orin
+        {"AD102", 128, 2.520, 1008.0}, // RTX 4090
+        {"AD104", 60, 2.610, 504.0},  // RTX 4070 Ti
+        {"GH100", 132, 1.980, 3350.0}, // H100 SXM5
+    };
+    return table;
+}
+
+const GmpRooflinePeaks *GmpRoofline::findPeaks(const std::string &chipName)
+{
+    for (const auto &peaks : getPeakTable())
+    {
+        if (isSameChip(peaks.chipName, chipName))
+        {
+            return &peaks;
+        }
+    }
+    return nullptr;
+}
+
+GmpRooflinePoint GmpRoofline::classify(const std::string &name, double instructions, double dramSectors,
+                                       double durationNs) const
+{
+    GmpRooflinePoint point;
+    point.name = name;
+    point.instructions = instructions;
+    point.dramBytes = dramSectors * DRAM_SECTOR_BYTES;
+    point.durationNs = durationNs;
+    if (instructions <= 0.0 || durationNs <= 0.0 || !peaks.isValid())
+    {
+        return point;
+    }
+
+    point.intensity = point.dramBytes > 0.0 ? instructions / point.dramBytes : std::numeric_limits<double>::infinity();
+    point.instructionRate = instructions / durationNs;
+    point.bandwidth = point.dramBytes / durationNs;
+    if (point.intensity < ridgeIntensity())
+    {
+        point.bound = GmpRooflineBound::MEMORY;
+        point.roofRate = point.intensity * peaks.dramBandwidth;
+    }
+    else
+    {
+        point.bound = GmpRooflineBound::COMPUTE;
+        point.roofRate = peaks.instructionRate();
+    }
+    point.roofFraction = point.instructionRate / point.roofRate;
+    return point;
+}
+
+bool GmpRoofline::writeCsv(const std::string &path, const std::vector<GmpRooflinePoint> &points)
+{
+    FILE *file = fopen(path.c_str(), "w");
+    if (!file)
+    {
+        GMP_LOG_ERROR("Failed to open roofline file: " + path);
+        return false;
+    }
+    fputs("range,kernel,instructions,dram_bytes,duration_ns,intensity,ginst_per_s,dram_gb_per_s,"
+          "roof_ginst_per_s,roof_fraction,bound\n",
+          file);
+    for (const auto &point : points)
+    {
+        // A kernel row names its range, a range row has no kernel.
+        writeCsvField(file, point.rangeName.empty() ? point.name : point.rangeName);
+        fputc(',', file);
+        if (!point.rangeName.empty())
+        {
+            writeCsvField(file, point.name);
+        }
+        fprintf(file, ",%.0f,%.0f,%.0f,%.6g,%.6g,%.6g,%.6g,%.4f,%s\n", point.instructions, point.dramBytes,
+                point.durationNs, point.intensity, point.instructionRate, point.bandwidth, point.roofRate,
+                point.roofFraction, gmpRooflineBoundName(point.bound));
+    }
+    bool ok = ferror(file) == 0;
+    ok = fclose(file) == 0 && ok;
+    if (!ok)
+    {
+        GMP_LOG_ERROR("Failed to write roofline file: " + path);
+    }
+    return ok;
+}
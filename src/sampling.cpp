@@ -0,0 +1,89 @@
+#include "gmp/sampling.h"
+#include "gmp/hash.h"
+#include "gmp/log.h"
+
+void GmpRangeSampler::setPolicy(const GmpSamplingPolicy &newPolicy)
+{
+    policy = newPolicy;
+    if (policy.period == 0)
+    {
+        GMP_LOG_WARNING("Sampling period of 0 is invalid, using 1.");
+        policy.period = 1;
+    }
+    active = policy.mode != GmpSamplingMode::ALL || policy.warmupIterations > 0;
+    countsOccurrences = policy.mode == GmpSamplingMode::EVERY_KTH || policy.warmupIterations > 0;
+    reset();
+}
+
+const GmpSamplingPolicy &GmpRangeSampler::getPolicy() const
+{
+    return policy;
+}
+
+void GmpRangeSampler::reset()
+{
+    occurrences.clear();
+    rng.seed(policy.seed);
+    hasFirstDecision = false;
+    overhead = clock_t::duration::zero();
+    profiledCount = 0;
+    skippedCount = 0;
+}
+
+bool GmpRangeSampler::shouldProfile(const std::string &name)
+{
+    return shouldProfile(countsOccurrences ? gmpHash64(name) : 0);
+}
+
+bool GmpRangeSampler::shouldProfile(uint64_t nameHash)
+{
+    uint64_t occurrence = countsOccurrences ? occurrences[nameHash]++ : 0;
+    bool profile = occurrence >= policy.warmupIterations && decide(occurrence - policy.warmupIterations);
+    if (profile)
+    {
+        profiledCount++;
+    }
+    else
+    {
+        skippedCount++;
+    }
+    return profile;
+}
+
+bool GmpRangeSampler::decide(uint64_t occurrence)
+{
+    switch (policy.mode)
+    {
+    case GmpSamplingMode::ALL:
+        return true;
+    case GmpSamplingMode::EVERY_KTH:
+        return occurrence % policy.period == 0;
+    case GmpSamplingMode::RANDOM_FRACTION:
+        return uniform(rng) < policy.fraction;
+    case GmpSamplingMode::ADAPTIVE:
+    {
+        auto now = clock_t::now();
+        if (!hasFirstDecision)
+        {
+            firstDecision = now;
+            hasFirstDecision = true;
+            return true;
+        }
+        auto wall = now - firstDecision;
+        if (wall <= clock_t::duration::zero())
+        {
+            return true;
+        }
+        double overheadPct = 100.0 * std::chrono::duration<double>(overhead).count() /
+                             std::chrono::duration<double>(wall).count();
+        return overheadPct < policy.overheadBudgetPct;
+    }
+    default:
+        return true;
+    }
+}
+
+void GmpRangeSampler::recordOverhead(clock_t::duration elapsed)
+{
+    overhead += elapsed;
+}
@@ -1,6 +1,51 @@
+#include <cstring>
 #include "gmp/session.h"
 #include "gmp/profile.h"
 
+namespace
+{
+void putRaw(std::vector<uint8_t> &out, const void *data, size_t size)
+{
+    const auto *bytes = static_cast<const uint8_t *>(data);
+    out.insert(out.end(), bytes, bytes + size);
+}
+
+// Element count, then the records of a list, block by block.
+template <typename T>
+void putList(std::vector<uint8_t> &out, const GmpRecordList<T> &values)
+{
+    uint64_t count = values.size();
+    putRaw(out, &count, sizeof(count));
+    values.forEachBlock([&out](const T *records, size_t n)
+                        { putRaw(out, records, n * sizeof(T)); });
+}
+
+bool getRaw(const uint8_t *&cursor, const uint8_t *end, void *data, size_t size)
+{
+    if (size_t(end - cursor) < size)
+    {
+        return false;
+    }
+    memcpy(data, cursor, size);
+    cursor += size;
+    return true;
+}
+
+template <typename T>
+bool getList(const uint8_t *&cursor, const uint8_t *end, GmpRecordList<T> &values)
+{
+    uint64_t count = 0;
+    if (!getRaw(cursor, end, &count, sizeof(count)) || count > size_t(end - cursor) / sizeof(T))
+    {
+        return false;
+    }
+    values.clear();
+    values.appendBytes(cursor, count);
+    cursor += count * sizeof(T);
+    return true;
+}
+} // namespace
+
 // GmpProfileSession method implementations
 bool GmpProfileSession::isActive() const { 
     return is_active; 
@@ -10,9 +55,17 @@ void GmpProfileSession::deactivate() {
     is_active = false; 
 }
 
-std::string GmpProfileSession::getSessionName()
+const std::string &GmpProfileSession::getSessionName() const
+{
+    return GmpStringTable::instance().get(sessionNameId);
+}
+
+void GmpProfileSession::setArena(GmpArena *arena)
 {
-    return sessionName;
+    kernelData.setArena(arena);
+    memData.setArena(arena);
+    transferData.setArena(arena);
+    computeIntervals.setArena(arena);
 }
 
 void GmpProfileSession::setRuntimeData(const ApiRuntimeRecord &data)
@@ -28,27 +81,157 @@ const ApiRuntimeRecord &GmpProfileSession::getRuntimeData() const
 void GmpProfileSession::pushKernelData(const GmpKernelData &data)
 {
     kernelData.push_back(data);
+    kernelLaunchCount++;
+}
+
+void GmpProfileSession::pushFilteredKernel()
+{
+    kernelLaunchCount++;
+}
+
+size_t GmpProfileSession::getKernelLaunchCount() const
+{
+    return kernelLaunchCount;
 }
 
 void GmpProfileSession::pushMemData(const GmpMemData &data)
 {
-    memData.push_back(data);
+    memData.push(data);
+}
+
+void GmpProfileSession::pushTransferData(const GmpTransferData &data)
+{
+    transferData.push_back(data);
+}
+
+void GmpProfileSession::pushComputeInterval(const GmpTimeInterval &interval)
+{
+    computeIntervals.push_back(interval);
 }
 
 std::vector<GmpKernelData> GmpProfileSession::getKernelData() const
 {
-    return kernelData;
+    return kernelData.toVector();
 }
 
 std::vector<GmpMemData> GmpProfileSession::getMemData() const
+{
+    return memData.rows();
+}
+
+const GmpRecordList<GmpKernelData> &GmpProfileSession::getKernelDataView() const
+{
+    return kernelData;
+}
+
+const GmpMemColumns &GmpProfileSession::getMemDataView() const
 {
     return memData;
 }
 
+void GmpProfileSession::addUnifiedMemoryCounter(CUpti_ActivityUnifiedMemoryCounterKind kind, uint64_t value,
+                                                uint64_t start, uint64_t end)
+{
+    unifiedMemory.add(kind, value, start, end);
+}
+
+const GmpUnifiedMemorySummary &GmpProfileSession::getUnifiedMemorySummary() const
+{
+    return unifiedMemory;
+}
+
+const GmpRecordList<GmpTransferData> &GmpProfileSession::getTransferDataView() const
+{
+    return transferData;
+}
+
+const GmpRecordList<GmpTimeInterval> &GmpProfileSession::getComputeIntervalView() const
+{
+    return computeIntervals;
+}
+
+void GmpProfileSession::setStartTimestamp(uint64_t timestamp)
+{
+    startTimestamp = timestamp;
+}
+
+void GmpProfileSession::setEndTimestamp(uint64_t timestamp)
+{
+    endTimestamp = timestamp;
+}
+
+uint64_t GmpProfileSession::getStartTimestamp() const
+{
+    return startTimestamp;
+}
+
+uint64_t GmpProfileSession::getEndTimestamp() const
+{
+    return endTimestamp;
+}
+
+size_t GmpProfileSession::getRecordBytes() const
+{
+    return kernelData.getCapacityBytes() + memData.getCapacityBytes() + transferData.getCapacityBytes() +
+           computeIntervals.getCapacityBytes();
+}
+
+void GmpProfileSession::serializeRecords(std::vector<uint8_t> &out) const
+{
+    // Kernel names are string table ids, valid for the process that spilled them.
+    putList(out, kernelData);
+    putList(out, memData.address);
+    putList(out, memData.bytes);
+    putList(out, memData.timestamp);
+    putList(out, memData.correlationId);
+    putList(out, memData.streamId);
+    putList(out, memData.symbolId);
+    putList(out, memData.contextId);
+    putList(out, memData.deviceId);
+    putList(out, memData.flags);
+    putList(out, transferData);
+    putList(out, computeIntervals);
+}
+
+bool GmpProfileSession::deserializeRecords(const uint8_t *data, size_t size)
+{
+    const uint8_t *cursor = data;
+    const uint8_t *end = data + size;
+    return getList(cursor, end, kernelData) && getList(cursor, end, memData.address) &&
+           getList(cursor, end, memData.bytes) && getList(cursor, end, memData.timestamp) &&
+           getList(cursor, end, memData.correlationId) && getList(cursor, end, memData.streamId) &&
+           getList(cursor, end, memData.symbolId) && getList(cursor, end, memData.contextId) &&
+           getList(cursor, end, memData.deviceId) && getList(cursor, end, memData.flags) &&
+           getList(cursor, end, transferData) && getList(cursor, end, computeIntervals) && cursor == end;
+}
+
+void GmpProfileSession::releaseRecords()
+{
+    // The blocks go back to the free lists of the arena, if any.
+    kernelData.clear();
+    memData.clear();
+    transferData.clear();
+    computeIntervals.clear();
+}
+
+void GmpSessionDeleter::operator()(GmpProfileSession *session) const
+{
+    if (!arena)
+    {
+        delete session;
+        return;
+    }
+    session->~GmpProfileSession();
+    arena->release(session, size);
+}
+
 // GmpConcurrentKernelSession method implementations
 GmpConcurrentKernelSession::GmpConcurrentKernelSession(const std::string &sessionName)
     : GmpProfileSession(sessionName) {}
 
+GmpConcurrentKernelSession::GmpConcurrentKernelSession(uint32_t sessionNameId)
+    : GmpProfileSession(sessionNameId) {}
+
 void GmpConcurrentKernelSession::report() const
 {
     // GMP_LOG_DEBUG("Session " + sessionName.c_str() + " captured " + std::to_string(num_calls) + " calls");
@@ -58,7 +241,21 @@ void GmpConcurrentKernelSession::report() const
 GmpMemSession::GmpMemSession(const std::string &sessionName)
     : GmpProfileSession(sessionName) {}
 
+GmpMemSession::GmpMemSession(uint32_t sessionNameId)
+    : GmpProfileSession(sessionNameId) {}
+
 void GmpMemSession::report() const
 {
     // GMP_LOG_DEBUG("Session " + sessionName.c_str() + " captured " + std::to_string(num_calls) + " calls");
-}
\ No newline at end of file
+}
+
+// GmpTransferSession method implementations
+GmpTransferSession::GmpTransferSession(const std::string &sessionName)
+    : GmpProfileSession(sessionName) {}
+
+GmpTransferSession::GmpTransferSession(uint32_t sessionNameId)
+    : GmpProfileSession(sessionNameId) {}
+
+void GmpTransferSession::report() const
+{
+}
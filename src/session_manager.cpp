@@ -30,7 +30,7 @@ GmpResult SessionManager::reportAllSessions()
     return GmpResult::SUCCESS;
 }
 
-GmpResult SessionManager::startSession(GmpProfileType type, std::unique_ptr<GmpProfileSession> sessionPtr)
+GmpResult SessionManager::startSession(GmpProfileType type, GmpSessionPtr sessionPtr)
 {
     assert(sessionPtr != nullptr);
     if (ActivityMap[type].empty() || !ActivityMap[type].back()->isActive())
@@ -48,7 +48,7 @@ GmpResult SessionManager::startSession(GmpProfileType type, std::unique_ptr<GmpP
     }
 }
 
-GmpResult SessionManager::endSession(GmpProfileType type)
+GmpResult SessionManager::endSession(GmpProfileType type, uint64_t endTimestamp)
 {
 #ifdef USE_CUPTI
     GMP_LOG_DEBUG("Ending session");
@@ -63,8 +63,16 @@ GmpResult SessionManager::endSession(GmpProfileType type)
         // CUpti_SubscriberHandle subscriber = sessionPtr->getRuntimeSubscriberHandle();
         // CUPTI_CALL(cuptiUnsubscribe(subscriber));
 
+        sessionPtr->setEndTimestamp(endTimestamp);
         sessionPtr->report();
         sessionPtr->deactivate();
+        if (memoryBudget > 0)
+        {
+            size_t bytes = sessionPtr->getRecordBytes();
+            residentBytes += bytes;
+            residentSessions.emplace_back(sessionPtr.get(), bytes);
+            enforceMemoryBudget();
+        }
         GMP_LOG_DEBUG("Session of type " + std::to_string(static_cast<int>(type)) + " ended.");
         return GmpResult::SUCCESS;
     }
@@ -78,25 +86,151 @@ GmpResult SessionManager::endSession(GmpProfileType type)
 std::vector<GmpRangeData> SessionManager::getAllKernelDataOfType(GmpProfileType type)
 {
     std::vector<GmpRangeData> allKernelData;
-    for (const auto &sessionPtr : ActivityMap[type])
+    forEachSession(type, [&allKernelData](const GmpProfileSession &session)
     {
-        auto dataInRange = sessionPtr->getKernelData();
-        allKernelData.push_back({sessionPtr->getSessionName(), dataInRange});
-    }
+        allKernelData.push_back({session.getSessionName(), session.getKernelData(), session.getKernelLaunchCount()});
+    });
     return allKernelData;
 }
 
 std::vector<GmpMemRangeData> SessionManager::getAllMemDataOfType(GmpProfileType type)
 {
     std::vector<GmpMemRangeData> allMemData;
-    for (const auto &sessionPtr : ActivityMap[type])
+    forEachSession(type, [&allMemData](const GmpProfileSession &session)
     {
-        auto dataInRange = sessionPtr->getMemData();
-        allMemData.push_back({sessionPtr->getSessionName(), dataInRange});
-    }
+        allMemData.push_back({session.getSessionName(), session.getMemData()});
+    });
     return allMemData;
 }
 
+GmpResult SessionManager::setMemoryBudget(size_t bytes, const std::string &spillPath)
+{
+    if (!residentSessions.empty() || !spillSlots.empty())
+    {
+        GMP_LOG_WARNING("The memory budget must be set before the first session ends.");
+        return GmpResult::WARNING;
+    }
+    if (bytes > 0 && !spillFile.isOpen() && spillFile.open(spillPath) != GmpResult::SUCCESS)
+    {
+        return GmpResult::ERROR;
+    }
+    memoryBudget = bytes;
+    return GmpResult::SUCCESS;
+}
+
+GmpSessionStorageStats SessionManager::getStorageStats() const
+{
+    GmpSessionStorageStats stats;
+    stats.memoryBudget = memoryBudget;
+    stats.residentBytes = residentBytes;
+    stats.spilledSessions = spillSlots.size();
+    stats.spilledBytes = spillFile.getSize();
+    stats.pageIns = pageInCount;
+    return stats;
+}
+
+bool SessionManager::hasActiveSession() const
+{
+    for (const auto &pair : ActivityMap)
+    {
+        if (!pair.second.empty() && pair.second.back()->isActive())
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+GmpResult SessionManager::reset()
+{
+    for (const auto &pair : ActivityMap)
+    {
+        if (!pair.second.empty() && pair.second.back()->isActive())
+        {
+            GMP_LOG_WARNING("Cannot reset the sessions while session " + pair.second.back()->getSessionName() +
+                            " is active.");
+            return GmpResult::WARNING;
+        }
+    }
+    // Keep the capacity of the session lists, the next epoch fills them again.
+    for (auto &pair : ActivityMap)
+    {
+        pair.second.clear();
+    }
+    residentSessions.clear();
+    residentBytes = 0;
+    spillSlots.clear();
+    if (spillFile.isOpen())
+    {
+        std::string path = spillFile.getPath();
+        spillFile.close();
+        if (spillFile.open(path) != GmpResult::SUCCESS)
+        {
+            GMP_LOG_ERROR("Failed to reopen the session spill file, the memory budget is disabled.");
+            memoryBudget = 0;
+        }
+    }
+    arena.reset();
+    return GmpResult::SUCCESS;
+}
+
+GmpArenaStats SessionManager::getArenaStats() const
+{
+    return arena.getStats();
+}
+
+void SessionManager::enforceMemoryBudget()
+{
+    while (residentBytes > memoryBudget && !residentSessions.empty())
+    {
+        GmpProfileSession *session = residentSessions.front().first;
+        size_t bytes = residentSessions.front().second;
+        residentSessions.pop_front();
+        residentBytes -= bytes;
+
+        pageBuffer.clear();
+        session->serializeRecords(pageBuffer);
+        GmpSessionSpillSlot slot;
+        if (spillFile.append(pageBuffer, slot) != GmpResult::SUCCESS)
+        {
+            // Keep this and the remaining sessions in memory rather than lose them.
+            GMP_LOG_ERROR("Failed to spill session " + session->getSessionName() + ", the memory budget is disabled.");
+            memoryBudget = 0;
+            return;
+        }
+        session->releaseRecords();
+        spillSlots.emplace(session, slot);
+    }
+}
+
+bool SessionManager::pageIn(GmpProfileSession &session) const
+{
+    auto it = spillSlots.find(&session);
+    if (it == spillSlots.end())
+    {
+        return true;
+    }
+    if (spillFile.read(it->second, pageBuffer) != GmpResult::SUCCESS ||
+        !session.deserializeRecords(pageBuffer.data(), pageBuffer.size()))
+    {
+        GMP_LOG_ERROR("Failed to read back spilled session " + session.getSessionName() +
+                      ", its records are missing from the report.");
+        session.releaseRecords();
+        return false;
+    }
+    pageInCount++;
+    return true;
+}
+
+void SessionManager::pageOut(GmpProfileSession &session) const
+{
+    // Already in the spill file, only the memory is given back.
+    if (spillSlots.count(&session) > 0)
+    {
+        session.releaseRecords();
+    }
+}
+
 // Explicit template instantiations
 template GmpResult SessionManager::accumulate<GmpConcurrentKernelSession>(GmpProfileType, AccumulateFunc<GmpConcurrentKernelSession>);
 template GmpResult SessionManager::accumulate<GmpMemSession>(GmpProfileType, AccumulateFunc<GmpMemSession>);
\ No newline at end of file
@@ -0,0 +1,94 @@
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include "gmp/session_spill.h"
+#include "gmp/log.h"
+
+GmpSessionSpillFile::~GmpSessionSpillFile()
+{
+    close();
+}
+
+GmpResult GmpSessionSpillFile::open(const std::string &filePath)
+{
+    if (fd >= 0)
+    {
+        GMP_LOG_ERROR("Session spill file is already open.");
+        return GmpResult::ERROR;
+    }
+    fd = ::open(filePath.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+    if (fd < 0)
+    {
+        GMP_LOG_ERROR("Failed to open session spill file " + filePath + ": " + strerror(errno));
+        return GmpResult::ERROR;
+    }
+    path = filePath;
+    size = 0;
+    return GmpResult::SUCCESS;
+}
+
+GmpResult GmpSessionSpillFile::append(const std::vector<uint8_t> &payload, GmpSessionSpillSlot &slot)
+{
+    if (fd < 0)
+    {
+        return GmpResult::ERROR;
+    }
+    size_t written = 0;
+    while (written < payload.size())
+    {
+        ssize_t result = pwrite(fd, payload.data() + written, payload.size() - written, size + written);
+        if (result < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (result <= 0)
+        {
+            GMP_LOG_ERROR("Failed to write session spill file " + path + ": " + strerror(errno));
+            return GmpResult::ERROR;
+        }
+        written += static_cast<size_t>(result);
+    }
+    slot.offset = size;
+    slot.size = payload.size();
+    size += payload.size();
+    return GmpResult::SUCCESS;
+}
+
+GmpResult GmpSessionSpillFile::read(const GmpSessionSpillSlot &slot, std::vector<uint8_t> &out) const
+{
+    if (fd < 0 || slot.offset + slot.size > size)
+    {
+        return GmpResult::ERROR;
+    }
+    out.resize(slot.size);
+    size_t done = 0;
+    while (done < slot.size)
+    {
+        ssize_t result = pread(fd, out.data() + done, slot.size - done, slot.offset + done);
+        if (result < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (result <= 0)
+        {
+            GMP_LOG_ERROR("Failed to read session spill file " + path + ": " +
+                          (result == 0 ? "unexpected end of file" : strerror(errno)));
+            return GmpResult::ERROR;
+        }
+        done += static_cast<size_t>(result);
+    }
+    return GmpResult::SUCCESS;
+}
+
+void GmpSessionSpillFile::close()
+{
+    if (fd < 0)
+    {
+        return;
+    }
+    ::close(fd);
+    fd = -1;
+    unlink(path.c_str());
+    size = 0;
+}
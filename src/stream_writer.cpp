@@ -0,0 +1,269 @@
+#include <cerrno>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include "gmp/stream_writer.h"
+#include "gmp/log.h"
+
+namespace
+{
+// Quote a field if it holds a separator, a quote or a newline.
+void appendCsvField(std::string &line, const std::string &field)
+{
+    if (field.find_first_of(",\"\n") == std::string::npos)
+    {
+        line += field;
+        return;
+    }
+    line += '"';
+    for (char c : field)
+    {
+        if (c == '"')
+        {
+            line += '"';
+        }
+        line += c;
+    }
+    line += '"';
+}
+
+std::string makeHeader(const std::vector<std::string> &metricNames)
+{
+    std::string header = "range_index,range,start_ns,end_ns,kernels";
+    for (const auto &metric : metricNames)
+    {
+        header += ',';
+        appendCsvField(header, metric);
+    }
+    header += '\n';
+    return header;
+}
+} // namespace
+
+GmpStreamWriter::~GmpStreamWriter()
+{
+    close();
+}
+
+GmpResult GmpStreamWriter::open(const std::string &filePath, const std::vector<std::string> &metricNames)
+{
+    if (fd >= 0)
+    {
+        GMP_LOG_ERROR("Stream file is already open.");
+        return GmpResult::ERROR;
+    }
+    // Appending to an existing file continues the stream of an earlier run.
+    fd = ::open(filePath.c_str(), O_RDWR | O_CREAT | O_APPEND, 0644);
+    if (fd < 0)
+    {
+        GMP_LOG_ERROR("Failed to open stream file " + filePath + ": " + strerror(errno));
+        return GmpResult::ERROR;
+    }
+    path = filePath;
+    metrics = metricNames;
+    pending.clear();
+    pendingRangeCount = 0;
+    if (!truncateTornLine())
+    {
+        close();
+        return GmpResult::ERROR;
+    }
+
+    std::string header = makeHeader(metrics);
+    if (size == 0)
+    {
+        if (!writeAll(header) || fdatasync(fd) != 0)
+        {
+            GMP_LOG_ERROR("Failed to write the header of stream file " + path + ": " + strerror(errno));
+            close();
+            return GmpResult::ERROR;
+        }
+        return GmpResult::SUCCESS;
+    }
+    std::string existing(header.size(), '\0');
+    ssize_t result = pread(fd, &existing[0], existing.size(), 0);
+    if (result != static_cast<ssize_t>(existing.size()) || existing != header)
+    {
+        GMP_LOG_ERROR("Stream file " + path + " was written with other metrics, not appending to it.");
+        close();
+        return GmpResult::ERROR;
+    }
+    if (!readNextRangeIndex(header.size()))
+    {
+        close();
+        return GmpResult::ERROR;
+    }
+    return GmpResult::SUCCESS;
+}
+
+bool GmpStreamWriter::findLineStart(off_t end, off_t &lineStart)
+{
+    // Find the last newline before end, reading backwards.
+    char block[4096];
+    lineStart = 0;
+    for (off_t blockEnd = end; blockEnd > 0 && lineStart == 0;)
+    {
+        off_t blockStart = blockEnd > off_t(sizeof(block)) ? blockEnd - off_t(sizeof(block)) : 0;
+        ssize_t result = pread(fd, block, blockEnd - blockStart, blockStart);
+        if (result < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (result != blockEnd - blockStart)
+        {
+            GMP_LOG_ERROR("Failed to read stream file " + path + ": " + strerror(errno));
+            return false;
+        }
+        for (off_t i = result; i > 0; --i)
+        {
+            if (block[i - 1] == '\n')
+            {
+                lineStart = blockStart + i;
+                break;
+            }
+        }
+        blockEnd = blockStart;
+    }
+    return true;
+}
+
+bool GmpStreamWriter::readNextRangeIndex(size_t headerSize)
+{
+    nextRangeIndex = 0;
+    if (size <= headerSize)
+    {
+        return true;
+    }
+    // Continue after the range_index of the last committed row.
+    off_t lineStart = 0;
+    if (!findLineStart(static_cast<off_t>(size) - 1, lineStart))
+    {
+        return false;
+    }
+    char field[32] = {};
+    ssize_t result = pread(fd, field, sizeof(field) - 1, lineStart);
+    char *fieldEnd = nullptr;
+    unsigned long long lastIndex = result > 0 ? strtoull(field, &fieldEnd, 10) : 0;
+    if (result <= 0 || fieldEnd == field || *fieldEnd != ',')
+    {
+        GMP_LOG_ERROR("Last row of stream file " + path + " has no range index, not appending to it.");
+        return false;
+    }
+    nextRangeIndex = static_cast<size_t>(lastIndex) + 1;
+    return true;
+}
+
+bool GmpStreamWriter::truncateTornLine()
+{
+    off_t end = lseek(fd, 0, SEEK_END);
+    if (end < 0)
+    {
+        GMP_LOG_ERROR("Failed to seek stream file " + path + ": " + strerror(errno));
+        return false;
+    }
+    off_t lineEnd = 0;
+    if (!findLineStart(end, lineEnd))
+    {
+        return false;
+    }
+    if (lineEnd < end)
+    {
+        GMP_LOG_WARNING("Stream file " + path + " ends in a torn line, cutting " + std::to_string(end - lineEnd) +
+                        " bytes.");
+        if (ftruncate(fd, lineEnd) != 0)
+        {
+            GMP_LOG_ERROR("Failed to truncate stream file " + path + ": " + strerror(errno));
+            return false;
+        }
+    }
+    size = static_cast<uint64_t>(lineEnd);
+    return true;
+}
+
+void GmpStreamWriter::appendRange(const std::string &name, uint64_t startNs, uint64_t endNs, size_t kernelCount,
+                                  const std::unordered_map<std::string, double> &metricValues)
+{
+    char number[32];
+    snprintf(number, sizeof(number), "%zu,", nextRangeIndex + pendingRangeCount++);
+    pending += number;
+    appendCsvField(pending, name);
+    snprintf(number, sizeof(number), ",%" PRIu64 ",%" PRIu64 ",%zu", startNs, endNs, kernelCount);
+    pending += number;
+    for (const auto &metric : metrics)
+    {
+        pending += ',';
+        auto it = metricValues.find(metric);
+        if (it != metricValues.end())
+        {
+            snprintf(number, sizeof(number), "%.9g", it->second);
+            pending += number;
+        }
+    }
+    pending += '\n';
+}
+
+bool GmpStreamWriter::writeAll(const std::string &data)
+{
+    size_t written = 0;
+    while (written < data.size())
+    {
+        ssize_t result = write(fd, data.data() + written, data.size() - written);
+        if (result < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (result <= 0)
+        {
+            return false;
+        }
+        written += static_cast<size_t>(result);
+    }
+    size += data.size();
+    return true;
+}
+
+GmpResult GmpStreamWriter::commit()
+{
+    if (fd < 0)
+    {
+        return GmpResult::ERROR;
+    }
+    if (pending.empty())
+    {
+        return GmpResult::SUCCESS;
+    }
+    uint64_t committedSize = size;
+    if (!writeAll(pending) || fdatasync(fd) != 0)
+    {
+        GMP_LOG_ERROR("Failed to append to stream file " + path + ": " + strerror(errno));
+        // Do not leave half a window for the next one to be appended after.
+        if (ftruncate(fd, static_cast<off_t>(committedSize)) == 0)
+        {
+            size = committedSize;
+        }
+        pending.clear();
+        pendingRangeCount = 0;
+        return GmpResult::ERROR;
+    }
+    pending.clear();
+    nextRangeIndex += pendingRangeCount;
+    pendingRangeCount = 0;
+    return GmpResult::SUCCESS;
+}
+
+void GmpStreamWriter::close()
+{
+    if (fd < 0)
+    {
+        return;
+    }
+    ::close(fd);
+    fd = -1;
+    size = 0;
+    pending.clear();
+    nextRangeIndex = 0;
+    pendingRangeCount = 0;
+}
@@ -0,0 +1,55 @@
+#include "gmp/string_table.h"
+
+GmpStringTable &GmpStringTable::instance()
+{
+    static GmpStringTable table;
+    return table;
+}
+
+GmpStringTable::GmpStringTable()
+{
+    strings.emplace_back();
+    ids.emplace(std::string_view(strings.front()), 0);
+}
+
+uint32_t GmpStringTable::intern(std::string_view str)
+{
+    if (str.empty())
+    {
+        return 0;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = ids.find(str);
+    if (it != ids.end())
+    {
+        return it->second;
+    }
+    uint32_t id = static_cast<uint32_t>(strings.size());
+    // Deque elements never move, so the view used as key stays valid.
+    strings.emplace_back(str);
+    ids.emplace(std::string_view(strings.back()), id);
+    return id;
+}
+
+uint32_t GmpStringTable::intern(const char *str)
+{
+    return str ? intern(std::string_view(str)) : 0;
+}
+
+GmpRangeName GmpStringTable::internRangeName(std::string_view str, uint64_t hash)
+{
+    uint32_t id = intern(str);
+    return {&get(id), id, hash};
+}
+
+const std::string &GmpStringTable::get(uint32_t id) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return id < strings.size() ? strings[id] : strings.front();
+}
+
+size_t GmpStringTable::size() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return strings.size();
+}
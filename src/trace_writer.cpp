@@ -0,0 +1,200 @@
+#include <cinttypes>
+#include <cmath>
+#include "gmp/trace_writer.h"
+#include "gmp/log.h"
+
+GmpTraceWriter::GmpTraceWriter(size_t flushThreshold)
+    : flushThreshold(flushThreshold)
+{
+    buffer.reserve(flushThreshold + 4096);
+}
+
+GmpTraceWriter::~GmpTraceWriter()
+{
+    close();
+}
+
+bool GmpTraceWriter::open(const std::string &path)
+{
+    close();
+    file = fopen(path.c_str(), "w");
+    if (!file)
+    {
+        GMP_LOG_ERROR("Failed to open trace file: " + path);
+        return false;
+    }
+    eventCount = 0;
+    buffer.clear();
+    buffer += "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+    return true;
+}
+
+bool GmpTraceWriter::close()
+{
+    if (!file)
+    {
+        return true;
+    }
+    buffer += "\n]}\n";
+    flush();
+    bool ok = ferror(file) == 0;
+    ok &= fclose(file) == 0;
+    file = nullptr;
+    return ok;
+}
+
+void GmpTraceWriter::flush()
+{
+    if (file && !buffer.empty())
+    {
+        fwrite(buffer.data(), 1, buffer.size(), file);
+    }
+    buffer.clear();
+}
+
+void GmpTraceWriter::flushIfNeeded()
+{
+    if (buffer.size() >= flushThreshold)
+    {
+        flush();
+    }
+}
+
+void GmpTraceWriter::appendString(std::string_view str)
+{
+    buffer.push_back('"');
+    for (char c : str)
+    {
+        switch (c)
+        {
+        case '"':
+            buffer += "\\\"";
+            break;
+        case '\\':
+            buffer += "\\\\";
+            break;
+        case '\n':
+            buffer += "\\n";
+            break;
+        case '\t':
+            buffer += "\\t";
+            break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20)
+            {
+                char escaped[8];
+                snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                buffer += escaped;
+            }
+            else
+            {
+                buffer.push_back(c);
+            }
+            break;
+        }
+    }
+    buffer.push_back('"');
+}
+
+void GmpTraceWriter::appendTimestamp(uint64_t ns)
+{
+    char text[32];
+    snprintf(text, sizeof(text), "%" PRIu64 ".%03" PRIu64, ns / 1000, ns % 1000);
+    buffer += text;
+}
+
+void GmpTraceWriter::beginEvent(std::string_view name, std::string_view category, char phase, uint32_t pid, uint32_t tid,
+                                uint64_t timestampNs)
+{
+    if (eventCount++ > 0)
+    {
+        buffer += ",\n";
+    }
+    buffer += "{\"name\":";
+    appendString(name);
+    if (!category.empty())
+    {
+        buffer += ",\"cat\":";
+        appendString(category);
+    }
+    buffer += ",\"ph\":\"";
+    buffer.push_back(phase);
+    buffer += "\",\"pid\":" + std::to_string(pid) + ",\"tid\":" + std::to_string(tid) + ",\"ts\":";
+    appendTimestamp(timestampNs);
+    hasArgs = false;
+}
+
+void GmpTraceWriter::metadata(std::string_view type, uint32_t pid, uint32_t tid, std::string_view name)
+{
+    beginEvent(type, "", 'M', pid, tid, 0);
+    addArg("name", name);
+    endEvent();
+}
+
+void GmpTraceWriter::processName(uint32_t pid, std::string_view name)
+{
+    metadata("process_name", pid, 0, name);
+}
+
+void GmpTraceWriter::threadName(uint32_t pid, uint32_t tid, std::string_view name)
+{
+    metadata("thread_name", pid, tid, name);
+}
+
+void GmpTraceWriter::beginComplete(std::string_view name, std::string_view category, uint32_t pid, uint32_t tid,
+                                   uint64_t startNs, uint64_t durationNs)
+{
+    beginEvent(name, category, 'X', pid, tid, startNs);
+    buffer += ",\"dur\":";
+    appendTimestamp(durationNs);
+}
+
+void GmpTraceWriter::beginInstant(std::string_view name, std::string_view category, uint32_t pid, uint32_t tid,
+                                  uint64_t timestampNs)
+{
+    beginEvent(name, category, 'i', pid, tid, timestampNs);
+    buffer += ",\"s\":\"t\"";
+}
+
+void GmpTraceWriter::beginArg(std::string_view key)
+{
+    buffer += hasArgs ? "," : ",\"args\":{";
+    hasArgs = true;
+    appendString(key);
+    buffer.push_back(':');
+}
+
+void GmpTraceWriter::addArg(std::string_view key, std::string_view value)
+{
+    beginArg(key);
+    appendString(value);
+}
+
+void GmpTraceWriter::addArg(std::string_view key, uint64_t value)
+{
+    beginArg(key);
+    buffer += std::to_string(value);
+}
+
+void GmpTraceWriter::addArg(std::string_view key, double value)
+{
+    beginArg(key);
+    char text[32];
+    // JSON has no representation for NaN or infinity.
+    snprintf(text, sizeof(text), "%.6g", std::isfinite(value) ? value : 0.0);
+    buffer += text;
+}
+
+void GmpTraceWriter::endEvent()
+{
+    buffer += hasArgs ? "}}" : "}";
+    hasArgs = false;
+    flushIfNeeded();
+}
+
+void GmpTraceWriter::counter(std::string_view name, uint32_t pid, uint64_t timestampNs, std::string_view series, double value)
+{
+    beginEvent(name, "", 'C', pid, 0, timestampNs);
+    addArg(series, value);
+    endEvent();
+}
@@ -0,0 +1,165 @@
+#include <algorithm>
+#include "gmp/transfer_stats.h"
+
+const char *gmpTransferDirectionName(GmpTransferDirection direction)
+{
+    switch (direction)
+    {
+    case GmpTransferDirection::HOST_TO_DEVICE:
+        return "HtoD";
+    case GmpTransferDirection::DEVICE_TO_HOST:
+        return "DtoH";
+    case GmpTransferDirection::DEVICE_TO_DEVICE:
+        return "DtoD";
+    case GmpTransferDirection::HOST_TO_HOST:
+        return "HtoH";
+    case GmpTransferDirection::PEER_TO_PEER:
+        return "PtoP";
+    case GmpTransferDirection::MEMSET:
+        return "Memset";
+    default:
+        return "Unknown";
+    }
+}
+
+GmpTransferDirection gmpTransferDirectionOf(const GmpTransferData &transfer)
+{
+    if (transfer.isMemset())
+    {
+        return GmpTransferDirection::MEMSET;
+    }
+    switch (transfer.copyKind)
+    {
+    case CUPTI_ACTIVITY_MEMCPY_KIND_HTOD:
+    case CUPTI_ACTIVITY_MEMCPY_KIND_HTOA:
+        return GmpTransferDirection::HOST_TO_DEVICE;
+    case CUPTI_ACTIVITY_MEMCPY_KIND_DTOH:
+    case CUPTI_ACTIVITY_MEMCPY_KIND_ATOH:
+        return GmpTransferDirection::DEVICE_TO_HOST;
+    case CUPTI_ACTIVITY_MEMCPY_KIND_DTOD:
+    case CUPTI_ACTIVITY_MEMCPY_KIND_ATOA:
+    case CUPTI_ACTIVITY_MEMCPY_KIND_ATOD:
+    case CUPTI_ACTIVITY_MEMCPY_KIND_DTOA:
+        return GmpTransferDirection::DEVICE_TO_DEVICE;
+    case CUPTI_ACTIVITY_MEMCPY_KIND_HTOH:
+        return GmpTransferDirection::HOST_TO_HOST;
+    case CUPTI_ACTIVITY_MEMCPY_KIND_PTOP:
+        return GmpTransferDirection::PEER_TO_PEER;
+    default:
+        return GmpTransferDirection::UNKNOWN;
+    }
+}
+
+size_t GmpTransferStats::sizeBucket(uint64_t bytes)
+{
+    size_t bucket = 0;
+    for (uint64_t limit = 4096; bucket + 1 < SIZE_BUCKET_COUNT && bytes >= limit; limit *= 16)
+    {
+        bucket++;
+    }
+    return bucket;
+}
+
+const char *GmpTransferStats::sizeBucketName(size_t bucket)
+{
+    static const char *names[SIZE_BUCKET_COUNT] = {"< 4 KiB", "4-64 KiB", "64 KiB-1 MiB",
+                                                   "1-16 MiB", "16-256 MiB", ">= 256 MiB"};
+    return bucket < SIZE_BUCKET_COUNT ? names[bucket] : "";
+}
+
+void GmpTransferAnalyzer::mergeIntervals(std::vector<GmpTimeInterval> &intervals)
+{
+    std::sort(intervals.begin(), intervals.end(), [](const GmpTimeInterval &a, const GmpTimeInterval &b)
+              { return a.start < b.start; });
+    size_t merged = 0;
+    for (size_t i = 0; i < intervals.size(); ++i)
+    {
+        if (merged > 0 && intervals[i].start <= intervals[merged - 1].end)
+        {
+            intervals[merged - 1].end = std::max(intervals[merged - 1].end, intervals[i].end);
+        }
+        else
+        {
+            intervals[merged++] = intervals[i];
+        }
+    }
+    intervals.resize(merged);
+}
+
+GmpTransferStats GmpTransferAnalyzer::analyze(const std::string &name, const GmpRecordList<GmpTransferData> &transfers,
+                                              const GmpRecordList<GmpTimeInterval> &computeIntervals) const
+{
+    GmpTransferStats stats;
+    stats.name = name;
+    stats.transferCount = transfers.size();
+    stats.kernelCount = computeIntervals.size();
+
+    std::vector<GmpTimeInterval> copies;
+    copies.reserve(transfers.size());
+    for (const auto &transfer : transfers)
+    {
+        auto &direction = stats.directions[static_cast<size_t>(gmpTransferDirectionOf(transfer))];
+        uint64_t duration = transfer.end > transfer.start ? transfer.end - transfer.start : 0;
+        direction.count++;
+        direction.bytes += transfer.bytes;
+        direction.durationNs += duration;
+        stats.totalBytes += transfer.bytes;
+        stats.sizeHistogram[GmpTransferStats::sizeBucket(transfer.bytes)]++;
+        if (transfer.isMemset())
+        {
+            continue;
+        }
+        if (transfer.srcKind == CUPTI_ACTIVITY_MEMORY_KIND_PAGEABLE || transfer.dstKind == CUPTI_ACTIVITY_MEMORY_KIND_PAGEABLE)
+        {
+            stats.pageableCount++;
+            stats.pageableBytes += transfer.bytes;
+        }
+        if (duration > 0)
+        {
+            copies.push_back({transfer.start, transfer.end});
+        }
+    }
+
+    mergeIntervals(copies);
+    for (const auto &copy : copies)
+    {
+        stats.copyBusyNs += copy.end - copy.start;
+    }
+    if (copies.empty() || computeIntervals.empty())
+    {
+        return stats;
+    }
+
+    std::vector<GmpTimeInterval> kernels;
+    kernels.reserve(computeIntervals.size());
+    for (const auto &kernel : computeIntervals)
+    {
+        if (kernel.end > kernel.start)
+        {
+            kernels.push_back(kernel);
+        }
+    }
+    mergeIntervals(kernels);
+
+    // Both lists are disjoint and sorted, walk them together.
+    size_t copyIdx = 0;
+    size_t kernelIdx = 0;
+    while (copyIdx < copies.size() && kernelIdx < kernels.size())
+    {
+        uint64_t start = std::max(copies[copyIdx].start, kernels[kernelIdx].start);
+        uint64_t end = std::min(copies[copyIdx].end, kernels[kernelIdx].end);
+        if (end > start)
+        {
+            stats.overlapNs += end - start;
+        }
+        if (copies[copyIdx].end < kernels[kernelIdx].end)
+        {
+            copyIdx++;
+        }
+        else
+        {
+            kernelIdx++;
+        }
+    }
+    return stats;
+}
@@ -0,0 +1,335 @@
+// gmp_diff: compare two GMP result.csv files and gate performance regressions.
+//
+// Exit status: 0 if every change is within budget, 1 if a budget is exceeded
+// (or rows are missing with --fail-on-missing), 2 on usage or I/O errors.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <future>
+#include <string>
+#include "gmp/result_diff.h"
+
+namespace
+{
+    constexpr int EXIT_PASS = 0;
+    constexpr int EXIT_REGRESSION = 1;
+    constexpr int EXIT_USAGE = 2;
+
+    void printUsage(const char *program)
+    {
+        fprintf(stderr,
+                "Usage: %s [options] <baseline.csv> <candidate.csv>\n"
+                "\n"
+                "Rows are joined on config name, range name, metric and the occurrence of\n"
+                "that triple in the file, so repeated ranges are compared iteration by iteration.\n"
+                "\n"
+                "Options:\n"
+                "  --abs-noise <value>         Absolute changes up to value are noise (default 0)\n"
+                "  --rel-noise <percent>       Relative changes up to percent are noise (default 1)\n"
+                "  --sigma <k>                 Summary rows: changes within k combined stddevs are noise (default 3)\n"
+                "  --budget [metric=][+|-]<percent>\n"
+                "                              Fail if a change, noise included, exceeds percent. '+' only\n"
+                "                              counts increases, '-' only decreases. Without a metric the\n"
+                "                              budget applies to every metric. Repeatable.\n"
+                "  --fail-on-missing           Fail if a row exists in only one of the files\n"
+                "  --top <n>                   Print the n largest relative changes (default 20)\n"
+                "  --csv <path>                Write every joined row with its deltas and status\n"
+                "  --quiet                     Only print the summary\n",
+                program);
+    }
+
+    bool parseNumber(const char *text, double &value)
+    {
+        char *end = nullptr;
+        value = strtod(text, &end);
+        return end != text && *end == '\0';
+    }
+
+    bool parseBudget(const char *text, GmpDiffBudget &budget)
+    {
+        std::string spec(text);
+        size_t equals = spec.rfind('=');
+        budget.metric = equals == std::string::npos ? "*" : spec.substr(0, equals);
+        std::string limit = equals == std::string::npos ? spec : spec.substr(equals + 1);
+        if (!limit.empty() && (limit[0] == '+' || limit[0] == '-'))
+        {
+            budget.direction = limit[0] == '+' ? GmpBudgetDirection::INCREASE : GmpBudgetDirection::DECREASE;
+            limit.erase(0, 1);
+        }
+        if (!limit.empty() && limit.back() == '%')
+        {
+            limit.pop_back();
+        }
+        double percent = 0.0;
+        if (budget.metric.empty() || !parseNumber(limit.c_str(), percent) || percent < 0.0)
+        {
+            return false;
+        }
+        budget.maxRelative = percent / 100.0;
+        return true;
+    }
+
+    std::string formatRelative(double relDelta)
+    {
+        if (std::isinf(relDelta))
+        {
+            return relDelta > 0 ? "+inf" : "-inf";
+        }
+        char text[32];
+        snprintf(text, sizeof(text), "%+.2f%%", 100.0 * relDelta);
+        return text;
+    }
+
+    // Quote a field if it would break the CSV row.
+    void writeField(FILE *file, std::string_view field)
+    {
+        if (field.find_first_of(",\"\n") == std::string_view::npos)
+        {
+            fwrite(field.data(), 1, field.size(), file);
+            return;
+        }
+        fputc('"', file);
+        for (char c : field)
+        {
+            if (c == '"')
+            {
+                fputc('"', file);
+            }
+            fputc(c, file);
+        }
+        fputc('"', file);
+    }
+
+    bool writeCsv(const std::string &path, const GmpDiffReport &report)
+    {
+        FILE *file = fopen(path.c_str(), "w");
+        if (!file)
+        {
+            return false;
+        }
+        // 1 MiB stdio buffer, the report can have millions of rows.
+        setvbuf(file, nullptr, _IOFBF, 1 << 20);
+        fputs("config,range,occurrence,metric,base,new,abs_delta,rel_delta,status\n", file);
+        for (const auto &entry : report.entries)
+        {
+            const GmpResultRow &row = entry.base ? *entry.base : *entry.current;
+            writeField(file, row.config);
+            fputc(',', file);
+            writeField(file, row.range);
+            fprintf(file, ",%u,", row.occurrence);
+            writeField(file, row.metric);
+            if (entry.base && entry.current)
+            {
+                fprintf(file, ",%.17g,%.17g,%.17g,%.17g,", entry.base->value, entry.current->value,
+                        entry.absDelta, entry.relDelta);
+            }
+            else if (entry.base)
+            {
+                fprintf(file, ",%.17g,,,,", entry.base->value);
+            }
+            else
+            {
+                fprintf(file, ",,%.17g,,,", entry.current->value);
+            }
+            fputs(gmpDiffStatusName(entry.status), file);
+            fputc('\n', file);
+        }
+        return fclose(file) == 0;
+    }
+
+    void printTopChanges(const GmpDiffReport &report, size_t topN)
+    {
+        std::vector<const GmpDiffEntry *> changes;
+        for (const auto &entry : report.entries)
+        {
+            if (entry.status == GmpDiffStatus::CHANGED || entry.status == GmpDiffStatus::OVER_BUDGET)
+            {
+                changes.push_back(&entry);
+            }
+        }
+        topN = std::min(topN, changes.size());
+        std::partial_sort(changes.begin(), changes.begin() + topN, changes.end(),
+                          [](const GmpDiffEntry *a, const GmpDiffEntry *b)
+                          { return std::fabs(a->relDelta) > std::fabs(b->relDelta); });
+
+        if (topN == 0)
+        {
+            return;
+        }
+        printf("%-12s %-32s %-40s %16s %16s %10s\n", "status", "range", "metric", "base", "new", "change");
+        for (size_t i = 0; i < topN; ++i)
+        {
+            const GmpDiffEntry &entry = *changes[i];
+            std::string range(entry.base->range);
+            if (entry.base->occurrence > 0)
+            {
+                range += "#" + std::to_string(entry.base->occurrence);
+            }
+            printf("%-12s %-32.32s %-40.*s %16.4g %16.4g %10s\n", gmpDiffStatusName(entry.status), range.c_str(),
+                   static_cast<int>(std::min<size_t>(entry.base->metric.size(), 40)), entry.base->metric.data(),
+                   entry.base->value, entry.current->value, formatRelative(entry.relDelta).c_str());
+        }
+        printf("\n");
+    }
+
+    void printMissing(const GmpDiffReport &report, size_t maxRows)
+    {
+        size_t printed = 0;
+        for (const auto &entry : report.entries)
+        {
+            if (entry.base && entry.current)
+            {
+                continue;
+            }
+            if (printed++ == maxRows)
+            {
+                printf("...\n");
+                break;
+            }
+            const GmpResultRow &row = entry.base ? *entry.base : *entry.current;
+            printf("%-12s %.*s / %.*s #%u / %.*s\n", gmpDiffStatusName(entry.status),
+                   static_cast<int>(row.config.size()), row.config.data(),
+                   static_cast<int>(row.range.size()), row.range.data(), row.occurrence,
+                   static_cast<int>(row.metric.size()), row.metric.data());
+        }
+        if (printed > 0)
+        {
+            printf("\n");
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    GmpDiffOptions options;
+    size_t topN = 20;
+    std::string csvPath;
+    bool quiet = false;
+    std::vector<const char *> inputs;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const char *arg = argv[i];
+        auto nextNumber = [&](double &value)
+        {
+            if (i + 1 >= argc || !parseNumber(argv[i + 1], value))
+            {
+                fprintf(stderr, "%s expects a number\n", arg);
+                return false;
+            }
+            i++;
+            return true;
+        };
+
+        double number = 0.0;
+        if (strcmp(arg, "--abs-noise") == 0)
+        {
+            if (!nextNumber(options.absNoise))
+            {
+                return EXIT_USAGE;
+            }
+        }
+        else if (strcmp(arg, "--rel-noise") == 0)
+        {
+            if (!nextNumber(number))
+            {
+                return EXIT_USAGE;
+            }
+            options.relNoise = number / 100.0;
+        }
+        else if (strcmp(arg, "--sigma") == 0)
+        {
+            if (!nextNumber(options.sigma))
+            {
+                return EXIT_USAGE;
+            }
+        }
+        else if (strcmp(arg, "--budget") == 0)
+        {
+            GmpDiffBudget budget;
+            if (i + 1 >= argc || !parseBudget(argv[i + 1], budget))
+            {
+                fprintf(stderr, "--budget expects [metric=][+|-]<percent>\n");
+                return EXIT_USAGE;
+            }
+            options.budgets.push_back(budget);
+            i++;
+        }
+        else if (strcmp(arg, "--fail-on-missing") == 0)
+        {
+            options.failOnMissing = true;
+        }
+        else if (strcmp(arg, "--top") == 0)
+        {
+            if (!nextNumber(number) || number < 0)
+            {
+                return EXIT_USAGE;
+            }
+            topN = static_cast<size_t>(number);
+        }
+        else if (strcmp(arg, "--csv") == 0 && i + 1 < argc)
+        {
+            csvPath = argv[++i];
+        }
+        else if (strcmp(arg, "--quiet") == 0)
+        {
+            quiet = true;
+        }
+        else if (strcmp(arg, "--help") == 0 || strcmp(arg, "-h") == 0)
+        {
+            printUsage(argv[0]);
+            return EXIT_PASS;
+        }
+        else if (arg[0] == '-' && arg[1] != '\0')
+        {
+            fprintf(stderr, "Unknown option: %s\n", arg);
+            printUsage(argv[0]);
+            return EXIT_USAGE;
+        }
+        else
+        {
+            inputs.push_back(arg);
+        }
+    }
+    if (inputs.size() != 2)
+    {
+        printUsage(argv[0]);
+        return EXIT_USAGE;
+    }
+
+    // Parse both files concurrently.
+    GmpResultSet base;
+    GmpResultSet current;
+    auto baseLoaded = std::async(std::launch::async, [&]() { return base.load(inputs[0]); });
+    GmpResult currentResult = current.load(inputs[1]);
+    if (baseLoaded.get() != GmpResult::SUCCESS || currentResult != GmpResult::SUCCESS)
+    {
+        return EXIT_USAGE;
+    }
+
+    GmpDiffReport report = gmpDiffResults(base, current, options);
+    bool failed = gmpDiffFailed(report, options);
+
+    if (!quiet)
+    {
+        printTopChanges(report, topN);
+        printMissing(report, topN);
+    }
+    printf("Compared %zu baseline and %zu candidate rows: %zu unchanged, %zu noise, %zu changed, "
+           "%zu over budget, %zu only in baseline, %zu only in candidate\n",
+           base.getRows().size(), current.getRows().size(), report.count(GmpDiffStatus::UNCHANGED),
+           report.count(GmpDiffStatus::NOISE), report.count(GmpDiffStatus::CHANGED),
+           report.count(GmpDiffStatus::OVER_BUDGET), report.count(GmpDiffStatus::ONLY_BASE),
+           report.count(GmpDiffStatus::ONLY_NEW));
+
+    if (!csvPath.empty() && !writeCsv(csvPath, report))
+    {
+        fprintf(stderr, "Failed to write %s\n", csvPath.c_str());
+        return EXIT_USAGE;
+    }
+    printf("%s\n", failed ? "FAIL" : "PASS");
+    return failed ? EXIT_REGRESSION : EXIT_PASS;
+}
@@ -0,0 +1,263 @@
+// gmp_replay: rebuild the reports of a run captured with setSpillFile().
+//
+// The spill file holds the raw CUPTI activity buffers, the range boundaries
+// and the counter data image of the run, so it can be processed later, on a
+// machine without a GPU, and again whenever a new analysis is added.
+//
+// Exit status: 0 on success, 1 if the spill file cannot be read or is malformed,
+// 2 on usage errors or if the trace cannot be written.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include "gmp/profile.h"
+
+namespace
+{
+    constexpr int EXIT_OK = 0;
+    constexpr int EXIT_REPLAY_FAILED = 1;
+    constexpr int EXIT_USAGE = 2;
+
+    void printUsage(const char *program)
+    {
+        fprintf(stderr,
+                "Usage: %s [options] <spill file>\n"
+                "\n"
+                "Without report options the hot kernels and the kernel timeline are printed.\n"
+                "\n"
+                "Options:\n"
+                "  --config <name>             Print the range metrics and write output/result.csv\n"
+                "                              under this config name (needs counter data)\n"
+                "  --reduction sum|max|mean    Reduction of per-kernel metrics (default sum)\n"
+                "  --no-kernel-detail          Fold auto range metrics per range while evaluating\n"
+                "  --memory-budget <MiB>       Spill the records of older ranges to a temporary file\n"
+                "  --summary                   Write one summary row per range name to result.csv\n"
+                "  --stats                     Print range statistics across iterations\n"
+                "  --hot <n>                   Print the top n kernels\n"
+                "  --timeline                  Print the kernel timeline of every range\n"
+                "  --memory                    Print the memory activity and footprint\n"
+                "  --transfers                 Print the memcpy/memset statistics\n"
+                "  --unified-memory            Print the unified memory migrations and page faults\n"
+                "  --roofline                  Print the roofline of the ranges and kernels\n"
+                "  --roofline-csv <path>       Write the roofline of the ranges and kernels as CSV\n"
+                "  --bottlenecks               Print the ranked stall reasons of the ranges and kernels\n"
+                "  --trace <path>              Write a Chrome JSON trace\n",
+                program);
+    }
+
+    bool parseReduction(const char *text, GmpOutputKernelReduction &option)
+    {
+        if (strcmp(text, "sum") == 0)
+        {
+            option = GmpOutputKernelReduction::SUM;
+        }
+        else if (strcmp(text, "max") == 0)
+        {
+            option = GmpOutputKernelReduction::MAX;
+        }
+        else if (strcmp(text, "mean") == 0)
+        {
+            option = GmpOutputKernelReduction::MEAN;
+        }
+        else
+        {
+            return false;
+        }
+        return true;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    std::string configName;
+    std::string tracePath;
+    GmpOutputKernelReduction reduction = GmpOutputKernelReduction::SUM;
+    bool keepKernelDetail = true;
+    bool summary = false;
+    bool stats = false;
+    bool timeline = false;
+    bool memory = false;
+    bool transfers = false;
+    bool unifiedMemory = false;
+    bool roofline = false;
+    std::string rooflinePath;
+    bool bottlenecks = false;
+    size_t hotKernels = 0;
+    size_t memoryBudgetMb = 0;
+    const char *input = nullptr;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const char *arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (strcmp(arg, "--config") == 0 && hasValue)
+        {
+            configName = argv[++i];
+        }
+        else if (strcmp(arg, "--reduction") == 0 && hasValue)
+        {
+            if (!parseReduction(argv[++i], reduction))
+            {
+                fprintf(stderr, "--reduction expects sum, max or mean\n");
+                return EXIT_USAGE;
+            }
+        }
+        else if (strcmp(arg, "--memory-budget") == 0 && hasValue)
+        {
+            char *end = nullptr;
+            memoryBudgetMb = strtoull(argv[++i], &end, 10);
+            if (*end != '\0')
+            {
+                fprintf(stderr, "--memory-budget expects a size in MiB\n");
+                return EXIT_USAGE;
+            }
+        }
+        else if (strcmp(arg, "--no-kernel-detail") == 0)
+        {
+            keepKernelDetail = false;
+        }
+        else if (strcmp(arg, "--summary") == 0)
+        {
+            summary = true;
+        }
+        else if (strcmp(arg, "--stats") == 0)
+        {
+            stats = true;
+        }
+        else if (strcmp(arg, "--hot") == 0 && hasValue)
+        {
+            char *end = nullptr;
+            hotKernels = strtoul(argv[++i], &end, 10);
+            if (*end != '\0')
+            {
+                fprintf(stderr, "--hot expects a count\n");
+                return EXIT_USAGE;
+            }
+        }
+        else if (strcmp(arg, "--timeline") == 0)
+        {
+            timeline = true;
+        }
+        else if (strcmp(arg, "--memory") == 0)
+        {
+            memory = true;
+        }
+        else if (strcmp(arg, "--transfers") == 0)
+        {
+            transfers = true;
+        }
+        else if (strcmp(arg, "--unified-memory") == 0)
+        {
+            unifiedMemory = true;
+        }
+        else if (strcmp(arg, "--roofline") == 0)
+        {
+            roofline = true;
+        }
+        else if (strcmp(arg, "--roofline-csv") == 0 && hasValue)
+        {
+            rooflinePath = argv[++i];
+        }
+        else if (strcmp(arg, "--bottlenecks") == 0)
+        {
+            bottlenecks = true;
+        }
+        else if (strcmp(arg, "--trace") == 0 && hasValue)
+        {
+            tracePath = argv[++i];
+        }
+        else if (strcmp(arg, "--help") == 0 || strcmp(arg, "-h") == 0)
+        {
+            printUsage(argv[0]);
+            return EXIT_OK;
+        }
+        else if (arg[0] == '-' && arg[1] != '\0')
+        {
+            fprintf(stderr, "Unknown option or missing value: %s\n", arg);
+            printUsage(argv[0]);
+            return EXIT_USAGE;
+        }
+        else if (!input)
+        {
+            input = arg;
+        }
+        else
+        {
+            printUsage(argv[0]);
+            return EXIT_USAGE;
+        }
+    }
+    if (!input)
+    {
+        printUsage(argv[0]);
+        return EXIT_USAGE;
+    }
+    bool anyReport = !configName.empty() || stats || hotKernels > 0 || timeline || memory || transfers ||
+                     unifiedMemory || roofline || !rooflinePath.empty() || bottlenecks ||
+                     !tracePath.empty();
+    if (!anyReport)
+    {
+        hotKernels = 10;
+        timeline = true;
+    }
+
+    GmpProfiler *profiler = GmpProfiler::getInstance();
+    profiler->setKernelDetail(keepKernelDetail);
+    profiler->setRangeSummary(summary);
+    if (memoryBudgetMb > 0)
+    {
+        profiler->setMemoryBudget(memoryBudgetMb << 20);
+    }
+    if (profiler->replaySpill(input) != GmpResult::SUCCESS)
+    {
+        return EXIT_REPLAY_FAILED;
+    }
+
+    if (!configName.empty())
+    {
+        profiler->printProfilerRanges(configName, reduction);
+    }
+    if (stats)
+    {
+        profiler->printRangeStatistics(reduction);
+    }
+    if (hotKernels > 0)
+    {
+        profiler->printHotKernels(hotKernels);
+    }
+    if (timeline)
+    {
+        profiler->printKernelTimeline();
+    }
+    if (memory)
+    {
+        profiler->printMemoryActivity();
+        profiler->printMemoryFootprint();
+    }
+    if (transfers)
+    {
+        profiler->printTransferStats();
+    }
+    if (unifiedMemory)
+    {
+        profiler->printUnifiedMemorySummary();
+    }
+    if (roofline)
+    {
+        profiler->printRoofline();
+    }
+    if (!rooflinePath.empty() && profiler->exportRooflineCsv(rooflinePath) != GmpResult::SUCCESS)
+    {
+        return EXIT_USAGE;
+    }
+    if (bottlenecks)
+    {
+        profiler->printBottlenecks();
+    }
+    if (!tracePath.empty() && profiler->exportTrace(tracePath) != GmpResult::SUCCESS)
+    {
+        return EXIT_USAGE;
+    }
+    return EXIT_OK;
+}
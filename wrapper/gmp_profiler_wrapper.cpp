@@ -2,6 +2,7 @@
 #include <pybind11/stl.h>
 #include <pybind11/stl_bind.h>
 #include <pybind11/numpy.h>
+#include <unistd.h>
 #include "gmp/profile.h"
 #include "gmp/data_struct.h"
 
@@ -21,6 +22,83 @@ public:
         profiler->init();
     }
     
+    void init_async() {
+        profiler->initAsync();
+    }
+    
+    int set_config_cache(bool enabled, const std::string& directory) {
+        return static_cast<int>(profiler->setConfigCache(enabled, directory));
+    }
+    
+    int set_spill_file(const std::string& path) {
+        return static_cast<int>(profiler->setSpillFile(path));
+    }
+    
+    int set_memory_budget(size_t budget_bytes, const std::string& spill_path) {
+        return static_cast<int>(profiler->setMemoryBudget(budget_bytes, spill_path));
+    }
+    
+    py::dict get_session_storage_stats() {
+        auto stats = profiler->getSessionStorageStats();
+        py::dict stats_dict;
+        stats_dict["memory_budget"] = stats.memoryBudget;
+        stats_dict["resident_bytes"] = stats.residentBytes;
+        stats_dict["spilled_sessions"] = stats.spilledSessions;
+        stats_dict["spilled_bytes"] = stats.spilledBytes;
+        stats_dict["page_ins"] = stats.pageIns;
+        return stats_dict;
+    }
+    
+    py::dict get_session_arena_stats() {
+        auto stats = profiler->getSessionArenaStats();
+        py::dict stats_dict;
+        stats_dict["chunks"] = stats.chunks;
+        stats_dict["chunk_bytes"] = stats.chunkBytes;
+        stats_dict["allocations"] = stats.allocations;
+        stats_dict["reuses"] = stats.reuses;
+        stats_dict["bytes_in_use"] = stats.bytesInUse;
+        stats_dict["resets"] = stats.resets;
+        return stats_dict;
+    }
+    
+    int enable_streaming(const std::string& path, size_t range_interval, double interval_seconds, int reduction) {
+        GmpStreamingConfig config;
+        config.path = path;
+        config.rangeInterval = range_interval;
+        config.intervalSeconds = interval_seconds;
+        config.reduction = static_cast<GmpOutputKernelReduction>(reduction);
+        return static_cast<int>(profiler->enableStreaming(config));
+    }
+    
+    int flush_streaming_window() {
+        return static_cast<int>(profiler->flushStreamingWindow());
+    }
+    
+    int close_streaming() {
+        return static_cast<int>(profiler->closeStreaming());
+    }
+    
+    py::dict get_streaming_stats() {
+        auto stats = profiler->getStreamingStats();
+        py::dict stats_dict;
+        stats_dict["windows"] = stats.windows;
+        stats_dict["ranges"] = stats.ranges;
+        stats_dict["bytes_written"] = stats.bytesWritten;
+        return stats_dict;
+    }
+    
+    int set_unified_memory_counters(bool enabled) {
+        return static_cast<int>(profiler->setUnifiedMemoryCounters(enabled));
+    }
+    
+    int close_spill() {
+        return static_cast<int>(profiler->closeSpill());
+    }
+    
+    int replay_spill(const std::string& path) {
+        return static_cast<int>(profiler->replaySpill(path));
+    }
+    
     void enable() {
         profiler->enable();
     }
@@ -49,9 +127,9 @@ public:
         return static_cast<int>(result);
     }
     
-    void print_profiler_ranges(int output_reduction_option = 0) {
+    void print_profiler_ranges(int output_reduction_option = 0, std::string config_name = "default") {
         GmpOutputKernelReduction option = static_cast<GmpOutputKernelReduction>(output_reduction_option);
-        profiler->printProfilerRanges(option);
+        profiler->printProfilerRanges(config_name, option);
     }
     
     void print_memory_activity() {
@@ -69,19 +147,19 @@ public:
             py::list mem_operations;
             for (const auto& mem_data : range_data.memDataInRange) {
                 py::dict mem_dict;
-                mem_dict["name"] = mem_data.name ? std::string(mem_data.name) : "";
-                mem_dict["memory_operation_type"] = static_cast<int>(mem_data.memoryOperationType);
-                mem_dict["memory_kind"] = static_cast<int>(mem_data.memoryKind);
+                mem_dict["name"] = std::string(mem_data.name());
+                mem_dict["memory_operation_type"] = static_cast<int>(mem_data.memoryOperationType());
+                mem_dict["memory_kind"] = static_cast<int>(mem_data.memoryKind());
                 mem_dict["correlation_id"] = mem_data.correlationId;
                 mem_dict["address"] = mem_data.address;
                 mem_dict["bytes"] = mem_data.bytes;
                 mem_dict["timestamp"] = mem_data.timestamp;
-                mem_dict["process_id"] = mem_data.processId;
+                mem_dict["process_id"] = static_cast<uint32_t>(getpid());
                 mem_dict["device_id"] = mem_data.deviceId;
                 mem_dict["context_id"] = mem_data.contextId;
                 mem_dict["stream_id"] = mem_data.streamId;
-                mem_dict["is_async"] = static_cast<bool>(mem_data.isAsync);
-                mem_dict["source"] = mem_data.source ? std::string(mem_data.source) : "";
+                mem_dict["is_async"] = mem_data.isAsync();
+                mem_dict["source"] = std::string(mem_data.source());
                 
                 mem_operations.append(mem_dict);
             }
@@ -92,6 +170,273 @@ public:
         return result;
     }
     
+    void print_memory_footprint() {
+        profiler->printMemoryFootprint();
+    }
+    
+    py::dict get_memory_footprint() {
+        auto timeline = profiler->getMemoryFootprint();
+        py::dict result;
+        
+        py::list ranges;
+        for (const auto& footprint : timeline.getRangeFootprints()) {
+            py::dict range_dict;
+            range_dict["name"] = footprint.name;
+            range_dict["live_bytes_at_start"] = footprint.liveBytesAtStart;
+            range_dict["live_bytes_at_end"] = footprint.liveBytesAtEnd;
+            range_dict["peak_live_bytes"] = footprint.peakLiveBytes;
+            range_dict["high_water_mark"] = footprint.highWaterMark;
+            range_dict["allocated_bytes"] = footprint.allocatedBytes;
+            range_dict["released_bytes"] = footprint.releasedBytes;
+            
+            py::list leaked;
+            for (const auto& allocation : footprint.leakedAllocations) {
+                py::dict allocation_dict;
+                allocation_dict["address"] = allocation.address;
+                allocation_dict["bytes"] = allocation.bytes;
+                allocation_dict["timestamp"] = allocation.timestamp;
+                leaked.append(allocation_dict);
+            }
+            range_dict["leaked_allocations"] = leaked;
+            ranges.append(range_dict);
+        }
+        
+        py::list points;
+        for (const auto& point : timeline.getTimeline()) {
+            points.append(py::make_tuple(point.timestamp, point.liveBytes));
+        }
+        
+        result["ranges"] = ranges;
+        result["timeline"] = points;
+        result["high_water_mark"] = timeline.getHighWaterMark();
+        result["live_bytes"] = timeline.getLiveBytes();
+        return result;
+    }
+    
+    void print_kernel_timeline(size_t max_reported_gaps) {
+        profiler->printKernelTimeline(max_reported_gaps);
+    }
+    
+    py::list get_kernel_timeline(size_t max_reported_gaps) {
+        py::list result;
+        for (const auto& stats : profiler->getKernelTimeline(max_reported_gaps)) {
+            py::dict range_dict;
+            range_dict["name"] = stats.name;
+            range_dict["kernel_count"] = stats.kernelCount;
+            range_dict["span_ns"] = stats.spanNs;
+            range_dict["busy_ns"] = stats.busyNs;
+            range_dict["idle_ns"] = stats.idleNs;
+            range_dict["overlap_ns"] = stats.overlapNs;
+            range_dict["max_concurrency"] = stats.maxConcurrency;
+            range_dict["concurrency_histogram_ns"] = stats.concurrencyHistogram;
+            range_dict["idle_gap_count"] = stats.idleGapCount;
+            
+            py::list gaps;
+            for (const auto& gap : stats.longestGaps) {
+                gaps.append(py::make_tuple(gap.start, gap.end));
+            }
+            range_dict["longest_gaps"] = gaps;
+            result.append(range_dict);
+        }
+        return result;
+    }
+    
+    void print_transfer_stats() {
+        profiler->printTransferStats();
+    }
+    
+    py::list get_transfer_stats() {
+        py::list result;
+        for (const auto& stats : profiler->getTransferStats()) {
+            py::dict range_dict;
+            range_dict["name"] = stats.name;
+            range_dict["transfer_count"] = stats.transferCount;
+            range_dict["total_bytes"] = stats.totalBytes;
+            
+            py::dict directions;
+            for (size_t i = 0; i < stats.directions.size(); ++i) {
+                const auto& direction = stats.directions[i];
+                if (direction.count == 0) {
+                    continue;
+                }
+                py::dict direction_dict;
+                direction_dict["count"] = direction.count;
+                direction_dict["bytes"] = direction.bytes;
+                direction_dict["duration_ns"] = direction.durationNs;
+                direction_dict["bandwidth_gbps"] = direction.bandwidth();
+                directions[py::str(gmpTransferDirectionName(static_cast<GmpTransferDirection>(i)))] = direction_dict;
+            }
+            range_dict["directions"] = directions;
+            
+            py::dict histogram;
+            for (size_t bucket = 0; bucket < GmpTransferStats::SIZE_BUCKET_COUNT; ++bucket) {
+                histogram[py::str(GmpTransferStats::sizeBucketName(bucket))] = stats.sizeHistogram[bucket];
+            }
+            range_dict["size_histogram"] = histogram;
+            range_dict["pageable_count"] = stats.pageableCount;
+            range_dict["pageable_bytes"] = stats.pageableBytes;
+            range_dict["kernel_count"] = stats.kernelCount;
+            range_dict["copy_busy_ns"] = stats.copyBusyNs;
+            range_dict["overlap_ns"] = stats.overlapNs;
+            result.append(range_dict);
+        }
+        return result;
+    }
+    
+    void print_unified_memory_summary() {
+        profiler->printUnifiedMemorySummary();
+    }
+    
+    py::list get_unified_memory_summary() {
+        py::list result;
+        for (const auto& range : profiler->getUnifiedMemorySummary()) {
+            const auto& summary = range.summary;
+            py::dict range_dict;
+            range_dict["name"] = range.name;
+            range_dict["profile_type"] = static_cast<int>(range.type);
+            range_dict["bytes_htod"] = summary.bytesHtoD;
+            range_dict["bytes_dtoh"] = summary.bytesDtoH;
+            range_dict["bytes_dtod"] = summary.bytesDtoD;
+            range_dict["migration_count"] = summary.migrationCount;
+            range_dict["migration_ns"] = summary.migrationNs;
+            range_dict["cpu_page_faults"] = summary.cpuPageFaults;
+            range_dict["gpu_page_faults"] = summary.gpuPageFaults;
+            range_dict["gpu_page_fault_groups"] = summary.gpuPageFaultGroups;
+            range_dict["gpu_page_fault_ns"] = summary.gpuPageFaultNs;
+            range_dict["thrashing_events"] = summary.thrashingEvents;
+            range_dict["throttling_events"] = summary.throttlingEvents;
+            range_dict["remote_map_events"] = summary.remoteMapEvents;
+            result.append(range_dict);
+        }
+        return result;
+    }
+    
+    void print_hot_kernels(size_t top_n) {
+        profiler->printHotKernels(top_n);
+    }
+    
+    py::list get_hot_kernels(size_t top_n, int order) {
+        py::list result;
+        for (const auto& entry : profiler->getHotKernels(top_n, static_cast<GmpHotKernelOrder>(order))) {
+            py::dict kernel_dict;
+            kernel_dict["name"] = entry.name;
+            kernel_dict["grid_size"] = py::make_tuple(entry.grid_size[0], entry.grid_size[1], entry.grid_size[2]);
+            kernel_dict["block_size"] = py::make_tuple(entry.block_size[0], entry.block_size[1], entry.block_size[2]);
+            kernel_dict["launch_count"] = entry.launchCount;
+            kernel_dict["total_time_ns"] = entry.totalTimeNs;
+            kernel_dict["measured_launch_count"] = entry.measuredLaunchCount;
+            kernel_dict["instructions"] = entry.instructions;
+            kernel_dict["dram_sectors"] = entry.dramSectors;
+            result.append(kernel_dict);
+        }
+        return result;
+    }
+    
+    void set_roofline_peaks(const std::string& chip_name, uint32_t sm_count, double clock_ghz, double dram_bandwidth) {
+        GmpRooflinePeaks peaks;
+        peaks.chipName = chip_name;
+        peaks.smCount = sm_count;
+        peaks.clockGhz = clock_ghz;
+        peaks.dramBandwidth = dram_bandwidth;
+        profiler->setRooflinePeaks(peaks);
+    }
+    
+    void print_roofline(size_t top_n) {
+        profiler->printRoofline(top_n);
+    }
+    
+    py::list get_roofline(bool kernels) {
+        py::list result;
+        for (const auto& point : kernels ? profiler->getRooflineKernels() : profiler->getRooflineRanges()) {
+            py::dict point_dict;
+            point_dict["name"] = point.name;
+            point_dict["range"] = point.rangeName;
+            point_dict["instructions"] = point.instructions;
+            point_dict["dram_bytes"] = point.dramBytes;
+            point_dict["duration_ns"] = point.durationNs;
+            point_dict["intensity"] = point.intensity;
+            point_dict["ginst_per_s"] = point.instructionRate;
+            point_dict["dram_gb_per_s"] = point.bandwidth;
+            point_dict["roof_ginst_per_s"] = point.roofRate;
+            point_dict["roof_fraction"] = point.roofFraction;
+            point_dict["distance_to_roof"] = point.distanceToRoof();
+            point_dict["bound"] = gmpRooflineBoundName(point.bound);
+            result.append(point_dict);
+        }
+        return result;
+    }
+    
+    int export_roofline_csv(const std::string& path, bool include_kernels) {
+        return static_cast<int>(profiler->exportRooflineCsv(path, include_kernels));
+    }
+    
+    void print_bottlenecks(size_t top_n) {
+        profiler->printBottlenecks(top_n);
+    }
+    
+    py::list get_bottlenecks(bool kernels) {
+        py::list result;
+        for (const auto& report : kernels ? profiler->getBottleneckKernels() : profiler->getBottleneckRanges()) {
+            py::dict report_dict;
+            report_dict["name"] = report.name;
+            report_dict["range"] = report.rangeName;
+            report_dict["duration_ns"] = report.durationNs;
+            report_dict["issue_rate"] = report.issueRate;
+            report_dict["eligible_per_cycle"] = report.eligiblePerCycle;
+            py::list ranked;
+            for (const auto& bottleneck : report.ranked) {
+                ranked.append(py::make_tuple(gmpBottleneckName(bottleneck.kind), bottleneck.fraction));
+            }
+            report_dict["bottlenecks"] = ranked;
+            report_dict["summary"] = report.summary();
+            result.append(report_dict);
+        }
+        return result;
+    }
+    
+    void print_range_statistics(int reduction) {
+        profiler->printRangeStatistics(static_cast<GmpOutputKernelReduction>(reduction));
+    }
+    
+    py::list get_range_statistics(int reduction) {
+        auto stats_table = profiler->getRangeStatistics(static_cast<GmpOutputKernelReduction>(reduction));
+        const auto& metric_names = stats_table.getMetricNames();
+        auto to_dict = [](const GmpWelford& stats) {
+            py::dict stats_dict;
+            stats_dict["count"] = stats.count;
+            stats_dict["mean"] = stats.mean;
+            stats_dict["stddev"] = stats.stddev();
+            stats_dict["min"] = stats.min;
+            stats_dict["max"] = stats.max;
+            stats_dict["cv"] = stats.cv();
+            return stats_dict;
+        };
+        py::list result;
+        for (const auto& range_stats : stats_table.getStats()) {
+            py::dict range_dict;
+            range_dict["name"] = range_stats.name;
+            range_dict["iterations"] = range_stats.iterationCount;
+            range_dict["duration_ns"] = to_dict(range_stats.durationNs);
+            py::dict metrics_dict;
+            for (size_t i = 0; i < metric_names.size(); ++i) {
+                if (range_stats.metrics[i].count > 0) {
+                    metrics_dict[py::str(metric_names[i])] = to_dict(range_stats.metrics[i]);
+                }
+            }
+            range_dict["metrics"] = metrics_dict;
+            result.append(range_dict);
+        }
+        return result;
+    }
+    
+    void set_range_summary(bool summarize) {
+        profiler->setRangeSummary(summarize);
+    }
+    
+    int export_trace(const std::string& path) {
+        return static_cast<int>(profiler->exportTrace(path));
+    }
+    
     bool is_all_pass_submitted() {
         return profiler->isAllPassSubmitted();
     }
@@ -103,6 +448,52 @@ public:
     void add_metrics(const std::string& metric) {
         profiler->addMetrics(metric);
     }
+    
+    void set_sampling_policy(int mode, uint64_t warmup_iterations, uint64_t period,
+                             double fraction, uint64_t seed, double overhead_budget_pct) {
+        GmpSamplingPolicy policy;
+        policy.mode = static_cast<GmpSamplingMode>(mode);
+        policy.warmupIterations = warmup_iterations;
+        policy.period = period;
+        policy.fraction = fraction;
+        policy.seed = seed;
+        policy.overheadBudgetPct = overhead_budget_pct;
+        profiler->setSamplingPolicy(policy);
+    }
+    
+    int set_replay_mode(int mode) {
+        return static_cast<int>(profiler->setReplayMode(static_cast<GmpReplayMode>(mode)));
+    }
+    
+    void set_kernel_detail(bool keep) {
+        profiler->setKernelDetail(keep);
+    }
+    
+    int set_range_mode(int mode) {
+        return static_cast<int>(profiler->setRangeMode(static_cast<GmpRangeMode>(mode)));
+    }
+    
+    int profile(const py::function& workload, const py::object& restore, size_t max_passes) {
+        std::function<void()> restoreFunc;
+        if (!restore.is_none()) {
+            restoreFunc = [&restore]() { restore(); };
+        }
+        return static_cast<int>(profiler->profile([&workload]() { workload(); }, restoreFunc, max_passes));
+    }
+    
+    int add_range_filter(const std::string& pattern, bool exclude, bool substring) {
+        GmpResult result = profiler->addRangeFilter(pattern,
+            exclude ? GmpFilterAction::EXCLUDE : GmpFilterAction::INCLUDE,
+            substring ? GmpFilterMatch::SUBSTRING : GmpFilterMatch::EXACT);
+        return static_cast<int>(result);
+    }
+    
+    int add_kernel_filter(const std::string& pattern, bool exclude, bool substring) {
+        GmpResult result = profiler->addKernelFilter(pattern,
+            exclude ? GmpFilterAction::EXCLUDE : GmpFilterAction::INCLUDE,
+            substring ? GmpFilterMatch::SUBSTRING : GmpFilterMatch::EXACT);
+        return static_cast<int>(result);
+    }
 };
 
 PYBIND11_MODULE(gmp_py_wrapper, m) {
@@ -116,13 +507,33 @@ PYBIND11_MODULE(gmp_py_wrapper, m) {
     
     py::enum_<GmpProfileType>(m, "GmpProfileType")
         .value("CONCURRENT_KERNEL", GmpProfileType::CONCURRENT_KERNEL)
-        .value("MEMORY", GmpProfileType::MEMORY);
+        .value("MEMORY", GmpProfileType::MEMORY)
+        .value("TRANSFER", GmpProfileType::TRANSFER);
     
     py::enum_<GmpOutputKernelReduction>(m, "GmpOutputKernelReduction")
         .value("SUM", GmpOutputKernelReduction::SUM)
         .value("MAX", GmpOutputKernelReduction::MAX)
         .value("MEAN", GmpOutputKernelReduction::MEAN);
     
+    py::enum_<GmpReplayMode>(m, "GmpReplayMode")
+        .value("KERNEL", GmpReplayMode::KERNEL)
+        .value("USER", GmpReplayMode::USER);
+    
+    py::enum_<GmpRangeMode>(m, "GmpRangeMode")
+        .value("AUTO", GmpRangeMode::AUTO)
+        .value("USER", GmpRangeMode::USER);
+    
+    py::enum_<GmpHotKernelOrder>(m, "GmpHotKernelOrder")
+        .value("TIME", GmpHotKernelOrder::TIME)
+        .value("INSTRUCTIONS", GmpHotKernelOrder::INSTRUCTIONS)
+        .value("DRAM_SECTORS", GmpHotKernelOrder::DRAM_SECTORS);
+    
+    py::enum_<GmpSamplingMode>(m, "GmpSamplingMode")
+        .value("ALL", GmpSamplingMode::ALL)
+        .value("EVERY_KTH", GmpSamplingMode::EVERY_KTH)
+        .value("RANDOM_FRACTION", GmpSamplingMode::RANDOM_FRACTION)
+        .value("ADAPTIVE", GmpSamplingMode::ADAPTIVE);
+    
     // Memory operation type constants
     m.attr("MEMORY_OP_ALLOCATION") = py::int_(static_cast<int>(CUPTI_ACTIVITY_MEMORY_OPERATION_TYPE_ALLOCATION));
     m.attr("MEMORY_OP_RELEASE") = py::int_(static_cast<int>(CUPTI_ACTIVITY_MEMORY_OPERATION_TYPE_RELEASE));
@@ -136,6 +547,38 @@ PYBIND11_MODULE(gmp_py_wrapper, m) {
     py::class_<PyGmpProfiler>(m, "GmpProfiler")
         .def(py::init<>())
         .def("init", &PyGmpProfiler::init, "Initialize the profiler")
+        .def("init_async", &PyGmpProfiler::init_async, 
+             "Initialize the profiler on a background thread")
+        .def("set_config_cache", &PyGmpProfiler::set_config_cache, 
+             "Enable or disable the on-disk config image cache (call before init)",
+             py::arg("enabled") = true, py::arg("directory") = "")
+        .def("set_spill_file", &PyGmpProfiler::set_spill_file, 
+             "Append raw activity buffers to a spill file instead of decoding them (call before init)",
+             py::arg("path"))
+        .def("set_memory_budget", &PyGmpProfiler::set_memory_budget, 
+             "Spill the records of completed ranges to disk beyond this many bytes (call before the first pop)",
+             py::arg("budget_bytes"), py::arg("spill_path") = "")
+        .def("get_session_storage_stats", &PyGmpProfiler::get_session_storage_stats, 
+             "Get the memory budget, resident bytes, spilled ranges and page-ins")
+        .def("get_session_arena_stats", &PyGmpProfiler::get_session_arena_stats, 
+             "Get the chunks and blocks of the arena holding the sessions and their records")
+        .def("enable_streaming", &PyGmpProfiler::enable_streaming, 
+             "Append completed kernel ranges to a CSV every N ranges or T seconds and free them (call before init)",
+             py::arg("path"), py::arg("range_interval") = 100, py::arg("interval_seconds") = 0.0,
+             py::arg("reduction") = 0)
+        .def("flush_streaming_window", &PyGmpProfiler::flush_streaming_window, 
+             "Write and free the current streaming window now")
+        .def("close_streaming", &PyGmpProfiler::close_streaming, 
+             "Write the last streaming window and close the stream file")
+        .def("get_streaming_stats", &PyGmpProfiler::get_streaming_stats, 
+             "Get the windows, ranges and bytes streamed so far")
+        .def("set_unified_memory_counters", &PyGmpProfiler::set_unified_memory_counters, 
+             "Collect unified memory migrations and page faults per range (call before init)",
+             py::arg("enabled") = true)
+        .def("close_spill", &PyGmpProfiler::close_spill, 
+             "Flush the activity buffers, append the counter data and close the spill file")
+        .def("replay_spill", &PyGmpProfiler::replay_spill, 
+             "Rebuild sessions and counter data from a spill file instead of init", py::arg("path"))
         .def("enable", &PyGmpProfiler::enable, "Enable profiling")
         .def("disable", &PyGmpProfiler::disable, "Disable profiling")
         .def("start_range_profiling", &PyGmpProfiler::start_range_profiling, "Start range profiling")
@@ -145,15 +588,90 @@ PYBIND11_MODULE(gmp_py_wrapper, m) {
         .def("pop_range", &PyGmpProfiler::pop_range, 
              "Pop a profiling range", py::arg("name"), py::arg("profile_type") = 0)
         .def("print_profiler_ranges", &PyGmpProfiler::print_profiler_ranges, 
-             "Print profiler ranges", py::arg("output_reduction_option") = 0)
+             "Print profiler ranges", py::arg("output_reduction_option") = 0,
+             py::arg("config_name") = "default")
         .def("print_memory_activity", &PyGmpProfiler::print_memory_activity, 
              "Print memory activity")
         .def("get_memory_activity", &PyGmpProfiler::get_memory_activity, 
              "Get memory activity data as Python list")
+        .def("print_memory_footprint", &PyGmpProfiler::print_memory_footprint, 
+             "Print live memory footprint per range")
+        .def("get_memory_footprint", &PyGmpProfiler::get_memory_footprint, 
+             "Get per-range peak, leaked allocations and the live-bytes timeline")
+        .def("print_kernel_timeline", &PyGmpProfiler::print_kernel_timeline, 
+             "Print GPU busy time, kernel concurrency and idle gaps per range",
+             py::arg("max_reported_gaps") = 5)
+        .def("get_kernel_timeline", &PyGmpProfiler::get_kernel_timeline, 
+             "Get GPU busy time, kernel concurrency and idle gaps per range",
+             py::arg("max_reported_gaps") = 5)
+        .def("print_transfer_stats", &PyGmpProfiler::print_transfer_stats, 
+             "Print memcpy/memset bytes, bandwidth, sizes and copy/compute overlap per range")
+        .def("get_transfer_stats", &PyGmpProfiler::get_transfer_stats, 
+             "Get memcpy/memset bytes, bandwidth, sizes and copy/compute overlap per range")
+        .def("print_unified_memory_summary", &PyGmpProfiler::print_unified_memory_summary, 
+             "Print unified memory migrations, page faults and thrashing per range")
+        .def("get_unified_memory_summary", &PyGmpProfiler::get_unified_memory_summary, 
+             "Get unified memory migrations, page faults and thrashing per range")
+        .def("print_hot_kernels", &PyGmpProfiler::print_hot_kernels, 
+             "Print the top kernel signatures by time, instructions and DRAM sectors",
+             py::arg("top_n") = 10)
+        .def("get_hot_kernels", &PyGmpProfiler::get_hot_kernels, 
+             "Get the top kernel signatures ranked by time (0), instructions (1) or DRAM sectors (2)",
+             py::arg("top_n") = 10, py::arg("order") = 0)
+        .def("set_roofline_peaks", &PyGmpProfiler::set_roofline_peaks, 
+             "Override the roofline peaks: SM count, SM clock in GHz and DRAM bandwidth in GB/s",
+             py::arg("chip_name"), py::arg("sm_count"), py::arg("clock_ghz"), py::arg("dram_bandwidth"))
+        .def("print_roofline", &PyGmpProfiler::print_roofline, 
+             "Print the roofline of every range and the kernels furthest below the roof",
+             py::arg("top_n") = 10)
+        .def("get_roofline", &PyGmpProfiler::get_roofline, 
+             "Get the roofline point of every range, or of every kernel if kernels is set",
+             py::arg("kernels") = false)
+        .def("export_roofline_csv", &PyGmpProfiler::export_roofline_csv, 
+             "Write the roofline of every range and kernel to a CSV file",
+             py::arg("path"), py::arg("include_kernels") = true)
+        .def("print_bottlenecks", &PyGmpProfiler::print_bottlenecks, 
+             "Print the ranked stall reasons and pipe utilizations of every range and the longest kernels",
+             py::arg("top_n") = 10)
+        .def("get_bottlenecks", &PyGmpProfiler::get_bottlenecks, 
+             "Get the ranked stall reasons and pipe utilizations of every range, or of every kernel if kernels is set",
+             py::arg("kernels") = false)
+        .def("print_range_statistics", &PyGmpProfiler::print_range_statistics, 
+             "Print mean, stddev, min, max and CV of every metric across iterations of each range name",
+             py::arg("reduction") = 0)
+        .def("get_range_statistics", &PyGmpProfiler::get_range_statistics, 
+             "Get mean, stddev, min, max and CV of every metric across iterations of each range name",
+             py::arg("reduction") = 0)
+        .def("set_range_summary", &PyGmpProfiler::set_range_summary, 
+             "Write one statistics row per range name to result.csv", py::arg("summarize"))
+        .def("export_trace", &PyGmpProfiler::export_trace, 
+             "Write ranges, kernels and memory operations to a Chrome JSON trace", py::arg("path"))
         .def("is_all_pass_submitted", &PyGmpProfiler::is_all_pass_submitted, 
              "Check if all passes are submitted")
         .def("decode_counter_data", &PyGmpProfiler::decode_counter_data, 
              "Decode counter data")
         .def("add_metrics", &PyGmpProfiler::add_metrics, 
-             "Add metrics for profiling", py::arg("metric"));
+             "Add metrics for profiling", py::arg("metric"))
+        .def("set_sampling_policy", &PyGmpProfiler::set_sampling_policy,
+             "Select which ranges are profiled", py::arg("mode") = 0,
+             py::arg("warmup_iterations") = 0, py::arg("period") = 1,
+             py::arg("fraction") = 1.0, py::arg("seed") = 0,
+             py::arg("overhead_budget_pct") = 5.0)
+        .def("set_replay_mode", &PyGmpProfiler::set_replay_mode,
+             "Select kernel (0) or user (1) replay (call before init)", py::arg("mode"))
+        .def("set_kernel_detail", &PyGmpProfiler::set_kernel_detail,
+             "Keep per-kernel metrics (True) or reduce them per range while evaluating (False)",
+             py::arg("keep"))
+        .def("set_range_mode", &PyGmpProfiler::set_range_mode,
+             "Select auto (0) or user (1) ranges; user ranges imply user replay (call before init)",
+             py::arg("mode"))
+        .def("profile", &PyGmpProfiler::profile,
+             "Run the workload until all passes are submitted, then evaluate the metrics",
+             py::arg("workload"), py::arg("restore") = py::none(), py::arg("max_passes") = 64)
+        .def("add_range_filter", &PyGmpProfiler::add_range_filter,
+             "Only profile matching range names (call before init)", py::arg("pattern"),
+             py::arg("exclude") = false, py::arg("substring") = false)
+        .def("add_kernel_filter", &PyGmpProfiler::add_kernel_filter,
+             "Only record matching kernel names (call before init)", py::arg("pattern"),
+             py::arg("exclude") = false, py::arg("substring") = true);
 }
\ No newline at end of file
@@ -29,7 +29,7 @@ except ImportError as e:
     print("Make sure the GMP Python wrapper is compiled and installed.")
     exit(1)
 
-from typing import Optional, Dict, List, Any, Union
+from typing import Optional, Dict, List, Any, Union, Callable
 import warnings
 
 
@@ -52,19 +52,135 @@ class GmpProfiler:
         self._initialized = False
         self._enabled = False
     
-    def init(self) -> None:
+    def init(self, background: bool = False) -> None:
         """
         Initialize the profiler.
         
         This must be called before any kernel launches to ensure proper profiling.
+        
+        Args:
+            background: Initialize on a background thread. The first profiled
+                range waits for it to finish if needed.
         """
         try:
-            self._profiler.init()
+            if background:
+                self._profiler.init_async()
+            else:
+                self._profiler.init()
             self._initialized = True
             self._enabled = True
         except Exception as e:
             raise ProfilerError(f"Failed to initialize profiler: {e}")
     
+    def set_config_cache(self, enabled: bool = True, directory: str = "") -> None:
+        """
+        Configure the on-disk cache of range profiler config images.
+        
+        Args:
+            enabled: Reuse config images built by earlier processes
+            directory: Cache location, defaults to $GMP_CACHE_DIR or ~/.cache/gmp
+        """
+        if self._initialized:
+            warnings.warn("Config cache settings must be set before init().")
+        self._profiler.set_config_cache(enabled, directory)
+    
+    def set_spill_file(self, path: str) -> None:
+        """
+        Capture mode: append the raw CUPTI activity buffers and range
+        boundaries to a spill file instead of decoding them during the run.
+        Reports are built later with replay_spill() or tools/gmp_replay.
+        
+        Args:
+            path: Spill file, overwritten if it exists
+        """
+        if self._initialized:
+            warnings.warn("The spill file must be set before init().")
+        self._profiler.set_spill_file(path)
+    
+    def set_memory_budget(self, budget_bytes: int, spill_path: str = "") -> None:
+        """
+        Bound the host memory held by the records of completed ranges.
+        
+        Beyond the budget the oldest ranges are written to a spill file and
+        read back one at a time when a report visits them. Set it before the
+        first range is popped.
+        
+        Args:
+            budget_bytes: Bytes of records kept in memory, 0 for no limit
+            spill_path: Spill file, defaults to a file in the temporary directory
+        """
+        self._profiler.set_memory_budget(budget_bytes, spill_path)
+    
+    def get_session_storage_stats(self) -> Dict[str, Any]:
+        """Memory budget, resident bytes, spilled ranges, spill file bytes and page-ins."""
+        return self._profiler.get_session_storage_stats()
+    
+    def get_session_arena_stats(self) -> Dict[str, Any]:
+        """Chunks, carved and reused blocks, bytes in use and resets of the session arena."""
+        return self._profiler.get_session_arena_stats()
+    
+    def enable_streaming(self, path: str, range_interval: int = 100, interval_seconds: float = 0.0,
+                         reduction: Union[str, int] = "SUM") -> None:
+        """
+        Streaming mode for long runs: every range_interval kernel ranges or
+        interval_seconds, once no range is open, the completed kernel ranges
+        are evaluated, appended to a CSV file with one row per range and freed.
+        Reports built afterwards only cover the current window. Needs auto
+        range mode and kernel replay. Must be called before init().
+        
+        Args:
+            path: CSV file, appended to if it was written with the same metrics
+            range_interval: Kernel ranges per window, 0 to not count ranges
+            interval_seconds: Also close a window after this long, 0 to not time windows
+            reduction: "SUM", "MAX" or "MEAN" (or corresponding int)
+        """
+        if self._initialized:
+            warnings.warn("Streaming must be enabled before init().")
+        if isinstance(reduction, str):
+            reduction = {"SUM": 0, "MAX": 1, "MEAN": 2}.get(reduction.upper(), 0)
+        self._profiler.enable_streaming(path, range_interval, interval_seconds, reduction)
+    
+    def flush_streaming_window(self) -> bool:
+        """Write and free the current streaming window now, e.g. at a checkpoint."""
+        return self._profiler.flush_streaming_window() == 0
+    
+    def close_streaming(self) -> bool:
+        """Write the last streaming window and close the stream file."""
+        return self._profiler.close_streaming() == 0
+    
+    def get_streaming_stats(self) -> Dict[str, Any]:
+        """Windows, ranges and bytes streamed so far."""
+        return self._profiler.get_streaming_stats()
+    
+    def set_unified_memory_counters(self, enabled: bool = True) -> None:
+        """
+        Collect unified memory counters (migrated bytes, CPU/GPU page faults,
+        thrashing, throttling and remote map events) summarized per range.
+        Must be called before init().
+        """
+        if self._initialized:
+            warnings.warn("Unified memory counters must be set before init().")
+        self._profiler.set_unified_memory_counters(enabled)
+    
+    def close_spill(self) -> bool:
+        """Flush the activity buffers, append the counter data and close the spill file."""
+        return self._profiler.close_spill() == 0
+    
+    def replay_spill(self, path: str) -> None:
+        """
+        Rebuild the sessions and counter data of a spill file instead of
+        calling init(). No GPU is needed; the usual reports are available afterwards.
+        
+        Args:
+            path: Spill file written with set_spill_file()
+        """
+        if self._initialized:
+            raise ProfilerError("replay_spill() needs a profiler that has not been initialized.")
+        if self._profiler.replay_spill(path) != 0:
+            raise ProfilerError(f"Failed to replay spill file {path}")
+        self._initialized = True
+        self._enabled = True
+    
     def enable(self) -> None:
         """Enable profiling."""
         if not self._initialized:
@@ -93,12 +209,13 @@ class GmpProfiler:
             return
         self._profiler.stop_range_profiling()
 
-    def print_profiler_ranges(self, reduction: Union[str, int] = "SUM") -> None:
+    def print_profiler_ranges(self, reduction: Union[str, int] = "SUM", config_name: str = "default") -> None:
         """
         Print profiling results for all ranges.
         
         Args:
             reduction: Reduction method for results ("SUM", "AVG", etc., or corresponding int)
+            config_name: Label written with the results to ./output/result.csv
         """
         if isinstance(reduction, str):
             reduction_map = {
@@ -108,7 +225,7 @@ class GmpProfiler:
             }
             reduction = reduction_map.get(reduction.upper(), 0)
         
-        self._profiler.print_profiler_ranges(reduction)
+        self._profiler.print_profiler_ranges(reduction, config_name)
     
     def push_range(self, name: str, profile_type: Union[str, int] = "CONCURRENT_KERNEL") -> None:
         """
@@ -116,7 +233,7 @@ class GmpProfiler:
         
         Args:
             name: Name of the range
-            profile_type: Type of profiling ("CONCURRENT_KERNEL" or "MEMORY", or corresponding int)
+            profile_type: Type of profiling ("CONCURRENT_KERNEL", "MEMORY" or "TRANSFER", or corresponding int)
         """
         if not self.is_enabled():
             return
@@ -125,7 +242,8 @@ class GmpProfiler:
         if isinstance(profile_type, str):
             type_map = {
                 "CONCURRENT_KERNEL": 0,
-                "MEMORY": 1
+                "MEMORY": 1,
+                "TRANSFER": 2
             }
             profile_type = type_map.get(profile_type.upper(), 0)
         
@@ -148,7 +266,8 @@ class GmpProfiler:
         if isinstance(profile_type, str):
             type_map = {
                 "CONCURRENT_KERNEL": 0,
-                "MEMORY": 1
+                "MEMORY": 1,
+                "TRANSFER": 2
             }
             profile_type = type_map.get(profile_type.upper(), 0)
         
@@ -171,6 +290,184 @@ class GmpProfiler:
             return []
         return self._profiler.get_memory_activity()
     
+    def print_memory_footprint(self) -> None:
+        """Print live footprint, peak and leaked allocations of every memory range."""
+        self._profiler.print_memory_footprint()
+    
+    def get_memory_footprint(self) -> Dict[str, Any]:
+        """
+        Get the live device memory footprint rebuilt from memory activity.
+        
+        Returns:
+            Dictionary with per-range footprints, the (timestamp, live_bytes)
+            timeline, the overall high-water mark and the bytes still live
+        """
+        if not self.is_enabled():
+            return {}
+        return self._profiler.get_memory_footprint()
+    
+    def print_kernel_timeline(self, max_reported_gaps: int = 5) -> None:
+        """Print GPU busy time, kernel concurrency and idle gaps per range."""
+        self._profiler.print_kernel_timeline(max_reported_gaps)
+    
+    def get_kernel_timeline(self, max_reported_gaps: int = 5) -> List[Dict[str, Any]]:
+        """
+        Get GPU busy time, kernel concurrency and idle gaps per range.
+        
+        Args:
+            max_reported_gaps: Number of longest idle gaps reported per range
+        """
+        if not self.is_enabled():
+            return []
+        return self._profiler.get_kernel_timeline(max_reported_gaps)
+    
+    def print_transfer_stats(self) -> None:
+        """Print memcpy/memset bytes, bandwidth, sizes and copy/compute overlap per TRANSFER range."""
+        self._profiler.print_transfer_stats()
+    
+    def get_transfer_stats(self) -> List[Dict[str, Any]]:
+        """
+        Get memcpy/memset statistics per TRANSFER range.
+        
+        Returns:
+            List of dictionaries with bytes, count, duration and bandwidth per
+            direction, the size histogram, pageable copies and copy/compute overlap
+        """
+        if not self.is_enabled():
+            return []
+        return self._profiler.get_transfer_stats()
+    
+    def print_unified_memory_summary(self) -> None:
+        """Print unified memory migrations, page faults and thrashing per range."""
+        self._profiler.print_unified_memory_summary()
+    
+    def get_unified_memory_summary(self) -> List[Dict[str, Any]]:
+        """
+        Get the unified memory summary of every range, kernel ranges first.
+        
+        Returns:
+            List of dictionaries with migrated bytes per direction, page fault
+            counts and thrashing, throttling and remote map events
+        """
+        if not self.is_enabled():
+            return []
+        return self._profiler.get_unified_memory_summary()
+    
+    def print_hot_kernels(self, top_n: int = 10) -> None:
+        """Print the top kernel signatures by GPU time, instructions and DRAM sectors."""
+        self._profiler.print_hot_kernels(top_n)
+    
+    def get_hot_kernels(self, top_n: int = 10, order: Union[str, int] = "TIME") -> List[Dict[str, Any]]:
+        """
+        Group all kernel launches by (name, grid, block) and rank them.
+        
+        Args:
+            top_n: Number of signatures returned
+            order: "TIME", "INSTRUCTIONS" or "DRAM_SECTORS" (or corresponding int)
+        """
+        if isinstance(order, str):
+            order = {"TIME": 0, "INSTRUCTIONS": 1, "DRAM_SECTORS": 2}.get(order.upper(), 0)
+        if not self.is_enabled():
+            return []
+        return self._profiler.get_hot_kernels(top_n, order)
+    
+    def set_roofline_peaks(self, chip_name: str, sm_count: int, clock_ghz: float, dram_bandwidth: float) -> None:
+        """
+        Override the roofline peaks of the chip, e.g. for a board with fewer
+        SMs or other clocks than the built-in table assumes.
+        
+        Args:
+            chip_name: Label used in the reports
+            sm_count: Number of SMs
+            clock_ghz: SM clock in GHz
+            dram_bandwidth: Peak DRAM bandwidth in GB/s
+        """
+        self._profiler.set_roofline_peaks(chip_name, sm_count, clock_ghz, dram_bandwidth)
+    
+    def print_roofline(self, top_n: int = 10) -> None:
+        """Print the roofline of every range and the top_n kernels furthest below the roof."""
+        self._profiler.print_roofline(top_n)
+    
+    def get_roofline(self, kernels: bool = False) -> List[Dict[str, Any]]:
+        """
+        Place every range, or every kernel launch, on the instruction roofline.
+        
+        Each entry holds the warp instructions, DRAM bytes and duration, the
+        intensity in warp instructions per DRAM byte, the achieved and
+        attainable G instructions/s, the fraction of the roof reached and
+        whether it is "memory", "compute" or "unknown" bound.
+        
+        Args:
+            kernels: Return one entry per kernel launch instead of per range
+        """
+        if not self.is_enabled():
+            return []
+        return self._profiler.get_roofline(kernels)
+    
+    def export_roofline_csv(self, path: str, include_kernels: bool = True) -> bool:
+        """Write the roofline of every range, and of every kernel if include_kernels is set, to a CSV file."""
+        return self._profiler.export_roofline_csv(path, include_kernels) == 0
+    
+    def print_bottlenecks(self, top_n: int = 10) -> None:
+        """Print the ranked bottlenecks of every range and of the top_n longest kernels."""
+        self._profiler.print_bottlenecks(top_n)
+    
+    def get_bottlenecks(self, kernels: bool = False) -> List[Dict[str, Any]]:
+        """
+        Rank the stall reasons and pipe utilizations of every range, or kernel.
+        
+        Each entry holds the name, the instructions issued per active cycle,
+        the eligible warps per cycle, "bottlenecks" as (name, fraction) pairs
+        sorted largest first, and a summary such as
+        "memory latency 52%, tensor pipe idle 80%".
+        
+        Args:
+            kernels: Return one entry per kernel launch instead of per range
+        """
+        if not self.is_enabled():
+            return []
+        return self._profiler.get_bottlenecks(kernels)
+    
+    def print_range_statistics(self, reduction: Union[str, int] = "SUM") -> None:
+        """Print per range name statistics of every metric across its iterations."""
+        if isinstance(reduction, str):
+            reduction = {"SUM": 0, "MAX": 1, "MEAN": 2}.get(reduction.upper(), 0)
+        self._profiler.print_range_statistics(reduction)
+    
+    def get_range_statistics(self, reduction: Union[str, int] = "SUM") -> List[Dict[str, Any]]:
+        """
+        Group repeated ranges (e.g. training steps) by name and summarize them.
+        
+        Each entry holds the range name, its iteration count, and mean, stddev,
+        min, max and coefficient of variation of the range duration and of
+        every metric, after the kernels of each iteration are reduced.
+        
+        Args:
+            reduction: "SUM", "MAX" or "MEAN" (or corresponding int)
+        """
+        if isinstance(reduction, str):
+            reduction = {"SUM": 0, "MAX": 1, "MEAN": 2}.get(reduction.upper(), 0)
+        if not self.is_enabled():
+            return []
+        return self._profiler.get_range_statistics(reduction)
+    
+    def set_range_summary(self, summarize: bool = True) -> None:
+        """Write one statistics row per range name to result.csv instead of one row per iteration."""
+        self._profiler.set_range_summary(summarize)
+    
+    def export_trace(self, path: str) -> bool:
+        """
+        Write ranges, kernels and memory operations to a Chrome JSON trace
+        that Perfetto UI (ui.perfetto.dev) and chrome://tracing can open.
+        
+        Args:
+            path: Output file, conventionally ending in .json
+        
+        Returns:
+            True if the trace was written
+        """
+        return self._profiler.export_trace(path) == 0
+    
     def add_metrics(self, metric: str) -> None:
         """
         Add metrics for profiling.
@@ -180,6 +477,106 @@ class GmpProfiler:
         """
         self._profiler.add_metrics(metric)
     
+    def set_sampling_policy(self, mode: Union[str, int] = "ALL", warmup_iterations: int = 0,
+                            period: int = 1, fraction: float = 1.0, seed: int = 0,
+                            overhead_budget_pct: float = 5.0) -> None:
+        """
+        Select which ranges are profiled.
+        
+        Args:
+            mode: "ALL", "EVERY_KTH", "RANDOM_FRACTION" or "ADAPTIVE" (or corresponding int)
+            warmup_iterations: Occurrences of each range name skipped before profiling starts
+            period: EVERY_KTH only, profile every Kth occurrence of a range name
+            fraction: RANDOM_FRACTION only, probability that a range is profiled
+            seed: RANDOM_FRACTION only, random seed
+            overhead_budget_pct: ADAPTIVE only, maximum profiler overhead in percent of wall time
+        """
+        if isinstance(mode, str):
+            mode_map = {
+                "ALL": 0,
+                "EVERY_KTH": 1,
+                "RANDOM_FRACTION": 2,
+                "ADAPTIVE": 3,
+            }
+            mode = mode_map.get(mode.upper(), 0)
+        
+        self._profiler.set_sampling_policy(mode, warmup_iterations, period,
+                                           fraction, seed, overhead_budget_pct)
+    
+    def set_replay_mode(self, mode: Union[str, int] = "KERNEL") -> None:
+        """
+        Select how metrics that need several passes are collected. Call before init().
+        
+        Args:
+            mode: "KERNEL" (CUPTI replays every kernel) or "USER" (the workload
+                is rerun once per pass by profile())
+        """
+        if isinstance(mode, str):
+            mode = {"KERNEL": 0, "USER": 1}.get(mode.upper(), 0)
+        if self._profiler.set_replay_mode(mode) != 0:
+            warnings.warn("Replay mode was not changed, call set_replay_mode() before init().")
+    
+    def set_kernel_detail(self, keep: bool = True) -> None:
+        """
+        Keep per-kernel metrics after evaluation (default). With keep=False the
+        metrics are folded into per-range sum/max/mean while they are evaluated,
+        so memory grows with the number of ranges instead of kernels.
+        """
+        self._profiler.set_kernel_detail(keep)
+    
+    def set_range_mode(self, mode: Union[str, int] = "AUTO") -> None:
+        """
+        Select how kernels map to counter data ranges. Call before init().
+        
+        Args:
+            mode: "AUTO" (one range per kernel, per-kernel metrics reduced per
+                GMP range) or "USER" (one range per GMP range, aggregated by the
+                hardware; switches to user replay)
+        """
+        if isinstance(mode, str):
+            mode = {"AUTO": 0, "USER": 1}.get(mode.upper(), 0)
+        if self._profiler.set_range_mode(mode) != 0:
+            warnings.warn("Range mode was not changed, call set_range_mode() before init().")
+    
+    def profile(self, workload: Callable[[], None], restore: Optional[Callable[[], None]] = None,
+                max_passes: int = 64) -> None:
+        """
+        Run the workload until every pass is submitted, then decode and evaluate
+        the counter data. Results are printed with print_profiler_ranges().
+        
+        Args:
+            workload: Callable that launches the profiled ranges
+            restore: Called before every rerun under user replay to reset state
+                the workload mutates, e.g. reload model weights
+            max_passes: Give up after this many runs of the workload
+        """
+        if self._profiler.profile(workload, restore, max_passes) != 0:
+            raise ProfilerError("Profiling did not complete, see the log for details.")
+    
+    def add_range_filter(self, pattern: str, exclude: bool = False, substring: bool = False) -> None:
+        """
+        Only profile ranges whose name passes the filters. Call before init().
+        
+        Args:
+            pattern: Range name, or part of it when substring is True
+            exclude: Drop matching ranges instead of keeping only them
+            substring: Match the pattern anywhere in the name
+        """
+        if self._profiler.add_range_filter(pattern, exclude, substring) != 0:
+            warnings.warn(f"Range filter '{pattern}' was not added.")
+    
+    def add_kernel_filter(self, pattern: str, exclude: bool = False, substring: bool = True) -> None:
+        """
+        Only record kernels whose name passes the filters. Call before init().
+        
+        Args:
+            pattern: Kernel name, or part of it when substring is True
+            exclude: Drop matching kernels instead of keeping only them
+            substring: Match the pattern anywhere in the name
+        """
+        if self._profiler.add_kernel_filter(pattern, exclude, substring) != 0:
+            warnings.warn(f"Kernel filter '{pattern}' was not added.")
+    
     def decode_counter_data(self) -> None:
         """Decode counter data."""
         if self.is_enabled():